@@ -1,9 +1,24 @@
 #include "BinarySerializer/binarySerializer.h"
+#include "BinarySerializer/cellFormat.h"
+#include "BinarySerializer/dumpText.h"
+#include "BinarySerializer/executionContext.h"
+#include "BinarySerializer/externalMemory.h"
+#include "BinarySerializer/instrumentation.h"
+#include "BinarySerializer/mappedDump.h"
 #include "BinarySerializer/mergeHashTable.h"
+#include "BinarySerializer/mergeHashTable.hpp"
+#include "BinarySerializer/sortDump.h"
+#include "BinarySerializer/specializedHashTable.h"
+#include "workload.hpp"
 
 #include <benchmark/benchmark.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
 #include <memory>
 #include <random>
+#include <string>
 #include <vector>
 
 #if defined(BS_ENABLE_MI_MALLOC)
@@ -17,6 +32,7 @@ std::vector<long> ids;
 std::unique_ptr<StatData[]> benchData;
 std::unique_ptr<StatData[]> firstJoin;
 std::unique_ptr<StatData[]> secondJoin;
+std::vector<StatData> sortData;
 
 } // namespace
 
@@ -72,6 +88,42 @@ static void DoTeardownJoin(const benchmark::State &state) {
   secondJoin = {};
 }
 
+static void DoSetupSort(const benchmark::State &state) {
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<long> idDistrib(0, state.range(0));
+  std::uniform_real_distribution<float> costDistrib(0.0f, 1e6f);
+  sortData.resize(state.range(0));
+  for (StatData &record : sortData) {
+    record.id = idDistrib(gen);
+    record.cost = costDistrib(gen);
+    record.count = 1;
+    record.mode = 0;
+    record.primary = 1;
+  }
+}
+
+static void DoTeardownSort(const benchmark::State &state) {
+  sortData = {};
+}
+
+// Распределение по бакетам в отчете бенчмарка: ухудшение хеша или перекос
+// id видны по max_chain и mean_probe без профилировщика
+static void ReportHashTableStats(benchmark::State &state,
+                                 const MergeHashTable *table) {
+  state.PauseTiming();
+  HashTableStats stats;
+  if (GetHashTableStats(table, &stats)) {
+    state.counters["load_factor"] = stats.loadFactor;
+    state.counters["max_chain"] = (double)stats.maxChainLength;
+    state.counters["mean_probe"] = stats.meanProbeLength;
+    state.counters["empty_buckets"] = (double)stats.emptyBuckets;
+    state.counters["table_bytes"] = benchmark::Counter(
+        (double)stats.totalBytes, benchmark::Counter::kDefaults,
+        benchmark::Counter::kIs1024);
+  }
+  state.ResumeTiming();
+}
+
 static void
 TestInsertElementsWithUniquesId([[maybe_unused]] benchmark::State &state) {
   for ([[maybe_unused]] const auto &_ : state) {
@@ -89,6 +141,7 @@ TestInsertElementsWithUniquesId([[maybe_unused]] benchmark::State &state) {
       benchmark::DoNotOptimize(InsertToHashTable(&table, &mem[i]));
     }
 
+    ReportHashTableStats(state, &table);
     ClearHashTable(&table);
   }
 }
@@ -111,6 +164,7 @@ TestInsertElementsWithNonUniquesId([[maybe_unused]] benchmark::State &state) {
       benchmark::DoNotOptimize(InsertToHashTable(&table, &mem[i]));
     }
 
+    ReportHashTableStats(state, &table);
     ClearHashTable(&table);
   }
 }
@@ -133,10 +187,117 @@ TestInsertElementsWithRandomId([[maybe_unused]] benchmark::State &state) {
       benchmark::DoNotOptimize(InsertToHashTable(&table, &mem[i]));
     }
 
+    ReportHashTableStats(state, &table);
+    ClearHashTable(&table);
+  }
+}
+
+static void
+TestBatchInsertWithNonUniquesId([[maybe_unused]] benchmark::State &state) {
+  size_t size = state.range(0);
+  std::unique_ptr<StatData[]> mem = std::make_unique<StatData[]>(size);
+  for (size_t i = 0; i < size; ++i) {
+    mem[i].id = i % 50;
+    mem[i].cost = 20;
+    mem[i].count = 50.0;
+    mem[i].mode = 0;
+    mem[i].primary = 1;
+  }
+
+  for ([[maybe_unused]] const auto &_ : state) {
+    MergeHashTable table;
+    benchmark::DoNotOptimize(InitHashTable(&table, NULL, NULL, NULL));
+    benchmark::DoNotOptimize(InsertBatchToHashTable(&table, mem.get(), size));
+
+    ReportHashTableStats(state, &table);
     ClearHashTable(&table);
   }
 }
 
+static void TestSpecializedInsertWithNonUniquesId(
+    [[maybe_unused]] benchmark::State &state) {
+  for ([[maybe_unused]] const auto &_ : state) {
+    DefaultMergeTable table;
+    benchmark::DoNotOptimize(DefaultMergeTableInit(&table, 0));
+
+    size_t size = state.range(0);
+
+    std::unique_ptr<StatData[]> mem = std::make_unique<StatData[]>(size);
+    for (size_t i = 0; i < size; ++i) {
+      mem[i].id = i % 50;
+      mem[i].cost = 20;
+      mem[i].count = 50.0;
+      mem[i].mode = 0;
+      mem[i].primary = 1;
+      benchmark::DoNotOptimize(DefaultMergeTableInsert(&table, &mem[i]));
+    }
+
+    DefaultMergeTableClear(&table);
+  }
+}
+
+static void
+TestSpecializedInsertWithRandomId([[maybe_unused]] benchmark::State &state) {
+  for ([[maybe_unused]] const auto &_ : state) {
+    DefaultMergeTable table;
+    benchmark::DoNotOptimize(DefaultMergeTableInit(&table, 0));
+
+    size_t size = state.range(0);
+
+    std::unique_ptr<StatData[]> mem = std::make_unique<StatData[]>(size);
+    for (size_t i = 0; i < size; ++i) {
+      mem[i].id = ids[i];
+      mem[i].cost = 25;
+      mem[i].count = 1.0;
+      mem[i].mode = 0;
+      mem[i].primary = 1;
+      benchmark::DoNotOptimize(DefaultMergeTableInsert(&table, &mem[i]));
+    }
+
+    DefaultMergeTableClear(&table);
+  }
+}
+
+static void
+TestTemplateInsertWithNonUniquesId([[maybe_unused]] benchmark::State &state) {
+  for ([[maybe_unused]] const auto &_ : state) {
+    bs::DefaultMergeHashTable table;
+
+    size_t size = state.range(0);
+
+    std::unique_ptr<StatData[]> mem = std::make_unique<StatData[]>(size);
+    for (size_t i = 0; i < size; ++i) {
+      mem[i].id = i % 50;
+      mem[i].cost = 20;
+      mem[i].count = 50.0;
+      mem[i].mode = 0;
+      mem[i].primary = 1;
+      table.Insert(mem[i]);
+    }
+    benchmark::DoNotOptimize(table.Size());
+  }
+}
+
+static void
+TestTemplateInsertWithRandomId([[maybe_unused]] benchmark::State &state) {
+  for ([[maybe_unused]] const auto &_ : state) {
+    bs::DefaultMergeHashTable table;
+
+    size_t size = state.range(0);
+
+    std::unique_ptr<StatData[]> mem = std::make_unique<StatData[]>(size);
+    for (size_t i = 0; i < size; ++i) {
+      mem[i].id = ids[i];
+      mem[i].cost = 25;
+      mem[i].count = 1.0;
+      mem[i].mode = 0;
+      mem[i].primary = 1;
+      table.Insert(mem[i]);
+    }
+    benchmark::DoNotOptimize(table.Size());
+  }
+}
+
 static void
 TestStoreAndLoadDataWithRandomIDs([[maybe_unused]] benchmark::State &state) {
   for ([[maybe_unused]] const auto &_ : state) {
@@ -165,11 +326,395 @@ static void TestJoinData([[maybe_unused]] benchmark::State &state) {
   }
 }
 
-static int SortStatDataFunc(const void *__restrict lhs,
-                            const void *__restrict rhs) {
+static void TestJoinDataToFile([[maybe_unused]] benchmark::State &state) {
+  FILE *fd = fopen("join.dat", "ab+");
+  fclose(fd);
+  for ([[maybe_unused]] const auto &_ : state) {
+    benchmark::DoNotOptimize(JoinDumpToFile(firstJoin.get(), state.range(0),
+                                            secondJoin.get(), state.range(0),
+                                            "join.dat", NULL));
+  }
+  remove("join.dat");
+}
+
+// Та же работа, что TestJoinData / TestInsertElementsWithRandomId, но со
+// включенным сбором: разница времени - цена instrumentation.h
+static void TestJoinDataInstrumented([[maybe_unused]] benchmark::State &state) {
+  ResetInstrumentationStats();
+  SetInstrumentationEnabled(1);
+  for ([[maybe_unused]] const auto &_ : state) {
+    StatData *dt = NULL;
+    size_t size = 0;
+    benchmark::DoNotOptimize(JoinDump(firstJoin.get(), state.range(0),
+                                      secondJoin.get(), state.range(0), &dt,
+                                      &size));
+    free(dt);
+  }
+  SetInstrumentationEnabled(0);
+  InstrumentationStats stats;
+  if (GetInstrumentationStats(&stats) == SUCCESS) {
+    const double iterations = (double)state.iterations();
+    state.counters["hash_ns"] =
+        stats.phaseNanoseconds[INSTRUMENTATION_PHASE_HASH] / iterations;
+    state.counters["to_array_ns"] =
+        stats.phaseNanoseconds[INSTRUMENTATION_PHASE_TO_ARRAY] / iterations;
+    state.counters["probes"] =
+        stats.counters[INSTRUMENTATION_PROBES] / iterations;
+    state.counters["merges"] =
+        stats.counters[INSTRUMENTATION_MERGES] / iterations;
+  }
+}
+
+static void
+TestInsertRandomIdInstrumented([[maybe_unused]] benchmark::State &state) {
+  SetInstrumentationEnabled(1);
+  TestInsertElementsWithRandomId(state);
+  SetInstrumentationEnabled(0);
+}
+
+static void
+TestSortDumpExternalByCost([[maybe_unused]] benchmark::State &state) {
+  FILE *fd = fopen("external_sort.dat", "wb+");
+  fclose(fd);
+  benchmark::DoNotOptimize(
+      StoreDump("external_sort.dat", sortData.data(), sortData.size()));
+  for ([[maybe_unused]] const auto &_ : state) {
+    benchmark::DoNotOptimize(SortDumpExternal(
+        "external_sort.dat", "external_sort_out.dat", NULL,
+        (size_t)state.range(1) << 20, SORT_FIELD_COST, SORT_ASC, NULL, NULL));
+  }
+  state.SetBytesProcessed(state.iterations() * sortData.size() *
+                          sizeof(StatData));
+  remove("external_sort.dat");
+  remove("external_sort_out.dat");
+}
+
+// Пропускная способность считается по объему выведенного текста
+static void TestExportDump([[maybe_unused]] benchmark::State &state) {
+  FILE *fd = fopen("export_bench.dat", "wb+");
+  fclose(fd);
+  benchmark::DoNotOptimize(
+      StoreDump("export_bench.dat", sortData.data(), sortData.size()));
+  TextFormat format = static_cast<TextFormat>(state.range(1));
+  for ([[maybe_unused]] const auto &_ : state) {
+    benchmark::DoNotOptimize(
+        ExportDump("export_bench.dat", "export_bench.txt", format, 0));
+  }
+  struct stat statBuf;
+  stat("export_bench.txt", &statBuf);
+  state.SetBytesProcessed(state.iterations() * statBuf.st_size);
+  state.SetItemsProcessed(state.iterations() * sortData.size());
+  remove("export_bench.dat");
+  remove("export_bench.txt");
+}
+
+static void DoSetupImport(const benchmark::State &state) {
+  DoSetupSort(state);
+  FILE *fd = fopen("import_bench.dat", "wb+");
+  fclose(fd);
+  benchmark::DoNotOptimize(
+      StoreDump("import_bench.dat", sortData.data(), sortData.size()));
+  benchmark::DoNotOptimize(ExportDump("import_bench.dat", "import_bench.csv",
+                                      TEXT_FORMAT_CSV, 0));
+}
+
+static void DoTeardownImport(const benchmark::State &state) {
+  DoTeardownSort(state);
+  remove("import_bench.dat");
+  remove("import_bench.csv");
+}
+
+static void TestImportDump([[maybe_unused]] benchmark::State &state) {
+  for ([[maybe_unused]] const auto &_ : state) {
+    benchmark::DoNotOptimize(
+        ImportDump("import_bench.csv", "import_bench.dat", 0));
+  }
+  struct stat statBuf;
+  stat("import_bench.csv", &statBuf);
+  state.SetBytesProcessed(state.iterations() * statBuf.st_size);
+  state.SetItemsProcessed(state.iterations() * sortData.size());
+}
+
+// Тот же разбор через strtol / strtof по строкам для сравнения
+static void TestImportWithStrtod([[maybe_unused]] benchmark::State &state) {
+  std::vector<StatData> records(sortData.size());
+  char line[256];
+  for ([[maybe_unused]] const auto &_ : state) {
+    FILE *file = fopen("import_bench.csv", "rb");
+    size_t count = 0;
+    benchmark::DoNotOptimize(fgets(line, sizeof(line), file));
+    while (fgets(line, sizeof(line), file) && count < records.size()) {
+      char *p = line;
+      StatData &record = records[count++];
+      record.id = strtol(p, &p, 10);
+      record.count = (int)strtol(p + 1, &p, 10);
+      record.cost = strtof(p + 1, &p);
+      record.primary = (unsigned)strtol(p + 1, &p, 10);
+      record.mode = (unsigned)strtol(p + 1, &p, 10);
+    }
+    fclose(file);
+    benchmark::DoNotOptimize(
+        StoreDump("import_bench.dat", records.data(), count));
+  }
+  struct stat statBuf;
+  stat("import_bench.csv", &statBuf);
+  state.SetBytesProcessed(state.iterations() * statBuf.st_size);
+  state.SetItemsProcessed(state.iterations() * sortData.size());
+}
+
+static void PrintBenchFormatter(int id, const void *data, char *buffer,
+                                size_t bufferSize) {
+  const StatData *p = reinterpret_cast<const StatData *>(data);
+  int count = 0;
+  switch (id) {
+  case 0:
+    count = snprintf(buffer, bufferSize, "%lx", p->id);
+    break;
+  case 1:
+    count = snprintf(buffer, bufferSize, "%d", p->count);
+    break;
+  default:
+    count = snprintf(buffer, bufferSize, "%.3e", p->cost);
+    break;
+  }
+  buffer[count] = ' ';
+}
+
+static void InitBenchTableView(TableView *view,
+                               FormatterFunc formatter = &PrintBenchFormatter) {
+  static const char idField[] = "id";
+  static const char countField[] = "count";
+  static const char costField[] = "cost";
+  const Field fields[] = {{NULL, 0, -1, 15},
+                          {idField, sizeof(idField), 0, 15},
+                          {countField, sizeof(countField), 1, 15},
+                          {costField, sizeof(costField), 2, 15}};
+  benchmark::DoNotOptimize(
+      InitTableView(view, formatter, fields, 4));
+}
+
+// Строка и разделитель на каждую запись
+static const size_t printedBytesPerRecord = 2 * (3 + 15 * 4);
+
+static void TestPrintDumpToDevNull([[maybe_unused]] benchmark::State &state) {
+  TableView view;
+  InitBenchTableView(&view);
+
+  fflush(stdout);
+  int savedStdout = dup(STDOUT_FILENO);
+  int devNull = open("/dev/null", O_WRONLY);
+  dup2(devNull, STDOUT_FILENO);
+  for ([[maybe_unused]] const auto &_ : state) {
+    benchmark::DoNotOptimize(
+        PrintDump(sortData.data(), sortData.size(), sortData.size(), &view));
+  }
+  dup2(savedStdout, STDOUT_FILENO);
+  close(devNull);
+  close(savedStdout);
+
+  state.SetBytesProcessed(state.iterations() * sortData.size() *
+                          printedBytesPerRecord);
+  ClearTableView(&view);
+}
+
+static void TestPrintDumpToMemory([[maybe_unused]] benchmark::State &state) {
+  TableView view;
+  InitBenchTableView(&view);
+  TableMemoryBuffer memory = {};
+  SetTableViewSink(&view, MemoryTableSink(&memory));
+  for ([[maybe_unused]] const auto &_ : state) {
+    memory.size = 0;
+    benchmark::DoNotOptimize(
+        PrintDump(sortData.data(), sortData.size(), sortData.size(), &view));
+  }
+  state.SetBytesProcessed(state.iterations() * sortData.size() *
+                          printedBytesPerRecord);
+  ClearTableMemoryBuffer(&memory);
+  ClearTableView(&view);
+}
+
+static void
+TestPrintDumpToMemoryCellFormat([[maybe_unused]] benchmark::State &state) {
+  TableView view;
+  InitBenchTableView(&view, &StatDataFormatter);
+  TableMemoryBuffer memory = {};
+  SetTableViewSink(&view, MemoryTableSink(&memory));
+  for ([[maybe_unused]] const auto &_ : state) {
+    memory.size = 0;
+    benchmark::DoNotOptimize(
+        PrintDump(sortData.data(), sortData.size(), sortData.size(), &view));
+  }
+  state.SetBytesProcessed(state.iterations() * sortData.size() *
+                          printedBytesPerRecord);
+  ClearTableMemoryBuffer(&memory);
+  ClearTableView(&view);
+}
+
+// Ячейки id, count и cost каждой записи без отрисовки таблицы
+static void TestFormatCellsSnprintf([[maybe_unused]] benchmark::State &state) {
+  char buffer[16];
+  for ([[maybe_unused]] const auto &_ : state) {
+    for (const StatData &record : sortData) {
+      for (int id = 0; id < 3; ++id) {
+        PrintBenchFormatter(id, &record, buffer, sizeof(buffer) - 1);
+        benchmark::DoNotOptimize(buffer);
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * sortData.size() * 3);
+}
+
+static void
+TestFormatCellsCellFormat([[maybe_unused]] benchmark::State &state) {
+  char buffer[16];
+  for ([[maybe_unused]] const auto &_ : state) {
+    for (const StatData &record : sortData) {
+      for (int id = 0; id < 3; ++id) {
+        StatDataFormatter(id, &record, buffer, sizeof(buffer) - 1);
+        benchmark::DoNotOptimize(buffer);
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * sortData.size() * 3);
+}
+
+// Страница из середины дампа: время не должно зависеть от его размера
+static void TestPrintMappedDumpPage([[maybe_unused]] benchmark::State &state) {
+  FILE *fd = fopen("page_bench.dat", "wb+");
+  fclose(fd);
+  benchmark::DoNotOptimize(
+      StoreDump("page_bench.dat", sortData.data(), sortData.size()));
+  TableView view;
+  InitBenchTableView(&view, &StatDataFormatter);
+  TableMemoryBuffer memory = {};
+  SetTableViewSink(&view, MemoryTableSink(&memory));
+  size_t offset = sortData.size() / 2;
+  for ([[maybe_unused]] const auto &_ : state) {
+    MappedDump dump;
+    benchmark::DoNotOptimize(MapDump("page_bench.dat", 0, &dump));
+    memory.size = 0;
+    benchmark::DoNotOptimize(PrintMappedDumpPage(&dump, offset, 50, &view));
+    benchmark::DoNotOptimize(UnmapDump(&dump));
+    offset = (offset * 7 + 12345) % sortData.size();
+  }
+  ClearTableMemoryBuffer(&memory);
+  ClearTableView(&view);
+  remove("page_bench.dat");
+}
+
+static int CompareStatDataByCost(const void *lhs, const void *rhs) {
+  const StatData *sdlhs = reinterpret_cast<const StatData *>(lhs);
+  const StatData *sdrhs = reinterpret_cast<const StatData *>(rhs);
+  return (sdlhs->cost > sdrhs->cost) - (sdlhs->cost < sdrhs->cost);
+}
+
+static void TestSortDumpQsortByCost([[maybe_unused]] benchmark::State &state) {
+  std::vector<StatData> data;
+  for ([[maybe_unused]] const auto &_ : state) {
+    state.PauseTiming();
+    data = sortData;
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(
+        SortDump(data.data(), data.size(), &CompareStatDataByCost));
+  }
+}
+
+static int CompareStatDataByCostDescIdAsc(const void *lhs, const void *rhs) {
   const StatData *sdlhs = reinterpret_cast<const StatData *>(lhs);
   const StatData *sdrhs = reinterpret_cast<const StatData *>(rhs);
-  return sdlhs->cost > sdrhs->cost;
+  int byCost = (sdlhs->cost < sdrhs->cost) - (sdlhs->cost > sdrhs->cost);
+  int byId = (sdlhs->id > sdrhs->id) - (sdlhs->id < sdrhs->id);
+  return byCost != 0 ? byCost : byId;
+}
+
+static void
+TestSortDumpQsortByCostDescIdAsc([[maybe_unused]] benchmark::State &state) {
+  std::vector<StatData> data;
+  for ([[maybe_unused]] const auto &_ : state) {
+    state.PauseTiming();
+    data = sortData;
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(SortDump(data.data(), data.size(),
+                                      &CompareStatDataByCostDescIdAsc));
+  }
+}
+
+static void
+TestSortDumpByKeysCostDescIdAsc([[maybe_unused]] benchmark::State &state) {
+  const SortKeySpec keys[] = {{SORT_FIELD_COST, SORT_DESC},
+                              {SORT_FIELD_ID, SORT_ASC}};
+  std::vector<StatData> data;
+  for ([[maybe_unused]] const auto &_ : state) {
+    state.PauseTiming();
+    data = sortData;
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(
+        SortDumpByKeys(data.data(), data.size(), keys, 2));
+  }
+}
+
+static void TestSortDumpRadixByCost([[maybe_unused]] benchmark::State &state) {
+  std::vector<StatData> data;
+  for ([[maybe_unused]] const auto &_ : state) {
+    state.PauseTiming();
+    data = sortData;
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(
+        SortDumpByKey(data.data(), data.size(), SORT_FIELD_COST, SORT_ASC));
+  }
+}
+
+static void TestSortDumpRadixById([[maybe_unused]] benchmark::State &state) {
+  std::vector<StatData> data;
+  for ([[maybe_unused]] const auto &_ : state) {
+    state.PauseTiming();
+    data = sortData;
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(
+        SortDumpByKey(data.data(), data.size(), SORT_FIELD_ID, SORT_DESC));
+  }
+}
+
+static void
+TestSortDumpParallelByCost([[maybe_unused]] benchmark::State &state) {
+  std::vector<StatData> data;
+  for ([[maybe_unused]] const auto &_ : state) {
+    state.PauseTiming();
+    data = sortData;
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(SortDumpByKeyParallel(
+        data.data(), data.size(), SORT_FIELD_COST, SORT_ASC, state.range(1)));
+  }
+}
+
+static void TestArgSortAndGatherByCost(
+    [[maybe_unused]] benchmark::State &state) {
+  std::vector<uint32_t> permutation(sortData.size());
+  std::vector<StatData> data(sortData.size());
+  for ([[maybe_unused]] const auto &_ : state) {
+    benchmark::DoNotOptimize(ArgSortByKey(sortData.data(), sortData.size(),
+                                          SORT_FIELD_COST, SORT_ASC,
+                                          permutation.data()));
+    benchmark::DoNotOptimize(GatherByPermutation(
+        sortData.data(), permutation.data(), sortData.size(), data.data()));
+  }
+}
+
+static void TestArgSortByCost([[maybe_unused]] benchmark::State &state) {
+  std::vector<uint32_t> permutation(sortData.size());
+  for ([[maybe_unused]] const auto &_ : state) {
+    benchmark::DoNotOptimize(ArgSortByKey(sortData.data(), sortData.size(),
+                                          SORT_FIELD_COST, SORT_ASC,
+                                          permutation.data()));
+  }
+}
+
+static void TestTopKByCost([[maybe_unused]] benchmark::State &state) {
+  StatData top[10];
+  for ([[maybe_unused]] const auto &_ : state) {
+    benchmark::DoNotOptimize(TopKByKey(sortData.data(), sortData.size(),
+                                       SORT_FIELD_COST, SORT_DESC, top, 10));
+  }
 }
 
 static void TestJoinAndSortData([[maybe_unused]] benchmark::State &state) {
@@ -180,11 +725,275 @@ static void TestJoinAndSortData([[maybe_unused]] benchmark::State &state) {
     benchmark::DoNotOptimize(JoinDump(firstJoin.get(), state.range(0),
                                       secondJoin.get(), state.range(0), &dt,
                                       &size));
-    benchmark::DoNotOptimize(SortDump(dt, size, &SortStatDataFunc));
+    benchmark::DoNotOptimize(SortDump(dt, size, &CompareStatDataByCost));
+    free(dt);
+  }
+}
+
+// Частые небольшие объединения: без контекста каждый вызов создает таблицу
+// и вспомогательный массив сортировки, с контекстом они переиспользуются
+static void TestJoinAndSortSmall([[maybe_unused]] benchmark::State &state) {
+  for ([[maybe_unused]] const auto &_ : state) {
+    StatData *dt = NULL;
+    size_t size = 0;
+    benchmark::DoNotOptimize(JoinDump(firstJoin.get(), state.range(0),
+                                      secondJoin.get(), state.range(0), &dt,
+                                      &size));
+    benchmark::DoNotOptimize(
+        SortDumpByKey(dt, size, SORT_FIELD_COST, SORT_ASC));
+    free(dt);
+  }
+}
+
+static void
+TestJoinAndSortWithContext([[maybe_unused]] benchmark::State &state) {
+  ExecutionContext *context = CreateExecutionContext(0, NULL);
+  for ([[maybe_unused]] const auto &_ : state) {
+    StatData *dt = NULL;
+    size_t size = 0;
+    benchmark::DoNotOptimize(JoinDumpWithContext(
+        context, firstJoin.get(), state.range(0), secondJoin.get(),
+        state.range(0), &dt, &size));
+    benchmark::DoNotOptimize(SortDumpByKeyWithContext(context, dt, size,
+                                                      SORT_FIELD_COST,
+                                                      SORT_ASC));
+  }
+  DestroyExecutionContext(context);
+}
+
+// Учет выделений библиотеки (GetAllocationStats) рядом со временем: сброс
+// перед замеряемым вызовом, allocs и alloc_bytes - среднее на итерацию,
+// peak_live_bytes - максимум по итерациям. Сбор включен, поэтому время
+// сравнимо с *Instrumented, а не с обычными вариантами
+class AllocationCounters {
+public:
+  AllocationCounters() { SetInstrumentationEnabled(1); }
+
+  void Begin(benchmark::State &state) {
+    state.PauseTiming();
+    ResetInstrumentationStats();
+    state.ResumeTiming();
+  }
+
+  void End(benchmark::State &state) {
+    state.PauseTiming();
+    AllocationStats stats;
+    if (GetAllocationStats(&stats) == SUCCESS) {
+      allocations_ += (double)(stats.allocations + stats.reallocations);
+      bytes_ += (double)stats.allocatedBytes;
+      peak_ = std::max(peak_, (double)stats.peakLiveBytes);
+    }
+    state.ResumeTiming();
+  }
+
+  void Report(benchmark::State &state) {
+    SetInstrumentationEnabled(0);
+    state.counters["allocs"] =
+        benchmark::Counter(allocations_, benchmark::Counter::kAvgIterations);
+    state.counters["alloc_bytes"] = benchmark::Counter(
+        bytes_, benchmark::Counter::kAvgIterations,
+        benchmark::Counter::kIs1024);
+    state.counters["peak_live_bytes"] = benchmark::Counter(
+        peak_, benchmark::Counter::kDefaults, benchmark::Counter::kIs1024);
+  }
+
+private:
+  double allocations_ = 0;
+  double bytes_ = 0;
+  double peak_ = 0;
+};
+
+static void
+TestInsertToHashTableMemory([[maybe_unused]] benchmark::State &state) {
+  AllocationCounters counters;
+  for ([[maybe_unused]] const auto &_ : state) {
+    counters.Begin(state);
+    MergeHashTable table;
+    benchmark::DoNotOptimize(InitHashTable(&table, NULL, NULL, NULL));
+    for (size_t i = 0; i < (size_t)state.range(0); ++i) {
+      benchmark::DoNotOptimize(InsertToHashTable(&table, &firstJoin[i]));
+    }
+    counters.End(state);
+    ClearHashTable(&table);
+  }
+  counters.Report(state);
+}
+
+static void TestJoinDumpMemory([[maybe_unused]] benchmark::State &state) {
+  AllocationCounters counters;
+  for ([[maybe_unused]] const auto &_ : state) {
+    StatData *dt = NULL;
+    size_t size = 0;
+    counters.Begin(state);
+    benchmark::DoNotOptimize(JoinDump(firstJoin.get(), state.range(0),
+                                      secondJoin.get(), state.range(0), &dt,
+                                      &size));
+    counters.End(state);
     free(dt);
   }
+  counters.Report(state);
+}
+
+static void TestLoadDumpMemory([[maybe_unused]] benchmark::State &state) {
+  FILE *fd = fopen("memory_load.dat", "ab+");
+  fclose(fd);
+  benchmark::DoNotOptimize(
+      StoreDump("memory_load.dat", firstJoin.get(), state.range(0)));
+  AllocationCounters counters;
+  for ([[maybe_unused]] const auto &_ : state) {
+    StatData *data = NULL;
+    size_t size = 0;
+    counters.Begin(state);
+    benchmark::DoNotOptimize(LoadDump("memory_load.dat", &data, &size));
+    counters.End(state);
+    free(data);
+  }
+  counters.Report(state);
+  remove("memory_load.dat");
+}
+
+static void
+TestHashTableToArrayMemory([[maybe_unused]] benchmark::State &state) {
+  MergeHashTable table;
+  benchmark::DoNotOptimize(InitHashTable(&table, NULL, NULL, NULL));
+  benchmark::DoNotOptimize(
+      InsertBatchToHashTable(&table, firstJoin.get(), state.range(0)));
+  AllocationCounters counters;
+  for ([[maybe_unused]] const auto &_ : state) {
+    StatData *data = NULL;
+    size_t size = 0;
+    counters.Begin(state);
+    benchmark::DoNotOptimize(HashTableToArray(&table, &data, &size));
+    counters.End(state);
+    free(data);
+  }
+  counters.Report(state);
+  ClearHashTable(&table);
+}
+
+// Матрица Workload/<операция>/<распределение>/<строк> над GenerateWorkload().
+// Размеры задаются списком через запятую в BS_WORKLOAD_ROWS, по умолчанию
+// 1000000; генерация входа не входит в замер.
+static const char *workloadPath = "workload.dat";
+
+static void SetWorkloadThroughput(benchmark::State &state, size_t rows) {
+  state.SetItemsProcessed((int64_t)state.iterations() * (int64_t)rows);
+  state.SetBytesProcessed((int64_t)state.iterations() * (int64_t)rows *
+                          (int64_t)sizeof(StatData));
+}
+
+static void WorkloadInsert(benchmark::State &state,
+                           bench::IdDistribution distribution) {
+  const size_t rows = state.range(0);
+  std::vector<StatData> data = bench::GenerateWorkload(rows, distribution);
+  for ([[maybe_unused]] const auto &_ : state) {
+    MergeHashTable table;
+    benchmark::DoNotOptimize(
+        InitHashTableWithBuckets(&table, rows, NULL, NULL, NULL));
+    for (const StatData &record : data) {
+      benchmark::DoNotOptimize(InsertToHashTable(&table, &record));
+    }
+    ReportHashTableStats(state, &table);
+    ClearHashTable(&table);
+  }
+  SetWorkloadThroughput(state, rows);
+}
+
+static void WorkloadJoin(benchmark::State &state,
+                         bench::IdDistribution distribution) {
+  const size_t rows = state.range(0);
+  std::vector<StatData> data = bench::GenerateWorkload(rows, distribution);
+  const size_t half = rows / 2;
+  for ([[maybe_unused]] const auto &_ : state) {
+    StatData *joined = NULL;
+    size_t joinedSize = 0;
+    benchmark::DoNotOptimize(JoinDump(data.data(), half, data.data() + half,
+                                      rows - half, &joined, &joinedSize));
+    free(joined);
+  }
+  SetWorkloadThroughput(state, rows);
+}
+
+static void WorkloadSort(benchmark::State &state,
+                         bench::IdDistribution distribution) {
+  const size_t rows = state.range(0);
+  const std::vector<StatData> data =
+      bench::GenerateWorkload(rows, distribution);
+  std::vector<StatData> sorted(rows);
+  for ([[maybe_unused]] const auto &_ : state) {
+    state.PauseTiming();
+    std::copy(data.begin(), data.end(), sorted.begin());
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(
+        SortDumpByKey(sorted.data(), rows, SORT_FIELD_ID, SORT_ASC));
+  }
+  SetWorkloadThroughput(state, rows);
+}
+
+static void WorkloadStore(benchmark::State &state,
+                          bench::IdDistribution distribution) {
+  const size_t rows = state.range(0);
+  std::vector<StatData> data = bench::GenerateWorkload(rows, distribution);
+  FILE *file = fopen(workloadPath, "ab+");
+  fclose(file);
+  for ([[maybe_unused]] const auto &_ : state) {
+    benchmark::DoNotOptimize(StoreDump(workloadPath, data.data(), rows));
+  }
+  remove(workloadPath);
+  SetWorkloadThroughput(state, rows);
 }
 
+static void WorkloadLoad(benchmark::State &state,
+                         bench::IdDistribution distribution) {
+  const size_t rows = state.range(0);
+  {
+    std::vector<StatData> data = bench::GenerateWorkload(rows, distribution);
+    FILE *file = fopen(workloadPath, "ab+");
+    fclose(file);
+    if (StoreDump(workloadPath, data.data(), rows) != SUCCESS) {
+      state.SkipWithError("Cannot store workload dump");
+      return;
+    }
+  }
+  for ([[maybe_unused]] const auto &_ : state) {
+    StatData *data = NULL;
+    size_t size = 0;
+    benchmark::DoNotOptimize(LoadDump(workloadPath, &data, &size));
+    free(data);
+  }
+  remove(workloadPath);
+  SetWorkloadThroughput(state, rows);
+}
+
+static int RegisterWorkloadBenchmarks() {
+  using WorkloadFunction = void (*)(benchmark::State &, bench::IdDistribution);
+  const struct {
+    const char *name;
+    WorkloadFunction function;
+  } operations[] = {{"insert", &WorkloadInsert},
+                    {"join", &WorkloadJoin},
+                    {"sort", &WorkloadSort},
+                    {"store", &WorkloadStore},
+                    {"load", &WorkloadLoad}};
+  const std::vector<int64_t> rows =
+      bench::RowsFromEnvironment("BS_WORKLOAD_ROWS", 1000000);
+  for (const auto &operation : operations) {
+    for (bench::IdDistribution distribution : bench::allIdDistributions) {
+      std::string name = std::string("Workload/") + operation.name + "/" +
+                         bench::IdDistributionName(distribution);
+      auto *registered = benchmark::RegisterBenchmark(
+          name.c_str(), operation.function, distribution);
+      for (int64_t count : rows) {
+        registered->Arg(count);
+      }
+      registered->Unit(benchmark::kMillisecond)->UseRealTime();
+    }
+  }
+  return 0;
+}
+
+static const int workloadRegistered = RegisterWorkloadBenchmarks();
+
 BENCHMARK(TestInsertElementsWithUniquesId)
     ->Arg(0)
     ->Arg(1000)
@@ -214,6 +1023,55 @@ BENCHMARK(TestInsertElementsWithRandomId)
     ->Setup(DoSetup)
     ->Teardown(DoTeardown);
 
+BENCHMARK(TestBatchInsertWithNonUniquesId)
+    ->Arg(0)
+    ->Arg(1000)
+    ->Arg(50000)
+    ->Arg(100000)
+    ->Arg(200000)
+    ->Arg(500000)
+    ->Iterations(10);
+
+BENCHMARK(TestSpecializedInsertWithNonUniquesId)
+    ->Arg(0)
+    ->Arg(1000)
+    ->Arg(50000)
+    ->Arg(100000)
+    ->Arg(200000)
+    ->Arg(500000)
+    ->Iterations(10);
+
+BENCHMARK(TestSpecializedInsertWithRandomId)
+    ->Arg(0)
+    ->Arg(1000)
+    ->Arg(50000)
+    ->Arg(100000)
+    ->Arg(200000)
+    ->Arg(500000)
+    ->Iterations(10)
+    ->Setup(DoSetup)
+    ->Teardown(DoTeardown);
+
+BENCHMARK(TestTemplateInsertWithNonUniquesId)
+    ->Arg(0)
+    ->Arg(1000)
+    ->Arg(50000)
+    ->Arg(100000)
+    ->Arg(200000)
+    ->Arg(500000)
+    ->Iterations(10);
+
+BENCHMARK(TestTemplateInsertWithRandomId)
+    ->Arg(0)
+    ->Arg(1000)
+    ->Arg(50000)
+    ->Arg(100000)
+    ->Arg(200000)
+    ->Arg(500000)
+    ->Iterations(10)
+    ->Setup(DoSetup)
+    ->Teardown(DoTeardown);
+
 BENCHMARK(TestStoreAndLoadDataWithRandomIDs)
     ->Arg(0)
     ->Arg(1000)
@@ -236,6 +1094,83 @@ BENCHMARK(TestJoinData)
     ->Setup(DoSetupJoin)
     ->Teardown(DoTeardownJoin);
 
+BENCHMARK(TestJoinDataToFile)
+    ->Arg(0)
+    ->Arg(1000)
+    ->Arg(50000)
+    ->Arg(100000)
+    ->Arg(200000)
+    ->Arg(500000)
+    ->Iterations(10)
+    ->Setup(DoSetupJoin)
+    ->Teardown(DoTeardownJoin);
+
+BENCHMARK(TestJoinDataInstrumented)
+    ->Arg(0)
+    ->Arg(1000)
+    ->Arg(50000)
+    ->Arg(100000)
+    ->Arg(200000)
+    ->Arg(500000)
+    ->Iterations(10)
+    ->Setup(DoSetupJoin)
+    ->Teardown(DoTeardownJoin);
+
+BENCHMARK(TestInsertRandomIdInstrumented)
+    ->Arg(0)
+    ->Arg(1000)
+    ->Arg(50000)
+    ->Arg(100000)
+    ->Arg(200000)
+    ->Arg(500000)
+    ->Iterations(10)
+    ->Setup(DoSetup)
+    ->Teardown(DoTeardown);
+
+BENCHMARK(TestInsertToHashTableMemory)
+    ->Arg(0)
+    ->Arg(1000)
+    ->Arg(50000)
+    ->Arg(100000)
+    ->Arg(200000)
+    ->Arg(500000)
+    ->Iterations(10)
+    ->Setup(DoSetupJoin)
+    ->Teardown(DoTeardownJoin);
+
+BENCHMARK(TestJoinDumpMemory)
+    ->Arg(0)
+    ->Arg(1000)
+    ->Arg(50000)
+    ->Arg(100000)
+    ->Arg(200000)
+    ->Arg(500000)
+    ->Iterations(10)
+    ->Setup(DoSetupJoin)
+    ->Teardown(DoTeardownJoin);
+
+BENCHMARK(TestLoadDumpMemory)
+    ->Arg(0)
+    ->Arg(1000)
+    ->Arg(50000)
+    ->Arg(100000)
+    ->Arg(200000)
+    ->Arg(500000)
+    ->Iterations(10)
+    ->Setup(DoSetupJoin)
+    ->Teardown(DoTeardownJoin);
+
+BENCHMARK(TestHashTableToArrayMemory)
+    ->Arg(0)
+    ->Arg(1000)
+    ->Arg(50000)
+    ->Arg(100000)
+    ->Arg(200000)
+    ->Arg(500000)
+    ->Iterations(10)
+    ->Setup(DoSetupJoin)
+    ->Teardown(DoTeardownJoin);
+
 BENCHMARK(TestJoinAndSortData)
     ->Arg(0)
     ->Arg(1000)
@@ -245,4 +1180,177 @@ BENCHMARK(TestJoinAndSortData)
     ->Arg(500000)
     ->Iterations(10)
     ->Setup(DoSetupJoin)
-    ->Teardown(DoTeardownJoin);
\ No newline at end of file
+    ->Teardown(DoTeardownJoin);
+
+BENCHMARK(TestJoinAndSortSmall)
+    ->Arg(16)
+    ->Arg(128)
+    ->Arg(1000)
+    ->Setup(DoSetupJoin)
+    ->Teardown(DoTeardownJoin);
+
+BENCHMARK(TestJoinAndSortWithContext)
+    ->Arg(16)
+    ->Arg(128)
+    ->Arg(1000)
+    ->Setup(DoSetupJoin)
+    ->Teardown(DoTeardownJoin);
+
+BENCHMARK(TestSortDumpQsortByCost)
+    ->Arg(1000)
+    ->Arg(100000)
+    ->Arg(1000000)
+    ->Arg(10000000)
+    ->Iterations(3)
+    ->Setup(DoSetupSort)
+    ->Teardown(DoTeardownSort);
+
+BENCHMARK(TestSortDumpRadixByCost)
+    ->Arg(1000)
+    ->Arg(100000)
+    ->Arg(1000000)
+    ->Arg(10000000)
+    ->Iterations(3)
+    ->Setup(DoSetupSort)
+    ->Teardown(DoTeardownSort);
+
+BENCHMARK(TestSortDumpRadixById)
+    ->Arg(1000)
+    ->Arg(100000)
+    ->Arg(1000000)
+    ->Arg(10000000)
+    ->Iterations(3)
+    ->Setup(DoSetupSort)
+    ->Teardown(DoTeardownSort);
+
+BENCHMARK(TestSortDumpParallelByCost)
+    ->ArgsProduct({{1000000, 10000000, 100000000}, {1, 2, 4, 8}})
+    ->Iterations(3)
+    ->UseRealTime()
+    ->Setup(DoSetupSort)
+    ->Teardown(DoTeardownSort);
+
+BENCHMARK(TestTopKByCost)
+    ->Arg(1000)
+    ->Arg(100000)
+    ->Arg(1000000)
+    ->Arg(10000000)
+    ->Iterations(3)
+    ->Setup(DoSetupSort)
+    ->Teardown(DoTeardownSort);
+
+BENCHMARK(TestArgSortByCost)
+    ->Arg(1000)
+    ->Arg(100000)
+    ->Arg(1000000)
+    ->Arg(10000000)
+    ->Iterations(3)
+    ->Setup(DoSetupSort)
+    ->Teardown(DoTeardownSort);
+
+BENCHMARK(TestArgSortAndGatherByCost)
+    ->Arg(1000)
+    ->Arg(100000)
+    ->Arg(1000000)
+    ->Arg(10000000)
+    ->Iterations(3)
+    ->Setup(DoSetupSort)
+    ->Teardown(DoTeardownSort);
+
+BENCHMARK(TestSortDumpQsortByCostDescIdAsc)
+    ->Arg(1000)
+    ->Arg(100000)
+    ->Arg(1000000)
+    ->Iterations(3)
+    ->Setup(DoSetupSort)
+    ->Teardown(DoTeardownSort);
+
+BENCHMARK(TestSortDumpByKeysCostDescIdAsc)
+    ->Arg(1000)
+    ->Arg(100000)
+    ->Arg(1000000)
+    ->Iterations(3)
+    ->Setup(DoSetupSort)
+    ->Teardown(DoTeardownSort);
+
+BENCHMARK(TestSortDumpExternalByCost)
+    ->Args({1000000, 4})
+    ->Args({1000000, 64})
+    ->Args({10000000, 16})
+    ->Args({10000000, 256})
+    ->Iterations(1)
+    ->UseRealTime()
+    ->Setup(DoSetupSort)
+    ->Teardown(DoTeardownSort);
+
+BENCHMARK(TestExportDump)
+    ->Args({1000000, TEXT_FORMAT_CSV})
+    ->Args({1000000, TEXT_FORMAT_JSON_LINES})
+    ->Args({10000000, TEXT_FORMAT_CSV})
+    ->Iterations(3)
+    ->UseRealTime()
+    ->Setup(DoSetupSort)
+    ->Teardown(DoTeardownSort);
+
+BENCHMARK(TestImportDump)
+    ->Arg(1000000)
+    ->Arg(10000000)
+    ->Iterations(3)
+    ->UseRealTime()
+    ->Setup(DoSetupImport)
+    ->Teardown(DoTeardownImport);
+
+BENCHMARK(TestImportWithStrtod)
+    ->Arg(1000000)
+    ->Iterations(3)
+    ->UseRealTime()
+    ->Setup(DoSetupImport)
+    ->Teardown(DoTeardownImport);
+
+BENCHMARK(TestPrintMappedDumpPage)
+    ->Arg(1000000)
+    ->Arg(10000000)
+    ->Iterations(100)
+    ->UseRealTime()
+    ->Setup(DoSetupSort)
+    ->Teardown(DoTeardownSort);
+
+BENCHMARK(TestPrintDumpToDevNull)
+    ->Arg(1000)
+    ->Arg(1000000)
+    ->Iterations(3)
+    ->UseRealTime()
+    ->Setup(DoSetupSort)
+    ->Teardown(DoTeardownSort);
+
+BENCHMARK(TestPrintDumpToMemory)
+    ->Arg(1000)
+    ->Arg(1000000)
+    ->Iterations(3)
+    ->UseRealTime()
+    ->Setup(DoSetupSort)
+    ->Teardown(DoTeardownSort);
+
+BENCHMARK(TestPrintDumpToMemoryCellFormat)
+    ->Arg(1000)
+    ->Arg(1000000)
+    ->Iterations(3)
+    ->UseRealTime()
+    ->Setup(DoSetupSort)
+    ->Teardown(DoTeardownSort);
+
+BENCHMARK(TestFormatCellsSnprintf)
+    ->Arg(1000)
+    ->Arg(1000000)
+    ->Iterations(3)
+    ->UseRealTime()
+    ->Setup(DoSetupSort)
+    ->Teardown(DoTeardownSort);
+
+BENCHMARK(TestFormatCellsCellFormat)
+    ->Arg(1000)
+    ->Arg(1000000)
+    ->Iterations(3)
+    ->UseRealTime()
+    ->Setup(DoSetupSort)
+    ->Teardown(DoTeardownSort);
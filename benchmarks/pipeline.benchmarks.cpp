@@ -0,0 +1,364 @@
+#include "BinarySerializer/binarySerializer.h"
+#include "BinarySerializer/cellFormat.h"
+#include "BinarySerializer/joinPipeline.h"
+#include "BinarySerializer/mappedDump.h"
+#include "BinarySerializer/sortDump.h"
+#include "BinarySerializer/tableView.h"
+#include "workload.hpp"
+
+#include <benchmark/benchmark.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(BS_ENABLE_MI_MALLOC)
+#include <mimalloc-override.h>
+#else
+#include <stdlib.h>
+#endif
+
+// Сквозной прогон сценария serializeData (cli/app/main.c): загрузка двух
+// дампов -> объединение -> сортировка по cost -> вывод 10 строк -> запись.
+// Pipeline/<вариант>/<хранилище>/<строк в каждом входе>: варианты - разные
+// наборы функций библиотеки для тех же стадий, хранилище - tmpfs
+// (BS_PIPELINE_TMPFS, по умолчанию /dev/shm) или диск (BS_PIPELINE_DISK, по
+// умолчанию текущий каталог). Размеры задаются в BS_PIPELINE_ROWS.
+
+namespace {
+
+enum PipelineStage {
+  STAGE_LOAD,
+  STAGE_JOIN,
+  STAGE_SORT,
+  STAGE_PRINT,
+  STAGE_STORE,
+  STAGES_COUNT
+};
+
+const char *const stageCounters[STAGES_COUNT] = {
+    "load_ms", "join_ms", "sort_ms", "print_ms", "store_ms"};
+
+constexpr size_t printLinesCount = 10;
+
+/**
+ * @brief Замер стадий одной итерации
+ */
+class StageClock {
+public:
+  void Start() { last_ = std::chrono::steady_clock::now(); }
+
+  /** @brief Завершает стадию stage и начинает следующую */
+  void Finish(PipelineStage stage) {
+    auto now = std::chrono::steady_clock::now();
+    milliseconds_[stage] +=
+        std::chrono::duration<double, std::milli>(now - last_).count();
+    last_ = now;
+  }
+
+  double Milliseconds(PipelineStage stage) const {
+    return milliseconds_[stage];
+  }
+
+private:
+  std::chrono::steady_clock::time_point last_;
+  double milliseconds_[STAGES_COUNT] = {};
+};
+
+struct PipelinePaths {
+  std::string first;
+  std::string second;
+  std::string result;
+};
+
+/**
+ * @brief Вариант конвейера, возвращает 0 при ошибке любой стадии
+ */
+using PipelineFunction = int (*)(const PipelinePaths &, TableView *,
+                                 StageClock &);
+
+// Исходный сценарий: все стадии через массивы в памяти
+int StockPipeline(const PipelinePaths &paths, TableView *view,
+                  StageClock &clock) {
+  StatData *first = NULL;
+  StatData *second = NULL;
+  size_t firstSize = 0;
+  size_t secondSize = 0;
+  StatData *joined = NULL;
+  size_t joinedSize = 0;
+  int ok = LoadDump(paths.first.c_str(), &first, &firstSize) == SUCCESS &&
+           LoadDump(paths.second.c_str(), &second, &secondSize) == SUCCESS;
+  clock.Finish(STAGE_LOAD);
+  ok = ok && JoinDump(first, firstSize, second, secondSize, &joined,
+                      &joinedSize) == SUCCESS;
+  clock.Finish(STAGE_JOIN);
+  ok = ok && SortDumpByKey(joined, joinedSize, SORT_FIELD_COST, SORT_ASC) ==
+                 SUCCESS;
+  clock.Finish(STAGE_SORT);
+  ok = ok && PrintDump(joined, joinedSize, printLinesCount, view) == SUCCESS;
+  clock.Finish(STAGE_PRINT);
+  ok = ok && StoreDump(paths.result.c_str(), joined, joinedSize) == SUCCESS;
+  clock.Finish(STAGE_STORE);
+  free(first);
+  free(second);
+  free(joined);
+  return ok;
+}
+
+// Сортировка, вывод и запись прямо в отображении результата, как в
+// serializeData
+int JoinToFilePipelineTail(const StatData *first, size_t firstSize,
+                           const StatData *second, size_t secondSize,
+                           const PipelinePaths &paths, TableView *view,
+                           StageClock &clock) {
+  MappedDump result = {NULL, 0, 0, -1, 0};
+  int ok = JoinDumpToFile(first, firstSize, second, secondSize,
+                          paths.result.c_str(), &result) == SUCCESS;
+  clock.Finish(STAGE_JOIN);
+  if (!ok) {
+    return 0;
+  }
+  ok = SortDumpByKeyParallel(result.data, result.size, SORT_FIELD_COST,
+                             SORT_ASC, 0) == SUCCESS;
+  clock.Finish(STAGE_SORT);
+  ok = ok && PrintDump(result.data, result.size, printLinesCount, view) ==
+                 SUCCESS;
+  clock.Finish(STAGE_PRINT);
+  ok = UnmapDump(&result) == SUCCESS && ok;
+  clock.Finish(STAGE_STORE);
+  return ok;
+}
+
+int CliPipeline(const PipelinePaths &paths, TableView *view,
+                StageClock &clock) {
+  StatData *first = NULL;
+  StatData *second = NULL;
+  size_t firstSize = 0;
+  size_t secondSize = 0;
+  int ok = LoadDump(paths.first.c_str(), &first, &firstSize) == SUCCESS &&
+           LoadDump(paths.second.c_str(), &second, &secondSize) == SUCCESS;
+  clock.Finish(STAGE_LOAD);
+  ok = ok && JoinToFilePipelineTail(first, firstSize, second, secondSize,
+                                    paths, view, clock);
+  free(first);
+  free(second);
+  return ok;
+}
+
+// Входы читаются из отображений без копирования
+int MappedPipeline(const PipelinePaths &paths, TableView *view,
+                   StageClock &clock) {
+  MappedDump first = {NULL, 0, 0, -1, 0};
+  MappedDump second = {NULL, 0, 0, -1, 0};
+  int firstMapped = MapDump(paths.first.c_str(), 0, &first) == SUCCESS;
+  int secondMapped = MapDump(paths.second.c_str(), 0, &second) == SUCCESS;
+  clock.Finish(STAGE_LOAD);
+  int ok = firstMapped && secondMapped &&
+           JoinToFilePipelineTail(first.data, first.size, second.data,
+                                  second.size, paths, view, clock);
+  if (firstMapped) {
+    BINARYSERIALIZER_UNUSED(UnmapDump(&first));
+  }
+  if (secondMapped) {
+    BINARYSERIALIZER_UNUSED(UnmapDump(&second));
+  }
+  return ok;
+}
+
+// StartJoinPipeline(): загрузка, объединение, сортировка и запись
+// перекрываются, поэтому их общее время учитывается в store_ms
+int AsyncPipeline(const PipelinePaths &paths, TableView *view,
+                  StageClock &clock) {
+  JoinPipeline *pipeline = NULL;
+  JoinPipelineResult result = {};
+  int ok = StartJoinPipeline(paths.first.c_str(), paths.second.c_str(),
+                             paths.result.c_str(), NULL, &pipeline) == SUCCESS;
+  ok = ok && WaitJoinPipeline(pipeline, &result) == SUCCESS;
+  clock.Finish(STAGE_STORE);
+  ok = ok && PrintDump(result.data, result.size, printLinesCount, view) ==
+                 SUCCESS;
+  clock.Finish(STAGE_PRINT);
+  free(result.data);
+  return ok;
+}
+
+const struct {
+  const char *name;
+  PipelineFunction function;
+} pipelineVariants[] = {{"stock", &StockPipeline},
+                        {"cli", &CliPipeline},
+                        {"mapped", &MappedPipeline},
+                        {"async", &AsyncPipeline}};
+
+struct PipelineStorage {
+  const char *name;
+  const char *variable;
+  const char *fallback;
+};
+
+const PipelineStorage pipelineStorages[] = {
+    {"tmpfs", "BS_PIPELINE_TMPFS", "/dev/shm"},
+    {"disk", "BS_PIPELINE_DISK", "."}};
+
+std::string StorageDirectory(const PipelineStorage &storage) {
+  const char *directory = getenv(storage.variable);
+  return directory && *directory ? directory : storage.fallback;
+}
+
+int CreateDumpFile(const std::string &path) {
+  int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1) {
+    return 0;
+  }
+  close(fd);
+  return 1;
+}
+
+// Вытесняет файл из page cache, чтобы загрузка с диска читала устройство.
+// На tmpfs ничего не делает: страницы и есть хранилище
+void DropFromPageCache(const std::string &path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    return;
+  }
+  fdatasync(fd);
+  BINARYSERIALIZER_UNUSED(posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED));
+  close(fd);
+}
+
+// Пиковый RSS процесса (VmHWM) в байтах. Запись "5" в clear_refs
+// сбрасывает пик до текущего RSS, иначе значение накоплено с начала процесса
+void ResetPeakRss() {
+  int fd = open("/proc/self/clear_refs", O_WRONLY);
+  if (fd != -1) {
+    BINARYSERIALIZER_UNUSED(write(fd, "5", 1));
+    close(fd);
+  }
+}
+
+double PeakRssBytes() {
+  FILE *status = fopen("/proc/self/status", "r");
+  if (!status) {
+    return 0;
+  }
+  char line[256];
+  double kilobytes = 0;
+  while (fgets(line, sizeof(line), status)) {
+    if (strncmp(line, "VmHWM:", 6) == 0) {
+      kilobytes = strtod(line + 6, NULL);
+      break;
+    }
+  }
+  fclose(status);
+  return kilobytes * 1024;
+}
+
+TablewViewStatus InitPipelineTableView(TableView *view) {
+  static const char idField[] = "id";
+  static const char countField[] = "count";
+  static const char costField[] = "cost";
+  static const char primaryField[] = "primary";
+  static const char modeField[] = "mode";
+  const Field fields[] = {
+      {NULL, 0, STAT_DATA_COLUMN_NUMBER, 15},
+      {idField, sizeof(idField), STAT_DATA_COLUMN_ID, 15},
+      {countField, sizeof(countField), STAT_DATA_COLUMN_COUNT, 15},
+      {costField, sizeof(costField), STAT_DATA_COLUMN_COST, 15},
+      {primaryField, sizeof(primaryField), STAT_DATA_COLUMN_PRIMARY, 9},
+      {modeField, sizeof(modeField), STAT_DATA_COLUMN_MODE, 6},
+  };
+  return InitTableView(view, &StatDataFormatter, fields,
+                       sizeof(fields) / sizeof(Field));
+}
+
+void Pipeline(benchmark::State &state, PipelineFunction function,
+              const PipelineStorage *storage) {
+  const size_t rows = state.range(0);
+  const std::string directory = StorageDirectory(*storage);
+  const std::string prefix = directory + "/pipeline_" + storage->name;
+  const PipelinePaths paths = {prefix + "_first.dat", prefix + "_second.dat",
+                               prefix + "_result.dat"};
+  const int disk = strcmp(storage->name, "disk") == 0;
+
+  // Входы пересекаются по id наполовину: равномерные id из [0, rows) с
+  // разными seed
+  for (const auto &[path, seed] :
+       {std::pair{paths.first, 1u}, std::pair{paths.second, 2u}}) {
+    std::vector<StatData> data =
+        bench::GenerateWorkload(rows, bench::IdDistribution::Uniform, seed);
+    if (!CreateDumpFile(path) ||
+        StoreDump(path.c_str(), data.data(), rows) != SUCCESS) {
+      state.SkipWithError(("Cannot create input in " + directory).c_str());
+      return;
+    }
+  }
+  if (!CreateDumpFile(paths.result)) {
+    state.SkipWithError(("Cannot create result in " + directory).c_str());
+    return;
+  }
+
+  TableView view;
+  if (InitPipelineTableView(&view) != TVS_SUCCESS) {
+    state.SkipWithError("Cannot initTableView");
+    return;
+  }
+  int devNull = open("/dev/null", O_WRONLY);
+  SetTableViewSink(&view, FdTableSink(devNull));
+
+  StageClock clock;
+  ResetPeakRss();
+  for ([[maybe_unused]] const auto &_ : state) {
+    if (disk) {
+      state.PauseTiming();
+      DropFromPageCache(paths.first);
+      DropFromPageCache(paths.second);
+      state.ResumeTiming();
+    }
+    clock.Start();
+    if (!function(paths, &view, clock)) {
+      state.SkipWithError("Pipeline stage failed");
+      break;
+    }
+  }
+  state.counters["peak_rss_mb"] = PeakRssBytes() / (1024.0 * 1024.0);
+
+  for (int stage = 0; stage < STAGES_COUNT; ++stage) {
+    state.counters[stageCounters[stage]] =
+        benchmark::Counter(clock.Milliseconds((PipelineStage)stage),
+                           benchmark::Counter::kAvgIterations);
+  }
+  state.SetItemsProcessed((int64_t)state.iterations() * 2 * (int64_t)rows);
+  state.SetBytesProcessed((int64_t)state.iterations() * 2 * (int64_t)rows *
+                          (int64_t)sizeof(StatData));
+
+  ClearTableView(&view);
+  close(devNull);
+  remove(paths.first.c_str());
+  remove(paths.second.c_str());
+  remove(paths.result.c_str());
+}
+
+int RegisterPipelineBenchmarks() {
+  const std::vector<int64_t> rows =
+      bench::RowsFromEnvironment("BS_PIPELINE_ROWS", 1000000);
+  for (const auto &variant : pipelineVariants) {
+    for (const PipelineStorage &storage : pipelineStorages) {
+      std::string name =
+          std::string("Pipeline/") + variant.name + "/" + storage.name;
+      auto *registered = benchmark::RegisterBenchmark(
+          name.c_str(), &Pipeline, variant.function, &storage);
+      for (int64_t count : rows) {
+        registered->Arg(count);
+      }
+      registered->Unit(benchmark::kMillisecond)->UseRealTime();
+    }
+  }
+  return 0;
+}
+
+const int pipelineRegistered = RegisterPipelineBenchmarks();
+
+} // namespace
@@ -0,0 +1,199 @@
+#include "workload.hpp"
+
+#include <cmath>
+#include <cstdlib>
+
+namespace bench {
+namespace {
+
+/**
+ * @brief SplitMix64: быстрый генератор с одинаковым выходом на всех
+ * платформах
+ */
+class SplitMix64 {
+public:
+  explicit SplitMix64(std::uint64_t seed) : state_(seed) {}
+
+  std::uint64_t Next() {
+    std::uint64_t z = (state_ += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  /** @brief Равномерно в [0, bound) */
+  std::uint64_t Below(std::uint64_t bound) {
+    return (std::uint64_t)(((unsigned __int128)Next() * bound) >> 64);
+  }
+
+  /** @brief Равномерно в [0, 1) */
+  double Unit() { return (double)(Next() >> 11) * 0x1.0p-53; }
+
+private:
+  std::uint64_t state_;
+};
+
+/**
+ * @brief Выборка ранга из закона Ципфа на [1, n] методом rejection-inversion
+ *
+ * W. Hormann, G. Derflinger, "Rejection-inversion to generate variates from
+ * monotone discrete distributions": O(1) на выборку без таблицы вероятностей,
+ * поэтому подходит для сотен миллионов различных id.
+ */
+class ZipfSampler {
+public:
+  ZipfSampler(std::uint64_t n, double exponent)
+      : n_(n), exponent_(exponent),
+        hIntegralX1_(HIntegral(1.5) - 1.0),
+        hIntegralN_(HIntegral((double)n + 0.5)),
+        s_(2.0 - HIntegralInverse(HIntegral(2.5) - H(2.0))) {}
+
+  std::uint64_t Sample(SplitMix64 &random) const {
+    for (;;) {
+      double u = hIntegralN_ + random.Unit() * (hIntegralX1_ - hIntegralN_);
+      double x = HIntegralInverse(u);
+      double k = std::floor(x + 0.5);
+      if (k < 1.0) {
+        k = 1.0;
+      } else if (k > (double)n_) {
+        k = (double)n_;
+      }
+      if (k - x <= s_ || u >= HIntegral(k + 0.5) - H(k)) {
+        return (std::uint64_t)k;
+      }
+    }
+  }
+
+private:
+  static double Helper1(double x) {
+    return std::fabs(x) > 1e-8 ? std::log1p(x) / x
+                               : 1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+  }
+
+  static double Helper2(double x) {
+    return std::fabs(x) > 1e-8
+               ? std::expm1(x) / x
+               : 1.0 + x * 0.5 * (1.0 + x * (1.0 / 3.0) * (1.0 + 0.25 * x));
+  }
+
+  double H(double x) const { return std::exp(-exponent_ * std::log(x)); }
+
+  double HIntegral(double x) const {
+    double logX = std::log(x);
+    return Helper2((1.0 - exponent_) * logX) * logX;
+  }
+
+  double HIntegralInverse(double x) const {
+    double t = x * (1.0 - exponent_);
+    if (t < -1.0) {
+      t = -1.0;
+    }
+    return std::exp(Helper1(t) * x);
+  }
+
+  std::uint64_t n_;
+  double exponent_;
+  double hIntegralX1_;
+  double hIntegralN_;
+  double s_;
+};
+
+// Hot ranks are spread over the id space instead of being 1, 2, 3...:
+// multiplication by an odd constant is a bijection modulo 2^62
+long ScrambleRank(std::uint64_t rank) {
+  return (long)((rank * 0x9e3779b97f4a7c15ULL) & ((1ULL << 62) - 1));
+}
+
+constexpr std::size_t clusterRecords = 1024;
+constexpr std::uint64_t clusterWidth = 256;
+constexpr double zipfExponent = 1.1;
+
+} // namespace
+
+const char *IdDistributionName(IdDistribution distribution) {
+  switch (distribution) {
+  case IdDistribution::Uniform:
+    return "uniform";
+  case IdDistribution::Zipf:
+    return "zipf";
+  case IdDistribution::Sorted:
+    return "sorted";
+  case IdDistribution::ReverseSorted:
+    return "reverse";
+  case IdDistribution::Clustered:
+    return "clustered";
+  case IdDistribution::AllDuplicates:
+    return "duplicates";
+  }
+  return "unknown";
+}
+
+void GenerateWorkload(StatData *data, std::size_t size,
+                      IdDistribution distribution, std::uint64_t seed) {
+  SplitMix64 random(seed);
+  ZipfSampler zipf(size ? size : 1, zipfExponent);
+  std::uint64_t clusterBase = 0;
+  for (std::size_t i = 0; i < size; ++i) {
+    long id = 0;
+    switch (distribution) {
+    case IdDistribution::Uniform:
+      id = (long)random.Below(size);
+      break;
+    case IdDistribution::Zipf:
+      id = ScrambleRank(zipf.Sample(random));
+      break;
+    case IdDistribution::Sorted:
+      id = (long)i;
+      break;
+    case IdDistribution::ReverseSorted:
+      id = (long)(size - 1 - i);
+      break;
+    case IdDistribution::Clustered:
+      if (i % clusterRecords == 0) {
+        clusterBase = random.Below(size);
+      }
+      id = (long)(clusterBase + random.Below(clusterWidth));
+      break;
+    case IdDistribution::AllDuplicates:
+      id = 42;
+      break;
+    }
+    std::uint64_t bits = random.Next();
+    data[i].id = id;
+    data[i].count = (int)(bits % 100) + 1;
+    data[i].cost = (float)((bits >> 8) % 1000000) / 100.0f;
+    data[i].primary = (bits >> 40) & 1;
+    data[i].mode = (bits >> 41) & 7;
+  }
+}
+
+std::vector<StatData> GenerateWorkload(std::size_t size,
+                                       IdDistribution distribution,
+                                       std::uint64_t seed) {
+  std::vector<StatData> data(size);
+  GenerateWorkload(data.data(), size, distribution, seed);
+  return data;
+}
+
+std::vector<std::int64_t> RowsFromEnvironment(const char *variable,
+                                              std::int64_t fallback) {
+  std::vector<std::int64_t> rows;
+  const char *env = std::getenv(variable);
+  for (const char *p = env; p && *p;) {
+    char *end = nullptr;
+    long long value = std::strtoll(p, &end, 10);
+    if (end == p) {
+      break;
+    }
+    if (value > 0) {
+      rows.push_back(value);
+    }
+    p = *end == ',' ? end + 1 : end;
+  }
+  if (rows.empty()) {
+    rows.push_back(fallback);
+  }
+  return rows;
+}
+
+} // namespace bench
@@ -0,0 +1,83 @@
+/**
+ * @file workload.hpp
+ * @brief Генератор наборов StatData с распределениями id, близкими к
+ * реальному трафику
+ * @author Melpomenna
+ * @version 1.0
+ * @date 18.10.2026
+ *
+ * Используется бенчмарками для воспроизводимых входов: результат зависит
+ * только от распределения, размера и seed и не зависит от стандартной
+ * библиотеки (std::*_distribution дают разные последовательности в разных
+ * реализациях).
+ */
+
+#ifndef BINARYSERIALIZER_BENCHMARKS_WORKLOAD_HPP
+#define BINARYSERIALIZER_BENCHMARKS_WORKLOAD_HPP
+
+#include "BinarySerializer/statData.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bench {
+
+/**
+ * @brief Распределение id в генерируемом наборе
+ */
+enum class IdDistribution {
+  Uniform,       /**< Равномерно в [0, size) */
+  Zipf,          /**< Закон Ципфа с показателем 1.1 над size различными id */
+  Sorted,        /**< 0, 1, ..., size - 1 */
+  ReverseSorted, /**< size - 1, ..., 1, 0 */
+  Clustered, /**< Серии по 1024 записи из окна в 256 соседних id */
+  AllDuplicates /**< Все записи с одним id */
+};
+
+/** @brief Все распределения, в порядке перечисления */
+inline constexpr IdDistribution allIdDistributions[] = {
+    IdDistribution::Uniform,   IdDistribution::Zipf,
+    IdDistribution::Sorted,    IdDistribution::ReverseSorted,
+    IdDistribution::Clustered, IdDistribution::AllDuplicates};
+
+/**
+ * @brief Имя распределения для названий бенчмарков ("zipf", "sorted", ...)
+ */
+const char *IdDistributionName(IdDistribution distribution);
+
+/**
+ * @brief Заполняет data записями с заданным распределением id
+ *
+ * count равномерно в [1, 100], cost равномерно в [0, 10000), primary и
+ * mode случайны.
+ *
+ * @param[out] data Буфер на size записей
+ * @param[in] size Количество записей
+ * @param[in] distribution Распределение id
+ * @param[in] seed Начальное значение генератора
+ */
+void GenerateWorkload(StatData *data, std::size_t size,
+                      IdDistribution distribution, std::uint64_t seed = 42);
+
+/**
+ * @brief Вариант GenerateWorkload() с выделением вектора
+ */
+std::vector<StatData> GenerateWorkload(std::size_t size,
+                                       IdDistribution distribution,
+                                       std::uint64_t seed = 42);
+
+/**
+ * @brief Список размеров входа из переменной окружения
+ *
+ * @param[in] variable Имя переменной со списком чисел через запятую
+ * @param[in] fallback Размер, если переменная не задана или пуста
+ *
+ * @return Положительные значения из переменной или {fallback}
+ */
+std::vector<std::int64_t> RowsFromEnvironment(const char *variable,
+                                              std::int64_t fallback);
+
+} // namespace bench
+
+#endif // BINARYSERIALIZER_BENCHMARKS_WORKLOAD_HPP
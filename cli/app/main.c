@@ -1,4 +1,10 @@
 #include "BinarySerializer/binarySerializer.h"
+#include "BinarySerializer/cellFormat.h"
+#include "BinarySerializer/dumpText.h"
+#include "BinarySerializer/instrumentation.h"
+#include "BinarySerializer/joinPipeline.h"
+#include "BinarySerializer/mappedDump.h"
+#include "BinarySerializer/sortDump.h"
 #include "BinarySerializer/tableView.h"
 #include "utility/colorFormat.h"
 
@@ -8,86 +14,189 @@
 #include <stdlib.h>
 #endif
 
-#include <assert.h>
 #include <stdio.h>
 #include <string.h>
 
-typedef enum Columns {
-  NUMBER = -1,
-  ID = 0,
-  COUNT,
-  COST,
-  PRIMARY,
-  MODE
-} Columns;
-
-static void PrintStatDataFormatter(int id, const void *__restrict data,
-                                   char *__restrict buffer, size_t bufferSize) {
-  const StatData *p = data;
-  size_t count = 0;
-  switch (id) {
-  case ID: {
-    count = snprintf(buffer, bufferSize, "%lx", p->id);
-    break;
-  }
-  case COUNT: {
-    count = snprintf(buffer, bufferSize, "%d", p->count);
-    break;
-  }
-  case COST: {
-    count = snprintf(buffer, bufferSize, "%.3e", p->cost);
-    break;
-  }
-  case PRIMARY: {
-    count = snprintf(buffer, bufferSize, "%c", p->primary == 1 ? 'y' : 'n');
-    break;
-  }
-  case MODE: {
-    unsigned int mode = p->mode;
-    char tmp[sizeof(mode)];
-    memset(tmp, 0, sizeof(tmp));
-    for (int i = 2; i >= 0; i--) {
-      tmp[2 - i] = (mode & (1 << i)) ? '1' : '0';
-    }
-    count = snprintf(buffer, bufferSize, "%s", tmp);
-    break;
-  }
-  default: {
-    LOG_ERR("Unknow id for formatter:%d\n", id);
-    assert(0);
-  }
-  }
-  buffer[count] = ' ';
-}
+#define PRINT_LINES_COUNT 10
 
-static int SortStatDataFunc(const void *__restrict lhs,
-                            const void *__restrict rhs) {
-  const StatData *sdlhs = lhs;
-  const StatData *sdrhs = rhs;
-  return sdlhs->cost > sdrhs->cost;
+static void ReportLoadStatus(Status status, const char *path) {
+  if (status == INVALID_POINTER_OR_SIZE || status == ERROR) {
+    fprintf(stderr, BS_RED("Cannot load dump from: [path:%s][ERROR:%d]\n"),
+            path, status);
+  } else if (status == EMPTY_FILE) {
+    fprintf(stdout, "Empty file [path:%s]\n", path);
+  }
 }
 
 static void LoadDumpHelper(StatData **data, size_t *size, const char *path) {
-  Status loadFirstSt = LoadDump(path, data, size);
-  if (loadFirstSt == INVALID_POINTER_OR_SIZE || loadFirstSt == ERROR) {
-    fprintf(stderr, BS_RED("Cannot load dump from: [path:%s][ERROR:%d]\n"),
-            path, loadFirstSt);
-  } else if (loadFirstSt == EMPTY_FILE) {
-    fprintf(stdout, "Empty file [path:%s]\n", path);
+  ReportLoadStatus(LoadDump(path, data, size), path);
+}
+
+// serializeData --export csv|jsonl dumpPath resultPath
+static int ExportMain(int argc, char **argv) {
+  TextFormat format = TEXT_FORMAT_CSV;
+  int validFormat = argc == 5 && (strcmp(argv[2], "csv") == 0 ||
+                                  strcmp(argv[2], "jsonl") == 0);
+  if (!validFormat) {
+    fprintf(stderr,
+            BS_RED("Export must have arguments in format: serializeData "
+                   "--export csv|jsonl dumpPath resultPath [args count:%d]\n"),
+            argc);
+    return -1;
   }
+  if (strcmp(argv[2], "jsonl") == 0) {
+    format = TEXT_FORMAT_JSON_LINES;
+  }
+  Status status = ExportDump(argv[3], argv[4], format, 0);
+  if (status != SUCCESS && status != EMPTY_FILE) {
+    fprintf(stderr, BS_RED("Cannot export dump: [path:%s][ERROR:%d]\n"),
+            argv[3], status);
+    return -1;
+  }
+  return 0;
 }
 
-int main(int argc, char **argv) {
+// serializeData --import textPath dumpPath
+static int ImportMain(int argc, char **argv) {
   if (argc != 4) {
+    fprintf(stderr,
+            BS_RED("Import must have arguments in format: serializeData "
+                   "--import textPath dumpPath [args count:%d]\n"),
+            argc);
+    return -1;
+  }
+  Status status = ImportDump(argv[2], argv[3], 0);
+  if (status != SUCCESS && status != EMPTY_FILE) {
+    fprintf(stderr, BS_RED("Cannot import text: [path:%s][ERROR:%d]\n"),
+            argv[2], status);
+    return -1;
+  }
+  return 0;
+}
+
+static TablewViewStatus InitStatDataTableView(TableView *view) {
+  static const char idField[] = "id";
+  static const char countField[] = "count";
+  static const char costField[] = "cost";
+  static const char primaryField[] = "primary";
+  static const char modeField[] = "mode";
+
+  const Field fields[] = {
+      {NULL, 0, STAT_DATA_COLUMN_NUMBER, 15},
+      {idField, sizeof(idField), STAT_DATA_COLUMN_ID, 15},
+      {countField, sizeof(countField), STAT_DATA_COLUMN_COUNT, 15},
+      {costField, sizeof(costField), STAT_DATA_COLUMN_COST, 15},
+      {primaryField, sizeof(primaryField), STAT_DATA_COLUMN_PRIMARY, 9},
+      {modeField, sizeof(modeField), STAT_DATA_COLUMN_MODE, 6},
+  };
+  return InitTableView(view, &StatDataFormatter, fields,
+                       sizeof(fields) / sizeof(Field));
+}
+
+// serializeData --page dumpPath offset limit
+static int PageMain(int argc, char **argv) {
+  char *offsetEnd = NULL;
+  char *limitEnd = NULL;
+  size_t offset = argc == 5 ? strtoull(argv[3], &offsetEnd, 10) : 0;
+  size_t limit = argc == 5 ? strtoull(argv[4], &limitEnd, 10) : 0;
+  if (argc != 5 || *offsetEnd != '\0' || *limitEnd != '\0' || limit == 0) {
+    fprintf(stderr,
+            BS_RED("Page must have arguments in format: serializeData "
+                   "--page dumpPath offset limit [args count:%d]\n"),
+            argc);
+    return -1;
+  }
+  MappedDump dump;
+  Status status = MapDump(argv[2], 0, &dump);
+  if (status != SUCCESS) {
+    fprintf(stderr, BS_RED("Cannot map dump: [path:%s][ERROR:%d]\n"),
+            argv[2], status);
+    return -1;
+  }
+  TableView view;
+  if (InitStatDataTableView(&view) != TVS_SUCCESS) {
+    BINARYSERIALIZER_UNUSED(UnmapDump(&dump));
+    fprintf(stderr, BS_RED("Cannot initTableView\n"));
+    return -1;
+  }
+  status = PrintMappedDumpPage(&dump, offset, limit, &view);
+  if (status != SUCCESS) {
+    fprintf(stderr,
+            BS_RED("Cannot print page: [offset:%zu][records:%zu][ERROR:%d]\n"),
+            offset, dump.size, status);
+  }
+  ClearTableView(&view);
+  BINARYSERIALIZER_UNUSED(UnmapDump(&dump));
+  return status == SUCCESS ? 0 : -1;
+}
+
+// Отчет сбора из instrumentation.h, включается переменной окружения BS_STATS
+static void PrintInstrumentationReport(void) {
+  InstrumentationStats stats;
+  if (GetInstrumentationStats(&stats) != SUCCESS) {
+    return;
+  }
+  for (int i = 0; i < INSTRUMENTATION_PHASES_COUNT; ++i) {
+    fprintf(stderr, "phase %-8s %12.3f ms %8llu calls\n",
+            InstrumentationPhaseName((InstrumentationPhase)i),
+            (double)stats.phaseNanoseconds[i] / 1e6,
+            (unsigned long long)stats.phaseCalls[i]);
+  }
+  for (int i = 0; i < INSTRUMENTATION_COUNTERS_COUNT; ++i) {
+    fprintf(stderr, "counter %-13s %llu\n",
+            InstrumentationCounterName((InstrumentationCounter)i),
+            (unsigned long long)stats.counters[i]);
+  }
+}
+
+// Загрузка, объединение, сортировка и запись перекрываются в конвейере,
+// вывод берется из отсортированного результата
+static int JoinPipelineMain(char **argv) {
+  JoinPipeline *pipeline = NULL;
+  JoinPipelineResult result = {SUCCESS, SUCCESS, SUCCESS, NULL, 0};
+  result.status = StartJoinPipeline(argv[1], argv[2], argv[3], NULL, &pipeline);
+  if (result.status == SUCCESS) {
+    BINARYSERIALIZER_UNUSED(WaitJoinPipeline(pipeline, &result));
+  }
+  ReportLoadStatus(result.firstStatus, argv[1]);
+  ReportLoadStatus(result.secondStatus, argv[2]);
+  if (result.status != SUCCESS) {
+    fprintf(stderr, BS_RED("Cannot join dumps into: [path:%s][ERROR:%d]\n"),
+            argv[3], result.status);
+  }
+
+  LOG("Result data size: [size:%zu]\n", result.size);
+
+  TableView view;
+  if (InitStatDataTableView(&view) != TVS_SUCCESS) {
+    free(result.data);
+    fprintf(stderr, BS_RED("Cannot initTableView\n"));
+    return -1;
+  }
+
+  BINARYSERIALIZER_UNUSED(
+      PrintDump(result.data, result.size, PRINT_LINES_COUNT, &view));
+  ClearTableView(&view);
+  free(result.data);
+  return 0;
+}
+
+static int JoinMain(int argc, char **argv) {
+  // --top prints the cheapest records without sorting the stored result
+  int topMode = argc == 5 && strcmp(argv[4], "--top") == 0;
+  if (argc != 4 && !topMode) {
     fprintf(
         stderr,
         BS_RED("Program must have 3 argmunts with application (total 4) in "
                "format: joinBs firstStoredPath "
-               "secondStorePath resultPath.  All paths must be exited! [args "
-               "count:%d]\n"),
+               "secondStorePath resultPath [--top].  All paths must be "
+               "exited! [args count:%d]\n"),
         argc);
     return -1;
   }
+  if (!topMode) {
+    return JoinPipelineMain(argv);
+  }
 
   StatData *first = NULL;
   StatData *second = NULL;
@@ -96,46 +205,63 @@ int main(int argc, char **argv) {
 
   LoadDumpHelper(&first, &firstSize, argv[1]);
   LoadDumpHelper(&second, &secondSize, argv[2]);
-  StatData *resultData = NULL;
-  size_t resultSize = 0;
-  BINARYSERIALIZER_UNUSED(
-      JoinDump(first, firstSize, second, secondSize, &resultData, &resultSize));
-
-  BINARYSERIALIZER_UNUSED(SortDump(resultData, resultSize, &SortStatDataFunc));
-
-  LOG("Result data size: [size:%zu]\n", resultSize);
+  // Результат объединения пишется прямо в отображение argv[3], выборка
+  // выполняется на месте без промежуточного массива
+  MappedDump result = {NULL, 0, 0, -1, 0};
+  Status joinStatus =
+      JoinDumpToFile(first, firstSize, second, secondSize, argv[3], &result);
+  if (joinStatus != SUCCESS) {
+    fprintf(stderr, BS_RED("Cannot join dumps into: [path:%s][ERROR:%d]\n"),
+            argv[3], joinStatus);
+  }
 
-  const char idField[] = "id";
-  const char countField[] = "count";
-  const char costField[] = "cost";
-  const char primaryField[] = "primary";
-  const char modeField[] = "mode";
+  StatData top[PRINT_LINES_COUNT];
+  const StatData *printed = result.data;
+  size_t printedSize = result.size;
+  if (TopKByKey(result.data, result.size, SORT_FIELD_COST, SORT_ASC, top,
+                PRINT_LINES_COUNT) == SUCCESS) {
+    printed = top;
+    printedSize =
+        result.size < PRINT_LINES_COUNT ? result.size : PRINT_LINES_COUNT;
+  }
 
-  const Field fields[] = {
-      {NULL, 0, NUMBER, 15},
-      {idField, sizeof(idField), ID, 15},
-      {countField, sizeof(countField), COUNT, 15},
-      {costField, sizeof(costField), COST, 15},
-      {primaryField, sizeof(primaryField), PRIMARY, 9},
-      {modeField, sizeof(modeField), MODE, 6},
-  };
+  LOG("Result data size: [size:%zu]\n", result.size);
 
   TableView view;
-  TablewViewStatus tvStatus = InitTableView(
-      &view, &PrintStatDataFormatter, fields, sizeof(fields) / sizeof(Field));
-  if (tvStatus != TVS_SUCCESS) {
+  if (InitStatDataTableView(&view) != TVS_SUCCESS) {
     fprintf(stderr, BS_RED("Cannot initTableView\n"));
     return -1;
   }
 
-  BINARYSERIALIZER_UNUSED(PrintDump(resultData, resultSize, 10, &view));
+  BINARYSERIALIZER_UNUSED(
+      PrintDump(printed, printedSize, PRINT_LINES_COUNT, &view));
   ClearTableView(&view);
 
-  BINARYSERIALIZER_UNUSED(StoreDump(argv[3], resultData, resultSize));
+  if (joinStatus == SUCCESS) {
+    BINARYSERIALIZER_UNUSED(UnmapDump(&result));
+  }
 
-  free(resultData);
   free(first);
   free(second);
 
   return 0;
+}
+
+int main(int argc, char **argv) {
+  int statsEnabled = getenv("BS_STATS") != NULL;
+  SetInstrumentationEnabled(statsEnabled);
+  int result = 0;
+  if (argc > 1 && strcmp(argv[1], "--export") == 0) {
+    result = ExportMain(argc, argv);
+  } else if (argc > 1 && strcmp(argv[1], "--import") == 0) {
+    result = ImportMain(argc, argv);
+  } else if (argc > 1 && strcmp(argv[1], "--page") == 0) {
+    result = PageMain(argc, argv);
+  } else {
+    result = JoinMain(argc, argv);
+  }
+  if (statsEnabled) {
+    PrintInstrumentationReport();
+  }
+  return result;
 }
\ No newline at end of file
@@ -0,0 +1,98 @@
+/**
+ * @file allocator.h
+ * @brief Подключаемый аллокатор для хеш-таблицы, загрузки и объединения
+ * @author Melpomenna
+ * @version 1.0
+ * @date 18.10.2026
+ *
+ * Allocator - таблица функций выделения памяти с пользовательским
+ * контекстом. Ее принимают InitHashTableWithAllocator(),
+ * LoadDumpWithAllocator() и JoinDumpWithAllocator(), что позволяет выбирать
+ * размещение памяти (арены NUMA-узла, пулы больших страниц, учет выделений)
+ * для каждого вызова без пересборки библиотеки. Вместо NULL используется
+ * DefaultAllocator(): malloc/realloc/free или mimalloc при сборке с
+ * BS_ENABLE_MI_MALLOC, как и в функциях без аллокатора.
+ */
+
+#ifndef BINARYSERIALIZER_ALLOCATOR_H
+#define BINARYSERIALIZER_ALLOCATOR_H
+
+#include "BinarySerializer/config.h"
+
+#include <stddef.h>
+
+/**
+ * @typedef AllocateFunction
+ * @brief Выделяет size байт, выровненных как у malloc()
+ *
+ * @return Указатель на блок или NULL при ошибке
+ */
+typedef void *(*AllocateFunction)(void *context, size_t size);
+
+/**
+ * @typedef ReallocateFunction
+ * @brief Изменяет размер блока с семантикой realloc()
+ *
+ * memory может быть NULL, тогда функция работает как AllocateFunction. При
+ * ошибке возвращает NULL и оставляет memory без изменений.
+ */
+typedef void *(*ReallocateFunction)(void *context, void *memory, size_t size);
+
+/**
+ * @typedef DeallocateFunction
+ * @brief Освобождает блок, библиотека не передает NULL
+ */
+typedef void (*DeallocateFunction)(void *context, void *memory);
+
+/**
+ * @struct Allocator
+ * @brief Функции выделения памяти и их общий контекст
+ *
+ * Все три функции обязательны. Библиотека копирует структуру, context
+ * должен оставаться действительным, пока живут выделенные через нее блоки.
+ * Если один аллокатор используется из нескольких потоков одновременно,
+ * синхронизацию обеспечивает сам аллокатор.
+ *
+ * @par Пример использования:
+ * @code
+ * static void *ArenaAllocate(void *arena, size_t size);
+ * static void *ArenaReallocate(void *arena, void *memory, size_t size);
+ * static void ArenaDeallocate(void *arena, void *memory);
+ *
+ * Allocator allocator = {&ArenaAllocate, &ArenaReallocate, &ArenaDeallocate,
+ *                        &arena};
+ * StatData *data = NULL;
+ * size_t size = 0;
+ * if (LoadDumpWithAllocator("dump.bin", &data, &size, &allocator) ==
+ *     SUCCESS) {
+ *     ArenaDeallocate(&arena, data);
+ * }
+ * @endcode
+ */
+typedef struct Allocator {
+  AllocateFunction allocate;     /**< Выделение блока */
+  ReallocateFunction reallocate; /**< Изменение размера блока */
+  DeallocateFunction deallocate; /**< Освобождение блока */
+  void *context;                 /**< Передается первым аргументом */
+} Allocator;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief Аллокатор библиотеки по умолчанию
+ *
+ * Выделенные им блоки можно освобождать через free(), выделения учитываются
+ * в GetAllocationStats().
+ *
+ * @return Указатель на неизменяемый статический аллокатор
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API const Allocator *
+DefaultAllocator(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // BINARYSERIALIZER_ALLOCATOR_H
@@ -16,6 +16,7 @@
 #ifndef BINARYSERIALIZER_BINARYSERIALIZER__H
 #define BINARYSERIALIZER_BINARYSERIALIZER__H
 
+#include "BinarySerializer/allocator.h"
 #include "BinarySerializer/config.h"
 #include "BinarySerializer/statData.h"
 #include "BinarySerializer/tableView.h"
@@ -45,19 +46,27 @@ typedef enum Status {
  *         Положительное значение, если lhs > rhs
  *
  * @note Сигнатура совместима с qsort() из stdlib.h
+ * @warning Результат вида lhs > rhs (только 0 или 1) не является корректной
+ * функцией сравнения: qsort() получает противоречивые ответы
  *
  * @par Пример использования:
  * @code
  * int CompareByAge(const void *lhs, const void *rhs) {
  *     const StatData *a = (const StatData*)lhs;
  *     const StatData *b = (const StatData*)rhs;
- *     return a->age < b->age;
+ *     return (a->age > b->age) - (a->age < b->age);
  * }
  * @endcode
  */
 typedef int (*SortFunction)(const void *__restrict lhs,
                             const void *__restrict rhs);
 
+/**
+ * @struct MappedDump
+ * @brief Дамп, отображенный в память (см. mappedDump.h)
+ */
+struct MappedDump;
+
 #if defined(__cplusplus)
 extern "C" {
 #endif
@@ -139,6 +148,27 @@ StoreDump(const char *filePath, const StatData *data, size_t size);
 BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API Status
 LoadDump(const char *filePath, StatData **data, size_t *size);
 
+/**
+ * @brief Загружает массив StatData в память, выделенную через allocator
+ *
+ * Аналог LoadDump(): массив результата растет через allocator->reallocate
+ * и освобождается вызывающей стороной через allocator->deallocate.
+ *
+ * @param[in] filePath Путь к файлу для чтения (не должен быть NULL)
+ * @param[out] data Указатель на указатель для сохранения адреса массива
+ * @param[out] size Указатель для сохранения количества элементов
+ * @param[in] allocator Аллокатор массива, NULL - DefaultAllocator()
+ *
+ * @return Коды возврата LoadDump()
+ * @return INVALID_POINTER_OR_SIZE также если у allocator не заданы все
+ * функции
+ *
+ * @see LoadDump, Allocator
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API Status
+LoadDumpWithAllocator(const char *filePath, StatData **data, size_t *size,
+                      const Allocator *allocator);
+
 /**
  * @brief Объединяет два массива StatData в один
  *
@@ -167,6 +197,14 @@ LoadDump(const char *filePath, StatData **data, size_t *size);
 массива
  * @note Исходные массивы (firstData, secondData) не изменяются
  * @note При ошибке *resultData и *resultSize не изменяются
+ * @note Сначала в хеш-таблицу вставляется весь firstData, затем весь
+ * secondData, каждый через InsertBatchToHashTable(). Поэтому cost одного id
+ * суммируется в порядке "все записи firstData, затем secondData" (внутри
+ * пакетов свыше 64 записей повторы сворачиваются заранее), а в пределах
+ * бакета записи идут в порядке первого появления id в этой же
+ * последовательности. До пакетной вставки элементы двух массивов
+ * вставлялись попеременно, и суммы cost могли отличаться в пределах
+ * погрешности float.
  *
  * @par Пример использования:
  * @code
@@ -189,6 +227,153 @@ JoinDump(const StatData *__restrict firstData, size_t firstSize,
          const StatData *__restrict secondData, size_t secondSize,
          StatData **__restrict resultData, size_t *resultSize);
 
+/**
+ * @brief Объединяет два массива StatData через пользовательский аллокатор
+ *
+ * Аналог JoinDump(): промежуточная хеш-таблица и массив результата
+ * выделяются через allocator, результат освобождается вызывающей стороной
+ * через allocator->deallocate.
+ *
+ * @param[in] firstData Первый массив для объединения
+ * @param[in] firstSize Размер первого массива
+ * @param[in] secondData Второй массив для объединения
+ * @param[in] secondSize Размер второго массива
+ * @param[out] resultData Указатель для адреса результата
+ * @param[out] resultSize Указатель для размера результата
+ * @param[in] allocator Аллокатор таблицы и результата, NULL -
+ * DefaultAllocator()
+ *
+ * @return Коды возврата JoinDump()
+ * @return INVALID_POINTER_OR_SIZE также если у allocator не заданы все
+ * функции
+ *
+ * @see JoinDump, Allocator, InitHashTableWithAllocator
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API Status JoinDumpWithAllocator(
+    const StatData *__restrict firstData, size_t firstSize,
+    const StatData *__restrict secondData, size_t secondSize,
+    StatData **__restrict resultData, size_t *resultSize,
+    const Allocator *allocator);
+
+/**
+ * @brief Объединяет два массива StatData с записью результата сразу в файл
+ *
+ * Аналог JoinDump() без промежуточного массива: после объединения файл
+ * resultPath расширяется до итогового размера, отображается в память, и
+ * элементы хеш-таблицы копируются прямо в отображение. Экономит одно
+ * выделение памяти размером с результат и одно копирование по сравнению с
+ * JoinDump() + StoreDump().
+ *
+ * @param[in] firstData Первый массив для объединения
+ * @param[in] firstSize Размер первого массива
+ * @param[in] secondData Второй массив для объединения
+ * @param[in] secondSize Размер второго массива
+ * @param[in] resultPath Путь к результирующему файлу (файл должен
+ * существовать, содержимое будет перезаписано)
+ * @param[out] result Если не NULL, сюда передается открытое на запись
+ * отображение результата, которое вызывающая сторона обязана закрыть через
+ * UnmapDump(); если NULL, отображение закрывается внутри функции
+ *
+ * @return SUCCESS при успешном объединении
+ * @return INVALID_POINTER_OR_SIZE если оба массива пусты или resultPath ==
+ * NULL
+ * @return BAD_FILE если файл не удалось открыть или расширить
+ * @return ERROR при ошибке выделения памяти или отображения файла
+ *
+ * @note Правила слияния записей совпадают с JoinDump()
+ * @note При ошибке *result не изменяется
+ *
+ * @par Пример использования:
+ * @code
+ * MappedDump joined;
+ * if (JoinDumpToFile(first, 100, second, 50, "out.bin", &joined) ==
+ *     SUCCESS) {
+ *     // сортировка и вывод прямо в отображении файла
+ *     SortDump(joined.data, joined.size, CompareByCost);
+ *     UnmapDump(&joined);
+ * }
+ * @endcode
+ *
+ * @see JoinDump, MapDump
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API Status JoinDumpToFile(
+    const StatData *__restrict firstData, size_t firstSize,
+    const StatData *__restrict secondData, size_t secondSize,
+    const char *resultPath, struct MappedDump *result);
+
+/**
+ * @brief Инкрементально сливает пакет записей в существующий дамп
+ *
+ * Предназначена для регулярного обновления большого агрегата небольшой
+ * дельтой без повторного JoinDump всего файла. Дамп должен быть отсортирован
+ * по возрастанию id и не содержать повторяющихся id (например, результат
+ * SortDump по id) либо быть результатом предыдущих вызовов UpdateDump.
+ *
+ * Записи дельты с одинаковым id предварительно объединяются. Записи с id,
+ * уже присутствующими в дампе, сливаются на месте по правилам JoinDump.
+ * Новые id не сдвигают существующие записи: они дописываются в конец файла
+ * отсортированной серией, длины серий хранятся рядом в файле
+ * "<filePath>.runs". Короткие серии в конце файла сливаются, пока каждая
+ * серия хотя бы вдвое длиннее следующей, поэтому серий не больше
+ * log2(n) + 1. Поиск id идет галопирующим бинарным поиском по каждой серии
+ * прямо в отображенной памяти.
+ *
+ * Пока серий больше одной, дамп содержит все записи в формате LoadDump, но
+ * не отсортирован целиком; CompactDump() сливает серии в одну.
+ *
+ * @param[in] filePath Путь к отсортированному по id дампу (файл должен
+ * существовать, может быть пустым)
+ * @param[in] delta Массив новых записей (не должен быть NULL)
+ * @param[in] deltaSize Размер дельты (должен быть > 0)
+ *
+ * @return SUCCESS при успешном обновлении
+ * @return INVALID_POINTER_OR_SIZE если filePath == NULL, delta == NULL или
+ * deltaSize == 0
+ * @return BAD_FILE если файл не удалось открыть или расширить, не удалось
+ * записать файл серий, либо просмотренные при поиске записи идут не по
+ * возрастанию id (в этом случае дамп не изменяется)
+ * @return ERROR при ошибке выделения памяти или отображения файла
+ *
+ * @note Сложность: O(d log d + d log^2 n) на поиск и слияние, где d - размер
+ * дельты, n - размер дампа; новые записи дописываются за O(d), а слияние
+ * серий переписывает каждую запись O(log n) раз за все время жизни дампа,
+ * то есть амортизированно O(d log n) на вызов
+ * @warning Проверка порядка выборочная: она ловит, например, дамп,
+ * отсортированный по cost, но не доказывает сортировку всего файла
+ * @warning Файл серий относится к дампу: дамп, перезаписанный StoreDump, с
+ * несовпадающим по сумме длин файлом серий снова считается одной серией
+ *
+ * @par Пример использования:
+ * @code
+ * StatData delta[2] = {...};
+ * Status result = UpdateDump("aggregate.bin", delta, 2);
+ * @endcode
+ *
+ * @see JoinDump, MapDump, CompactDump
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API Status
+UpdateDump(const char *filePath, const StatData *delta, size_t deltaSize);
+
+/**
+ * @brief Сливает серии, дописанные UpdateDump(), в один отсортированный дамп
+ *
+ * После успешного вызова дамп отсортирован по id целиком, а файл
+ * "<filePath>.runs" удален. Для дампа без файла серий ничего не делает.
+ *
+ * @param[in] filePath Путь к дампу
+ *
+ * @return SUCCESS при успехе
+ * @return INVALID_POINTER_OR_SIZE если filePath == NULL
+ * @return BAD_FILE если файл не удалось открыть или удалить файл серий
+ * @return ERROR при ошибке выделения памяти или отображения файла
+ *
+ * @note Сложность O(n log r) для r серий, память O(n) в худшем случае
+ *
+ * @see UpdateDump
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API Status
+CompactDump(const char *filePath);
+
 /**
  * @brief Сортирует массив StatData с использованием пользовательской функции
  * сравнения
@@ -260,6 +445,37 @@ SortDump(StatData *data, size_t size, SortFunction sortFunc);
 BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API Status PrintDump(
     const StatData *data, size_t size, size_t linesCount, TableView *view);
 
+/**
+ * @brief Выводит массив StatData в порядке перестановки
+ *
+ * То же, что PrintDump(), но i-й выводимой строкой становится
+ * data[permutation[i]]. Сами данные не переупорядочиваются, поэтому
+ * отсортированный вывод не требует копии массива.
+ *
+ * @param[in] data Указатель на массив для вывода (не должен быть NULL)
+ * @param[in] permutation Порядок вывода из size индексов в data (не должен
+ * быть NULL)
+ * @param[in] size Количество элементов (должно быть > 0)
+ * @param[in] linesCount Максимальное количество строк для вывода
+ * @param[in] view Указатель на структуру для вывода данных в формате таблицы
+ *
+ * @return SUCCESS при успешном выводе
+ * @return INVALID_POINTER_OR_SIZE если data, permutation или view == NULL
+ * или size == 0
+ * @return ERROR при ошибке вывода
+ *
+ * @par Пример использования:
+ * @code
+ * ArgSortByKey(data, size, SORT_FIELD_COST, SORT_ASC, order);
+ * PrintDumpPermuted(data, order, size, 10, &view);
+ * @endcode
+ *
+ * @see ArgSortByKey
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API Status
+PrintDumpPermuted(const StatData *data, const uint32_t *permutation,
+                  size_t size, size_t linesCount, TableView *view);
+
 #if defined(__cplusplus)
 }
 #endif
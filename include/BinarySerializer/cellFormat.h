@@ -0,0 +1,106 @@
+/**
+ * @file cellFormat.h
+ * @brief Быстрое форматирование чисел для ячеек TableView
+ * @author Melpomenna
+ * @version 1.0
+ * @date 18.10.2026
+ *
+ * Функции пишут текст прямо в буфер ячейки без snprintf, без выделения
+ * памяти и без завершающего нуля, как того требует FormatterFunc. Каждая
+ * функция возвращает количество записанных символов; если результат не
+ * помещается в буфер, ничего не пишется и возвращается 0.
+ */
+
+#ifndef BINARYSERIALIZER_CELLFORMAT_H
+#define BINARYSERIALIZER_CELLFORMAT_H
+
+#include "BinarySerializer/config.h"
+#include "BinarySerializer/tableView.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @enum StatDataColumn
+ * @brief Идентификаторы полей StatData для StatDataFormatter()
+ */
+typedef enum StatDataColumn {
+  STAT_DATA_COLUMN_NUMBER = -1, /**< Номер строки, выводит сам TableView */
+  STAT_DATA_COLUMN_ID,      /**< id в шестнадцатеричном виде */
+  STAT_DATA_COLUMN_COUNT,   /**< count в десятичном виде */
+  STAT_DATA_COLUMN_COST,    /**< cost в научной записи с 3 знаками */
+  STAT_DATA_COLUMN_PRIMARY, /**< primary как 'y' / 'n' */
+  STAT_DATA_COLUMN_MODE     /**< mode как 3 двоичных разряда */
+} StatDataColumn;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief Шестнадцатеричная запись строчными буквами, как "%lx"
+ *
+ * @return Количество символов или 0, если буфер мал
+ */
+BINARYSERIALIZER_API size_t FormatHex(uint64_t value, char *buffer,
+                                      size_t bufferSize);
+
+/**
+ * @brief Десятичная запись со знаком, как "%ld"
+ *
+ * @return Количество символов или 0, если буфер мал
+ */
+BINARYSERIALIZER_API size_t FormatDecimal(int64_t value, char *buffer,
+                                          size_t bufferSize);
+
+/**
+ * @brief Научная запись с precision знаками после точки, как "%.<p>e"
+ *
+ * Мантисса округляется к ближайшему, точные середины - к четному, как в
+ * glibc. Для значений float результат совпадает с snprintf; для double
+ * возможны расхождения в последнем знаке у значений, отличающихся от
+ * середины меньше чем на 2^-64 относительной погрешности.
+ *
+ * @param[in] value Значение (inf и nan выводятся как "inf" и "nan")
+ * @param[in] precision Знаков после точки, не больше 9
+ * @param[out] buffer Буфер ячейки
+ * @param[in] bufferSize Размер буфера
+ *
+ * @return Количество символов или 0, если буфер мал или precision > 9
+ */
+BINARYSERIALIZER_API size_t FormatScientific(double value, unsigned precision,
+                                             char *buffer, size_t bufferSize);
+
+/**
+ * @brief Младшие width бит value символами '0' / '1', старший бит первым
+ *
+ * @param[in] width Количество разрядов, от 1 до 64
+ *
+ * @return Количество символов (width) или 0, если буфер мал или width вне
+ * диапазона
+ */
+BINARYSERIALIZER_API size_t FormatBits(uint64_t value, unsigned width,
+                                       char *buffer, size_t bufferSize);
+
+/**
+ * @brief FormatterFunc для StatData
+ *
+ * Выводит поле с идентификатором id (см. StatDataColumn) функциями этого
+ * модуля. Неизвестный id оставляет ячейку пустой.
+ *
+ * @par Пример использования:
+ * @code
+ * const Field fields[] = {{NULL, 0, STAT_DATA_COLUMN_NUMBER, 15},
+ *                         {"id", 3, STAT_DATA_COLUMN_ID, 15},
+ *                         {"cost", 5, STAT_DATA_COLUMN_COST, 15}};
+ * InitTableView(&view, &StatDataFormatter, fields, 3);
+ * @endcode
+ */
+BINARYSERIALIZER_API void StatDataFormatter(int id, const void *data,
+                                            char *buffer, size_t bufferSize);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // BINARYSERIALIZER_CELLFORMAT_H
@@ -0,0 +1,153 @@
+/**
+ * @file dumpText.h
+ * @brief Потоковое преобразование дампов в текстовые форматы и обратно
+ * @author Melpomenna
+ * @version 1.0
+ * @date 18.10.2026
+ *
+ * Дамп читается окнами фиксированного размера, блоки окна форматируются
+ * параллельно в собственные буферы и записываются в выходной файл в
+ * исходном порядке. Импорт CSV устроен так же: окно текста делится по
+ * границам строк между потоками, записи участков дописываются в дамп по
+ * порядку. Пиковое потребление памяти не зависит от размера дампа.
+ */
+
+#ifndef BINARYSERIALIZER_DUMPTEXT_H
+#define BINARYSERIALIZER_DUMPTEXT_H
+
+#include "BinarySerializer/binarySerializer.h"
+#include "BinarySerializer/config.h"
+
+#include <stddef.h>
+
+/**
+ * @def BINARYSERIALIZER_TEXT_CHUNK_RECORDS
+ * @brief Количество записей в одном блоке параллельной обработки
+ */
+#define BINARYSERIALIZER_TEXT_CHUNK_RECORDS (1u << 14)
+
+/**
+ * @def BINARYSERIALIZER_TEXT_CHUNK_BYTES
+ * @brief Объем текста на один поток в окне импорта
+ */
+#define BINARYSERIALIZER_TEXT_CHUNK_BYTES (1u << 20)
+
+/**
+ * @enum TextFormat
+ * @brief Текстовый формат выгрузки
+ *
+ * Поля выводятся в порядке id, count, cost, primary, mode. id и count -
+ * десятичные целые, cost - научная запись с 9 значащими цифрами (точно
+ * восстанавливает float), mode - целое от 0 до 7.
+ */
+typedef enum TextFormat {
+  /**
+   * CSV с заголовком "id,count,cost,primary,mode", primary как 0 / 1,
+   * строки разделяются '\n'
+   */
+  TEXT_FORMAT_CSV,
+  /**
+   * JSON Lines: объект {"id":..,"count":..,"cost":..,"primary":..,"mode":..}
+   * на строку, primary как true / false, нечисловой cost как null
+   */
+  TEXT_FORMAT_JSON_LINES
+} TextFormat;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief Выгружает дамп в текстовом формате в открытый дескриптор
+ *
+ * @param[in] inputPath Путь к дампу (не должен быть NULL)
+ * @param[in] fd Дескриптор, открытый на запись, не закрывается
+ * @param[in] format Формат выгрузки
+ * @param[in] threadsCount Количество потоков форматирования, 0 - по числу
+ * доступных процессоров
+ *
+ * @return SUCCESS при успехе
+ * @return EMPTY_FILE если дамп пуст (для CSV записывается только заголовок)
+ * @return INVALID_POINTER_OR_SIZE если inputPath == NULL, fd < 0 или format
+ * вне допустимых значений
+ * @return BAD_FILE если дамп не удалось открыть
+ * @return ERROR при ошибке чтения, записи или выделения памяти
+ *
+ * @note Память: по BINARYSERIALIZER_TEXT_CHUNK_RECORDS строк на поток
+ *
+ * @see ExportDump
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API Status
+ExportDumpToFd(const char *inputPath, int fd, TextFormat format,
+               size_t threadsCount);
+
+/**
+ * @brief Выгружает дамп в текстовом формате в файл
+ *
+ * Файл resultPath создается или перезаписывается. Параметры и коды
+ * возврата совпадают с ExportDumpToFd(); BAD_FILE также возвращается, если
+ * не удалось создать resultPath.
+ *
+ * @par Пример использования:
+ * @code
+ * Status result = ExportDump("result.bin", "result.csv", TEXT_FORMAT_CSV, 0);
+ * @endcode
+ *
+ * @see ExportDumpToFd
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API Status
+ExportDump(const char *inputPath, const char *resultPath, TextFormat format,
+           size_t threadsCount);
+
+/**
+ * @brief Загружает CSV из открытого дескриптора в файл дампа
+ *
+ * Строки имеют вид id,count,cost,primary,mode, как в TEXT_FORMAT_CSV: id и
+ * count - десятичные целые, cost - число с необязательными дробной частью и
+ * порядком (а также inf и nan), primary - 0 или 1, mode - от 0 до 7. Первая
+ * строка пропускается, если не начинается с цифры или знака (заголовок).
+ * Пустые строки пропускаются, допускаются окончания "\r\n" и отсутствие
+ * '\n' в конце. Разделители ищутся векторными инструкциями, числа
+ * разбираются без strtod() и не зависят от локали.
+ *
+ * @param[in] fd Дескриптор, открытый на чтение (может быть каналом), не
+ * закрывается
+ * @param[in] resultPath Путь к создаваемому или перезаписываемому дампу
+ * @param[in] threadsCount Количество потоков разбора, 0 - по числу доступных
+ * процессоров
+ *
+ * @return SUCCESS при успехе
+ * @return EMPTY_FILE если в тексте нет записей (создается пустой дамп)
+ * @return INVALID_POINTER_OR_SIZE если fd < 0 или resultPath == NULL
+ * @return BAD_FILE если resultPath не удалось создать, строка не
+ * соответствует формату или длиннее 64 КБ; записанный дамп неполон
+ * @return ERROR при ошибке чтения, записи или выделения памяти
+ *
+ * @note Память: около 4 * BINARYSERIALIZER_TEXT_CHUNK_BYTES на поток
+ *
+ * @see ImportDump, ExportDumpToFd
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API Status
+ImportDumpFromFd(int fd, const char *resultPath, size_t threadsCount);
+
+/**
+ * @brief Загружает CSV файл в файл дампа
+ *
+ * Параметры и коды возврата совпадают с ImportDumpFromFd(); BAD_FILE также
+ * возвращается, если не удалось открыть inputPath.
+ *
+ * @par Пример использования:
+ * @code
+ * Status result = ImportDump("upstream.csv", "upstream.bin", 0);
+ * @endcode
+ *
+ * @see ImportDumpFromFd, ExportDump
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API Status
+ImportDump(const char *inputPath, const char *resultPath, size_t threadsCount);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // BINARYSERIALIZER_DUMPTEXT_H
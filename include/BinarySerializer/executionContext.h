@@ -0,0 +1,152 @@
+/**
+ * @file executionContext.h
+ * @brief Переиспользуемый контекст объединения, сортировки и вывода
+ * @author Melpomenna
+ * @version 1.0
+ * @date 18.10.2026
+ *
+ * JoinDump() на каждый вызов создает и освобождает хеш-таблицу, а
+ * SortDumpByKey() - вспомогательный массив. Для частых небольших вызовов
+ * (сервис, выполняющий тысячи объединений в секунду) подготовка и
+ * освобождение памяти занимают большую часть времени. ExecutionContext
+ * владеет хеш-таблицей (очищается без освобождения памяти через
+ * ResetHashTable()), рабочими массивами пакетной вставки, буферами
+ * результата объединения, сортировки и текста таблицы. Буферы растут до
+ * наибольшего встреченного размера и не уменьшаются, поэтому после прогрева
+ * варианты функций с контекстом не выделяют память.
+ *
+ * Контекст не потокобезопасен: для параллельной работы нужен отдельный
+ * контекст на поток.
+ */
+
+#ifndef BINARYSERIALIZER_EXECUTIONCONTEXT_H
+#define BINARYSERIALIZER_EXECUTIONCONTEXT_H
+
+#include "BinarySerializer/allocator.h"
+#include "BinarySerializer/binarySerializer.h"
+#include "BinarySerializer/config.h"
+#include "BinarySerializer/sortDump.h"
+#include "BinarySerializer/statData.h"
+#include "BinarySerializer/tableView.h"
+
+#include <stddef.h>
+
+/**
+ * @struct ExecutionContext
+ * @brief Непрозрачный контекст, создается CreateExecutionContext()
+ */
+typedef struct ExecutionContext ExecutionContext;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief Создает контекст
+ *
+ * @param[in] bucketsCount Количество бакетов хеш-таблицы (округляется до
+ * степени двойки), 0 - BINARYSERIALIZER_DEFUALT_BUCKETS_COUNT
+ * @param[in] allocator Аллокатор всех буферов контекста (копируется), NULL -
+ * DefaultAllocator()
+ *
+ * @return Контекст или NULL при ошибке выделения памяти или неполном
+ * allocator
+ *
+ * @par Пример использования:
+ * @code
+ * ExecutionContext *context = CreateExecutionContext(1 << 16, NULL);
+ * for (;;) {
+ *     StatData *joined = NULL;
+ *     size_t joinedSize = 0;
+ *     Status status = JoinDumpWithContext(context, first, firstSize, second,
+ *                                         secondSize, &joined, &joinedSize);
+ *     status = SortDumpByKeyWithContext(context, joined, joinedSize,
+ *                                       SORT_FIELD_COST, SORT_ASC);
+ *     // joined действителен до следующего JoinDumpWithContext()
+ * }
+ * DestroyExecutionContext(context);
+ * @endcode
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API ExecutionContext *
+CreateExecutionContext(size_t bucketsCount, const Allocator *allocator);
+
+/**
+ * @brief Освобождает контекст и все его буферы
+ *
+ * @param[in] context Контекст (NULL игнорируется)
+ */
+BINARYSERIALIZER_API void DestroyExecutionContext(ExecutionContext *context);
+
+/**
+ * @brief JoinDump() с таблицей и буфером результата из контекста
+ *
+ * Результат совпадает с JoinDump(), но массив принадлежит контексту:
+ * вызывающая сторона не освобождает его, может изменять (например,
+ * сортировать) и использовать до следующего вызова JoinDumpWithContext()
+ * или DestroyExecutionContext().
+ *
+ * @param[in,out] context Контекст
+ * @param[in] firstData Первый массив для объединения
+ * @param[in] firstSize Размер первого массива
+ * @param[in] secondData Второй массив для объединения
+ * @param[in] secondSize Размер второго массива
+ * @param[out] resultData Указатель для адреса результата в контексте
+ * @param[out] resultSize Указатель для размера результата
+ *
+ * @return SUCCESS при успешном объединении
+ * @return INVALID_POINTER_OR_SIZE если context == NULL, оба массива пусты
+ * или указатели результата NULL
+ * @return ERROR при ошибке выделения памяти
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API Status JoinDumpWithContext(
+    ExecutionContext *context, const StatData *__restrict firstData,
+    size_t firstSize, const StatData *__restrict secondData,
+    size_t secondSize, StatData **__restrict resultData, size_t *resultSize);
+
+/**
+ * @brief SortDumpByKey() со вспомогательным массивом из контекста
+ *
+ * @param[in,out] context Контекст
+ * @param[in,out] data Массив для сортировки
+ * @param[in] size Количество элементов
+ * @param[in] field Поле сортировки
+ * @param[in] direction Направление сортировки
+ *
+ * @return Коды возврата SortDumpByKey(), INVALID_POINTER_OR_SIZE также при
+ * context == NULL
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API Status
+SortDumpByKeyWithContext(ExecutionContext *context, StatData *data,
+                         size_t size, SortField field,
+                         SortDirection direction);
+
+/**
+ * @brief PrintDump() в текстовый буфер контекста
+ *
+ * Таблица выводится не в приемник view, а в буфер контекста, который
+ * очищается в начале каждого вызова. Приемник view после вызова прежний.
+ * Буфер блока вывода view переиспользуется самим view, поэтому для
+ * вывода без выделений view тоже нужно создавать один раз.
+ *
+ * @param[in,out] context Контекст
+ * @param[in] data Массив для вывода
+ * @param[in] size Количество элементов
+ * @param[in] linesCount Количество выводимых строк
+ * @param[in,out] view Инициализированное представление
+ * @param[out] text Адрес текста в контексте (не завершается нулем),
+ * действителен до следующего вызова с этим контекстом
+ * @param[out] textSize Длина текста в байтах
+ *
+ * @return SUCCESS при успехе
+ * @return INVALID_POINTER_OR_SIZE при NULL аргументах или size == 0
+ * @return ERROR при ошибке форматирования или выделения памяти
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API Status PrintDumpWithContext(
+    ExecutionContext *context, const StatData *data, size_t size,
+    size_t linesCount, TableView *view, const char **text, size_t *textSize);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // BINARYSERIALIZER_EXECUTIONCONTEXT_H
@@ -0,0 +1,180 @@
+/**
+ * @file externalMemory.h
+ * @brief Операции над дампами, не помещающимися в оперативную память
+ * @author Melpomenna
+ * @version 1.0
+ * @date 18.10.2026
+ *
+ * Функции этого модуля работают напрямую с файлами дампов и ограничивают
+ * пиковое потребление памяти заданным бюджетом. Промежуточные данные
+ * сохраняются во временные файлы в формате StoreDump.
+ */
+
+#ifndef BINARYSERIALIZER_EXTERNALMEMORY_H
+#define BINARYSERIALIZER_EXTERNALMEMORY_H
+
+#include "BinarySerializer/binarySerializer.h"
+#include "BinarySerializer/config.h"
+#include "BinarySerializer/sortDump.h"
+
+#include <stddef.h>
+
+/**
+ * @def BINARYSERIALIZER_MIN_MEMORY_BUDGET
+ * @brief Минимальный бюджет памяти для внешних операций в байтах
+ *
+ * Меньший бюджет не позволяет держать буферы ввода-вывода разумного размера.
+ */
+#define BINARYSERIALIZER_MIN_MEMORY_BUDGET (1u << 20)
+
+/**
+ * @enum ExternalSortPhase
+ * @brief Этап внешней сортировки
+ */
+typedef enum ExternalSortPhase {
+  EXTERNAL_SORT_RUNS,  /**< Формирование отсортированных серий */
+  EXTERNAL_SORT_MERGE, /**< Слияние серий */
+  EXTERNAL_SORT_DONE   /**< Сортировка завершена */
+} ExternalSortPhase;
+
+/**
+ * @struct ExternalSortProgress
+ * @brief Счетчики прогресса и пропускной способности SortDumpExternal()
+ *
+ * Пропускная способность ввода-вывода равна
+ * (bytesRead + bytesWritten) / elapsedSeconds.
+ */
+typedef struct ExternalSortProgress {
+  ExternalSortPhase phase; /**< Текущий этап */
+  size_t totalRecords;     /**< Записей во входном дампе */
+  size_t sortedRecords;    /**< Записей, разложенных по сериям */
+  size_t runsCount;        /**< Создано серий */
+  size_t mergePasses;      /**< Выполнено проходов слияния */
+  size_t mergedRecords; /**< Записей, выведенных текущим проходом слияния */
+  size_t bytesRead;     /**< Всего прочитано байт, включая временные файлы */
+  size_t bytesWritten;  /**< Всего записано байт, включая временные файлы */
+  double elapsedSeconds; /**< Время с начала сортировки */
+} ExternalSortProgress;
+
+/**
+ * @typedef ExternalSortProgressFunc
+ * @brief Функция, получающая счетчики прогресса
+ *
+ * @param progress Текущие значения счетчиков (валидны только во время вызова)
+ * @param args Пользовательские аргументы из SortDumpExternal()
+ */
+typedef void (*ExternalSortProgressFunc)(const ExternalSortProgress *progress,
+                                         void *args);
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief Объединяет два дампа на диске с ограничением по памяти
+ *
+ * Аналог JoinDump() для данных, не помещающихся в память. Если суммарное
+ * количество записей не укладывается в бюджет, записи хеш-партиционируются
+ * по id во временные файлы, после чего каждая партиция объединяется в памяти
+ * и потоково дописывается в результирующий файл. Партиции, все еще
+ * превышающие бюджет, рекурсивно делятся повторно. Повторы одного id
+ * сворачиваются при вставке, поэтому неделимая партиция (например, один
+ * горячий id) укладывается в бюджет, если в ней помещаются различные id.
+ *
+ * Правила слияния записей с одинаковым id совпадают с JoinDump(), записи
+ * партиции тоже вставляются пакетами, рабочие массивы которых входят в
+ * бюджет. Порядок записей в результате не гарантируется.
+ *
+ * @param[in] firstPath Путь к первому дампу (может быть NULL)
+ * @param[in] secondPath Путь ко второму дампу (может быть NULL)
+ * @param[in] resultPath Путь к результирующему дампу (создается или
+ * перезаписывается, может совпадать с firstPath или secondPath). Файл
+ * открывается только после того, как входные дампы прочитаны целиком; при
+ * ошибке до этого момента он не изменяется.
+ * @param[in] tempDir Каталог для временных файлов; если NULL, используется
+ * каталог resultPath
+ * @param[in] memoryBudget Бюджет памяти в байтах (не меньше
+ * BINARYSERIALIZER_MIN_MEMORY_BUDGET)
+ *
+ * @return SUCCESS при успешном объединении
+ * @return INVALID_POINTER_OR_SIZE если оба входа NULL, resultPath == NULL или
+ * бюджет слишком мал
+ * @return BAD_FILE при ошибке открытия, чтения или записи файлов
+ * @return EMPTY_FILE если оба входных дампа пусты
+ * @return ERROR при ошибке выделения памяти или если в неделимой партиции
+ * различных id больше, чем помещается в бюджет
+ *
+ * @note Временные файлы удаляются из файловой системы сразу после создания и
+ * не остаются на диске даже при аварийном завершении
+ * @warning Каталог tempDir должен вмещать объем обоих входных дампов
+ *
+ * @par Пример использования:
+ * @code
+ * // Объединение двух дампов по 200 ГБ с бюджетом в 4 ГБ
+ * Status result = JoinDumpExternal("a.dat", "b.dat", "out.dat", "/var/tmp",
+ *                                  4ull << 30);
+ * @endcode
+ *
+ * @see JoinDump
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API Status JoinDumpExternal(
+    const char *firstPath, const char *secondPath, const char *resultPath,
+    const char *tempDir, size_t memoryBudget);
+
+/**
+ * @brief Сортирует дамп на диске с ограничением по памяти
+ *
+ * Внешняя сортировка слиянием. Вход читается порциями, умещающимися в
+ * бюджет, каждая порция сортируется SortDumpByKey() и записывается во
+ * временный файл (серию). Затем серии сливаются K-путевым слиянием с
+ * крупными последовательными чтениями и записью; если серий больше, чем
+ * можно слить за раз, выполняется несколько проходов. Если вход целиком
+ * помещается в одну серию, временные файлы не создаются.
+ *
+ * Сортировка устойчива: результат совпадает с SortDumpByKey() над всем
+ * дампом.
+ *
+ * @param[in] inputPath Путь к сортируемому дампу
+ * @param[in] resultPath Путь к результату (создается или перезаписывается,
+ * может совпадать с inputPath)
+ * @param[in] tempDir Каталог для временных файлов; если NULL, используется
+ * каталог resultPath
+ * @param[in] memoryBudget Бюджет памяти в байтах (не меньше
+ * BINARYSERIALIZER_MIN_MEMORY_BUDGET)
+ * @param[in] field Поле сортировки
+ * @param[in] direction Направление сортировки
+ * @param[in] progress Функция для счетчиков прогресса (может быть NULL),
+ * вызывается после каждой серии, периодически во время слияния и один раз
+ * с EXTERNAL_SORT_DONE
+ * @param[in] progressArgs Аргументы для progress
+ *
+ * @return SUCCESS при успешной сортировке
+ * @return INVALID_POINTER_OR_SIZE если inputPath или resultPath == NULL,
+ * бюджет слишком мал или field / direction вне допустимых значений
+ * @return BAD_FILE при ошибке открытия, чтения или записи файлов
+ * @return EMPTY_FILE если входной дамп пуст
+ * @return ERROR при ошибке выделения памяти
+ *
+ * @note Пиковое потребление памяти библиотекой не превышает memoryBudget
+ * @warning Каталог tempDir должен вмещать объем входного дампа
+ *
+ * @par Пример использования:
+ * @code
+ * // Сортировка дампа на 300 ГБ по стоимости с бюджетом в 8 ГБ
+ * Status result = SortDumpExternal("all.dat", "sorted.dat", "/var/tmp",
+ *                                  8ull << 30, SORT_FIELD_COST, SORT_ASC,
+ *                                  NULL, NULL);
+ * @endcode
+ *
+ * @see SortDumpByKey
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API Status SortDumpExternal(
+    const char *inputPath, const char *resultPath, const char *tempDir,
+    size_t memoryBudget, SortField field, SortDirection direction,
+    ExternalSortProgressFunc progress, void *progressArgs);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // BINARYSERIALIZER_EXTERNALMEMORY_H
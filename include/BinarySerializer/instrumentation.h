@@ -0,0 +1,191 @@
+/**
+ * @file instrumentation.h
+ * @brief Счетчики и таймеры фаз работы библиотеки
+ * @author Melpomenna
+ * @version 1.0
+ * @date 18.10.2026
+ *
+ * Библиотека накапливает время основных фаз (открытие, отображение,
+ * копирование, хеширование, слияние, выгрузка из таблицы, сортировка, вывод,
+ * запись) по монотонным часам и счетчики событий. Сбор выключен по
+ * умолчанию и включается во время работы через SetInstrumentationEnabled():
+ * выключенный сбор стоит одной проверки флага на вызов функции библиотеки,
+ * поэтому его можно оставлять в релизных сборках. Опция сборки
+ * BS_DISABLE_INSTRUMENTATION удаляет сбор полностью.
+ *
+ * Значения глобальны для процесса и обновляются атомарно, поэтому вызовы из
+ * нескольких потоков суммируются.
+ *
+ * При включенном сборе учитываются и выделения памяти внутри библиотеки
+ * (GetAllocationStats()): количество, объем и пик живых байт, в том числе
+ * при сборке с BS_ENABLE_MI_MALLOC.
+ */
+
+#ifndef BINARYSERIALIZER_INSTRUMENTATION_H
+#define BINARYSERIALIZER_INSTRUMENTATION_H
+
+#include "BinarySerializer/binarySerializer.h"
+#include "BinarySerializer/config.h"
+
+#include <stdint.h>
+
+/**
+ * @enum InstrumentationPhase
+ * @brief Фазы, время которых накапливается
+ */
+typedef enum InstrumentationPhase {
+  INSTRUMENTATION_PHASE_OPEN, /**< open/fstat/ftruncate файлов дампов */
+  INSTRUMENTATION_PHASE_MAP,  /**< mmap файлов дампов */
+  INSTRUMENTATION_PHASE_COPY, /**< Копирование отображения в память */
+  INSTRUMENTATION_PHASE_HASH, /**< Пакетная вставка в MergeHashTable */
+  INSTRUMENTATION_PHASE_MERGE, /**< Слияние с дампом и слияние серий */
+  INSTRUMENTATION_PHASE_TO_ARRAY, /**< Выгрузка записей из MergeHashTable */
+  INSTRUMENTATION_PHASE_SORT,     /**< Сортировки */
+  INSTRUMENTATION_PHASE_PRINT,    /**< Вывод таблицы */
+  INSTRUMENTATION_PHASE_STORE,    /**< Запись дампов */
+  INSTRUMENTATION_PHASES_COUNT    /**< Количество фаз */
+} InstrumentationPhase;
+
+/**
+ * @enum InstrumentationCounter
+ * @brief Счетчики событий
+ */
+typedef enum InstrumentationCounter {
+  INSTRUMENTATION_BYTES_READ,    /**< Прочитано байт из файлов */
+  INSTRUMENTATION_BYTES_WRITTEN, /**< Записано байт в файлы */
+  INSTRUMENTATION_RECORDS, /**< Записей передано в MergeHashTable */
+  INSTRUMENTATION_MERGES,  /**< Слияний записей с одинаковым id */
+  INSTRUMENTATION_PROBES, /**< Узлов просмотрено в цепочках MergeHashTable */
+  INSTRUMENTATION_REALLOCS,     /**< Вызовов realloc при росте массивов */
+  INSTRUMENTATION_COUNTERS_COUNT /**< Количество счетчиков */
+} InstrumentationCounter;
+
+/**
+ * @struct InstrumentationStats
+ * @brief Снимок накопленных значений
+ */
+typedef struct InstrumentationStats {
+  /** Суммарное время каждой фазы в наносекундах */
+  uint64_t phaseNanoseconds[INSTRUMENTATION_PHASES_COUNT];
+  /** Количество завершенных замеров каждой фазы */
+  uint64_t phaseCalls[INSTRUMENTATION_PHASES_COUNT];
+  /** Значения счетчиков */
+  uint64_t counters[INSTRUMENTATION_COUNTERS_COUNT];
+} InstrumentationStats;
+
+/**
+ * @struct AllocationStats
+ * @brief Снимок учета выделений памяти библиотекой
+ *
+ * Размеры берутся по фактическому размеру блока у аллокатора
+ * (malloc_usable_size / mi_usable_size), поэтому не меньше запрошенных.
+ * Буферы, которые библиотека возвращает вызывающей стороне (LoadDump(),
+ * JoinDump(), HashTableToArray()), остаются живыми и после free() снаружи:
+ * для замера одного вызова значения обнуляются через
+ * ResetInstrumentationStats() перед ним.
+ */
+typedef struct AllocationStats {
+  uint64_t allocations;    /**< Выделений новых блоков */
+  uint64_t reallocations;  /**< Изменений размера существующих блоков */
+  uint64_t frees;          /**< Освобождений */
+  uint64_t allocatedBytes; /**< Выделено байт, включая рост при realloc */
+  /** Живых байт сейчас: выделенные минус освобожденные с последнего сброса,
+   * может быть отрицательным после освобождения более старых блоков */
+  int64_t liveBytes;
+  int64_t peakLiveBytes; /**< Максимум liveBytes с последнего сброса */
+} AllocationStats;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief Включает или выключает сбор
+ *
+ * Накопленные значения при выключении сохраняются.
+ *
+ * @param[in] enabled Ненулевое значение включает сбор
+ *
+ * @note Ничего не делает, если библиотека собрана с
+ * BS_DISABLE_INSTRUMENTATION
+ */
+BINARYSERIALIZER_API void SetInstrumentationEnabled(int enabled);
+
+/**
+ * @brief Проверяет, включен ли сбор
+ *
+ * @return 1 если сбор включен, 0 если выключен или удален при сборке
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API int
+IsInstrumentationEnabled(void);
+
+/**
+ * @brief Копирует накопленные значения
+ *
+ * @param[out] stats Структура для снимка
+ *
+ * @return SUCCESS при успехе
+ * @return INVALID_POINTER_OR_SIZE если stats == NULL
+ *
+ * @note Значения разных полей читаются по отдельности, снимок во время
+ * работы других потоков не согласован между полями
+ *
+ * @par Пример использования:
+ * @code
+ * SetInstrumentationEnabled(1);
+ * Status status = JoinDump(first, firstSize, second, secondSize, &data, &size);
+ * InstrumentationStats stats;
+ * status = GetInstrumentationStats(&stats);
+ * uint64_t hashNs = stats.phaseNanoseconds[INSTRUMENTATION_PHASE_HASH];
+ * @endcode
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API Status
+GetInstrumentationStats(InstrumentationStats *stats);
+
+/**
+ * @brief Копирует учет выделений памяти
+ *
+ * @param[out] stats Структура для снимка
+ *
+ * @return SUCCESS при успехе
+ * @return INVALID_POINTER_OR_SIZE если stats == NULL
+ *
+ * @par Пример использования:
+ * @code
+ * SetInstrumentationEnabled(1);
+ * ResetInstrumentationStats();
+ * Status status = LoadDump("dump.bin", &data, &size);
+ * AllocationStats memory;
+ * status = GetAllocationStats(&memory);
+ * int64_t peak = memory.peakLiveBytes;
+ * @endcode
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API Status
+GetAllocationStats(AllocationStats *stats);
+
+/**
+ * @brief Обнуляет накопленные значения, включая учет выделений памяти
+ */
+BINARYSERIALIZER_API void ResetInstrumentationStats(void);
+
+/**
+ * @brief Имя фазы для вывода ("open", "map", ...)
+ *
+ * @return Строка с именем или "unknown" для значений вне перечисления
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API const char *
+InstrumentationPhaseName(InstrumentationPhase phase);
+
+/**
+ * @brief Имя счетчика для вывода ("bytes_read", "records", ...)
+ *
+ * @return Строка с именем или "unknown" для значений вне перечисления
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API const char *
+InstrumentationCounterName(InstrumentationCounter counter);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // BINARYSERIALIZER_INSTRUMENTATION_H
@@ -0,0 +1,132 @@
+/**
+ * @file joinPipeline.h
+ * @brief Асинхронный конвейер загрузка -> объединение -> сортировка -> запись
+ * @author Melpomenna
+ * @version 1.0
+ * @date 18.10.2026
+ *
+ * Последовательный сценарий (два LoadDump(), JoinDump(), сортировка,
+ * StoreDump()) занимает сумму времен стадий. Конвейер выполняет их на
+ * небольшом внутреннем пуле потоков с перекрытием:
+ * - оба входа читаются одновременно;
+ * - готовые пакеты первого входа вставляются в хеш-таблицу, пока
+ *   дочитываются остальные;
+ * - результат сортируется частями по старшему байту ключа, и каждая готовая
+ *   часть пишется в файл, пока сортируются следующие.
+ * Поэтому время конвейера приближается к самой долгой стадии. Результат
+ * побитово совпадает с JoinDump() и SortDumpByKey() над теми же входами.
+ *
+ * Завершение можно получить функцией обратного вызова (из потока конвейера)
+ * или ожиданием WaitJoinPipeline(), которая в любом случае обязательна для
+ * освобождения ресурсов.
+ */
+
+#ifndef BINARYSERIALIZER_JOINPIPELINE_H
+#define BINARYSERIALIZER_JOINPIPELINE_H
+
+#include "BinarySerializer/binarySerializer.h"
+#include "BinarySerializer/config.h"
+#include "BinarySerializer/sortDump.h"
+#include "BinarySerializer/statData.h"
+
+#include <stddef.h>
+
+/**
+ * @struct JoinPipeline
+ * @brief Непрозрачный запущенный конвейер, создается StartJoinPipeline()
+ */
+typedef struct JoinPipeline JoinPipeline;
+
+/**
+ * @struct JoinPipelineResult
+ * @brief Итог конвейера
+ *
+ * Входы, которые не удалось открыть или которые пусты, считаются пустыми
+ * (как в serializeData), их коды возвращаются в firstStatus и
+ * secondStatus.
+ */
+typedef struct JoinPipelineResult {
+  Status status;       /**< Итог объединения, сортировки и записи */
+  Status firstStatus;  /**< Код загрузки первого входа (как у LoadDump) */
+  Status secondStatus; /**< Код загрузки второго входа (как у LoadDump) */
+  StatData *data;      /**< Отсортированный результат или NULL при ошибке */
+  size_t size;         /**< Количество записей data */
+} JoinPipelineResult;
+
+/**
+ * @typedef JoinPipelineCallback
+ * @brief Вызывается из потока конвейера после завершения всех стадий
+ *
+ * result действителен только во время вызова, data принадлежит конвейеру
+ * до WaitJoinPipeline(). Функция не должна вызывать WaitJoinPipeline() для
+ * этого же конвейера.
+ */
+typedef void (*JoinPipelineCallback)(void *context,
+                                     const JoinPipelineResult *result);
+
+/**
+ * @struct JoinPipelineOptions
+ * @brief Параметры конвейера
+ */
+typedef struct JoinPipelineOptions {
+  SortField sortField;             /**< Поле сортировки результата */
+  SortDirection sortDirection;     /**< Направление сортировки */
+  JoinPipelineCallback onComplete; /**< Уведомление о завершении или NULL */
+  void *context;                   /**< Передается в onComplete */
+} JoinPipelineOptions;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief Запускает конвейер и сразу возвращает управление
+ *
+ * Пути копируются. Файл resultPath, как и в StoreDump(), должен
+ * существовать, его содержимое заменяется отсортированным результатом.
+ *
+ * @param[in] firstPath Путь к первому дампу
+ * @param[in] secondPath Путь ко второму дампу
+ * @param[in] resultPath Путь к файлу результата
+ * @param[in] options Параметры, NULL - сортировка по возрастанию cost без
+ * обратного вызова
+ * @param[out] pipeline Запущенный конвейер
+ *
+ * @return SUCCESS при успешном запуске
+ * @return INVALID_POINTER_OR_SIZE при NULL путях или pipeline или неверном
+ * ключе сортировки
+ * @return ERROR при ошибке создания потоков или выделения памяти
+ *
+ * @par Пример использования:
+ * @code
+ * JoinPipeline *pipeline = NULL;
+ * if (StartJoinPipeline("a.bin", "b.bin", "out.bin", NULL, &pipeline) ==
+ *     SUCCESS) {
+ *     // ... другая работа
+ *     JoinPipelineResult result;
+ *     Status status = WaitJoinPipeline(pipeline, &result);
+ *     free(result.data);
+ * }
+ * @endcode
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API Status StartJoinPipeline(
+    const char *firstPath, const char *secondPath, const char *resultPath,
+    const JoinPipelineOptions *options, JoinPipeline **pipeline);
+
+/**
+ * @brief Ждет завершения конвейера и освобождает его
+ *
+ * @param[in] pipeline Конвейер из StartJoinPipeline()
+ * @param[out] result Итог, data освобождается вызывающей стороной через
+ * free(). NULL - результат освобождается сразу
+ *
+ * @return result->status или INVALID_POINTER_OR_SIZE при pipeline == NULL
+ */
+BINARYSERIALIZER_API Status WaitJoinPipeline(JoinPipeline *pipeline,
+                                             JoinPipelineResult *result);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // BINARYSERIALIZER_JOINPIPELINE_H
@@ -0,0 +1,156 @@
+/**
+ * @file mappedDump.h
+ * @brief Отображение файлов дампов в память без копирования
+ * @author Melpomenna
+ * @version 1.0
+ * @date 18.10.2026
+ *
+ * Позволяет работать с дампом как с массивом StatData прямо в отображенной
+ * памяти: страницы подгружаются ядром по мере обращения, поэтому затраты
+ * пропорциональны объему затронутых данных, а не размеру файла.
+ */
+
+#ifndef BINARYSERIALIZER_MAPPEDDUMP_H
+#define BINARYSERIALIZER_MAPPEDDUMP_H
+
+#include "BinarySerializer/binarySerializer.h"
+#include "BinarySerializer/config.h"
+#include "BinarySerializer/statData.h"
+#include "BinarySerializer/tableView.h"
+
+#include <stddef.h>
+
+/**
+ * @struct MappedDump
+ * @brief Дамп, отображенный в память через mmap()
+ *
+ * @warning Перед использованием необходимо вызвать MapDump()
+ * @warning После использования обязательно вызвать UnmapDump()
+ */
+typedef struct MappedDump {
+  StatData *data; /**< Отображенные записи (NULL для пустого файла) */
+  size_t size;    /**< Количество записей */
+  /**
+   * @brief Размер отображения в байтах
+   * @private
+   */
+  size_t mappedBytes;
+  /**
+   * @brief Дескриптор файла
+   * @private
+   */
+  int fd;
+  int writable; /**< Ненулевое значение, если отображение доступно на запись */
+} MappedDump;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief Отображает файл дампа в память
+ *
+ * Хвост файла, не кратный sizeof(StatData), игнорируется. Пустой файл
+ * отображается с data == NULL и size == 0.
+ *
+ * @param[in] filePath Путь к файлу дампа (не должен быть NULL)
+ * @param[in] writable Ненулевое значение для отображения на запись
+ * (изменения попадают в файл)
+ * @param[out] dump Структура для заполнения (не должна быть NULL)
+ *
+ * @return SUCCESS при успешном отображении
+ * @return INVALID_POINTER_OR_SIZE если filePath == NULL или dump == NULL
+ * @return BAD_FILE если файл не удалось открыть
+ * @return ERROR при ошибке fstat() или mmap()
+ *
+ * @par Пример использования:
+ * @code
+ * MappedDump dump;
+ * if (MapDump("input.bin", 0, &dump) == SUCCESS) {
+ *     for (size_t i = 0; i < dump.size; ++i) {
+ *         // process dump.data[i]
+ *     }
+ *     UnmapDump(&dump);
+ * }
+ * @endcode
+ *
+ * @see UnmapDump, ResizeMappedDump
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API Status
+MapDump(const char *filePath, int writable, MappedDump *dump);
+
+/**
+ * @brief Изменяет размер отображенного на запись дампа
+ *
+ * Файл обрезается или расширяется до size записей и отображается заново.
+ * Содержимое первых min(size, dump->size) записей сохраняется, новые записи
+ * заполнены нулями.
+ *
+ * @param[in,out] dump Отображенный на запись дамп
+ * @param[in] size Новое количество записей
+ *
+ * @return SUCCESS при успехе
+ * @return INVALID_POINTER_OR_SIZE если dump == NULL или отображение только
+ * для чтения
+ * @return BAD_FILE при ошибке ftruncate()
+ * @return ERROR при ошибке mmap(), в этом случае dump становится пустым
+ *
+ * @warning Все указатели на dump->data становятся невалидными
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API Status
+ResizeMappedDump(MappedDump *dump, size_t size);
+
+/**
+ * @brief Снимает отображение и закрывает файл
+ *
+ * Для отображения на запись предварительно выполняется msync().
+ *
+ * @param[in,out] dump Отображенный дамп
+ *
+ * @return SUCCESS при успехе
+ * @return INVALID_POINTER_OR_SIZE если dump == NULL
+ * @return ERROR при ошибке msync(), munmap() или close()
+ */
+BINARYSERIALIZER_API Status UnmapDump(MappedDump *dump);
+
+/**
+ * @brief Выводит страницу отображенного дампа в виде таблицы
+ *
+ * Представление view настраивается на записи дампа (data, dataSize,
+ * memSize, permutation = NULL) и выводится PrintTablePage(). Для страниц
+ * отображения, покрывающих строки [offset, offset + limit), заранее
+ * запрашивается чтение (POSIX_MADV_WILLNEED), остальной файл не читается,
+ * поэтому время вывода не зависит от размера дампа.
+ *
+ * @param[in] dump Отображенный дамп (достаточно отображения только для
+ * чтения)
+ * @param[in] offset Первая выводимая запись
+ * @param[in] limit Наибольшее количество выводимых записей (> 0)
+ * @param[in,out] view Инициализированное представление со своими полями и
+ * форматтером (например, StatDataFormatter())
+ *
+ * @return SUCCESS при успешном выводе
+ * @return INVALID_POINTER_OR_SIZE если указатели NULL, limit == 0 или
+ * offset >= dump->size
+ * @return ERROR при ошибке вывода
+ *
+ * @par Пример использования:
+ * @code
+ * MappedDump dump;
+ * if (MapDump("huge.bin", 0, &dump) == SUCCESS) {
+ *     PrintMappedDumpPage(&dump, 40000000, 50, &view);
+ *     UnmapDump(&dump);
+ * }
+ * @endcode
+ *
+ * @see PrintTablePage
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API Status
+PrintMappedDumpPage(const MappedDump *dump, size_t offset, size_t limit,
+                    TableView *view);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // BINARYSERIALIZER_MAPPEDDUMP_H
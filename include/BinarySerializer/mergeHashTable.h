@@ -26,6 +26,7 @@
  */
 #define BINARYSERIALIZER_DEFUALT_BUCKETS_COUNT 512
 
+#include "BinarySerializer/allocator.h"
 #include "BinarySerializer/config.h"
 #include "BinarySerializer/statData.h"
 #include <stddef.h>
@@ -206,12 +207,72 @@ typedef struct MergeHashTable {
    * @private
    */
   size_t bucketsCount;
+
+  /**
+   * @brief Аллокатор бакетов, узлов и результата HashTableToArray()
+   * @private
+   */
+  Allocator allocator;
 } MergeHashTable;
 
+/**
+ * @def BINARYSERIALIZER_CHAIN_HISTOGRAM_SIZE
+ * @brief Количество интервалов гистограммы длин цепочек HashTableStats
+ *
+ * Интервал 0 - пустые бакеты, интервал k > 0 - цепочки длиной
+ * [2^(k-1), 2^k), последний интервал также включает все более длинные.
+ */
+#define BINARYSERIALIZER_CHAIN_HISTOGRAM_SIZE 24
+
+/**
+ * @struct HashTableStats
+ * @brief Распределение элементов по бакетам и занимаемая таблицей память
+ *
+ * @see GetHashTableStats
+ */
+typedef struct HashTableStats {
+  size_t elementsCount;  /**< Количество элементов */
+  size_t bucketsCount;   /**< Количество бакетов */
+  size_t emptyBuckets;   /**< Бакетов без элементов */
+  size_t maxChainLength; /**< Длина самой длинной цепочки */
+  double loadFactor;     /**< elementsCount / bucketsCount */
+  /** Средняя длина непустой цепочки */
+  double meanChainLength;
+  /**
+   * Среднее число узлов, просматриваемых при вставке существующего id:
+   * сумма len * (len + 1) / 2 по бакетам, деленная на elementsCount
+   */
+  double meanProbeLength;
+  /** Количество бакетов по интервалам длин цепочек */
+  size_t chainHistogram[BINARYSERIALIZER_CHAIN_HISTOGRAM_SIZE];
+  size_t bucketsBytes; /**< Память массива бакетов */
+  size_t nodesBytes;   /**< Память массивов узлов (по емкости) */
+  /** Память записей StatData узлов, включая сохраненные после
+   * ResetHashTable() и EraseFromHashTable() */
+  size_t payloadBytes;
+  /** bucketsBytes + nodesBytes + payloadBytes */
+  size_t totalBytes;
+} HashTableStats;
+
 #if defined(__cplusplus)
 extern "C" {
 #endif
 
+/**
+ * @brief Слияние двух записей по правилам таблицы по умолчанию
+ *
+ * Та же функция, что используется InitHashTable() при merge == NULL:
+ * count и cost складываются, primary равен 0, если хотя бы в одной записи он
+ * 0, mode принимает максимальное значение.
+ *
+ * @param[in,out] lhs Запись, в которую сохраняется результат
+ * @param[in] rhs Присоединяемая запись (только чтение)
+ *
+ * @see MergeFunction
+ */
+BINARYSERIALIZER_API void MergeStatData(StatData *__restrict lhs,
+                                        const StatData *__restrict rhs);
+
 /**
  * @brief Инициализация хеш-таблицы с заданными функциями
  *
@@ -242,6 +303,67 @@ BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API int
 InitHashTable(MergeHashTable *table, HashFunction hash, MergeFunction merge,
               StatDataCompareFunction comparator);
 
+/**
+ * @brief Инициализация хеш-таблицы с заданным количеством бакетов
+ *
+ * Аналог InitHashTable() для больших объемов данных: количество бакетов
+ * округляется вверх до ближайшей степени двойки.
+ *
+ * @param[out] table Указатель на структуру таблицы для инициализации
+ * @param[in] bucketsCount Желаемое количество бакетов (должно быть > 0)
+ * @param[in] hash Функция вычисления хеш-значения, может быть NULL
+ * @param[in] merge Функция слияния элементов, может быть NULL
+ * @param[in] comparator Функция сравнения элементов, может быть NULL
+ *
+ * @return 1 при успешной инициализации, нулевое значение при ошибке
+ *
+ * @code{.c}
+ * MergeHashTable table;
+ * // ~1 элемент на бакет для миллиона уникальных id
+ * if (!InitHashTableWithBuckets(&table, 1 << 20, NULL, NULL, NULL)) {
+ *     return -1;
+ * }
+ * @endcode
+ *
+ * @see InitHashTable, ClearHashTable
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API int
+InitHashTableWithBuckets(MergeHashTable *table, size_t bucketsCount,
+                         HashFunction hash, MergeFunction merge,
+                         StatDataCompareFunction comparator);
+
+/**
+ * @brief Инициализация хеш-таблицы с пользовательским аллокатором
+ *
+ * Аналог InitHashTableWithBuckets(): бакеты, узлы, рабочие буферы пакетной
+ * вставки и массив HashTableToArray() выделяются через allocator.
+ *
+ * @param[out] table Указатель на структуру таблицы для инициализации
+ * @param[in] bucketsCount Желаемое количество бакетов (должно быть > 0)
+ * @param[in] hash Функция вычисления хеш-значения, может быть NULL
+ * @param[in] merge Функция слияния элементов, может быть NULL
+ * @param[in] comparator Функция сравнения элементов, может быть NULL
+ * @param[in] allocator Аллокатор (копируется), NULL - DefaultAllocator()
+ *
+ * @return 1 при успешной инициализации, нулевое значение при ошибке или
+ * если у allocator не заданы все функции
+ *
+ * @code{.c}
+ * MergeHashTable table;
+ * if (!InitHashTableWithAllocator(&table, 1 << 20, NULL, NULL, NULL,
+ *                                 &hugePagesAllocator)) {
+ *     return -1;
+ * }
+ * @endcode
+ *
+ * @see InitHashTableWithBuckets, Allocator
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API int
+InitHashTableWithAllocator(MergeHashTable *table, size_t bucketsCount,
+                           HashFunction hash, MergeFunction merge,
+                           StatDataCompareFunction comparator,
+                           const Allocator *allocator);
+
 /**
  * @brief Вставка элемента в хеш-таблицу с автоматическим слиянием
  *
@@ -272,6 +394,33 @@ InitHashTable(MergeHashTable *table, HashFunction hash, MergeFunction merge,
 BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API int
 InsertToHashTable(MergeHashTable *table, const StatData *data);
 
+/**
+ * @brief Пакетная вставка массива элементов с агрегацией повторов
+ *
+ * Результат эквивалентен вызову InsertToHashTable() для каждого элемента.
+ * Если таблица использует merge и comparator по умолчанию, записи сначала
+ * сворачиваются по id внутри пакета (суммы count/cost, И для primary,
+ * максимум mode накапливаются за один проход без распаковки битовых полей
+ * в таблице), и в таблицу попадает одна запись на каждый различный id. Это
+ * многократно ускоряет вставку потоков, в которых немногие id повторяются
+ * очень часто.
+ *
+ * @param[in,out] table Указатель на хеш-таблицу
+ * @param[in] data Массив вставляемых записей
+ * @param[in] size Количество записей
+ *
+ * @return 1 при успешной вставке, нулевое значение при ошибке
+ *
+ * @note Порядок суммирования cost отличается от поэлементной вставки,
+ * результат может отличаться в пределах погрешности float
+ * @warning При ошибке часть записей может быть уже вставлена
+ *
+ * @see InsertToHashTable
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API int
+InsertBatchToHashTable(MergeHashTable *table, const StatData *data,
+                       size_t size);
+
 /**
  * @brief Удаление элемента из хеш-таблицы
  *
@@ -347,6 +496,87 @@ FindInHashTable(const MergeHashTable *table, const StatData *data);
  */
 BINARYSERIALIZER_API void ClearHashTable(MergeHashTable *table);
 
+/**
+ * @brief Удаляет все элементы, сохраняя выделенную память
+ *
+ * Бакеты, массивы узлов и записи остаются выделенными и переиспользуются
+ * следующими вставками, поэтому повторное заполнение таблицы близким
+ * набором id не выделяет память. Функции hash, merge, comparator и
+ * количество бакетов не меняются. Память освобождает ClearHashTable().
+ *
+ * @param[in,out] table Указатель на хеш-таблицу (NULL игнорируется)
+ *
+ * @par Сложность:
+ * O(bucketsCount)
+ *
+ * @see ClearHashTable
+ */
+BINARYSERIALIZER_API void ResetHashTable(MergeHashTable *table);
+
+/**
+ * @brief Количество элементов в таблице
+ *
+ * @param[in] table Указатель на хеш-таблицу
+ *
+ * @return Количество уникальных элементов, 0 если table == NULL
+ *
+ * @par Сложность: O(bucketsCount)
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API size_t
+HashTableSize(const MergeHashTable *table);
+
+/**
+ * @brief Статистика распределения элементов и памяти таблицы
+ *
+ * Позволяет обнаружить перекос распределения id (несколько огромных цепочек
+ * при пустых остальных бакетах) без профилировщика. Размеры памяти считаются
+ * по запрошенным у аллокатора байтам, без его служебных данных.
+ *
+ * @param[in] table Указатель на хеш-таблицу
+ * @param[out] stats Структура для результата
+ *
+ * @return 1 при успехе, 0 если table == NULL или stats == NULL
+ *
+ * @par Сложность: O(bucketsCount)
+ *
+ * @par Пример:
+ * @code{.c}
+ * HashTableStats stats;
+ * if (GetHashTableStats(&table, &stats) && stats.maxChainLength > 64) {
+ *     // таблице нужно больше бакетов
+ * }
+ * @endcode
+ *
+ * @see HashTableStats, InitHashTableWithBuckets
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API int
+GetHashTableStats(const MergeHashTable *table, HashTableStats *stats);
+
+/**
+ * @brief Копирование элементов таблицы в буфер вызывающей стороны
+ *
+ * В отличие от HashTableToArray() не выделяет память: элементы копируются
+ * напрямую, например в отображенный в память файл. Порядок элементов
+ * совпадает с HashTableToArray().
+ *
+ * @param[in] table Указатель на хеш-таблицу
+ * @param[out] data Буфер для элементов
+ * @param[in] size Емкость буфера в элементах
+ *
+ * @return Количество скопированных элементов (не больше size)
+ *
+ * @par Пример:
+ * @code{.c}
+ * size_t count = HashTableSize(&table);
+ * StatData *buffer = mapping; // минимум count элементов
+ * HashTableToBuffer(&table, buffer, count);
+ * @endcode
+ *
+ * @see HashTableSize, HashTableToArray
+ */
+BINARYSERIALIZER_API size_t HashTableToBuffer(const MergeHashTable *table,
+                                              StatData *data, size_t size);
+
 /**
  * @brief Экспорт всех элементов таблицы в массив
  *
@@ -361,6 +591,7 @@ BINARYSERIALIZER_API void ClearHashTable(MergeHashTable *table);
  * @return 1 при успехе, нулевое значение при ошибке выделения памяти
  *
  * @note Вызывающий код отвечает за освобождение памяти массива через free()
+ * или, для таблицы из InitHashTableWithAllocator(), через ее аллокатор
  * @warning При ошибке data и size не изменяются
  *
  * @par Пример:
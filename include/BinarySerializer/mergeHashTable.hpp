@@ -0,0 +1,211 @@
+/**
+ * @file mergeHashTable.hpp
+ * @brief C++20 интерфейс хеш-таблицы со слиянием и политиками-шаблонами
+ * @author Melpomenna
+ * @version 1.0
+ * @date 18.10.2026
+ *
+ * Шаблонный аналог BINARYSERIALIZER_DEFINE_MERGE_HASH_TABLE для потребителей
+ * на C++. Политики передаются как типы функциональных объектов и встраиваются
+ * компилятором, память освобождается автоматически.
+ *
+ * @see specializedHashTable.h, mergePolicy.h
+ */
+
+#ifndef BINARYSERIALIZER_MERGEHASHTABLE_HPP
+#define BINARYSERIALIZER_MERGEHASHTABLE_HPP
+
+#include "BinarySerializer/mergeHashTable.h"
+#include "BinarySerializer/mergePolicy.h"
+#include "BinarySerializer/statData.h"
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace bs {
+
+/**
+ * @brief Политика хеширования: HashT operator()(const StatData &)
+ */
+template <typename T>
+concept HashPolicy = requires(const T policy, const StatData &data) {
+  { policy(data) } -> std::convertible_to<HashT>;
+};
+
+/**
+ * @brief Политика сравнения ключей: bool operator()(lhs, rhs)
+ */
+template <typename T>
+concept EqualPolicy =
+    requires(const T policy, const StatData &lhs, const StatData &rhs) {
+      { policy(lhs, rhs) } -> std::convertible_to<bool>;
+    };
+
+/**
+ * @brief Политика слияния: void operator()(StatData &lhs, const StatData &rhs)
+ */
+template <typename T>
+concept MergePolicy =
+    requires(const T policy, StatData &lhs, const StatData &rhs) {
+      policy(lhs, rhs);
+    };
+
+/** @brief Хеш по id (MurmurHash2-64A), как в MergeHashTable */
+struct IdHash {
+  HashT operator()(const StatData &data) const noexcept {
+    return DefaultStatDataHash(&data);
+  }
+};
+
+/** @brief Равенство по id */
+struct IdEqual {
+  bool operator()(const StatData &lhs, const StatData &rhs) const noexcept {
+    return lhs.id == rhs.id;
+  }
+};
+
+/** @brief Слияние по правилам JoinDump() */
+struct DefaultMerge {
+  void operator()(StatData &lhs, const StatData &rhs) const noexcept {
+    DefaultStatDataMerge(&lhs, &rhs);
+  }
+};
+
+/**
+ * @class BasicMergeHashTable
+ * @brief Хеш-таблица со слиянием записей с одинаковым ключом
+ *
+ * Разрешение коллизий цепочками, число бакетов фиксируется в конструкторе и
+ * округляется вверх до степени двойки. Записи каждого бакета хранятся
+ * непрерывно.
+ *
+ * @code{.cpp}
+ * bs::DefaultMergeHashTable table(1 << 16);
+ * for (const StatData &record : records) {
+ *     table.Insert(record);
+ * }
+ * std::vector<StatData> joined = table.ToVector();
+ * @endcode
+ */
+template <HashPolicy Hash = IdHash, EqualPolicy Equal = IdEqual,
+          MergePolicy Merge = DefaultMerge>
+class BasicMergeHashTable {
+public:
+  explicit BasicMergeHashTable(
+      std::size_t bucketsCount = BINARYSERIALIZER_DEFUALT_BUCKETS_COUNT,
+      Hash hash = {}, Equal equal = {}, Merge merge = {})
+      : buckets_(RoundUpToPowerOfTwo(bucketsCount)), hash_(hash),
+        equal_(equal), merge_(merge) {}
+
+  /**
+   * @brief Вставляет запись или сливает ее с уже существующей
+   */
+  void Insert(const StatData &data) {
+    const HashT hash = hash_(data);
+    Bucket &bucket = buckets_[HashToBucketIndex(hash, buckets_.size())];
+    for (std::size_t i = 0; i < bucket.hashes.size(); ++i) {
+      if (bucket.hashes[i] == hash && equal_(bucket.data[i], data)) {
+        merge_(bucket.data[i], data);
+        return;
+      }
+    }
+    bucket.hashes.push_back(hash);
+    bucket.data.push_back(data);
+    ++size_;
+  }
+
+  /**
+   * @brief Вставляет все записи диапазона
+   */
+  void Insert(std::span<const StatData> data) {
+    for (const StatData &record : data) {
+      Insert(record);
+    }
+  }
+
+  /**
+   * @brief Ищет запись с тем же ключом, что и key
+   * @return Указатель на запись в таблице или nullptr
+   */
+  [[nodiscard]] const StatData *Find(const StatData &key) const {
+    const HashT hash = hash_(key);
+    const Bucket &bucket = buckets_[HashToBucketIndex(hash, buckets_.size())];
+    for (std::size_t i = 0; i < bucket.hashes.size(); ++i) {
+      if (bucket.hashes[i] == hash && equal_(bucket.data[i], key)) {
+        return &bucket.data[i];
+      }
+    }
+    return nullptr;
+  }
+
+  [[nodiscard]] std::size_t Size() const noexcept { return size_; }
+
+  [[nodiscard]] std::size_t BucketsCount() const noexcept {
+    return buckets_.size();
+  }
+
+  /**
+   * @brief Копирует не более out.size() записей в out
+   * @return Количество скопированных записей
+   */
+  std::size_t ToBuffer(std::span<StatData> out) const {
+    std::size_t shift = 0;
+    for (const Bucket &bucket : buckets_) {
+      const std::size_t count =
+          std::min(bucket.data.size(), out.size() - shift);
+      std::copy_n(bucket.data.begin(), count, out.begin() + shift);
+      shift += count;
+      if (shift == out.size()) {
+        break;
+      }
+    }
+    return shift;
+  }
+
+  [[nodiscard]] std::vector<StatData> ToVector() const {
+    std::vector<StatData> result(size_);
+    ToBuffer(result);
+    return result;
+  }
+
+  /**
+   * @brief Удаляет все записи, сохраняя количество бакетов
+   */
+  void Clear() noexcept {
+    for (Bucket &bucket : buckets_) {
+      bucket.hashes.clear();
+      bucket.data.clear();
+    }
+    size_ = 0;
+  }
+
+private:
+  struct Bucket {
+    std::vector<HashT> hashes;
+    std::vector<StatData> data;
+  };
+
+  static std::size_t RoundUpToPowerOfTwo(std::size_t count) noexcept {
+    std::size_t rounded = 1;
+    while (rounded < count) {
+      rounded <<= 1;
+    }
+    return rounded;
+  }
+
+  std::vector<Bucket> buckets_;
+  std::size_t size_ = 0;
+  [[no_unique_address]] Hash hash_;
+  [[no_unique_address]] Equal equal_;
+  [[no_unique_address]] Merge merge_;
+};
+
+/** @brief Таблица с политиками по умолчанию, как у JoinDump() */
+using DefaultMergeHashTable = BasicMergeHashTable<>;
+
+} // namespace bs
+
+#endif // BINARYSERIALIZER_MERGEHASHTABLE_HPP
@@ -0,0 +1,96 @@
+/**
+ * @file mergePolicy.h
+ * @brief Встраиваемые политики хеширования, сравнения и слияния StatData
+ * @author Melpomenna
+ * @version 1.0
+ * @date 18.10.2026
+ *
+ * Политики по умолчанию, которые MergeHashTable использует при передаче NULL
+ * в InitHashTable(), в виде static inline функций. В отличие от указателей на
+ * функции, такие политики компилятор может встроить прямо в цикл вставки.
+ *
+ * @see specializedHashTable.h, mergeHashTable.hpp
+ */
+
+#ifndef BINARYSERIALIZER_MERGEPOLICY_H
+#define BINARYSERIALIZER_MERGEPOLICY_H
+
+#include "BinarySerializer/config.h"
+#include "BinarySerializer/mergeHashTable.h"
+#include "BinarySerializer/statData.h"
+
+#include <stddef.h>
+
+/**
+ * @brief MurmurHash2-64A от поля id
+ *
+ * Совпадает с функцией хеширования MergeHashTable по умолчанию.
+ *
+ * @param[in] data Хешируемая запись (не должна быть NULL)
+ *
+ * @return 64-битное хеш-значение
+ */
+static inline HashT DefaultStatDataHash(const StatData *data) {
+  const HashT m = 0xc6a4a7935bd1e995ULL;
+  const int r = 47;
+  HashT h = 0x8445d61a4e774912ULL ^ (8 * m);
+
+  HashT k = (HashT)data->id;
+  k *= m;
+  k ^= k >> r;
+  k *= m;
+
+  h ^= k;
+  h *= m;
+
+  h ^= h >> r;
+  h *= m;
+  h ^= h >> r;
+
+  return h;
+}
+
+/**
+ * @brief Сравнение записей по id
+ *
+ * @return 1 если lhs->id == rhs->id, иначе 0
+ */
+static inline int DefaultStatDataEqual(const StatData *lhs,
+                                       const StatData *rhs) {
+  return lhs->id == rhs->id;
+}
+
+/**
+ * @brief Слияние rhs в lhs по правилам JoinDump()
+ *
+ * count и cost складываются, primary объединяется через И, mode принимает
+ * максимальное значение.
+ *
+ * @param[in,out] lhs Запись, в которую сохраняется результат
+ * @param[in] rhs Присоединяемая запись (только чтение)
+ */
+static inline void DefaultStatDataMerge(StatData *lhs, const StatData *rhs) {
+  lhs->count += rhs->count;
+  lhs->cost += rhs->cost;
+  lhs->primary &= rhs->primary;
+
+  // max(mode) without if, for performance branch predictor
+  unsigned lhsMode = lhs->mode;
+  unsigned rhsMode = rhs->mode;
+  unsigned greater = lhsMode > rhsMode;
+  lhs->mode = greater * lhsMode + (greater ^ 1u) * rhsMode;
+}
+
+/**
+ * @brief Индекс бакета для хеш-значения
+ *
+ * @param[in] hash Хеш-значение ключа
+ * @param[in] bucketsCount Количество бакетов (степень двойки)
+ *
+ * @return Индекс в диапазоне [0, bucketsCount)
+ */
+static inline size_t HashToBucketIndex(HashT hash, size_t bucketsCount) {
+  return (size_t)((hash ^ (hash >> 16)) & (bucketsCount - 1));
+}
+
+#endif // BINARYSERIALIZER_MERGEPOLICY_H
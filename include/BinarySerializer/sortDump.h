@@ -0,0 +1,248 @@
+/**
+ * @file sortDump.h
+ * @brief Сортировка массивов StatData по ключевым полям
+ * @author Melpomenna
+ * @version 1.0
+ * @date 18.10.2026
+ *
+ * В отличие от SortDump(), которой передается произвольная функция сравнения,
+ * функции этого модуля сортируют по известному полю записи. Это позволяет
+ * использовать поразрядную (LSD radix) сортировку без косвенных вызовов на
+ * каждое сравнение.
+ */
+
+#ifndef BINARYSERIALIZER_SORTDUMP_H
+#define BINARYSERIALIZER_SORTDUMP_H
+
+#include "BinarySerializer/binarySerializer.h"
+#include "BinarySerializer/config.h"
+#include "BinarySerializer/statData.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @enum SortField
+ * @brief Поле StatData, по которому выполняется сортировка
+ */
+typedef enum SortField {
+  SORT_FIELD_ID,  /**< Сортировка по id */
+  SORT_FIELD_COST /**< Сортировка по cost */
+} SortField;
+
+/**
+ * @enum SortDirection
+ * @brief Направление сортировки
+ */
+typedef enum SortDirection {
+  SORT_ASC, /**< По возрастанию */
+  SORT_DESC /**< По убыванию */
+} SortDirection;
+
+/**
+ * @struct SortKeySpec
+ * @brief Один ключ составной сортировки SortDumpByKeys()
+ */
+typedef struct SortKeySpec {
+  SortField field;         /**< Поле ключа */
+  SortDirection direction; /**< Направление по этому полю */
+} SortKeySpec;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief Сортирует массив StatData по одному полю
+ *
+ * Поразрядная LSD сортировка по байтам ключа. Для cost используется
+ * сохраняющее порядок преобразование битов float в беззнаковое целое, для id
+ * инвертируется знаковый бит. Проходы, в которых все записи имеют одинаковый
+ * байт ключа, пропускаются, поэтому для небольших диапазонов id выполняется
+ * лишь несколько проходов. Сложность O(n * k), где k - число значимых байтов
+ * ключа.
+ *
+ * Сортировка устойчива: записи с равными ключами сохраняют исходный порядок
+ * при любом направлении.
+ *
+ * @param[in,out] data Массив для сортировки (не должен быть NULL)
+ * @param[in] size Количество элементов (должно быть > 0)
+ * @param[in] field Поле сортировки
+ * @param[in] direction Направление сортировки
+ *
+ * @return SUCCESS при успешной сортировке
+ * @return INVALID_POINTER_OR_SIZE если data == NULL, size == 0 или field /
+ * direction вне допустимых значений
+ * @return ERROR при ошибке выделения вспомогательного буфера
+ *
+ * @note Требует вспомогательный буфер размером с массив
+ * @note NaN в cost упорядочиваются по битовому представлению: положительные
+ * NaN после +inf, отрицательные перед -inf
+ *
+ * @par Пример использования:
+ * @code
+ * // Сортировка результата объединения по убыванию стоимости
+ * Status result = SortDumpByKey(data, size, SORT_FIELD_COST, SORT_DESC);
+ * @endcode
+ *
+ * @see SortDump
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API Status
+SortDumpByKey(StatData *data, size_t size, SortField field,
+              SortDirection direction);
+
+/**
+ * @brief Устойчивая сортировка по нескольким ключам
+ *
+ * Записи упорядочиваются по keys[0], при равенстве - по keys[1] и т.д.;
+ * при равенстве всех ключей сохраняется исходный порядок. Выполняется
+ * цепочкой устойчивых проходов SortDumpByKey() от последнего ключа к
+ * первому, каждый проход - специализированная radix сортировка своего поля
+ * без функции сравнения. Повторное упоминание поля ничего не меняет и
+ * пропускается.
+ *
+ * @param[in,out] data Массив для сортировки (не должен быть NULL)
+ * @param[in] size Количество элементов (должно быть > 0)
+ * @param[in] keys Ключи в порядке убывания значимости (не должен быть NULL)
+ * @param[in] keysCount Количество ключей (должно быть > 0)
+ *
+ * @return SUCCESS при успешной сортировке
+ * @return INVALID_POINTER_OR_SIZE если data == NULL, keys == NULL, size == 0,
+ * keysCount == 0 или один из ключей вне допустимых значений
+ * @return ERROR при ошибке выделения вспомогательного буфера
+ *
+ * @par Пример использования:
+ * @code
+ * // По убыванию стоимости, при равной стоимости - по возрастанию id
+ * const SortKeySpec keys[] = {{SORT_FIELD_COST, SORT_DESC},
+ *                             {SORT_FIELD_ID, SORT_ASC}};
+ * Status result = SortDumpByKeys(data, size, keys, 2);
+ * @endcode
+ *
+ * @see SortDumpByKey
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API Status
+SortDumpByKeys(StatData *data, size_t size, const SortKeySpec *keys,
+               size_t keysCount);
+
+/**
+ * @brief Многопоточный вариант SortDumpByKey()
+ *
+ * Параллельная LSD radix сортировка: массив делится на блоки по числу
+ * потоков, гистограммы и раскладка записей каждого прохода выполняются
+ * блоками параллельно. Результат совпадает с SortDumpByKey(), включая
+ * устойчивость. Для массивов меньше 65536 записей и threadsCount == 1
+ * выполняется однопоточная сортировка.
+ *
+ * @param[in,out] data Массив для сортировки (не должен быть NULL)
+ * @param[in] size Количество элементов (должно быть > 0)
+ * @param[in] field Поле сортировки
+ * @param[in] direction Направление сортировки
+ * @param[in] threadsCount Количество потоков, 0 - по числу доступных
+ * процессоров
+ *
+ * @return SUCCESS при успешной сортировке
+ * @return INVALID_POINTER_OR_SIZE если data == NULL, size == 0 или field /
+ * direction вне допустимых значений
+ * @return ERROR при ошибке выделения памяти или запуска потоков
+ *
+ * @note Потоки создаются на время вызова
+ *
+ * @see SortDumpByKey
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API Status
+SortDumpByKeyParallel(StatData *data, size_t size, SortField field,
+                      SortDirection direction, size_t threadsCount);
+
+/**
+ * @brief Выбирает k первых записей порядка SortDumpByKey() без полной
+ * сортировки
+ *
+ * Записи просматриваются один раз, лучшие k кандидатов хранятся в куче
+ * размера k, сложность O(n log k). Результат совпадает с первыми min(k, size)
+ * записями устойчивой SortDumpByKey(): при равных ключах раньше идет запись
+ * с меньшим индексом во входном массиве. Исходный массив не изменяется.
+ *
+ * @param[in] data Входной массив (не должен быть NULL)
+ * @param[in] size Количество элементов (должно быть > 0)
+ * @param[in] field Поле сортировки
+ * @param[in] direction SORT_ASC - k наименьших, SORT_DESC - k наибольших
+ * @param[out] result Буфер не меньше чем на min(k, size) записей, результат
+ * упорядочен по ключу
+ * @param[in] k Количество выбираемых записей (должно быть > 0)
+ *
+ * @return SUCCESS при успехе, в result записано min(k, size) записей
+ * @return INVALID_POINTER_OR_SIZE если data == NULL, result == NULL,
+ * size == 0, k == 0 или field / direction вне допустимых значений
+ * @return ERROR при ошибке выделения памяти
+ *
+ * @par Пример использования:
+ * @code
+ * // 10 самых дорогих записей агрегата
+ * StatData top[10];
+ * Status result = TopKByKey(data, size, SORT_FIELD_COST, SORT_DESC, top, 10);
+ * @endcode
+ *
+ * @see SortDumpByKey
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API Status
+TopKByKey(const StatData *data, size_t size, SortField field,
+          SortDirection direction, StatData *result, size_t k);
+
+/**
+ * @brief Вычисляет перестановку, упорядочивающую массив, не перемещая записи
+ *
+ * Сортируются пары (ключ, индекс) по 16 байт (для cost - 8 байт) вместо
+ * 24-байтовых StatData, порядок совпадает с устойчивой SortDumpByKey():
+ * permutation[i] - индекс записи, стоящей на i-й позиции отсортированного
+ * массива. Перестановку можно применить через GatherByPermutation() или
+ * использовать для вывода без переупорядочивания (PrintDumpPermuted()).
+ *
+ * @param[in] data Входной массив (не должен быть NULL)
+ * @param[in] size Количество элементов (0 < size <= UINT32_MAX)
+ * @param[in] field Поле сортировки
+ * @param[in] direction Направление сортировки
+ * @param[out] permutation Буфер на size индексов
+ *
+ * @return SUCCESS при успехе
+ * @return INVALID_POINTER_OR_SIZE если data == NULL, permutation == NULL,
+ * size вне допустимого диапазона или field / direction вне допустимых
+ * значений
+ * @return ERROR при ошибке выделения памяти
+ *
+ * @par Пример использования:
+ * @code
+ * uint32_t *order = malloc(sizeof(uint32_t) * size);
+ * Status result = ArgSortByKey(data, size, SORT_FIELD_COST, SORT_DESC, order);
+ * @endcode
+ *
+ * @see SortDumpByKey, GatherByPermutation
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API Status
+ArgSortByKey(const StatData *data, size_t size, SortField field,
+             SortDirection direction, uint32_t *permutation);
+
+/**
+ * @brief Собирает записи в порядке перестановки: result[i] =
+ * data[permutation[i]]
+ *
+ * @param[in] data Входной массив (не должен быть NULL)
+ * @param[in] permutation Индексы в data, каждый меньше размера data
+ * @param[in] size Количество элементов permutation и result (должно быть > 0)
+ * @param[out] result Выходной массив, не должен совпадать с data
+ *
+ * @return SUCCESS при успехе
+ * @return INVALID_POINTER_OR_SIZE если указатели NULL, size == 0 или
+ * result == data
+ *
+ * @see ArgSortByKey
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API Status
+GatherByPermutation(const StatData *data, const uint32_t *permutation,
+                    size_t size, StatData *result);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // BINARYSERIALIZER_SORTDUMP_H
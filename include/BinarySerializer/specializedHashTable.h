@@ -0,0 +1,191 @@
+/**
+ * @file specializedHashTable.h
+ * @brief Генерация хеш-таблиц со слиянием, специализированных на этапе
+ * компиляции
+ * @author Melpomenna
+ * @version 1.0
+ * @date 18.10.2026
+ *
+ * MergeHashTable вызывает hash, comparator и merge через указатели на функции,
+ * поэтому компилятор не может встроить их в цикл вставки. Макрос
+ * BINARYSERIALIZER_DEFINE_MERGE_HASH_TABLE создает отдельный тип таблицы, в
+ * котором политики подставлены напрямую и встраиваются. Записи хранятся прямо
+ * в массивах бакетов, без отдельного выделения памяти на каждый узел.
+ *
+ * Для типовой агрегации уже определена таблица DefaultMergeTable с политиками
+ * из mergePolicy.h.
+ *
+ * @see mergeHashTable.h, mergeHashTable.hpp
+ */
+
+#ifndef BINARYSERIALIZER_SPECIALIZEDHASHTABLE_H
+#define BINARYSERIALIZER_SPECIALIZEDHASHTABLE_H
+
+#include "BinarySerializer/config.h"
+#include "BinarySerializer/mergeHashTable.h"
+#include "BinarySerializer/mergePolicy.h"
+#include "BinarySerializer/statData.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @def BINARYSERIALIZER_DEFINE_MERGE_HASH_TABLE
+ * @brief Определяет тип хеш-таблицы Name со встроенными политиками
+ *
+ * Генерирует тип Name и static inline функции:
+ * - int Name##Init(Name *table, size_t bucketsCount) - 1 при успехе;
+ *   bucketsCount округляется вверх до степени двойки, 0 означает
+ *   BINARYSERIALIZER_DEFUALT_BUCKETS_COUNT
+ * - int Name##Insert(Name *table, const StatData *data) - вставка или слияние,
+ *   0 при ошибке выделения памяти
+ * - StatData *Name##Find(const Name *table, const StatData *key)
+ * - size_t Name##Size(const Name *table)
+ * - size_t Name##ToBuffer(const Name *table, StatData *data, size_t size)
+ * - void Name##Clear(Name *table)
+ *
+ * Семантика совпадает с одноименными функциями MergeHashTable.
+ *
+ * @param Name Имя генерируемого типа
+ * @param HASH Функция HashT (const StatData *)
+ * @param EQUAL Функция int (const StatData *, const StatData *)
+ * @param MERGE Функция void (StatData *, const StatData *)
+ *
+ * @code{.c}
+ * BINARYSERIALIZER_DEFINE_MERGE_HASH_TABLE(CountTable, DefaultStatDataHash,
+ *                                          DefaultStatDataEqual, SumCount)
+ *
+ * CountTable table;
+ * if (CountTableInit(&table, 4096)) {
+ *     CountTableInsert(&table, &record);
+ *     CountTableClear(&table);
+ * }
+ * @endcode
+ */
+#define BINARYSERIALIZER_DEFINE_MERGE_HASH_TABLE(Name, HASH, EQUAL, MERGE)     \
+  typedef struct Name##Bucket {                                                \
+    HashT *hashes;                                                             \
+    StatData *data;                                                            \
+    size_t count;                                                              \
+    size_t capacity;                                                           \
+  } Name##Bucket;                                                              \
+                                                                               \
+  typedef struct Name {                                                        \
+    Name##Bucket *buckets;                                                     \
+    size_t bucketsCount;                                                       \
+    size_t size;                                                               \
+  } Name;                                                                      \
+                                                                               \
+  static inline int Name##Init(Name *table, size_t bucketsCount) {             \
+    if (BINARYSERIALIZER_UNLIKELY(!table)) {                                   \
+      return 0;                                                                \
+    }                                                                          \
+    if (bucketsCount == 0) {                                                   \
+      bucketsCount = BINARYSERIALIZER_DEFUALT_BUCKETS_COUNT;                   \
+    }                                                                          \
+    size_t roundedCount = 1;                                                   \
+    while (roundedCount < bucketsCount) {                                      \
+      roundedCount <<= 1;                                                      \
+    }                                                                          \
+    table->buckets =                                                           \
+        (Name##Bucket *)calloc(roundedCount, sizeof(Name##Bucket));            \
+    table->bucketsCount = table->buckets ? roundedCount : 0;                   \
+    table->size = 0;                                                           \
+    return table->buckets != NULL;                                             \
+  }                                                                            \
+                                                                               \
+  static inline int Name##Grow(Name##Bucket *bucket) {                         \
+    size_t capacity = bucket->capacity ? bucket->capacity * 2 : 1;             \
+    HashT *hashes =                                                            \
+        (HashT *)realloc(bucket->hashes, sizeof(HashT) * capacity);            \
+    if (BINARYSERIALIZER_UNLIKELY(!hashes)) {                                  \
+      return 0;                                                                \
+    }                                                                          \
+    bucket->hashes = hashes;                                                   \
+    StatData *data =                                                           \
+        (StatData *)realloc(bucket->data, sizeof(StatData) * capacity);        \
+    if (BINARYSERIALIZER_UNLIKELY(!data)) {                                    \
+      return 0;                                                                \
+    }                                                                          \
+    bucket->data = data;                                                       \
+    bucket->capacity = capacity;                                               \
+    return 1;                                                                  \
+  }                                                                            \
+                                                                               \
+  static inline int Name##Insert(Name *table, const StatData *data) {          \
+    HashT hash = HASH(data);                                                   \
+    Name##Bucket *bucket =                                                     \
+        table->buckets + HashToBucketIndex(hash, table->bucketsCount);         \
+    for (size_t i = 0; i < bucket->count; ++i) {                               \
+      if (bucket->hashes[i] == hash && EQUAL(bucket->data + i, data)) {        \
+        MERGE(bucket->data + i, data);                                         \
+        return 1;                                                              \
+      }                                                                        \
+    }                                                                          \
+    if (BINARYSERIALIZER_UNLIKELY(bucket->count == bucket->capacity) &&        \
+        BINARYSERIALIZER_UNLIKELY(!Name##Grow(bucket))) {                      \
+      return 0;                                                                \
+    }                                                                          \
+    bucket->hashes[bucket->count] = hash;                                      \
+    memcpy(bucket->data + bucket->count, data, sizeof(StatData));              \
+    bucket->count++;                                                           \
+    table->size++;                                                             \
+    return 1;                                                                  \
+  }                                                                            \
+                                                                               \
+  static inline StatData *Name##Find(const Name *table, const StatData *key) { \
+    HashT hash = HASH(key);                                                    \
+    const Name##Bucket *bucket =                                               \
+        table->buckets + HashToBucketIndex(hash, table->bucketsCount);         \
+    for (size_t i = 0; i < bucket->count; ++i) {                               \
+      if (bucket->hashes[i] == hash && EQUAL(bucket->data + i, key)) {         \
+        return bucket->data + i;                                               \
+      }                                                                        \
+    }                                                                          \
+    return NULL;                                                               \
+  }                                                                            \
+                                                                               \
+  static inline size_t Name##Size(const Name *table) { return table->size; }   \
+                                                                               \
+  static inline size_t Name##ToBuffer(const Name *table, StatData *data,       \
+                                      size_t size) {                           \
+    size_t shift = 0;                                                          \
+    for (size_t i = 0; i < table->bucketsCount && shift < size; ++i) {         \
+      size_t count = table->buckets[i].count;                                  \
+      if (count > size - shift) {                                              \
+        count = size - shift;                                                  \
+      }                                                                        \
+      if (count != 0) {                                                        \
+        memcpy(data + shift, table->buckets[i].data,                           \
+               sizeof(StatData) * count);                                      \
+      }                                                                        \
+      shift += count;                                                          \
+    }                                                                          \
+    return shift;                                                              \
+  }                                                                            \
+                                                                               \
+  static inline void Name##Clear(Name *table) {                                \
+    if (BINARYSERIALIZER_UNLIKELY(!table)) {                                   \
+      return;                                                                  \
+    }                                                                          \
+    for (size_t i = 0; i < table->bucketsCount; ++i) {                         \
+      free(table->buckets[i].hashes);                                          \
+      free(table->buckets[i].data);                                            \
+    }                                                                          \
+    free(table->buckets);                                                      \
+    table->buckets = NULL;                                                     \
+    table->bucketsCount = 0;                                                   \
+    table->size = 0;                                                           \
+  }
+
+/**
+ * @struct DefaultMergeTable
+ * @brief Таблица с политиками по умолчанию (хеш и равенство по id,
+ * слияние как в JoinDump())
+ */
+BINARYSERIALIZER_DEFINE_MERGE_HASH_TABLE(DefaultMergeTable, DefaultStatDataHash,
+                                         DefaultStatDataEqual,
+                                         DefaultStatDataMerge)
+
+#endif // BINARYSERIALIZER_SPECIALIZEDHASHTABLE_H
@@ -15,6 +15,14 @@
 
 #include "BinarySerializer/config.h"
 #include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * @def BINARYSERIALIZER_TABLE_VIEW_BLOCK_SIZE
+ * @brief Размер блока, которым PrintTable() сбрасывает вывод
+ */
+#define BINARYSERIALIZER_TABLE_VIEW_BLOCK_SIZE (1u << 16)
 
 /**
  * @enum TablewViewStatus
@@ -56,6 +64,41 @@ typedef struct Field {
   int fieldSize; ///< Ширина поля в символах при отображении
 } Field;
 
+/**
+ * @typedef TableSinkFunc
+ * @brief Функция записи отрисованного блока таблицы
+ *
+ * @param context Контекст приемника из TableSink
+ * @param data Очередной блок байт
+ * @param size Размер блока в байтах
+ * @return 1 при успехе, 0 при ошибке
+ */
+typedef int (*TableSinkFunc)(void *context, const char *data, size_t size);
+
+/**
+ * @struct TableSink
+ * @brief Приемник вывода таблицы: функция записи и ее контекст
+ *
+ * PrintTable() отдает приемнику блоки около
+ * BINARYSERIALIZER_TABLE_VIEW_BLOCK_SIZE байт.
+ */
+typedef struct TableSink {
+  TableSinkFunc write; ///< Функция записи
+  void *context;       ///< Контекст, передаваемый в write
+} TableSink;
+
+/**
+ * @struct TableMemoryBuffer
+ * @brief Растущий буфер в памяти для MemoryTableSink()
+ *
+ * Перед первым использованием инициализируется нулями.
+ */
+typedef struct TableMemoryBuffer {
+  char *data;      ///< Накопленные байты (не завершаются нулем)
+  size_t size;     ///< Количество накопленных байт
+  size_t capacity; ///< Размер выделенной памяти
+} TableMemoryBuffer;
+
 /**
  * \struct TableView
  * \brief Представление таблицы данных
@@ -70,8 +113,17 @@ typedef struct TableView {
   size_t fieldsCount; ///< Количество полей в таблице
   size_t dataSize;    ///< Количество элементов в data
   size_t memSize; ///< Размер одного элемента данных в байтах
+  /// Порядок вывода: i-я строка - элемент permutation[i], NULL - по порядку
+  const uint32_t *permutation;
+  char *output; ///< Буфер отрисовки, переиспользуется между вызовами
+  size_t outputCapacity; ///< Размер буфера отрисовки в байтах
+  TableSink sink; ///< Приемник вывода, по умолчанию STDOUT_FILENO
 } TableView;
 
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
 /**
  * @brief Инициализирует структуру TableView
  *
@@ -133,6 +185,13 @@ BINARYSERIALIZER_API void ClearTableView(TableView *view);
  * Использует функцию форматирования, заданную при инициализации, для
  * преобразования данных в текстовое представление.
  *
+ * Строки собираются в буфере view размером около
+ * BINARYSERIALIZER_TABLE_VIEW_BLOCK_SIZE байт, который отдается приемнику
+ * view->sink одним вызовом на блок. Буфер выделяется при первом выводе и
+ * переиспользуется до ClearTableView(). Если приемник - STDOUT_FILENO, перед
+ * выводом сбрасывается буфер stdout, поэтому порядок с предыдущим выводом
+ * через stdio сохраняется.
+ *
  * @param[in] view Указатель на инициализированную структуру TableView
  * @param[in] linesCount Количество строк данных для вывода
  *
@@ -147,6 +206,7 @@ BINARYSERIALIZER_API void ClearTableView(TableView *view);
  * view.data = myDataArray;
  * view.dataSize = dataSize;
  * view.memSize = sizeof(MyStruct);
+ * view.permutation = NULL;
  *
  * if (PrintTable(&view, 10) != TVS_SUCCESS) {
  *   fprintf(stderr, "Ошибка вывода таблицы\n");
@@ -156,4 +216,119 @@ BINARYSERIALIZER_API void ClearTableView(TableView *view);
 BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API TablewViewStatus
 PrintTable(TableView *view, size_t linesCount);
 
+/**
+ * @brief Выводит страницу таблицы: заголовок и строки [offset, offset + limit)
+ *
+ * Оформление совпадает с PrintTable(), номера строк - с номерами в полной
+ * таблице; PrintTablePage(view, 0, n) эквивалентно PrintTable(view, n).
+ * Обращения к данным ограничены выводимыми строками, поэтому над
+ * отображенным в память дампом (см. PrintMappedDumpPage()) подгружаются
+ * только их страницы.
+ *
+ * @param[in] view Инициализированное представление с заданными data и
+ * dataSize
+ * @param[in] offset Первая выводимая строка (меньше dataSize)
+ * @param[in] limit Наибольшее количество строк (> 0), страница обрезается
+ * по концу данных
+ *
+ * @return TVS_SUCCESS при успешном выводе, TVS_ERROR при ошибке или
+ * неверных offset / limit
+ *
+ * @code
+ * // Строки 40 000 000 - 40 000 049
+ * PrintTablePage(&view, 40000000, 50);
+ * @endcode
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API TablewViewStatus
+PrintTablePage(TableView *view, size_t offset, size_t limit);
+
+/**
+ * @brief Выводит только заголовок таблицы (три строки)
+ *
+ * Вместе с PrintTableRange() позволяет собирать таблицу по частям. Вывод
+ * PrintTableHeader() и PrintTableRange() для [0, dataSize) совпадает с
+ * PrintTable(view, dataSize).
+ *
+ * @return TVS_SUCCESS при успешном выводе, TVS_ERROR при ошибке
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API TablewViewStatus
+PrintTableHeader(TableView *view);
+
+/**
+ * @brief Выводит строки данных [begin, end), за каждой - разделитель
+ *
+ * Номера строк совпадают с номерами в полной таблице. Части таблицы можно
+ * отрисовывать параллельно: каждому потоку нужен свой TableView (со своим
+ * буфером и приемником, например MemoryTableSink()) над теми же данными.
+ *
+ * @param[in] view Инициализированное представление с заданными data и
+ * dataSize
+ * @param[in] begin Первая выводимая строка
+ * @param[in] end Строка после последней выводимой (не больше dataSize)
+ *
+ * @return TVS_SUCCESS при успешном выводе, TVS_ERROR при ошибке или
+ * неверном диапазоне
+ *
+ * @code
+ * // Вторая половина таблицы в память
+ * TableMemoryBuffer memory = {0};
+ * SetTableViewSink(&view, MemoryTableSink(&memory));
+ * PrintTableRange(&view, view.dataSize / 2, view.dataSize);
+ * @endcode
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API TablewViewStatus
+PrintTableRange(TableView *view, size_t begin, size_t end);
+
+/**
+ * @brief Задает приемник вывода таблицы
+ *
+ * @param[in,out] view Инициализированное представление
+ * @param[in] sink Приемник, sink.write не должен быть NULL
+ */
+BINARYSERIALIZER_API void SetTableViewSink(TableView *view, TableSink sink);
+
+/**
+ * @brief Приемник, пишущий в файловый дескриптор через write()
+ *
+ * @param[in] fd Дескриптор, открытый на запись (не закрывается)
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API TableSink FdTableSink(int fd);
+
+/**
+ * @brief Приемник, пишущий в FILE* одним fwrite() на блок
+ *
+ * @param[in] file Открытый на запись поток (не закрывается)
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API TableSink
+FileTableSink(FILE *file);
+
+/**
+ * @brief Приемник, дописывающий вывод в растущий буфер в памяти
+ *
+ * Буфер растет удвоением, ранее накопленные байты сохраняются, поэтому одну
+ * отрисовку можно переиспользовать многократно.
+ *
+ * @param[in,out] buffer Буфер, инициализированный нулями или ранее
+ * использованный (должен жить, пока используется приемник)
+ *
+ * @code
+ * TableMemoryBuffer memory = {0};
+ * SetTableViewSink(&view, MemoryTableSink(&memory));
+ * PrintTable(&view, 100);
+ * // memory.data, memory.size - отрисованная таблица
+ * ClearTableMemoryBuffer(&memory);
+ * @endcode
+ */
+BINARYSERIALIZER_NODISCARD BINARYSERIALIZER_API TableSink
+MemoryTableSink(TableMemoryBuffer *buffer);
+
+/**
+ * @brief Освобождает память TableMemoryBuffer и обнуляет его
+ */
+BINARYSERIALIZER_API void ClearTableMemoryBuffer(TableMemoryBuffer *buffer);
+
+#if defined(__cplusplus)
+}
+#endif
+
 #endif // TABLEVIEW_H
\ No newline at end of file
@@ -0,0 +1,130 @@
+/**
+ * @file allocation.h
+ * @brief Выделение памяти внутри библиотеки с учетом в instrumentation.h
+ * @author Melpomenna
+ * @version 1.0
+ * @date 18.10.2026
+ *
+ * Внутренний модуль библиотеки, не входит в публичное API. Все выделения
+ * библиотеки проходят через эти функции: при выключенном сборе они сводятся
+ * к malloc/realloc/free (mimalloc при BS_ENABLE_MI_MALLOC) и одной проверке
+ * флага, при включенном - дополнительно учитывают фактический размер блока.
+ * Блоки совместимы с free() вызывающей стороны.
+ */
+
+#ifndef BINARYSERIALIZER_INTERNAL_ALLOCATION_H
+#define BINARYSERIALIZER_INTERNAL_ALLOCATION_H
+
+#include "BinarySerializer/allocator.h"
+#include "internal/instrumentation.h"
+
+#if defined(BS_ENABLE_MI_MALLOC)
+#include <mimalloc-override.h>
+#else
+#include <malloc.h>
+#include <stdlib.h>
+#endif
+
+/**
+ * @brief malloc() с учетом выделения
+ */
+static inline void *AllocateMemory(size_t size) {
+  void *memory = malloc(size);
+#if !defined(BS_DISABLE_INSTRUMENTATION)
+  if (InstrumentationEnabled() && memory) {
+    TrackAllocation(malloc_usable_size(memory));
+  }
+#endif
+  return memory;
+}
+
+/**
+ * @brief calloc() с учетом выделения
+ */
+static inline void *AllocateZeroedMemory(size_t count, size_t size) {
+  void *memory = calloc(count, size);
+#if !defined(BS_DISABLE_INSTRUMENTATION)
+  if (InstrumentationEnabled() && memory) {
+    TrackAllocation(malloc_usable_size(memory));
+  }
+#endif
+  return memory;
+}
+
+/**
+ * @brief realloc() с учетом изменения размера
+ *
+ * При memory == NULL учитывается как новое выделение, при ошибке блок и
+ * учет не меняются.
+ */
+static inline void *ReallocateMemory(void *memory, size_t size) {
+#if defined(BS_DISABLE_INSTRUMENTATION)
+  return realloc(memory, size);
+#else
+  if (!InstrumentationEnabled()) {
+    return realloc(memory, size);
+  }
+  size_t oldBytes = memory ? malloc_usable_size(memory) : 0;
+  void *resized = realloc(memory, size);
+  if (resized && memory) {
+    TrackReallocation(oldBytes, malloc_usable_size(resized));
+  } else if (resized) {
+    TrackAllocation(malloc_usable_size(resized));
+  }
+  return resized;
+#endif
+}
+
+/**
+ * @brief free() с учетом освобождения
+ */
+static inline void FreeMemory(void *memory) {
+#if !defined(BS_DISABLE_INSTRUMENTATION)
+  if (InstrumentationEnabled() && memory) {
+    TrackFree(malloc_usable_size(memory));
+  }
+#endif
+  free(memory);
+}
+
+/**
+ * @brief Аллокатор вызова: allocator или DefaultAllocator() при NULL
+ *
+ * @return NULL, если у allocator не заданы все функции
+ */
+static inline const Allocator *ResolveAllocator(const Allocator *allocator) {
+  if (!allocator) {
+    return DefaultAllocator();
+  }
+  return allocator->allocate && allocator->reallocate &&
+                 allocator->deallocate
+             ? allocator
+             : NULL;
+}
+
+/**
+ * @brief Выделение через allocator
+ */
+static inline void *AllocatorAllocate(const Allocator *allocator,
+                                      size_t size) {
+  return allocator->allocate(allocator->context, size);
+}
+
+/**
+ * @brief Изменение размера через allocator, memory может быть NULL
+ */
+static inline void *AllocatorReallocate(const Allocator *allocator,
+                                        void *memory, size_t size) {
+  return allocator->reallocate(allocator->context, memory, size);
+}
+
+/**
+ * @brief Освобождение через allocator, NULL пропускается
+ */
+static inline void AllocatorFree(const Allocator *allocator, void *memory) {
+  if (memory) {
+    allocator->deallocate(allocator->context, memory);
+  }
+}
+
+#endif // BINARYSERIALIZER_INTERNAL_ALLOCATION_H
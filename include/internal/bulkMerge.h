@@ -0,0 +1,120 @@
+/**
+ * @file bulkMerge.h
+ * @brief Внутреннее пакетное агрегирование записей StatData по id
+ * @author Melpomenna
+ * @version 1.0
+ * @date 18.10.2026
+ *
+ * Внутренний модуль библиотеки, не входит в публичное API. Сворачивает пакет
+ * записей в одну запись на каждый различный id по правилам слияния по
+ * умолчанию. Каждая запись за один проход добавляется в распакованный
+ * аккумулятор своего id, поэтому при большом количестве повторов в
+ * хеш-таблицу попадает лишь одна запись на id, а битовые поля упаковываются
+ * один раз на группу.
+ */
+
+#ifndef BINARYSERIALIZER_INTERNAL_BULKMERGE_H
+#define BINARYSERIALIZER_INTERNAL_BULKMERGE_H
+
+#include "BinarySerializer/config.h"
+#include "BinarySerializer/mergeHashTable.h"
+#include "BinarySerializer/statData.h"
+
+#include <stddef.h>
+
+/**
+ * @def BINARYSERIALIZER_BULK_MERGE_CHUNK
+ * @brief Максимальное количество записей, сворачиваемых за один проход
+ *
+ * Подобрано так, чтобы рабочие массивы помещались в L2 кэш.
+ */
+#define BINARYSERIALIZER_BULK_MERGE_CHUNK 4096
+
+/**
+ * @struct BulkMergeGroup
+ * @brief Аккумулятор одного id с распакованными полями StatData
+ */
+typedef struct BulkMergeGroup {
+  int count;             /**< Сумма count */
+  float cost;            /**< Сумма cost */
+  unsigned char primary; /**< И по primary */
+  unsigned char mode;    /**< Максимум mode */
+} BulkMergeGroup;
+
+/**
+ * @struct BulkMergeScratch
+ * @brief Рабочие массивы для ReduceBatchById()
+ *
+ * Все массивы выделяются одним блоком в InitBulkMergeScratch().
+ */
+typedef struct BulkMergeScratch {
+  long *groupIds;             /**< id каждой группы */
+  int *slots;                 /**< Открытая адресация id -> группа, -1 пусто */
+  BulkMergeGroup *groups;     /**< Аккумулятор каждой группы */
+  StatData *reduced;          /**< Результат свертки, по записи на группу */
+  const Allocator *allocator; /**< Аллокатор блока массивов */
+} BulkMergeScratch;
+
+/**
+ * @brief Выделяет рабочие массивы на BINARYSERIALIZER_BULK_MERGE_CHUNK записей
+ *
+ * @param[out] scratch Рабочие массивы
+ * @param[in] allocator Аллокатор, должен жить до ClearBulkMergeScratch()
+ *
+ * @return 1 при успехе, 0 при ошибке выделения памяти
+ */
+BINARYSERIALIZER_NODISCARD int InitBulkMergeScratch(BulkMergeScratch *scratch,
+                                                    const Allocator *allocator);
+
+/**
+ * @brief Размер блока, который выделяет InitBulkMergeScratch(), в байтах
+ *
+ * Нужен вызывающим сторонам, которые учитывают рабочие массивы в бюджете
+ * памяти.
+ */
+size_t BulkMergeScratchBytes(void);
+
+/**
+ * @brief Освобождает рабочие массивы
+ */
+void ClearBulkMergeScratch(BulkMergeScratch *scratch);
+
+/**
+ * @brief Сворачивает пакет записей по id
+ *
+ * count и cost суммируются, primary объединяется через И, mode принимает
+ * максимум - как при последовательных вызовах MergeStatData(). Внутри группы
+ * cost суммируется в порядке записей, но сумма группы прибавляется к записи
+ * таблицы одним слагаемым, поэтому итог может отличаться от поэлементной
+ * вставки в пределах погрешности float.
+ *
+ * @param[in,out] scratch Рабочие массивы
+ * @param[in] data Входные записи
+ * @param[in] size Количество записей (не больше
+ * BINARYSERIALIZER_BULK_MERGE_CHUNK)
+ *
+ * @return Количество различных id; свернутые записи лежат в scratch->reduced
+ * в порядке первого появления id
+ */
+size_t ReduceBatchById(BulkMergeScratch *scratch, const StatData *data,
+                       size_t size);
+
+/**
+ * @brief InsertBatchToHashTable() с рабочими массивами вызывающей стороны
+ *
+ * Реализована в mergeHashTable.c. Позволяет переиспользовать scratch между
+ * вызовами вместо выделения на каждый пакет.
+ *
+ * @param[in,out] table Хеш-таблица
+ * @param[in] data Вставляемые записи
+ * @param[in] size Количество записей
+ * @param[in,out] scratch Инициализированные рабочие массивы или NULL, тогда
+ * они выделяются на время вызова
+ *
+ * @return 1 при успехе, 0 при ошибке
+ */
+BINARYSERIALIZER_NODISCARD int
+InsertBatchWithScratch(MergeHashTable *table, const StatData *data,
+                       size_t size, BulkMergeScratch *scratch);
+
+#endif // BINARYSERIALIZER_INTERNAL_BULKMERGE_H
@@ -0,0 +1,134 @@
+/**
+ * @file dumpIO.h
+ * @brief Внутренние буферизованные чтение и запись дампов StatData
+ * @author Melpomenna
+ * @version 1.0
+ * @date 18.10.2026
+ *
+ * Внутренний модуль библиотеки, не входит в публичное API. Позволяет
+ * потоково писать и читать дампы блоками фиксированного размера, не держа
+ * весь файл в памяти. Формат файла совпадает с форматом StoreDump/LoadDump.
+ */
+
+#ifndef BINARYSERIALIZER_INTERNAL_DUMPIO_H
+#define BINARYSERIALIZER_INTERNAL_DUMPIO_H
+
+#include "BinarySerializer/config.h"
+#include "BinarySerializer/statData.h"
+
+#include <stddef.h>
+
+/**
+ * @struct DumpWriter
+ * @brief Буферизованная последовательная запись StatData в файловый
+ * дескриптор
+ *
+ * Накопленные записи сбрасываются одним write() при заполнении буфера.
+ */
+typedef struct DumpWriter {
+  StatData *buffer; /**< Буфер записей */
+  size_t capacity;  /**< Емкость буфера в элементах */
+  size_t count;     /**< Количество записей в буфере */
+  size_t written; /**< Всего записано элементов (включая буфер) */
+  int fd;         /**< Дескриптор файла, не закрывается writer'ом */
+} DumpWriter;
+
+/**
+ * @struct DumpReader
+ * @brief Последовательное чтение StatData блоками через pread()
+ */
+typedef struct DumpReader {
+  StatData *buffer; /**< Буфер для очередного блока */
+  size_t capacity;  /**< Емкость буфера в элементах */
+  size_t offset;    /**< Смещение следующего чтения в байтах */
+  size_t size; /**< Размер читаемой области в байтах (кратен StatData) */
+  int fd;      /**< Дескриптор файла, не закрывается reader'ом */
+} DumpReader;
+
+/**
+ * @brief Инициализирует writer поверх открытого дескриптора
+ *
+ * @param[out] writer Инициализируемая структура
+ * @param[in] fd Дескриптор, открытый на запись
+ * @param[in] capacity Емкость буфера в элементах (> 0)
+ *
+ * @return 1 при успехе, 0 при ошибке выделения памяти
+ */
+BINARYSERIALIZER_NODISCARD int InitDumpWriter(DumpWriter *writer, int fd,
+                                              size_t capacity);
+
+/**
+ * @brief Добавляет записи в writer, сбрасывая буфер при заполнении
+ *
+ * @return 1 при успехе, 0 при ошибке записи
+ */
+BINARYSERIALIZER_NODISCARD int
+WriteToDumpWriter(DumpWriter *__restrict writer, const StatData *__restrict data,
+                  size_t size);
+
+/**
+ * @brief Сбрасывает содержимое буфера в файл
+ *
+ * @return 1 при успехе, 0 при ошибке записи
+ */
+BINARYSERIALIZER_NODISCARD int FlushDumpWriter(DumpWriter *writer);
+
+/**
+ * @brief Освобождает буфер writer'а без сброса данных
+ *
+ * @note Дескриптор не закрывается
+ */
+void ClearDumpWriter(DumpWriter *writer);
+
+/**
+ * @brief Инициализирует reader поверх открытого дескриптора
+ *
+ * Размер читаемой области берется из fstat() и округляется вниз до целого
+ * числа StatData.
+ *
+ * @param[out] reader Инициализируемая структура
+ * @param[in] fd Дескриптор, открытый на чтение
+ * @param[in] capacity Емкость буфера в элементах (> 0)
+ *
+ * @return 1 при успехе, 0 при ошибке fstat() или выделения памяти
+ */
+BINARYSERIALIZER_NODISCARD int InitDumpReader(DumpReader *reader, int fd,
+                                              size_t capacity);
+
+/**
+ * @brief Читает очередной блок записей
+ *
+ * @param[in,out] reader Инициализированный reader
+ * @param[out] data Адрес прочитанного блока (валиден до следующего чтения)
+ *
+ * @return Количество прочитанных записей, 0 при достижении конца файла
+ * @return (size_t)-1 при ошибке чтения
+ */
+BINARYSERIALIZER_NODISCARD size_t ReadFromDumpReader(DumpReader *reader,
+                                                     const StatData **data);
+
+/**
+ * @brief Количество записей в читаемой области
+ */
+BINARYSERIALIZER_NODISCARD size_t DumpReaderSize(const DumpReader *reader);
+
+/**
+ * @brief Освобождает буфер reader'а
+ *
+ * @note Дескриптор не закрывается
+ */
+void ClearDumpReader(DumpReader *reader);
+
+/**
+ * @brief Создает безымянный временный файл в каталоге dir
+ *
+ * Файл создается через mkstemp() и сразу удаляется из файловой системы,
+ * поэтому освобождается автоматически при закрытии дескриптора.
+ *
+ * @param[in] dir Каталог для временного файла (не NULL)
+ *
+ * @return Дескриптор файла или -1 при ошибке
+ */
+BINARYSERIALIZER_NODISCARD int CreateTempDumpFile(const char *dir);
+
+#endif // BINARYSERIALIZER_INTERNAL_DUMPIO_H
@@ -0,0 +1,96 @@
+/**
+ * @file dumpRuns.h
+ * @brief Внутреннее описание дампа как последовательности отсортированных
+ * серий
+ * @author Melpomenna
+ * @version 1.0
+ * @date 18.10.2026
+ *
+ * Внутренний модуль библиотеки, не входит в публичное API. UpdateDump()
+ * дописывает новые id отсортированной серией в конец дампа, не сдвигая
+ * существующие записи. Длины серий хранятся в файле "<путь дампа>.runs"
+ * (массив uint64_t), сам дамп остается в формате StoreDump/LoadDump. Если
+ * файла серий нет или он не соответствует дампу, весь дамп считается одной
+ * серией.
+ *
+ * Соседние серии сливаются, пока каждая серия хотя бы вдвое длиннее
+ * следующей, поэтому серий не больше log2(n) + 1, а каждая запись
+ * переписывается O(log n) раз за все время жизни дампа.
+ */
+
+#ifndef BINARYSERIALIZER_INTERNAL_DUMPRUNS_H
+#define BINARYSERIALIZER_INTERNAL_DUMPRUNS_H
+
+#include "BinarySerializer/config.h"
+#include "BinarySerializer/statData.h"
+
+#include <stddef.h>
+
+/**
+ * @def BINARYSERIALIZER_MAX_DUMP_RUNS
+ * @brief Максимальное количество серий: длины убывают хотя бы вдвое
+ */
+#define BINARYSERIALIZER_MAX_DUMP_RUNS 64
+
+/**
+ * @def BINARYSERIALIZER_UNORDERED_DUMP
+ * @brief Результат LowerBoundById() при нарушенном порядке id
+ */
+#define BINARYSERIALIZER_UNORDERED_DUMP ((size_t)-1)
+
+/**
+ * @struct DumpRuns
+ * @brief Длины отсортированных по id серий дампа в порядке файла
+ */
+typedef struct DumpRuns {
+  size_t count;                                /**< Количество серий */
+  size_t sizes[BINARYSERIALIZER_MAX_DUMP_RUNS]; /**< Записей в каждой серии */
+} DumpRuns;
+
+/**
+ * @brief Читает серии дампа
+ *
+ * @param[in] filePath Путь к дампу
+ * @param[in] size Количество записей дампа
+ * @param[out] runs Серии; одна серия (или ни одной для пустого дампа), если
+ * файла серий нет или его длины не дают в сумме size
+ */
+void LoadDumpRuns(const char *filePath, size_t size, DumpRuns *runs);
+
+/**
+ * @brief Сохраняет серии дампа
+ *
+ * Для одной серии файл серий удаляется: дамп снова просто отсортирован.
+ *
+ * @return 1 при успехе, 0 при ошибке записи
+ */
+BINARYSERIALIZER_NODISCARD int StoreDumpRuns(const char *filePath,
+                                             const DumpRuns *runs);
+
+/**
+ * @brief Сливает две последние серии на месте
+ *
+ * Копируется меньшая из двух серий, поэтому память O(min(a, b)).
+ *
+ * @param[in,out] data Записи дампа
+ * @param[in,out] runs Серии, count >= 2
+ *
+ * @return 1 при успехе, 0 при ошибке выделения памяти
+ */
+BINARYSERIALIZER_NODISCARD int MergeLastDumpRuns(StatData *data,
+                                                 DumpRuns *runs);
+
+/**
+ * @brief Первая позиция в [from, size) с id >= заданного
+ *
+ * Галопирующий поиск от from: для отсортированной дельты каждый следующий
+ * поиск стартует с позиции предыдущего и затрагивает O(log distance) страниц
+ * отображения. Просмотренные записи и соседи найденной позиции проверяются
+ * на строгое возрастание id.
+ *
+ * @return Позиция или BINARYSERIALIZER_UNORDERED_DUMP, если проверенные
+ * записи идут не по возрастанию id
+ */
+size_t LowerBoundById(const StatData *data, size_t from, size_t size, long id);
+
+#endif // BINARYSERIALIZER_INTERNAL_DUMPRUNS_H
@@ -0,0 +1,58 @@
+/**
+ * @file executionContext.h
+ * @brief Внутреннее устройство ExecutionContext
+ * @author Melpomenna
+ * @version 1.0
+ * @date 18.10.2026
+ *
+ * Внутренний модуль библиотеки, не входит в публичное API. Варианты функций
+ * с контекстом реализованы рядом с исходными функциями и получают буферы
+ * через ReserveContextRecords().
+ */
+
+#ifndef BINARYSERIALIZER_INTERNAL_EXECUTIONCONTEXT_H
+#define BINARYSERIALIZER_INTERNAL_EXECUTIONCONTEXT_H
+
+#include "BinarySerializer/executionContext.h"
+#include "BinarySerializer/mergeHashTable.h"
+#include "internal/bulkMerge.h"
+
+#include <stddef.h>
+
+struct ExecutionContext {
+  Allocator allocator;      /**< Аллокатор всех буферов */
+  MergeHashTable table;     /**< Таблица JoinDumpWithContext() */
+  BulkMergeScratch scratch; /**< Рабочие массивы пакетной вставки */
+  StatData *joined;         /**< Результат JoinDumpWithContext() */
+  size_t joinedCapacity;    /**< Емкость joined в записях */
+  StatData *sortBuffer;     /**< Вспомогательный массив сортировки */
+  size_t sortCapacity;      /**< Емкость sortBuffer в записях */
+  char *text;               /**< Текст PrintDumpWithContext() */
+  size_t textSize;          /**< Длина текста */
+  size_t textCapacity;      /**< Емкость text */
+};
+
+/**
+ * @brief Гарантирует буфер контекста не меньше records записей
+ *
+ * Содержимое при росте не сохраняется: буфер освобождается и выделяется
+ * заново.
+ *
+ * @param[in] context Контекст (для аллокатора)
+ * @param[in,out] buffer Буфер контекста
+ * @param[in,out] capacity Емкость буфера в записях
+ * @param[in] records Требуемое количество записей
+ *
+ * @return 1 при успехе, 0 при ошибке выделения памяти
+ */
+BINARYSERIALIZER_NODISCARD int
+ReserveContextRecords(const ExecutionContext *context, StatData **buffer,
+                      size_t *capacity, size_t records);
+
+/**
+ * @brief TableSinkFunc, дописывающая блок в текст контекста
+ */
+BINARYSERIALIZER_NODISCARD int AppendContextText(void *context,
+                                                 const char *data, size_t size);
+
+#endif // BINARYSERIALIZER_INTERNAL_EXECUTIONCONTEXT_H
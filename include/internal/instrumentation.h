@@ -0,0 +1,113 @@
+/**
+ * @file instrumentation.h
+ * @brief Внутренние точки сбора счетчиков и таймеров фаз
+ * @author Melpomenna
+ * @version 1.0
+ * @date 18.10.2026
+ *
+ * Внутренний модуль библиотеки, не входит в публичное API. Функции
+ * встраиваются в места сбора: при выключенном сборе остается одна проверка
+ * флага, при сборке с BS_DISABLE_INSTRUMENTATION - ничего. Счетчики горячих
+ * циклов следует копить в локальных переменных и публиковать одним вызовом.
+ */
+
+#ifndef BINARYSERIALIZER_INTERNAL_INSTRUMENTATION_H
+#define BINARYSERIALIZER_INTERNAL_INSTRUMENTATION_H
+
+#include "BinarySerializer/config.h"
+#include "BinarySerializer/instrumentation.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if !defined(BS_DISABLE_INSTRUMENTATION)
+/**
+ * @brief Флаг включенного сбора, читается без синхронизации
+ */
+extern int instrumentationEnabled;
+
+/**
+ * @brief Текущее значение CLOCK_MONOTONIC в наносекундах (не 0)
+ */
+uint64_t InstrumentationNow(void);
+
+/**
+ * @brief Атомарно добавляет замер фазы
+ */
+void AddPhaseTime(InstrumentationPhase phase, uint64_t nanoseconds);
+
+/**
+ * @brief Атомарно увеличивает счетчик
+ */
+void AddCounter(InstrumentationCounter counter, uint64_t value);
+
+/**
+ * @brief Учитывает выделение нового блока размером bytes
+ */
+void TrackAllocation(size_t bytes);
+
+/**
+ * @brief Учитывает изменение размера блока с oldBytes до newBytes
+ */
+void TrackReallocation(size_t oldBytes, size_t newBytes);
+
+/**
+ * @brief Учитывает освобождение блока размером bytes
+ */
+void TrackFree(size_t bytes);
+#endif
+
+/**
+ * @brief Проверяет флаг сбора
+ */
+static inline int InstrumentationEnabled(void) {
+#if defined(BS_DISABLE_INSTRUMENTATION)
+  return 0;
+#else
+  return BINARYSERIALIZER_UNLIKELY(
+      __atomic_load_n(&instrumentationEnabled, __ATOMIC_RELAXED));
+#endif
+}
+
+/**
+ * @brief Начинает замер фазы
+ *
+ * @return Метка начала или 0, если сбор выключен
+ */
+static inline uint64_t BeginPhase(void) {
+#if defined(BS_DISABLE_INSTRUMENTATION)
+  return 0;
+#else
+  return InstrumentationEnabled() ? InstrumentationNow() : 0;
+#endif
+}
+
+/**
+ * @brief Завершает замер фазы, начатый BeginPhase()
+ */
+static inline void EndPhase(InstrumentationPhase phase, uint64_t start) {
+#if defined(BS_DISABLE_INSTRUMENTATION)
+  BINARYSERIALIZER_UNUSED(phase);
+  BINARYSERIALIZER_UNUSED(start);
+#else
+  if (BINARYSERIALIZER_UNLIKELY(start != 0)) {
+    AddPhaseTime(phase, InstrumentationNow() - start);
+  }
+#endif
+}
+
+/**
+ * @brief Увеличивает счетчик, если сбор включен
+ */
+static inline void CountEvent(InstrumentationCounter counter, uint64_t value) {
+#if defined(BS_DISABLE_INSTRUMENTATION)
+  BINARYSERIALIZER_UNUSED(counter);
+  BINARYSERIALIZER_UNUSED(value);
+#else
+  if (InstrumentationEnabled()) {
+    AddCounter(counter, value);
+  }
+#endif
+}
+
+#endif // BINARYSERIALIZER_INTERNAL_INSTRUMENTATION_H
@@ -0,0 +1,46 @@
+/**
+ * @file partitionedSort.h
+ * @brief Внутренняя сортировка, отдающая готовый префикс по частям
+ * @author Melpomenna
+ * @version 1.0
+ * @date 18.10.2026
+ *
+ * Внутренний модуль библиотеки, не входит в публичное API. Записи сначала
+ * устойчиво раскладываются по старшему различающемуся байту ключа, затем
+ * каждая часть сортируется отдельно. После каждой части ее записи стоят на
+ * итоговых местах, поэтому потребитель (например, запись в файл) может
+ * забирать отсортированный префикс, пока сортируются следующие части.
+ */
+
+#ifndef BINARYSERIALIZER_INTERNAL_PARTITIONEDSORT_H
+#define BINARYSERIALIZER_INTERNAL_PARTITIONEDSORT_H
+
+#include "BinarySerializer/sortDump.h"
+#include "BinarySerializer/statData.h"
+
+#include <stddef.h>
+
+/**
+ * @typedef SortedPrefixFunc
+ * @brief Сообщает, что первые sortedCount записей результата готовы
+ */
+typedef void (*SortedPrefixFunc)(void *context, size_t sortedCount);
+
+/**
+ * @brief Устойчиво сортирует data в sorted, результат совпадает с
+ * SortDumpByKey()
+ *
+ * @param[in,out] data Исходные записи, после вызова содержат мусор
+ * @param[out] sorted Результат, size записей
+ * @param[in] size Количество записей
+ * @param[in] field Поле сортировки (проверено вызывающей стороной)
+ * @param[in] direction Направление сортировки (проверено вызывающей стороной)
+ * @param[in] ready Вызывается с неубывающими sortedCount, последний вызов -
+ * с size
+ * @param[in] context Передается в ready
+ */
+void SortByKeyPartitioned(StatData *data, StatData *sorted, size_t size,
+                          SortField field, SortDirection direction,
+                          SortedPrefixFunc ready, void *context);
+
+#endif // BINARYSERIALIZER_INTERNAL_PARTITIONEDSORT_H
@@ -0,0 +1,48 @@
+/**
+ * @file powersOfTen.h
+ * @brief Внутренние степени десяти для преобразования чисел в текст и обратно
+ * @author Melpomenna
+ * @version 1.0
+ * @date 18.10.2026
+ *
+ * Внутренний модуль библиотеки, не входит в публичное API. Используется
+ * форматированием ячеек и разбором текстовых дампов.
+ */
+
+#ifndef BINARYSERIALIZER_INTERNAL_POWERSOFTEN_H
+#define BINARYSERIALIZER_INTERNAL_POWERSOFTEN_H
+
+/**
+ * @def MAX_EXACT_DOUBLE_POWER_OF_TEN
+ * @brief Наибольшая степень десяти, точно представимая в double
+ */
+#define MAX_EXACT_DOUBLE_POWER_OF_TEN 22
+
+/**
+ * @brief 10^n в long double: точно для n <= 27
+ */
+static inline long double PowerOfTen(unsigned n) {
+  static const long double exact[] = {
+      1e0L,  1e1L,  1e2L,  1e3L,  1e4L,  1e5L,  1e6L,  1e7L,  1e8L,  1e9L,
+      1e10L, 1e11L, 1e12L, 1e13L, 1e14L, 1e15L, 1e16L, 1e17L, 1e18L, 1e19L,
+      1e20L, 1e21L, 1e22L, 1e23L, 1e24L, 1e25L, 1e26L, 1e27L};
+  long double result = 1.0L;
+  while (n > 27) {
+    result *= exact[27];
+    n -= 27;
+  }
+  return result * exact[n];
+}
+
+/**
+ * @brief 10^n в double для n <= MAX_EXACT_DOUBLE_POWER_OF_TEN
+ */
+static inline double ExactDoublePowerOfTen(unsigned n) {
+  static const double exact[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                 1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                 1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                 1e18, 1e19, 1e20, 1e21, 1e22};
+  return exact[n];
+}
+
+#endif // BINARYSERIALIZER_INTERNAL_POWERSOFTEN_H
@@ -0,0 +1,68 @@
+/**
+ * @file sortKey.h
+ * @brief Внутренние преобразования полей StatData в беззнаковые ключи
+ * @author Melpomenna
+ * @version 1.0
+ * @date 18.10.2026
+ *
+ * Внутренний модуль библиотеки, не входит в публичное API. Ключи сравниваются
+ * как uint64_t в том же порядке, что и исходные поля, а направление
+ * сортировки задается маской, которая xor-ится с ключом. Используется
+ * сортировками в памяти и внешней сортировкой дампов.
+ */
+
+#ifndef BINARYSERIALIZER_INTERNAL_SORTKEY_H
+#define BINARYSERIALIZER_INTERNAL_SORTKEY_H
+
+#include "BinarySerializer/sortDump.h"
+#include "BinarySerializer/statData.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @brief Ключ id, упорядоченный как беззнаковое число
+ *
+ * Инверсия знакового бита переводит порядок int64 в порядок uint64.
+ */
+static inline uint64_t IdSortKey(const StatData *data) {
+  return (uint64_t)(int64_t)data->id ^ ((uint64_t)1 << 63);
+}
+
+/**
+ * @brief Ключ cost, упорядоченный как беззнаковое число
+ *
+ * У положительных float инвертируется знаковый бит, у отрицательных - все
+ * биты, после чего беззнаковое сравнение совпадает со сравнением float.
+ */
+static inline uint64_t CostSortKey(const StatData *data) {
+  uint32_t bits;
+  memcpy(&bits, &data->cost, sizeof(bits));
+  uint32_t mask = (uint32_t)(-(int32_t)(bits >> 31)) | 0x80000000u;
+  return bits ^ mask;
+}
+
+/**
+ * @brief Ключ поля field без учета направления
+ */
+static inline uint64_t SortKey(const StatData *data, SortField field) {
+  return field == SORT_FIELD_ID ? IdSortKey(data) : CostSortKey(data);
+}
+
+static inline int IsValidSortKey(SortField field, SortDirection direction) {
+  return (field == SORT_FIELD_ID || field == SORT_FIELD_COST) &&
+         (direction == SORT_ASC || direction == SORT_DESC);
+}
+
+/**
+ * @brief Маска, которая xor-ится с ключом поля field
+ *
+ * Для убывания инвертируются все значащие биты ключа: ключ cost занимает
+ * только младшие 32 бита.
+ */
+static inline uint64_t SortMask(SortField field, SortDirection direction) {
+  uint64_t mask = direction == SORT_DESC ? UINT64_MAX : 0;
+  return field == SORT_FIELD_COST ? mask & UINT32_MAX : mask;
+}
+
+#endif // BINARYSERIALIZER_INTERNAL_SORTKEY_H
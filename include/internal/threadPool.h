@@ -0,0 +1,85 @@
+/**
+ * @file threadPool.h
+ * @brief Внутренний пул потоков для параллельных циклов
+ * @author Melpomenna
+ * @version 1.0
+ * @date 18.10.2026
+ *
+ * Внутренний модуль библиотеки, не входит в публичное API. Пул выполняет
+ * параллельный цикл из tasksCount независимых задач: потоки (включая
+ * вызывающий) разбирают индексы задач через атомарный счетчик, поэтому
+ * освободившийся поток сразу забирает следующую задачу.
+ */
+
+#ifndef BINARYSERIALIZER_INTERNAL_THREADPOOL_H
+#define BINARYSERIALIZER_INTERNAL_THREADPOOL_H
+
+#include "BinarySerializer/config.h"
+
+#include <pthread.h>
+#include <stddef.h>
+
+/**
+ * @typedef ThreadPoolTask
+ * @brief Задача параллельного цикла
+ *
+ * @param args Общие аргументы, переданные в RunThreadPool()
+ * @param index Индекс задачи в диапазоне [0, tasksCount)
+ */
+typedef void (*ThreadPoolTask)(void *args, size_t index);
+
+/**
+ * @struct ThreadPool
+ * @brief Пул рабочих потоков
+ *
+ * @warning Перед использованием необходимо вызвать InitThreadPool()
+ * @warning После использования обязательно вызвать ClearThreadPool()
+ */
+typedef struct ThreadPool {
+  pthread_t *threads;     /**< Рабочие потоки (threadsCount - 1 штук) */
+  size_t threadsCount;    /**< Количество потоков вместе с вызывающим */
+  pthread_mutex_t mutex;  /**< Защищает поля ниже */
+  pthread_cond_t wake;    /**< Сигнал о новом цикле или остановке */
+  pthread_cond_t done;    /**< Сигнал о завершении цикла */
+  ThreadPoolTask task;    /**< Задача текущего цикла */
+  void *args;             /**< Аргументы текущего цикла */
+  size_t tasksCount;      /**< Количество задач текущего цикла */
+  size_t nextTask;        /**< Следующий неразобранный индекс (атомарно) */
+  size_t finishedWorkers; /**< Рабочие потоки, завершившие текущий цикл */
+  unsigned long epoch;    /**< Номер цикла, меняется при каждом запуске */
+  int stop;               /**< Ненулевое значение останавливает потоки */
+} ThreadPool;
+
+/**
+ * @brief Количество доступных процессоров (не меньше 1)
+ */
+size_t HardwareThreadsCount(void);
+
+/**
+ * @brief Запускает threadsCount - 1 рабочих потоков
+ *
+ * @param[out] pool Инициализируемый пул
+ * @param[in] threadsCount Общее число потоков, 0 означает
+ * HardwareThreadsCount()
+ *
+ * @return 1 при успехе, 0 при ошибке
+ */
+BINARYSERIALIZER_NODISCARD int InitThreadPool(ThreadPool *pool,
+                                              size_t threadsCount);
+
+/**
+ * @brief Выполняет task(args, i) для всех i из [0, tasksCount) и ждет
+ * завершения
+ *
+ * Вызывающий поток тоже выполняет задачи. Не реентерабельна: задачи не должны
+ * вызывать RunThreadPool() того же пула.
+ */
+void RunThreadPool(ThreadPool *pool, ThreadPoolTask task, void *args,
+                   size_t tasksCount);
+
+/**
+ * @brief Останавливает и присоединяет рабочие потоки
+ */
+void ClearThreadPool(ThreadPool *pool);
+
+#endif // BINARYSERIALIZER_INTERNAL_THREADPOOL_H
@@ -0,0 +1,22 @@
+#include "BinarySerializer/allocator.h"
+#include "internal/allocation.h"
+
+static void *DefaultAllocate(void *context, size_t size) {
+  BINARYSERIALIZER_UNUSED(context);
+  return AllocateMemory(size);
+}
+
+static void *DefaultReallocate(void *context, void *memory, size_t size) {
+  BINARYSERIALIZER_UNUSED(context);
+  return ReallocateMemory(memory, size);
+}
+
+static void DefaultDeallocate(void *context, void *memory) {
+  BINARYSERIALIZER_UNUSED(context);
+  FreeMemory(memory);
+}
+
+static const Allocator defaultAllocator = {
+    &DefaultAllocate, &DefaultReallocate, &DefaultDeallocate, NULL};
+
+const Allocator *DefaultAllocator(void) { return &defaultAllocator; }
@@ -1,5 +1,10 @@
 #include "BinarySerializer/binarySerializer.h"
+#include "BinarySerializer/mappedDump.h"
 #include "BinarySerializer/mergeHashTable.h"
+#include "internal/allocation.h"
+#include "internal/dumpRuns.h"
+#include "internal/executionContext.h"
+#include "internal/instrumentation.h"
 
 #if defined(BS_ENABLE_MI_MALLOC)
 #include <mimalloc-override.h>
@@ -12,6 +17,7 @@
 #include <assert.h>
 #include <fcntl.h>
 #include <math.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/mman.h>
@@ -53,6 +59,7 @@ Status StoreDump(const char *filePath, const StatData *data, size_t size) {
     LOG("[StoreDump end]_____________________\n");
     return INVALID_POINTER_OR_SIZE;
   }
+  uint64_t phaseStart = BeginPhase();
   int fd = open(filePath, O_RDWR);
   if (BINARYSERIALIZER_UNLIKELY(fd < 0)) {
     LOG_ERR("Cannot open file with [path:%s]\n", filePath);
@@ -68,6 +75,7 @@ Status StoreDump(const char *filePath, const StatData *data, size_t size) {
     LOG("[StoreDump end]_____________________\n");
     return BAD_FILE;
   }
+  EndPhase(INSTRUMENTATION_PHASE_OPEN, phaseStart);
   LOG("[filePath:%s] [fd:%d] [dataSize:%zu] [fileSize:%zu]\n", filePath, fd,
       size, fileSize);
   void *addr =
@@ -79,22 +87,32 @@ Status StoreDump(const char *filePath, const StatData *data, size_t size) {
     LOG("[StoreDump end]_____________________\n");
     return INVALID_POINTER_OR_SIZE;
   }
+  phaseStart = BeginPhase();
   memcpy(addr, data, sizeof(StatData) * size);
   Tmsync(addr, sizeof(StatData) * size, MS_ASYNC);
   Tmunmap(addr, sizeof(StatData) * size);
   CloseFd(filePath, fd);
+  EndPhase(INSTRUMENTATION_PHASE_STORE, phaseStart);
+  CountEvent(INSTRUMENTATION_BYTES_WRITTEN, fileSize);
   LOG("[StoreDump end]_____________________\n");
   return SUCCESS;
 }
 
 Status LoadDump(const char *filePath, StatData **data, size_t *size) {
+  return LoadDumpWithAllocator(filePath, data, size, NULL);
+}
+
+Status LoadDumpWithAllocator(const char *filePath, StatData **data,
+                             size_t *size, const Allocator *allocator) {
   LOG("[LoadDump begin]_____________________\n");
-  if (BINARYSERIALIZER_UNLIKELY(!filePath || !data || !size)) {
+  allocator = ResolveAllocator(allocator);
+  if (BINARYSERIALIZER_UNLIKELY(!filePath || !data || !size || !allocator)) {
     LOG_ERR("Bad filePath or data or size\n");
     LOG("[LoadDump end]_____________________\n");
     return INVALID_POINTER_OR_SIZE;
   }
   LOG("[path:%s]\n", filePath);
+  uint64_t phaseStart = BeginPhase();
   int fd = open(filePath, O_RDWR);
   if (BINARYSERIALIZER_UNLIKELY(fd < 0)) {
     LOG_ERR("LoadDump: cannot open file [path:%s]\n", filePath);
@@ -122,6 +140,7 @@ Status LoadDump(const char *filePath, StatData **data, size_t *size) {
     return EMPTY_FILE;
   }
 
+  EndPhase(INSTRUMENTATION_PHASE_OPEN, phaseStart);
   LOG("File opened with [size:%zu][StatData size:%zu]\n", fileSize,
       sizeof(StatData));
 
@@ -136,112 +155,165 @@ Status LoadDump(const char *filePath, StatData **data, size_t *size) {
   StatData *resultData = NULL;
   size_t i = 0;
   void *baseAddr = NULL;
+  size_t mappedBytes = 0;
   for (; i < butchesCount && totalSize >= butchesSizeInBytes;
        ++i, totalSize -= butchesSizeInBytes) {
-    StatData *rdata = realloc(resultData, butchesSizeInBytes * (i + 1));
+    StatData *rdata = AllocatorReallocate(allocator, resultData,
+                                          butchesSizeInBytes * (i + 1));
     if (BINARYSERIALIZER_UNLIKELY(!rdata)) {
-      free(resultData);
+      if (baseAddr) {
+        Tmunmap(baseAddr, mappedBytes);
+      }
+      AllocatorFree(allocator, resultData);
       CloseFd(filePath, fd);
       LOG_ERR("Cannot allocate [bytes:%zu]\n", butchesSizeInBytes * (i + 1));
       LOG("[LoadDump end]_____________________\n");
       return ERROR;
     }
     resultData = rdata;
+    phaseStart = BeginPhase();
     void *addr = mmap(baseAddr, butchesSizeInBytes * (i + 1), PROT_READ,
                       MAP_SHARED, fd, 0);
+    EndPhase(INSTRUMENTATION_PHASE_MAP, phaseStart);
     if (BINARYSERIALIZER_UNLIKELY(addr == MAP_FAILED)) {
-      free(resultData);
+      if (baseAddr) {
+        Tmunmap(baseAddr, mappedBytes);
+      }
+      AllocatorFree(allocator, resultData);
       CloseFd(filePath, fd);
       LOG_ERR("Cannot mmap file [filePath:%s] with size [size:%zu][line:%d]\n",
               filePath, butchesSizeInBytes, __LINE__);
       LOG("[LoadDump end]_____________________\n");
       return ERROR;
     }
+    // Новое отображение не ложится поверх старого, старое снимается явно
+    if (baseAddr) {
+      Tmunmap(baseAddr, mappedBytes);
+    }
     baseAddr = addr;
+    mappedBytes = butchesSizeInBytes * (i + 1);
+    phaseStart = BeginPhase();
     memcpy(resultData + i * butchSize,
            (char *)baseAddr + i * butchesSizeInBytes, butchesSizeInBytes);
+    EndPhase(INSTRUMENTATION_PHASE_COPY, phaseStart);
   }
   LOG("Total size after butching: [size:%zu]\n", totalSize);
 
   if (totalSize != 0) {
-    StatData *rdata = realloc(resultData, fileSize);
+    StatData *rdata = AllocatorReallocate(allocator, resultData, fileSize);
     if (BINARYSERIALIZER_UNLIKELY(!rdata)) {
-      free(resultData);
+      if (baseAddr) {
+        Tmunmap(baseAddr, mappedBytes);
+      }
+      AllocatorFree(allocator, resultData);
       CloseFd(filePath, fd);
       LOG_ERR("Cannot allocate [bytes:%zu]\n", fileSize);
       LOG("[LoadDump end]_____________________\n");
       return ERROR;
     }
     resultData = rdata;
+    phaseStart = BeginPhase();
     void *addr = mmap(NULL, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+    EndPhase(INSTRUMENTATION_PHASE_MAP, phaseStart);
     if (BINARYSERIALIZER_UNLIKELY(addr == MAP_FAILED)) {
-      free(resultData);
+      if (baseAddr) {
+        Tmunmap(baseAddr, mappedBytes);
+      }
+      AllocatorFree(allocator, resultData);
       CloseFd(filePath, fd);
       LOG_ERR("Cannot mmap file [filePath:%s] with size [size:%zu][line:%d]\n",
               filePath, butchesSizeInBytes, __LINE__);
       LOG("[LoadDump end]_____________________\n");
       return ERROR;
     }
+    if (baseAddr) {
+      Tmunmap(baseAddr, mappedBytes);
+    }
     baseAddr = addr;
+    mappedBytes = fileSize;
+    phaseStart = BeginPhase();
     memcpy(resultData + i * butchSize,
            (char *)baseAddr + i * butchesSizeInBytes, totalSize);
+    EndPhase(INSTRUMENTATION_PHASE_COPY, phaseStart);
   }
 
-  Tmsync(baseAddr, fileSize, MS_ASYNC);
-  Tmunmap(baseAddr, fileSize);
+  Tmsync(baseAddr, mappedBytes, MS_ASYNC);
+  Tmunmap(baseAddr, mappedBytes);
 
   CloseFd(filePath, fd);
+  CountEvent(INSTRUMENTATION_BYTES_READ, fileSize);
+  CountEvent(INSTRUMENTATION_REALLOCS, i + (totalSize != 0));
   *data = resultData;
   *size = fileSize / sizeof(StatData);
   LOG("[LoadDump end]_____________________\n");
   return SUCCESS;
 }
 
+/**
+ * @brief Вставляет записи обоих входов JoinDump в хеш-таблицу
+ *
+ * Каждый вход вставляется пакетно через InsertBatchWithScratch(), повторы
+ * id сворачиваются до обращения к таблице.
+ *
+ * @param[in] scratch Рабочие массивы вставки, NULL - выделить на вызов
+ *
+ * @return SUCCESS или ERROR при ошибке вставки
+ */
+static Status FillJoinTable(MergeHashTable *__restrict table,
+                            BulkMergeScratch *scratch,
+                            const StatData *__restrict firstData,
+                            size_t firstSize,
+                            const StatData *__restrict secondData,
+                            size_t secondSize) {
+  if (BINARYSERIALIZER_UNLIKELY(
+          (firstData &&
+           !InsertBatchWithScratch(table, firstData, firstSize, scratch)) ||
+          (secondData &&
+           !InsertBatchWithScratch(table, secondData, secondSize, scratch)))) {
+    LOG_ERR("Cannot insert value into hash table\n");
+    return ERROR;
+  }
+  return SUCCESS;
+}
+
 Status JoinDump(const StatData *__restrict firstData, size_t firstSize,
                 const StatData *__restrict secondData, size_t secondSize,
                 StatData **__restrict resultData, size_t *resultSize) {
+  return JoinDumpWithAllocator(firstData, firstSize, secondData, secondSize,
+                               resultData, resultSize, NULL);
+}
+
+Status JoinDumpWithAllocator(const StatData *__restrict firstData,
+                             size_t firstSize,
+                             const StatData *__restrict secondData,
+                             size_t secondSize,
+                             StatData **__restrict resultData,
+                             size_t *resultSize, const Allocator *allocator) {
   LOG("[JoinDump begin]_____________________\n");
+  allocator = ResolveAllocator(allocator);
   if (BINARYSERIALIZER_UNLIKELY(((!firstData || firstSize == 0) &&
                                  (!secondData || secondSize == 0)) ||
-                                !resultData || !resultSize)) {
-    LOG_ERR("All data or result data is null or empty\n");
+                                !resultData || !resultSize || !allocator)) {
+    LOG_ERR("All data or result data is null or empty or bad allocator\n");
     LOG("[LoadDump end]_____________________\n");
     return INVALID_POINTER_OR_SIZE;
   }
 
   MergeHashTable table;
-  if (BINARYSERIALIZER_UNLIKELY(!InitHashTable(&table, NULL, NULL, NULL))) {
+  if (BINARYSERIALIZER_UNLIKELY(!InitHashTableWithAllocator(
+          &table, BINARYSERIALIZER_DEFUALT_BUCKETS_COUNT, NULL, NULL, NULL,
+          allocator))) {
     LOG_ERR("Cannot init MergeHashTable\n");
     LOG("[LoadDump end]_____________________\n");
     return ERROR;
   }
-  size_t maxSize = fmax((double)firstSize, (double)secondSize);
-  for (size_t i = 0; i < maxSize; ++i) {
-    if (i < firstSize) {
-      if (BINARYSERIALIZER_LIKELY(firstData)) {
-        int result = InsertToHashTable(&table, firstData + i);
-        assert(result == 1);
-        if (result != 1) {
-          ClearHashTable(&table);
-          LOG_ERR("Cannot insert value into hash table\n");
-          LOG("[LoadDump end]_____________________\n");
-          return ERROR;
-        }
-      }
-    }
-
-    if (i < secondSize) {
-      if (BINARYSERIALIZER_LIKELY(secondData)) {
-        int result = InsertToHashTable(&table, secondData + i);
-        assert(result == 1);
-        if (result != 1) {
-          ClearHashTable(&table);
-          LOG_ERR("Cannot insert value into hash table\n");
-          LOG("[LoadDump end]_____________________\n");
-          return ERROR;
-        }
-      }
-    }
+  if (BINARYSERIALIZER_UNLIKELY(FillJoinTable(&table, NULL, firstData,
+                                              firstSize, secondData,
+                                              secondSize) !=
+                                SUCCESS)) {
+    ClearHashTable(&table);
+    LOG("[LoadDump end]_____________________\n");
+    return ERROR;
   }
 
   Status result =
@@ -254,6 +326,268 @@ Status JoinDump(const StatData *__restrict firstData, size_t firstSize,
   return result;
 }
 
+Status JoinDumpWithContext(ExecutionContext *context,
+                           const StatData *__restrict firstData,
+                           size_t firstSize,
+                           const StatData *__restrict secondData,
+                           size_t secondSize, StatData **__restrict resultData,
+                           size_t *resultSize) {
+  LOG("[JoinDumpWithContext begin]_____________________\n");
+  if (BINARYSERIALIZER_UNLIKELY(!context ||
+                                ((!firstData || firstSize == 0) &&
+                                 (!secondData || secondSize == 0)) ||
+                                !resultData || !resultSize)) {
+    LOG_ERR("Null context or all data is null or empty or null result\n");
+    LOG("[JoinDumpWithContext end]_____________________\n");
+    return INVALID_POINTER_OR_SIZE;
+  }
+
+  // Узлы прошлого вызова остаются выделенными и заполняются заново
+  ResetHashTable(&context->table);
+  if (BINARYSERIALIZER_UNLIKELY(
+          FillJoinTable(&context->table, &context->scratch, firstData,
+                        firstSize, secondData, secondSize) != SUCCESS)) {
+    LOG("[JoinDumpWithContext end]_____________________\n");
+    return ERROR;
+  }
+  size_t size = HashTableSize(&context->table);
+  if (BINARYSERIALIZER_UNLIKELY(!ReserveContextRecords(
+          context, &context->joined, &context->joinedCapacity, size))) {
+    LOG_ERR("Cannot allocate [bytes:%zu]\n", sizeof(StatData) * size);
+    LOG("[JoinDumpWithContext end]_____________________\n");
+    return ERROR;
+  }
+  HashTableToBuffer(&context->table, context->joined, size);
+  *resultData = context->joined;
+  *resultSize = size;
+  LOG("[JoinDumpWithContext end]_____________________\n");
+  return SUCCESS;
+}
+
+Status JoinDumpToFile(const StatData *__restrict firstData, size_t firstSize,
+                      const StatData *__restrict secondData,
+                      size_t secondSize, const char *resultPath,
+                      MappedDump *result) {
+  LOG("[JoinDumpToFile begin]_____________________\n");
+  if (BINARYSERIALIZER_UNLIKELY(((!firstData || firstSize == 0) &&
+                                 (!secondData || secondSize == 0)) ||
+                                !resultPath)) {
+    LOG_ERR("All data is null or empty or null resultPath\n");
+    LOG("[JoinDumpToFile end]_____________________\n");
+    return INVALID_POINTER_OR_SIZE;
+  }
+
+  MergeHashTable table;
+  if (BINARYSERIALIZER_UNLIKELY(!InitHashTable(&table, NULL, NULL, NULL))) {
+    LOG_ERR("Cannot init MergeHashTable\n");
+    LOG("[JoinDumpToFile end]_____________________\n");
+    return ERROR;
+  }
+  Status status =
+      FillJoinTable(&table, NULL, firstData, firstSize, secondData, secondSize);
+
+  MappedDump dump;
+  if (status == SUCCESS) {
+    status = MapDump(resultPath, 1, &dump);
+    if (status == SUCCESS) {
+      // Файл сразу получает итоговый размер, узлы копируются в отображение
+      status = ResizeMappedDump(&dump, HashTableSize(&table));
+      if (status == SUCCESS) {
+        HashTableToBuffer(&table, dump.data, dump.size);
+        CountEvent(INSTRUMENTATION_BYTES_WRITTEN, dump.mappedBytes);
+      }
+      if (status != SUCCESS || !result) {
+        Status unmapStatus = UnmapDump(&dump);
+        status = status != SUCCESS ? status : unmapStatus;
+      } else {
+        *result = dump;
+      }
+    }
+  }
+  ClearHashTable(&table);
+  LOG("[JoinDumpToFile end]_____________________\n");
+  return status;
+}
+
+static int CompareStatDataById(const void *__restrict lhs,
+                               const void *__restrict rhs) {
+  const StatData *sdlhs = lhs;
+  const StatData *sdrhs = rhs;
+  return (sdlhs->id > sdrhs->id) - (sdlhs->id < sdrhs->id);
+}
+
+/**
+ * @brief Ищет отсортированные id unique во всех сериях дампа
+ *
+ * positions[i] получает позицию записи с тем же id или SIZE_MAX, если id в
+ * дампе нет. Поиск в каждой серии продолжается с позиции предыдущего id.
+ *
+ * @return SUCCESS или BAD_FILE, если серии не отсортированы по id
+ */
+static Status LocateDeltaIds(const MappedDump *dump, const DumpRuns *runs,
+                             const StatData *unique, size_t uniqueSize,
+                             size_t *positions) {
+  size_t from[BINARYSERIALIZER_MAX_DUMP_RUNS];
+  size_t ends[BINARYSERIALIZER_MAX_DUMP_RUNS];
+  size_t begin = 0;
+  for (size_t r = 0; r < runs->count; ++r) {
+    from[r] = begin;
+    begin += runs->sizes[r];
+    ends[r] = begin;
+  }
+  for (size_t i = 0; i < uniqueSize; ++i) {
+    positions[i] = SIZE_MAX;
+    for (size_t r = 0; r < runs->count; ++r) {
+      size_t pos = LowerBoundById(dump->data, from[r], ends[r], unique[i].id);
+      if (BINARYSERIALIZER_UNLIKELY(pos == BINARYSERIALIZER_UNORDERED_DUMP)) {
+        LOG_ERR("Dump is not sorted by id near [id:%ld]\n", unique[i].id);
+        return BAD_FILE;
+      }
+      from[r] = pos;
+      if (pos < ends[r] && dump->data[pos].id == unique[i].id) {
+        positions[i] = pos;
+        break;
+      }
+    }
+  }
+  return SUCCESS;
+}
+
+/**
+ * @brief Сливает соседние серии, пока каждая хотя бы вдвое длиннее
+ * следующей (или все серии, если compact)
+ */
+static Status MergeDumpRuns(const MappedDump *dump, DumpRuns *runs,
+                            int compact) {
+  while (runs->count > 1 &&
+         (compact || runs->sizes[runs->count - 2] <
+                         2 * runs->sizes[runs->count - 1])) {
+    if (BINARYSERIALIZER_UNLIKELY(!MergeLastDumpRuns(dump->data, runs))) {
+      return ERROR;
+    }
+  }
+  return SUCCESS;
+}
+
+Status UpdateDump(const char *filePath, const StatData *delta,
+                  size_t deltaSize) {
+  LOG("[UpdateDump begin]_____________________\n");
+  if (BINARYSERIALIZER_UNLIKELY(!filePath || !delta || deltaSize == 0)) {
+    LOG_ERR("Bad filePath or delta or deltaSize=0\n");
+    LOG("[UpdateDump end]_____________________\n");
+    return INVALID_POINTER_OR_SIZE;
+  }
+
+  StatData *unique = NULL;
+  size_t uniqueSize = 0;
+  Status status = JoinDump(delta, deltaSize, NULL, 0, &unique, &uniqueSize);
+  if (BINARYSERIALIZER_UNLIKELY(status != SUCCESS)) {
+    LOG("[UpdateDump end]_____________________\n");
+    return status;
+  }
+  uint64_t phaseStart = BeginPhase();
+  qsort(unique, uniqueSize, sizeof(StatData), &CompareStatDataById);
+  EndPhase(INSTRUMENTATION_PHASE_SORT, phaseStart);
+
+  MappedDump dump;
+  status = MapDump(filePath, 1, &dump);
+  if (BINARYSERIALIZER_UNLIKELY(status != SUCCESS)) {
+    FreeMemory(unique);
+    LOG("[UpdateDump end]_____________________\n");
+    return status;
+  }
+
+  size_t *positions = AllocateMemory(sizeof(size_t) * uniqueSize);
+  if (BINARYSERIALIZER_UNLIKELY(!positions)) {
+    FreeMemory(unique);
+    BINARYSERIALIZER_UNUSED(UnmapDump(&dump));
+    LOG_ERR("Cannot allocate [bytes:%zu]\n", sizeof(size_t) * uniqueSize);
+    LOG("[UpdateDump end]_____________________\n");
+    return ERROR;
+  }
+
+  // Дамп изменяется только после того, как все позиции найдены и порядок
+  // проверен: неотсортированный файл остается нетронутым
+  DumpRuns runs;
+  LoadDumpRuns(filePath, dump.size, &runs);
+  phaseStart = BeginPhase();
+  status = LocateDeltaIds(&dump, &runs, unique, uniqueSize, positions);
+  size_t newCount = 0;
+  if (status == SUCCESS) {
+    // Существующие id сливаются на месте, новые уплотняются в начало unique
+    for (size_t i = 0; i < uniqueSize; ++i) {
+      if (positions[i] != SIZE_MAX) {
+        MergeStatData(dump.data + positions[i], unique + i);
+      } else {
+        unique[newCount++] = unique[i];
+      }
+    }
+    CountEvent(INSTRUMENTATION_MERGES, uniqueSize - newCount);
+    LOG("Merged [records:%zu] new [records:%zu]\n", uniqueSize - newCount,
+        newCount);
+  }
+
+  if (status == SUCCESS && newCount != 0) {
+    // Новые id дописываются отдельной серией без сдвига существующих
+    // записей, затем короткие серии в конце сливаются
+    size_t end = dump.size;
+    status = ResizeMappedDump(&dump, dump.size + newCount);
+    if (status == SUCCESS) {
+      memcpy(dump.data + end, unique, sizeof(StatData) * newCount);
+      CountEvent(INSTRUMENTATION_BYTES_WRITTEN, sizeof(StatData) * newCount);
+      // При длинах, убывающих вдвое, предел недостижим; защита от
+      // постороннего файла серий
+      if (runs.count == BINARYSERIALIZER_MAX_DUMP_RUNS &&
+          BINARYSERIALIZER_UNLIKELY(!MergeLastDumpRuns(dump.data, &runs))) {
+        status = ERROR;
+      }
+      if (status == SUCCESS) {
+        runs.sizes[runs.count++] = newCount;
+        status = MergeDumpRuns(&dump, &runs, 0);
+      }
+    }
+    if (status == SUCCESS &&
+        BINARYSERIALIZER_UNLIKELY(!StoreDumpRuns(filePath, &runs))) {
+      status = BAD_FILE;
+    }
+  }
+  EndPhase(INSTRUMENTATION_PHASE_MERGE, phaseStart);
+
+  FreeMemory(positions);
+  FreeMemory(unique);
+  Status unmapStatus = UnmapDump(&dump);
+  LOG("[UpdateDump end]_____________________\n");
+  return status != SUCCESS ? status : unmapStatus;
+}
+
+Status CompactDump(const char *filePath) {
+  LOG("[CompactDump begin]_____________________\n");
+  if (BINARYSERIALIZER_UNLIKELY(!filePath)) {
+    LOG_ERR("Bad filePath\n");
+    LOG("[CompactDump end]_____________________\n");
+    return INVALID_POINTER_OR_SIZE;
+  }
+  MappedDump dump;
+  Status status = MapDump(filePath, 1, &dump);
+  if (BINARYSERIALIZER_UNLIKELY(status != SUCCESS)) {
+    LOG("[CompactDump end]_____________________\n");
+    return status;
+  }
+  DumpRuns runs;
+  LoadDumpRuns(filePath, dump.size, &runs);
+  LOG("Compacting [runs:%zu]\n", runs.count);
+  uint64_t phaseStart = BeginPhase();
+  status = MergeDumpRuns(&dump, &runs, 1);
+  EndPhase(INSTRUMENTATION_PHASE_MERGE, phaseStart);
+  if (status == SUCCESS &&
+      BINARYSERIALIZER_UNLIKELY(!StoreDumpRuns(filePath, &runs))) {
+    status = BAD_FILE;
+  }
+  Status unmapStatus = UnmapDump(&dump);
+  LOG("[CompactDump end]_____________________\n");
+  return status != SUCCESS ? status : unmapStatus;
+}
+
 Status SortDump(StatData *data, size_t size, SortFunction sortFunc) {
   LOG("[SortDump begin]_____________________\n");
   if (BINARYSERIALIZER_UNLIKELY(!data || size == 0 || !sortFunc)) {
@@ -261,7 +595,9 @@ Status SortDump(StatData *data, size_t size, SortFunction sortFunc) {
     LOG("[SortDump end]_____________________\n");
     return INVALID_POINTER_OR_SIZE;
   }
+  uint64_t phaseStart = BeginPhase();
   qsort(data, size, sizeof(StatData), sortFunc);
+  EndPhase(INSTRUMENTATION_PHASE_SORT, phaseStart);
   LOG("[SortDump end]_____________________\n");
   return SUCCESS;
 }
@@ -277,6 +613,7 @@ Status PrintDump(const StatData *data, size_t size, size_t linesCount,
   view->data = data;
   view->dataSize = size;
   view->memSize = sizeof(StatData);
+  view->permutation = NULL;
 
   TablewViewStatus status = PrintTable(view, linesCount);
   if (BINARYSERIALIZER_UNLIKELY(status == TVS_ERROR)) {
@@ -284,4 +621,54 @@ Status PrintDump(const StatData *data, size_t size, size_t linesCount,
   }
   LOG("[PrintDump end]_____________________\n");
   return status != TVS_ERROR ? SUCCESS : ERROR;
+}
+
+Status PrintDumpWithContext(ExecutionContext *context, const StatData *data,
+                            size_t size, size_t linesCount, TableView *view,
+                            const char **text, size_t *textSize) {
+  LOG("[PrintDumpWithContext begin]_____________________\n");
+  if (BINARYSERIALIZER_UNLIKELY(!context || !text || !textSize)) {
+    LOG_ERR("Null context or text\n");
+    LOG("[PrintDumpWithContext end]_____________________\n");
+    return INVALID_POINTER_OR_SIZE;
+  }
+  context->textSize = 0;
+  TableSink sink = view ? view->sink : (TableSink){NULL, NULL};
+  if (view) {
+    view->sink.write = &AppendContextText;
+    view->sink.context = context;
+  }
+  Status status = PrintDump(data, size, linesCount, view);
+  if (view) {
+    view->sink = sink;
+  }
+  if (status == SUCCESS) {
+    *text = context->text;
+    *textSize = context->textSize;
+  }
+  LOG("[PrintDumpWithContext end]_____________________\n");
+  return status;
+}
+
+Status PrintDumpPermuted(const StatData *data, const uint32_t *permutation,
+                         size_t size, size_t linesCount, TableView *view) {
+  LOG("[PrintDumpPermuted begin]_____________________\n");
+  if (BINARYSERIALIZER_UNLIKELY(!data || !permutation || size == 0 ||
+                                !view)) {
+    LOG_ERR("Invalid pointer or size\n");
+    LOG("[PrintDumpPermuted end]_____________________\n");
+    return INVALID_POINTER_OR_SIZE;
+  }
+  view->data = data;
+  view->dataSize = size;
+  view->memSize = sizeof(StatData);
+  view->permutation = permutation;
+
+  TablewViewStatus status = PrintTable(view, linesCount);
+  view->permutation = NULL;
+  if (BINARYSERIALIZER_UNLIKELY(status == TVS_ERROR)) {
+    LOG_ERR("Something then wrong with printTable\n");
+  }
+  LOG("[PrintDumpPermuted end]_____________________\n");
+  return status != TVS_ERROR ? SUCCESS : ERROR;
 }
\ No newline at end of file
@@ -0,0 +1,116 @@
+#include "internal/bulkMerge.h"
+#include "internal/allocation.h"
+
+#if defined(BS_ENABLE_MI_MALLOC)
+#include <mimalloc-override.h>
+#else
+#include <stdlib.h>
+#endif
+
+#include <string.h>
+
+// Load factor of the id -> group map is at most 1/2
+#define SLOTS_BITS 13
+#define SLOTS_COUNT ((size_t)1 << SLOTS_BITS)
+
+_Static_assert(SLOTS_COUNT >= 2 * BINARYSERIALIZER_BULK_MERGE_CHUNK,
+               "slots map must be at least twice as large as a chunk");
+
+size_t BulkMergeScratchBytes(void) {
+  const size_t chunk = BINARYSERIALIZER_BULK_MERGE_CHUNK;
+  // Widest types first to keep every array naturally aligned
+  return sizeof(StatData) * chunk + sizeof(long) * chunk +
+         sizeof(BulkMergeGroup) * chunk + sizeof(int) * SLOTS_COUNT;
+}
+
+int InitBulkMergeScratch(BulkMergeScratch *scratch,
+                         const Allocator *allocator) {
+  if (BINARYSERIALIZER_UNLIKELY(!scratch || !allocator)) {
+    return 0;
+  }
+  const size_t chunk = BINARYSERIALIZER_BULK_MERGE_CHUNK;
+  char *block = AllocatorAllocate(allocator, BulkMergeScratchBytes());
+  if (BINARYSERIALIZER_UNLIKELY(!block)) {
+    memset(scratch, 0, sizeof(*scratch));
+    return 0;
+  }
+  scratch->allocator = allocator;
+  scratch->reduced = (StatData *)block;
+  block += sizeof(StatData) * chunk;
+  scratch->groupIds = (long *)block;
+  block += sizeof(long) * chunk;
+  scratch->groups = (BulkMergeGroup *)block;
+  block += sizeof(BulkMergeGroup) * chunk;
+  scratch->slots = (int *)block;
+  // ReduceBatchById() leaves the map empty again, so it is cleared only once
+  memset(scratch->slots, 0xff, sizeof(int) * SLOTS_COUNT);
+  return 1;
+}
+
+void ClearBulkMergeScratch(BulkMergeScratch *scratch) {
+  if (BINARYSERIALIZER_UNLIKELY(!scratch)) {
+    return;
+  }
+  if (scratch->allocator) {
+    AllocatorFree(scratch->allocator, scratch->reduced);
+  }
+  memset(scratch, 0, sizeof(*scratch));
+}
+
+static size_t SlotIndex(long id) {
+  return (size_t)(((unsigned long long)id * 0x9e3779b97f4a7c15ULL) >>
+                  (64 - SLOTS_BITS));
+}
+
+size_t ReduceBatchById(BulkMergeScratch *scratch, const StatData *data,
+                       size_t size) {
+  int *__restrict slots = scratch->slots;
+  long *__restrict groupIds = scratch->groupIds;
+  BulkMergeGroup *__restrict groups = scratch->groups;
+
+  // One pass: every record is folded into the accumulator of its id. The
+  // accumulators keep the fields unpacked, so bitfields are decoded once per
+  // record and packed once per group
+  unsigned groupsCount = 0;
+  for (size_t i = 0; i < size; ++i) {
+    long id = data[i].id;
+    size_t slot = SlotIndex(id);
+    int g;
+    while ((g = slots[slot]) >= 0 && groupIds[g] != id) {
+      slot = (slot + 1) & (SLOTS_COUNT - 1);
+    }
+    unsigned char mode = (unsigned char)data[i].mode;
+    if (g < 0) {
+      slots[slot] = (int)groupsCount;
+      groupIds[groupsCount] = id;
+      BulkMergeGroup *group = groups + groupsCount++;
+      group->count = data[i].count;
+      group->cost = data[i].cost;
+      group->primary = (unsigned char)data[i].primary;
+      group->mode = mode;
+      continue;
+    }
+    BulkMergeGroup *group = groups + g;
+    group->count += data[i].count;
+    group->cost += data[i].cost;
+    group->primary &= (unsigned char)data[i].primary;
+    group->mode = mode > group->mode ? mode : group->mode;
+  }
+
+  // Pack the results and empty the map slot by slot: far cheaper than
+  // clearing it whole when only a few ids are hot
+  for (unsigned g = 0; g < groupsCount; ++g) {
+    StatData *out = scratch->reduced + g;
+    out->id = groupIds[g];
+    out->count = groups[g].count;
+    out->cost = groups[g].cost;
+    out->primary = groups[g].primary;
+    out->mode = groups[g].mode;
+    size_t slot = SlotIndex(groupIds[g]);
+    while (slots[slot] != (int)g) {
+      slot = (slot + 1) & (SLOTS_COUNT - 1);
+    }
+    slots[slot] = -1;
+  }
+  return groupsCount;
+}
@@ -0,0 +1,214 @@
+#include "BinarySerializer/cellFormat.h"
+#include "BinarySerializer/statData.h"
+#include "internal/powersOfTen.h"
+
+#if defined(BS_ENABLE_MI_MALLOC)
+#include <mimalloc-override.h>
+#else
+#include <stdlib.h>
+#endif
+
+#include <string.h>
+
+#define MAX_SCIENTIFIC_PRECISION 9
+
+static const char hexDigits[] = "0123456789abcdef";
+
+static const char decimalPairs[] = "00010203040506070809"
+                                   "10111213141516171819"
+                                   "20212223242526272829"
+                                   "30313233343536373839"
+                                   "40414243444546474849"
+                                   "50515253545556575859"
+                                   "60616263646566676869"
+                                   "70717273747576777879"
+                                   "80818283848586878889"
+                                   "90919293949596979899";
+
+size_t FormatHex(uint64_t value, char *buffer, size_t bufferSize) {
+  size_t digits = 1;
+  while (digits < 16 && (value >> (4 * digits)) != 0) {
+    ++digits;
+  }
+  if (BINARYSERIALIZER_UNLIKELY(digits > bufferSize)) {
+    return 0;
+  }
+  for (size_t i = digits; i-- > 0;) {
+    buffer[i] = hexDigits[value & 0xf];
+    value >>= 4;
+  }
+  return digits;
+}
+
+/**
+ * @brief Десятичные цифры value справа налево, по две за деление
+ *
+ * @return Количество цифр, записанных в конец tmp
+ */
+static size_t RenderUnsigned(uint64_t value, char tmp[20]) {
+  char *end = tmp + 20;
+  char *p = end;
+  while (value >= 100) {
+    unsigned pair = (unsigned)(value % 100);
+    value /= 100;
+    p -= 2;
+    memcpy(p, decimalPairs + 2 * pair, 2);
+  }
+  if (value >= 10) {
+    p -= 2;
+    memcpy(p, decimalPairs + 2 * value, 2);
+  } else {
+    *--p = (char)('0' + value);
+  }
+  return (size_t)(end - p);
+}
+
+size_t FormatDecimal(int64_t value, char *buffer, size_t bufferSize) {
+  char tmp[20];
+  uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+  size_t digits = RenderUnsigned(magnitude, tmp);
+  size_t sign = value < 0;
+  if (BINARYSERIALIZER_UNLIKELY(digits + sign > bufferSize)) {
+    return 0;
+  }
+  buffer[0] = '-';
+  memcpy(buffer + sign, tmp + 20 - digits, digits);
+  return digits + sign;
+}
+
+/**
+ * @brief Мантисса value * 10^shift, округленная к ближайшему четному
+ */
+static uint64_t ScaledDigits(double value, int shift) {
+  long double scaled = (long double)value;
+  if (shift >= 0) {
+    scaled *= PowerOfTen((unsigned)shift);
+  } else {
+    scaled /= PowerOfTen((unsigned)-shift);
+  }
+  uint64_t digits = (uint64_t)scaled;
+  long double fraction = scaled - (long double)digits;
+  if (fraction > 0.5L || (fraction == 0.5L && (digits & 1))) {
+    ++digits;
+  }
+  return digits;
+}
+
+size_t FormatScientific(double value, unsigned precision, char *buffer,
+                        size_t bufferSize) {
+  if (BINARYSERIALIZER_UNLIKELY(precision > MAX_SCIENTIFIC_PRECISION)) {
+    return 0;
+  }
+  // The library is built with -ffast-math, so the special values are told
+  // apart by their bits rather than by isnan() / isinf() / signbit()
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  size_t sign = (size_t)(bits >> 63);
+  bits &= ~((uint64_t)1 << 63);
+  unsigned biasedExponent = (unsigned)(bits >> 52);
+  if (BINARYSERIALIZER_UNLIKELY(biasedExponent == 0x7ff)) {
+    const char *text = (bits << 12) != 0 ? "nan" : "inf";
+    if (BINARYSERIALIZER_UNLIKELY(3 + sign > bufferSize)) {
+      return 0;
+    }
+    buffer[0] = '-';
+    memcpy(buffer + sign, text, 3);
+    return 3 + sign;
+  }
+  double magnitude;
+  memcpy(&magnitude, &bits, sizeof(magnitude));
+
+  int exponent = 0;
+  uint64_t digits = 0;
+  uint64_t lower = (uint64_t)PowerOfTen(precision);
+  if (bits != 0) {
+    // floor(log2(x) * log10(2)) is at most one below the decimal exponent,
+    // the loop below walks the rest of the way for subnormals
+    exponent = (((int)biasedExponent - 1023) * 78913) >> 18;
+    for (;;) {
+      digits = ScaledDigits(magnitude, (int)precision - exponent);
+      if (digits >= 10 * lower) {
+        ++exponent;
+      } else if (digits < lower) {
+        --exponent;
+      } else {
+        break;
+      }
+    }
+  }
+
+  char exponentDigits[20];
+  unsigned exponentMagnitude = exponent < 0 ? (unsigned)-exponent
+                                            : (unsigned)exponent;
+  size_t exponentLength = RenderUnsigned(exponentMagnitude, exponentDigits);
+  if (exponentLength < 2) {
+    exponentDigits[20 - 2] = '0';
+    exponentLength = 2;
+  }
+  size_t length = sign + 1 + (precision ? precision + 1 : 0) + 2 +
+                  exponentLength;
+  if (BINARYSERIALIZER_UNLIKELY(length > bufferSize)) {
+    return 0;
+  }
+
+  char mantissa[20];
+  size_t mantissaLength = RenderUnsigned(digits, mantissa);
+  const char *mantissaDigits = mantissa + 20 - mantissaLength;
+  if (bits == 0) {
+    memset(mantissa, '0', sizeof(mantissa));
+    mantissaDigits = mantissa;
+  }
+  char *p = buffer;
+  if (sign) {
+    *p++ = '-';
+  }
+  *p++ = mantissaDigits[0];
+  if (precision) {
+    *p++ = '.';
+    memcpy(p, mantissaDigits + 1, precision);
+    p += precision;
+  }
+  *p++ = 'e';
+  *p++ = exponent < 0 ? '-' : '+';
+  memcpy(p, exponentDigits + 20 - exponentLength, exponentLength);
+  return length;
+}
+
+size_t FormatBits(uint64_t value, unsigned width, char *buffer,
+                  size_t bufferSize) {
+  if (BINARYSERIALIZER_UNLIKELY(width == 0 || width > 64 ||
+                                width > bufferSize)) {
+    return 0;
+  }
+  for (unsigned i = 0; i < width; ++i) {
+    buffer[i] = (char)('0' + ((value >> (width - 1 - i)) & 1));
+  }
+  return width;
+}
+
+void StatDataFormatter(int id, const void *data, char *buffer,
+                       size_t bufferSize) {
+  const StatData *record = data;
+  switch (id) {
+  case STAT_DATA_COLUMN_ID:
+    FormatHex((uint64_t)record->id, buffer, bufferSize);
+    break;
+  case STAT_DATA_COLUMN_COUNT:
+    FormatDecimal(record->count, buffer, bufferSize);
+    break;
+  case STAT_DATA_COLUMN_COST:
+    FormatScientific(record->cost, 3, buffer, bufferSize);
+    break;
+  case STAT_DATA_COLUMN_PRIMARY:
+    if (BINARYSERIALIZER_LIKELY(bufferSize != 0)) {
+      buffer[0] = record->primary ? 'y' : 'n';
+    }
+    break;
+  case STAT_DATA_COLUMN_MODE:
+    FormatBits(record->mode, 3, buffer, bufferSize);
+    break;
+  default:
+    LOG_ERR("Unknown id for formatter:%d\n", id);
+    break;
+  }
+}
@@ -0,0 +1,156 @@
+#include "internal/dumpIO.h"
+#include "internal/allocation.h"
+#include "internal/instrumentation.h"
+
+#if defined(BS_ENABLE_MI_MALLOC)
+#include <mimalloc-override.h>
+#else
+#include <stdlib.h>
+#endif
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static int WriteAll(int fd, const void *data, size_t bytes) {
+  const char *p = data;
+  while (bytes != 0) {
+    ssize_t result = write(fd, p, bytes);
+    if (BINARYSERIALIZER_UNLIKELY(result < 0)) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG_ERR("Cannot write [bytes:%zu] into [fd:%d]\n", bytes, fd);
+      return 0;
+    }
+    p += result;
+    bytes -= (size_t)result;
+    CountEvent(INSTRUMENTATION_BYTES_WRITTEN, (size_t)result);
+  }
+  return 1;
+}
+
+int InitDumpWriter(DumpWriter *writer, int fd, size_t capacity) {
+  if (BINARYSERIALIZER_UNLIKELY(!writer || fd < 0 || capacity == 0)) {
+    return 0;
+  }
+  writer->buffer = AllocateMemory(sizeof(StatData) * capacity);
+  writer->capacity = writer->buffer ? capacity : 0;
+  writer->count = 0;
+  writer->written = 0;
+  writer->fd = fd;
+  return writer->buffer != NULL;
+}
+
+int WriteToDumpWriter(DumpWriter *writer, const StatData *data, size_t size) {
+  while (size != 0) {
+    if (writer->count == writer->capacity &&
+        BINARYSERIALIZER_UNLIKELY(!FlushDumpWriter(writer))) {
+      return 0;
+    }
+    size_t room = writer->capacity - writer->count;
+    size_t chunk = size < room ? size : room;
+    memcpy(writer->buffer + writer->count, data, sizeof(StatData) * chunk);
+    writer->count += chunk;
+    writer->written += chunk;
+    data += chunk;
+    size -= chunk;
+  }
+  return 1;
+}
+
+int FlushDumpWriter(DumpWriter *writer) {
+  if (writer->count == 0) {
+    return 1;
+  }
+  int result =
+      WriteAll(writer->fd, writer->buffer, sizeof(StatData) * writer->count);
+  writer->count = 0;
+  return result;
+}
+
+void ClearDumpWriter(DumpWriter *writer) {
+  if (BINARYSERIALIZER_UNLIKELY(!writer)) {
+    return;
+  }
+  FreeMemory(writer->buffer);
+  writer->buffer = NULL;
+  writer->capacity = 0;
+  writer->count = 0;
+}
+
+int InitDumpReader(DumpReader *reader, int fd, size_t capacity) {
+  if (BINARYSERIALIZER_UNLIKELY(!reader || fd < 0 || capacity == 0)) {
+    return 0;
+  }
+  struct stat statBuf;
+  if (BINARYSERIALIZER_UNLIKELY(fstat(fd, &statBuf) < 0)) {
+    LOG_ERR("Cannot fstat [fd:%d]\n", fd);
+    return 0;
+  }
+  reader->buffer = AllocateMemory(sizeof(StatData) * capacity);
+  reader->capacity = reader->buffer ? capacity : 0;
+  reader->offset = 0;
+  reader->size =
+      ((size_t)statBuf.st_size / sizeof(StatData)) * sizeof(StatData);
+  reader->fd = fd;
+  return reader->buffer != NULL;
+}
+
+size_t ReadFromDumpReader(DumpReader *reader, const StatData **data) {
+  size_t left = reader->size - reader->offset;
+  size_t bytes = sizeof(StatData) * reader->capacity;
+  if (bytes > left) {
+    bytes = left;
+  }
+  size_t done = 0;
+  while (done != bytes) {
+    ssize_t result = pread(reader->fd, (char *)reader->buffer + done,
+                           bytes - done, (off_t)(reader->offset + done));
+    if (BINARYSERIALIZER_UNLIKELY(result <= 0)) {
+      if (result < 0 && errno == EINTR) {
+        continue;
+      }
+      LOG_ERR("Cannot read [bytes:%zu] from [fd:%d]\n", bytes - done,
+              reader->fd);
+      return (size_t)-1;
+    }
+    done += (size_t)result;
+  }
+  reader->offset += bytes;
+  CountEvent(INSTRUMENTATION_BYTES_READ, bytes);
+  *data = reader->buffer;
+  return bytes / sizeof(StatData);
+}
+
+size_t DumpReaderSize(const DumpReader *reader) {
+  return reader->size / sizeof(StatData);
+}
+
+void ClearDumpReader(DumpReader *reader) {
+  if (BINARYSERIALIZER_UNLIKELY(!reader)) {
+    return;
+  }
+  FreeMemory(reader->buffer);
+  reader->buffer = NULL;
+  reader->capacity = 0;
+}
+
+int CreateTempDumpFile(const char *dir) {
+  char path[PATH_MAX];
+  int length = snprintf(path, sizeof(path), "%s/bs-XXXXXX", dir);
+  if (BINARYSERIALIZER_UNLIKELY(length < 0 || (size_t)length >= sizeof(path))) {
+    LOG_ERR("Too long temp dir [dir:%s]\n", dir);
+    return -1;
+  }
+  int fd = mkstemp(path);
+  if (BINARYSERIALIZER_UNLIKELY(fd < 0)) {
+    LOG_ERR("Cannot create temp file in [dir:%s]\n", dir);
+    return -1;
+  }
+  unlink(path);
+  return fd;
+}
@@ -0,0 +1,193 @@
+#include "internal/dumpRuns.h"
+#include "internal/allocation.h"
+#include "internal/instrumentation.h"
+
+#if defined(BS_ENABLE_MI_MALLOC)
+#include <mimalloc-override.h>
+#else
+#include <stdlib.h>
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * @brief Путь файла серий "<filePath>.runs"
+ *
+ * @return 1 при успехе, 0 если путь не помещается в PATH_MAX
+ */
+static int DumpRunsPath(const char *filePath, char path[PATH_MAX]) {
+  int length = snprintf(path, PATH_MAX, "%s.runs", filePath);
+  if (BINARYSERIALIZER_UNLIKELY(length < 0 || length >= PATH_MAX)) {
+    LOG_ERR("Too long dump path [path:%s]\n", filePath);
+    return 0;
+  }
+  return 1;
+}
+
+static void SingleDumpRun(size_t size, DumpRuns *runs) {
+  runs->count = size != 0;
+  runs->sizes[0] = size;
+}
+
+void LoadDumpRuns(const char *filePath, size_t size, DumpRuns *runs) {
+  SingleDumpRun(size, runs);
+  char path[PATH_MAX];
+  if (!DumpRunsPath(filePath, path)) {
+    return;
+  }
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return;
+  }
+  // One extra element detects a file longer than the runs limit
+  uint64_t sizes[BINARYSERIALIZER_MAX_DUMP_RUNS + 1];
+  ssize_t bytes = read(fd, sizes, sizeof(sizes));
+  close(fd);
+  if (bytes <= 0 || (size_t)bytes % sizeof(uint64_t) != 0 ||
+      (size_t)bytes > sizeof(uint64_t) * BINARYSERIALIZER_MAX_DUMP_RUNS) {
+    LOG_ERR("Ignoring malformed runs file [path:%s]\n", path);
+    return;
+  }
+  size_t count = (size_t)bytes / sizeof(uint64_t);
+  size_t total = 0;
+  for (size_t i = 0; i < count; ++i) {
+    if (sizes[i] == 0 || sizes[i] > size - total) {
+      LOG_ERR("Ignoring stale runs file [path:%s]\n", path);
+      return;
+    }
+    total += (size_t)sizes[i];
+  }
+  // The dump was rewritten without UpdateDump(): the runs no longer apply
+  if (total != size) {
+    LOG_ERR("Ignoring stale runs file [path:%s]\n", path);
+    return;
+  }
+  runs->count = count;
+  for (size_t i = 0; i < count; ++i) {
+    runs->sizes[i] = (size_t)sizes[i];
+  }
+}
+
+int StoreDumpRuns(const char *filePath, const DumpRuns *runs) {
+  char path[PATH_MAX];
+  if (!DumpRunsPath(filePath, path)) {
+    return 0;
+  }
+  if (runs->count <= 1) {
+    if (BINARYSERIALIZER_UNLIKELY(unlink(path) != 0 && errno != ENOENT)) {
+      LOG_ERR("Cannot remove runs file [path:%s]\n", path);
+      return 0;
+    }
+    return 1;
+  }
+  uint64_t sizes[BINARYSERIALIZER_MAX_DUMP_RUNS];
+  for (size_t i = 0; i < runs->count; ++i) {
+    sizes[i] = runs->sizes[i];
+  }
+  size_t bytes = sizeof(uint64_t) * runs->count;
+  int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (BINARYSERIALIZER_UNLIKELY(fd < 0)) {
+    LOG_ERR("Cannot open runs file [path:%s]\n", path);
+    return 0;
+  }
+  ssize_t written = write(fd, sizes, bytes);
+  int closed = close(fd) == 0;
+  if (BINARYSERIALIZER_UNLIKELY(written != (ssize_t)bytes || !closed)) {
+    LOG_ERR("Cannot write runs file [path:%s]\n", path);
+    return 0;
+  }
+  return 1;
+}
+
+int MergeLastDumpRuns(StatData *data, DumpRuns *runs) {
+  size_t begin = 0;
+  for (size_t i = 0; i + 2 < runs->count; ++i) {
+    begin += runs->sizes[i];
+  }
+  size_t leftSize = runs->sizes[runs->count - 2];
+  size_t rightSize = runs->sizes[runs->count - 1];
+  size_t middle = begin + leftSize;
+  size_t end = middle + rightSize;
+
+  size_t bufferSize = leftSize < rightSize ? leftSize : rightSize;
+  StatData *buffer = AllocateMemory(sizeof(StatData) * bufferSize);
+  if (BINARYSERIALIZER_UNLIKELY(!buffer)) {
+    LOG_ERR("Cannot allocate [bytes:%zu]\n", sizeof(StatData) * bufferSize);
+    return 0;
+  }
+  if (rightSize <= leftSize) {
+    // The right run is copied out and the merge fills the gap from the end
+    memcpy(buffer, data + middle, sizeof(StatData) * rightSize);
+    size_t i = middle;
+    size_t j = rightSize;
+    size_t k = end;
+    while (j != 0) {
+      if (i > begin && data[i - 1].id > buffer[j - 1].id) {
+        data[--k] = data[--i];
+      } else {
+        data[--k] = buffer[--j];
+      }
+    }
+  } else {
+    // The left run is copied out and the merge fills the gap from the start
+    memcpy(buffer, data + begin, sizeof(StatData) * leftSize);
+    size_t i = 0;
+    size_t j = middle;
+    size_t k = begin;
+    while (i != leftSize) {
+      if (j < end && data[j].id < buffer[i].id) {
+        data[k++] = data[j++];
+      } else {
+        data[k++] = buffer[i++];
+      }
+    }
+  }
+  CountEvent(INSTRUMENTATION_BYTES_WRITTEN, sizeof(StatData) * (end - begin));
+  FreeMemory(buffer);
+
+  runs->sizes[runs->count - 2] += rightSize;
+  runs->count--;
+  return 1;
+}
+
+size_t LowerBoundById(const StatData *data, size_t from, size_t size,
+                      long id) {
+  size_t lo = from;
+  size_t bound = 1;
+  long previous = 0;
+  int probed = 0;
+  while (lo + bound <= size) {
+    long probe = data[lo + bound - 1].id;
+    if (BINARYSERIALIZER_UNLIKELY(probed && probe <= previous)) {
+      return BINARYSERIALIZER_UNORDERED_DUMP;
+    }
+    if (probe >= id) {
+      break;
+    }
+    previous = probe;
+    probed = 1;
+    lo += bound;
+    bound <<= 1;
+  }
+  size_t hi = lo + bound - 1 < size ? lo + bound - 1 : size;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (data[mid].id < id) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (BINARYSERIALIZER_UNLIKELY(
+          (lo > from && lo < size && data[lo - 1].id >= data[lo].id) ||
+          (lo + 1 < size && data[lo].id >= data[lo + 1].id))) {
+    return BINARYSERIALIZER_UNORDERED_DUMP;
+  }
+  return lo;
+}
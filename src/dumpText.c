@@ -0,0 +1,748 @@
+#include "BinarySerializer/dumpText.h"
+#include "BinarySerializer/cellFormat.h"
+#include "internal/allocation.h"
+#include "internal/dumpIO.h"
+#include "internal/instrumentation.h"
+#include "internal/powersOfTen.h"
+#include "internal/threadPool.h"
+
+#if defined(BS_ENABLE_MI_MALLOC)
+#include <mimalloc-override.h>
+#else
+#include <stdlib.h>
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// The longest line is a JSON one with every field at its widest:
+// {"id":-9223372036854775808,"count":-2147483648,"cost":-1.23456789e+38,
+// "primary":false,"mode":7}
+#define MAX_LINE_LENGTH 128
+// 9 significant digits are enough to restore any float exactly
+#define COST_PRECISION 8
+#define INTEGER_CELL_SIZE 24
+#define COST_CELL_SIZE 16
+
+// Lines are split into fields by blocks of this size, so it also limits the
+// length of one imported line
+#define PARSE_BLOCK_BYTES ((size_t)1 << 16)
+// "0,0,0,0,0\n" is the shortest line that yields a record
+#define MIN_RECORD_LINE_LENGTH 10
+#define FIELDS_COUNT 5
+#define MAX_INTEGER_DIGITS 19
+#define NO_PARSE_ERROR ((size_t)-1)
+
+#define APPEND_LITERAL(p, literal)                                             \
+  (memcpy((p), (literal), sizeof(literal) - 1), (p) + sizeof(literal) - 1)
+
+static const char csvHeader[] = "id,count,cost,primary,mode\n";
+
+/**
+ * @struct TextChunk
+ * @brief Текст одного блока записей
+ */
+typedef struct TextChunk {
+  char *text;    /**< Буфер на BINARYSERIALIZER_TEXT_CHUNK_RECORDS строк */
+  size_t length; /**< Длина отформатированного текста */
+} TextChunk;
+
+/**
+ * @struct TextExport
+ * @brief Окно дампа, форматируемое одним запуском пула
+ */
+typedef struct TextExport {
+  const StatData *data; /**< Первая запись окна */
+  size_t size;          /**< Записей в окне */
+  TextFormat format;    /**< Формат строк */
+  TextChunk *chunks;    /**< Буферы блоков окна */
+} TextExport;
+
+static int WriteAll(int fd, const char *data, size_t bytes) {
+  while (bytes != 0) {
+    ssize_t result = write(fd, data, bytes);
+    if (BINARYSERIALIZER_UNLIKELY(result < 0)) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG_ERR("Cannot write text [bytes:%zu] into [fd:%d]\n", bytes, fd);
+      return 0;
+    }
+    data += result;
+    bytes -= (size_t)result;
+    CountEvent(INSTRUMENTATION_BYTES_WRITTEN, (size_t)result);
+  }
+  return 1;
+}
+
+static int IsFiniteCost(float cost) {
+  uint32_t bits;
+  memcpy(&bits, &cost, sizeof(bits));
+  return (bits & 0x7f800000u) != 0x7f800000u;
+}
+
+static char *RenderCsvLine(char *p, const StatData *record) {
+  p += FormatDecimal(record->id, p, INTEGER_CELL_SIZE);
+  *p++ = ',';
+  p += FormatDecimal(record->count, p, INTEGER_CELL_SIZE);
+  *p++ = ',';
+  p += FormatScientific(record->cost, COST_PRECISION, p, COST_CELL_SIZE);
+  *p++ = ',';
+  *p++ = (char)('0' + record->primary);
+  *p++ = ',';
+  *p++ = (char)('0' + record->mode);
+  *p++ = '\n';
+  return p;
+}
+
+static char *RenderJsonLine(char *p, const StatData *record) {
+  p = APPEND_LITERAL(p, "{\"id\":");
+  p += FormatDecimal(record->id, p, INTEGER_CELL_SIZE);
+  p = APPEND_LITERAL(p, ",\"count\":");
+  p += FormatDecimal(record->count, p, INTEGER_CELL_SIZE);
+  p = APPEND_LITERAL(p, ",\"cost\":");
+  if (BINARYSERIALIZER_LIKELY(IsFiniteCost(record->cost))) {
+    p += FormatScientific(record->cost, COST_PRECISION, p, COST_CELL_SIZE);
+  } else {
+    p = APPEND_LITERAL(p, "null");
+  }
+  if (record->primary) {
+    p = APPEND_LITERAL(p, ",\"primary\":true,\"mode\":");
+  } else {
+    p = APPEND_LITERAL(p, ",\"primary\":false,\"mode\":");
+  }
+  *p++ = (char)('0' + record->mode);
+  p = APPEND_LITERAL(p, "}\n");
+  return p;
+}
+
+static void ExportChunk(void *args, size_t index) {
+  TextExport *window = args;
+  size_t begin = index * BINARYSERIALIZER_TEXT_CHUNK_RECORDS;
+  size_t end = begin + BINARYSERIALIZER_TEXT_CHUNK_RECORDS;
+  if (end > window->size) {
+    end = window->size;
+  }
+  TextChunk *chunk = window->chunks + index;
+  char *p = chunk->text;
+  if (window->format == TEXT_FORMAT_CSV) {
+    for (size_t i = begin; i < end; ++i) {
+      p = RenderCsvLine(p, window->data + i);
+    }
+  } else {
+    for (size_t i = begin; i < end; ++i) {
+      p = RenderJsonLine(p, window->data + i);
+    }
+  }
+  chunk->length = (size_t)(p - chunk->text);
+}
+
+/**
+ * @brief Читает дамп окнами по chunksCount блоков и выводит их текст
+ */
+static Status ExportWindows(DumpReader *reader, int fd, TextFormat format,
+                            ThreadPool *pool, TextChunk *chunks) {
+  const size_t chunkRecords = BINARYSERIALIZER_TEXT_CHUNK_RECORDS;
+  TextExport window = {NULL, 0, format, chunks};
+  for (;;) {
+    window.size = ReadFromDumpReader(reader, &window.data);
+    if (window.size == 0) {
+      return SUCCESS;
+    }
+    if (BINARYSERIALIZER_UNLIKELY(window.size == (size_t)-1)) {
+      return ERROR;
+    }
+    size_t tasksCount = (window.size + chunkRecords - 1) / chunkRecords;
+    RunThreadPool(pool, &ExportChunk, &window, tasksCount);
+    for (size_t i = 0; i < tasksCount; ++i) {
+      if (BINARYSERIALIZER_UNLIKELY(
+              !WriteAll(fd, chunks[i].text, chunks[i].length))) {
+        return ERROR;
+      }
+    }
+  }
+}
+
+Status ExportDumpToFd(const char *inputPath, int fd, TextFormat format,
+                      size_t threadsCount) {
+  LOG("[ExportDumpToFd begin]_____________________\n");
+  if (BINARYSERIALIZER_UNLIKELY(!inputPath || fd < 0 ||
+                                (format != TEXT_FORMAT_CSV &&
+                                 format != TEXT_FORMAT_JSON_LINES))) {
+    LOG_ERR("Bad inputPath, fd or format [fd:%d][format:%d]\n", fd,
+            (int)format);
+    LOG("[ExportDumpToFd end]_____________________\n");
+    return INVALID_POINTER_OR_SIZE;
+  }
+
+  int inputFd = open(inputPath, O_RDONLY);
+  if (BINARYSERIALIZER_UNLIKELY(inputFd < 0)) {
+    LOG_ERR("Cannot open file with [path:%s]\n", inputPath);
+    LOG("[ExportDumpToFd end]_____________________\n");
+    return BAD_FILE;
+  }
+  ThreadPool pool;
+  if (BINARYSERIALIZER_UNLIKELY(!InitThreadPool(&pool, threadsCount))) {
+    close(inputFd);
+    LOG("[ExportDumpToFd end]_____________________\n");
+    return ERROR;
+  }
+  // One chunk per thread in a window keeps the memory independent of the
+  // dump size
+  size_t chunksCount = pool.threadsCount;
+  const size_t chunkBytes =
+      (size_t)BINARYSERIALIZER_TEXT_CHUNK_RECORDS * MAX_LINE_LENGTH;
+  DumpReader reader;
+  TextChunk *chunks = AllocateMemory(sizeof(TextChunk) * chunksCount);
+  char *text = AllocateMemory(chunkBytes * chunksCount);
+  int initialized = InitDumpReader(
+      &reader, inputFd, chunksCount * BINARYSERIALIZER_TEXT_CHUNK_RECORDS);
+  Status status = SUCCESS;
+  if (BINARYSERIALIZER_UNLIKELY(!initialized || !chunks || !text)) {
+    LOG_ERR("Cannot allocate buffers [chunks:%zu]\n", chunksCount);
+    status = ERROR;
+  } else if (format == TEXT_FORMAT_CSV &&
+             BINARYSERIALIZER_UNLIKELY(
+                 !WriteAll(fd, csvHeader, sizeof(csvHeader) - 1))) {
+    status = ERROR;
+  } else if (DumpReaderSize(&reader) == 0) {
+    LOG_ERR("Dump is empty [path:%s]\n", inputPath);
+    status = EMPTY_FILE;
+  } else {
+    for (size_t i = 0; i < chunksCount; ++i) {
+      chunks[i].text = text + i * chunkBytes;
+      chunks[i].length = 0;
+    }
+    status = ExportWindows(&reader, fd, format, &pool, chunks);
+    LOG("Exported [records:%zu] with [threads:%zu]\n",
+        DumpReaderSize(&reader), chunksCount);
+  }
+  if (initialized) {
+    ClearDumpReader(&reader);
+  }
+  FreeMemory(text);
+  FreeMemory(chunks);
+  ClearThreadPool(&pool);
+  close(inputFd);
+  LOG("[ExportDumpToFd end]_____________________\n");
+  return status;
+}
+
+Status ExportDump(const char *inputPath, const char *resultPath,
+                  TextFormat format, size_t threadsCount) {
+  LOG("[ExportDump begin]_____________________\n");
+  if (BINARYSERIALIZER_UNLIKELY(!inputPath || !resultPath)) {
+    LOG_ERR("Bad inputPath or resultPath\n");
+    LOG("[ExportDump end]_____________________\n");
+    return INVALID_POINTER_OR_SIZE;
+  }
+  int fd = open(resultPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (BINARYSERIALIZER_UNLIKELY(fd < 0)) {
+    LOG_ERR("Cannot create file with [path:%s]\n", resultPath);
+    LOG("[ExportDump end]_____________________\n");
+    return BAD_FILE;
+  }
+  Status status = ExportDumpToFd(inputPath, fd, format, threadsCount);
+  if (BINARYSERIALIZER_UNLIKELY(close(fd) != 0) && status == SUCCESS) {
+    status = ERROR;
+  }
+  LOG("[ExportDump end]_____________________\n");
+  return status;
+}
+
+/**
+ * @struct TextImportChunk
+ * @brief Участок окна текста, разбираемый одной задачей
+ */
+typedef struct TextImportChunk {
+  const char *begin;   /**< Начало первой строки участка */
+  const char *end;     /**< Позиция после последнего '\n' участка */
+  StatData *records;   /**< Разобранные записи */
+  size_t count;        /**< Количество разобранных записей */
+  uint32_t *positions; /**< Позиции разделителей блока PARSE_BLOCK_BYTES */
+  size_t errorOffset;  /**< Смещение ошибочной строки в окне */
+} TextImportChunk;
+
+/**
+ * @struct TextImport
+ * @brief Окно текста, разбираемое одним запуском пула
+ */
+typedef struct TextImport {
+  const char *text;        /**< Начало окна */
+  TextImportChunk *chunks; /**< Участки окна */
+} TextImport;
+
+/**
+ * @brief Записывает в positions смещения всех ',' и '\n' участка
+ *
+ * @return Количество найденных разделителей
+ */
+static size_t IndexDelimiters(const char *text, size_t size,
+                              uint32_t *positions) {
+  size_t count = 0;
+  size_t i = 0;
+#if defined(__AVX2__)
+  const __m256i comma = _mm256_set1_epi8(',');
+  const __m256i newline = _mm256_set1_epi8('\n');
+  for (; i + 32 <= size; i += 32) {
+    __m256i block = _mm256_loadu_si256((const __m256i *)(text + i));
+    uint32_t mask = (uint32_t)_mm256_movemask_epi8(
+        _mm256_or_si256(_mm256_cmpeq_epi8(block, comma),
+                        _mm256_cmpeq_epi8(block, newline)));
+    while (mask != 0) {
+      positions[count++] = (uint32_t)(i + (size_t)__builtin_ctz(mask));
+      mask &= mask - 1;
+    }
+  }
+#endif
+  for (; i < size; ++i) {
+    if (text[i] == ',' || text[i] == '\n') {
+      positions[count++] = (uint32_t)i;
+    }
+  }
+  return count;
+}
+
+/**
+ * @brief Разбирает десятичное целое [p, end) со знаком, |value| <= limit
+ * (для отрицательных - limit + 1)
+ *
+ * @return 1 при успехе, 0 если поле не является целым или вне диапазона
+ */
+static int ParseInteger(const char *p, const char *end, uint64_t limit,
+                        int64_t *value) {
+  int negative = p != end && *p == '-';
+  p += p != end && (*p == '-' || *p == '+');
+  size_t digits = (size_t)(end - p);
+  if (BINARYSERIALIZER_UNLIKELY(digits == 0 || digits > MAX_INTEGER_DIGITS)) {
+    return 0;
+  }
+  uint64_t magnitude = 0;
+  for (; p != end; ++p) {
+    unsigned digit = (unsigned)(unsigned char)*p - '0';
+    if (BINARYSERIALIZER_UNLIKELY(digit > 9)) {
+      return 0;
+    }
+    magnitude = magnitude * 10 + digit;
+  }
+  if (BINARYSERIALIZER_UNLIKELY(magnitude > limit + (uint64_t)negative)) {
+    return 0;
+  }
+  *value = negative ? (int64_t)(0 - magnitude) : (int64_t)magnitude;
+  return 1;
+}
+
+/**
+ * @brief Разбирает ровно 8 десятичных цифр одним 64-битным словом (SWAR)
+ *
+ * @return 1 при успехе, 0 если среди 8 символов есть не цифра
+ */
+static int ParseEightDigits(const char *p, uint64_t *value) {
+  uint64_t chunk;
+  memcpy(&chunk, p, sizeof(chunk));
+  const uint64_t high = 0xf0f0f0f0f0f0f0f0ULL;
+  if (((chunk & high) | (((chunk + 0x0606060606060606ULL) & high) >> 4)) !=
+      0x3333333333333333ULL) {
+    return 0;
+  }
+  // Neighbouring lanes are combined pairwise: 1 -> 2 -> 4 -> 8 digits
+  chunk -= 0x3030303030303030ULL;
+  chunk = chunk * 10 + (chunk >> 8);
+  const uint64_t lanes = 0x000000ff000000ffULL;
+  chunk = ((chunk & lanes) * (100 + (1000000ULL << 32)) +
+           ((chunk >> 16) & lanes) * (1 + (10000ULL << 32))) >>
+          32;
+  *value = chunk;
+  return 1;
+}
+
+/**
+ * @brief Разбирает число с плавающей точкой [p, end) без strtod()
+ *
+ * Принимает [+-]digits[.digits][(e|E)[+-]digits], а также inf и nan.
+ * Первые 19 значащих цифр накапливаются в целое; если оно и десятичный
+ * порядок точно представимы в double, значение получается одним точным
+ * умножением или делением, иначе - в long double.
+ *
+ * @return 1 при успехе, 0 если поле не является числом
+ */
+static int ParseCost(const char *p, const char *end, float *value) {
+  int negative = p != end && *p == '-';
+  p += p != end && (*p == '-' || *p == '+');
+  if (BINARYSERIALIZER_UNLIKELY(end - p == 3 && (memcmp(p, "inf", 3) == 0 ||
+                                                 memcmp(p, "nan", 3) == 0))) {
+    uint32_t bits = *p == 'i' ? 0x7f800000u : 0x7fc00000u;
+    bits |= negative ? 0x80000000u : 0;
+    memcpy(value, &bits, sizeof(bits));
+    return 1;
+  }
+
+  uint64_t mantissa = 0;
+  unsigned significant = 0;
+  int exponent = 0;
+  size_t digits = 0;
+  for (; p != end && (unsigned)(unsigned char)*p - '0' <= 9; ++p, ++digits) {
+    if (significant < MAX_INTEGER_DIGITS) {
+      mantissa = mantissa * 10 + (unsigned)(*p - '0');
+      significant += mantissa != 0;
+    } else {
+      ++exponent;
+    }
+  }
+  if (p != end && *p == '.') {
+    ++p;
+    uint64_t eightDigits = 0;
+    if (mantissa != 0 && significant + 8 <= MAX_INTEGER_DIGITS &&
+        end - p >= 8 && ParseEightDigits(p, &eightDigits)) {
+      mantissa = mantissa * 100000000 + eightDigits;
+      significant += 8;
+      exponent -= 8;
+      digits += 8;
+      p += 8;
+    }
+    for (; p != end && (unsigned)(unsigned char)*p - '0' <= 9;
+         ++p, ++digits) {
+      if (significant < MAX_INTEGER_DIGITS) {
+        mantissa = mantissa * 10 + (unsigned)(*p - '0');
+        significant += mantissa != 0;
+        --exponent;
+      }
+    }
+  }
+  if (BINARYSERIALIZER_UNLIKELY(digits == 0)) {
+    return 0;
+  }
+  if (p != end && (*p == 'e' || *p == 'E')) {
+    int64_t power = 0;
+    if (BINARYSERIALIZER_UNLIKELY(!ParseInteger(p + 1, end, 99999, &power))) {
+      return 0;
+    }
+    exponent += (int)power;
+    p = end;
+  }
+  if (BINARYSERIALIZER_UNLIKELY(p != end)) {
+    return 0;
+  }
+
+  uint32_t bits = 0;
+  if (mantissa != 0) {
+    float result;
+    if (mantissa <= ((uint64_t)1 << 53) &&
+        exponent >= -MAX_EXACT_DOUBLE_POWER_OF_TEN &&
+        exponent <= MAX_EXACT_DOUBLE_POWER_OF_TEN) {
+      double exact = (double)mantissa;
+      result = (float)(exponent < 0
+                           ? exact / ExactDoublePowerOfTen((unsigned)-exponent)
+                           : exact * ExactDoublePowerOfTen((unsigned)exponent));
+    } else if (exponent > 64) {
+      result = 0.0f;
+      bits = 0x7f800000u;
+    } else if (exponent < -90) {
+      result = 0.0f;
+    } else {
+      long double scaled = (long double)mantissa;
+      if (exponent < 0) {
+        scaled /= PowerOfTen((unsigned)-exponent);
+      } else {
+        scaled *= PowerOfTen((unsigned)exponent);
+      }
+      result = (float)scaled;
+    }
+    if (bits == 0) {
+      memcpy(&bits, &result, sizeof(bits));
+    }
+  }
+  // The library is built with -ffast-math, the sign of zero is set by bits
+  bits |= negative ? 0x80000000u : 0;
+  memcpy(value, &bits, sizeof(bits));
+  return 1;
+}
+
+/**
+ * @brief Разбирает поля одной строки, fields[i] - начало i-го поля
+ *
+ * @return 1 при успехе, 0 при ошибке формата
+ */
+static int ParseRecord(const char *fields[FIELDS_COUNT + 1],
+                       StatData *record) {
+  int64_t id = 0;
+  int64_t count = 0;
+  float cost = 0.0f;
+  const char *lineEnd = fields[FIELDS_COUNT] - 1;
+  if (lineEnd != fields[FIELDS_COUNT - 1] && lineEnd[-1] == '\r') {
+    --lineEnd;
+  }
+  const char *primary = fields[3];
+  const char *mode = fields[4];
+  if (BINARYSERIALIZER_UNLIKELY(
+          !ParseInteger(fields[0], fields[1] - 1, INT64_MAX, &id) ||
+          !ParseInteger(fields[1], fields[2] - 1, INT32_MAX, &count) ||
+          !ParseCost(fields[2], fields[3] - 1, &cost) ||
+          fields[4] - primary != 2 || (*primary != '0' && *primary != '1') ||
+          lineEnd - mode != 1 || (unsigned)(*mode - '0') > 7)) {
+    return 0;
+  }
+  record->id = (long)id;
+  record->count = (int)count;
+  record->cost = cost;
+  record->primary = (unsigned)(*primary - '0');
+  record->mode = (unsigned)(*mode - '0');
+  return 1;
+}
+
+static void ImportChunk(void *args, size_t index) {
+  TextImport *import = args;
+  TextImportChunk *chunk = import->chunks + index;
+  const char *p = chunk->begin;
+  chunk->count = 0;
+  chunk->errorOffset = NO_PARSE_ERROR;
+  while (p != chunk->end) {
+    size_t blockSize = (size_t)(chunk->end - p);
+    if (blockSize > PARSE_BLOCK_BYTES) {
+      blockSize = PARSE_BLOCK_BYTES;
+    }
+    size_t delimiters = IndexDelimiters(p, blockSize, chunk->positions);
+    const uint32_t *positions = chunk->positions;
+
+    // Only complete lines of the block are consumed, the next block starts
+    // at the first unfinished one
+    size_t lineStart = 0;
+    size_t d = 0;
+    while (d < delimiters) {
+      if (p[positions[d]] == '\n' &&
+          (positions[d] == lineStart ||
+           (positions[d] == lineStart + 1 && p[lineStart] == '\r'))) {
+        lineStart = positions[d++] + 1;
+        continue;
+      }
+      if (d + FIELDS_COUNT > delimiters) {
+        break;
+      }
+      const char *fields[FIELDS_COUNT + 1];
+      fields[0] = p + lineStart;
+      int separated = 1;
+      for (size_t i = 0; i < FIELDS_COUNT; ++i) {
+        separated &= p[positions[d + i]] == (i + 1 < FIELDS_COUNT ? ',' : '\n');
+        fields[i + 1] = p + positions[d + i] + 1;
+      }
+      StatData *record = chunk->records + chunk->count;
+      if (BINARYSERIALIZER_UNLIKELY(!separated ||
+                                    !ParseRecord(fields, record))) {
+        chunk->errorOffset = (size_t)(p + lineStart - import->text);
+        return;
+      }
+      ++chunk->count;
+      lineStart = positions[d + FIELDS_COUNT - 1] + 1;
+      d += FIELDS_COUNT;
+    }
+    if (BINARYSERIALIZER_UNLIKELY(lineStart == 0)) {
+      // Not a single line ends inside the block
+      chunk->errorOffset = (size_t)(p - import->text);
+      return;
+    }
+    p += lineStart;
+  }
+}
+
+static int IsRecordStart(char c) {
+  return (unsigned)(c - '0') <= 9 || c == '-' || c == '+' || c == '\n' ||
+         c == '\r';
+}
+
+/**
+ * @brief Делит строки [begin, end) окна на участки задач примерно поровну
+ */
+static void SplitTextWindow(const char *begin, const char *end,
+                            TextImportChunk *chunks, size_t chunksCount) {
+  size_t length = (size_t)(end - begin);
+  const char *start = begin;
+  for (size_t i = 0; i < chunksCount; ++i) {
+    const char *stop = end;
+    if (i + 1 < chunksCount) {
+      stop = begin + length / chunksCount * (i + 1);
+      if (stop < start) {
+        stop = start;
+      }
+      if (stop != begin && stop[-1] != '\n') {
+        stop = (const char *)memchr(stop, '\n', (size_t)(end - stop)) + 1;
+      }
+    }
+    chunks[i].begin = start;
+    chunks[i].end = stop;
+    start = stop;
+  }
+}
+
+/**
+ * @brief Читает текст окнами, разбирает их параллельно и пишет записи
+ */
+static Status ImportWindows(int inputFd, DumpWriter *writer, ThreadPool *pool,
+                            TextImportChunk *chunks, char *text,
+                            size_t capacity) {
+  const size_t chunksCount = pool->threadsCount;
+  TextImport import = {text, chunks};
+  size_t filled = 0;
+  size_t windowOffset = 0;
+  int headerChecked = 0;
+  int eof = 0;
+  for (;;) {
+    while (filled < capacity && !eof) {
+      ssize_t result = read(inputFd, text + filled, capacity - filled);
+      if (BINARYSERIALIZER_UNLIKELY(result < 0)) {
+        if (errno == EINTR) {
+          continue;
+        }
+        LOG_ERR("Cannot read text from [fd:%d]\n", inputFd);
+        return ERROR;
+      }
+      eof = result == 0;
+      filled += (size_t)result;
+      CountEvent(INSTRUMENTATION_BYTES_READ, (size_t)result);
+    }
+    // A missing '\n' after the last line is implied, text has a spare byte
+    if (eof && filled != 0 && text[filled - 1] != '\n') {
+      text[filled++] = '\n';
+    }
+
+    size_t start = 0;
+    if (!headerChecked && filled != 0 && !IsRecordStart(text[0])) {
+      const char *newline = memchr(text, '\n', filled);
+      if (BINARYSERIALIZER_UNLIKELY(!newline)) {
+        LOG_ERR("Header line is too long\n");
+        return BAD_FILE;
+      }
+      start = (size_t)(newline - text) + 1;
+    }
+    headerChecked = 1;
+    size_t last = filled;
+    while (last != start && text[last - 1] != '\n') {
+      --last;
+    }
+    if (last == start) {
+      if (BINARYSERIALIZER_UNLIKELY(filled != start)) {
+        LOG_ERR("Line is too long [offset:%zu]\n", windowOffset + start);
+        return BAD_FILE;
+      }
+      return SUCCESS;
+    }
+
+    SplitTextWindow(text + start, text + last, chunks, chunksCount);
+    RunThreadPool(pool, &ImportChunk, &import, chunksCount);
+    for (size_t i = 0; i < chunksCount; ++i) {
+      if (BINARYSERIALIZER_UNLIKELY(chunks[i].errorOffset != NO_PARSE_ERROR)) {
+        LOG_ERR("Malformed line [offset:%zu]\n",
+                windowOffset + chunks[i].errorOffset);
+        return BAD_FILE;
+      }
+      if (BINARYSERIALIZER_UNLIKELY(
+              !WriteToDumpWriter(writer, chunks[i].records, chunks[i].count))) {
+        return ERROR;
+      }
+    }
+
+    // The unfinished last line moves to the front of the next window
+    filled -= last;
+    memmove(text, text + last, filled);
+    windowOffset += last;
+  }
+}
+
+Status ImportDumpFromFd(int fd, const char *resultPath, size_t threadsCount) {
+  LOG("[ImportDumpFromFd begin]_____________________\n");
+  if (BINARYSERIALIZER_UNLIKELY(fd < 0 || !resultPath)) {
+    LOG_ERR("Bad fd or resultPath [fd:%d]\n", fd);
+    LOG("[ImportDumpFromFd end]_____________________\n");
+    return INVALID_POINTER_OR_SIZE;
+  }
+  int outFd = open(resultPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (BINARYSERIALIZER_UNLIKELY(outFd < 0)) {
+    LOG_ERR("Cannot create file with [path:%s]\n", resultPath);
+    LOG("[ImportDumpFromFd end]_____________________\n");
+    return BAD_FILE;
+  }
+  ThreadPool pool;
+  if (BINARYSERIALIZER_UNLIKELY(!InitThreadPool(&pool, threadsCount))) {
+    close(outFd);
+    LOG("[ImportDumpFromFd end]_____________________\n");
+    return ERROR;
+  }
+
+  const size_t chunksCount = pool.threadsCount;
+  const size_t capacity = chunksCount * BINARYSERIALIZER_TEXT_CHUNK_BYTES;
+  // A chunk ends at most one line past its share of the window
+  const size_t chunkRecords =
+      (BINARYSERIALIZER_TEXT_CHUNK_BYTES + PARSE_BLOCK_BYTES) /
+          MIN_RECORD_LINE_LENGTH +
+      1;
+  char *text = AllocateMemory(capacity + 1);
+  TextImportChunk *chunks =
+      AllocateMemory(sizeof(TextImportChunk) * chunksCount);
+  StatData *records =
+      AllocateMemory(sizeof(StatData) * chunkRecords * chunksCount);
+  uint32_t *positions =
+      AllocateMemory(sizeof(uint32_t) * PARSE_BLOCK_BYTES * chunksCount);
+  DumpWriter writer;
+  int initialized =
+      InitDumpWriter(&writer, outFd, BINARYSERIALIZER_TEXT_CHUNK_RECORDS);
+  Status status = ERROR;
+  if (BINARYSERIALIZER_LIKELY(initialized && text && chunks && records &&
+                              positions)) {
+    for (size_t i = 0; i < chunksCount; ++i) {
+      chunks[i].records = records + i * chunkRecords;
+      chunks[i].positions = positions + i * PARSE_BLOCK_BYTES;
+    }
+    status = ImportWindows(fd, &writer, &pool, chunks, text, capacity);
+    if (status == SUCCESS &&
+        BINARYSERIALIZER_UNLIKELY(!FlushDumpWriter(&writer))) {
+      status = ERROR;
+    }
+    if (status == SUCCESS && writer.written == 0) {
+      LOG_ERR("No records in text\n");
+      status = EMPTY_FILE;
+    }
+    LOG("Imported [records:%zu] with [threads:%zu]\n", writer.written,
+        chunksCount);
+  } else {
+    LOG_ERR("Cannot allocate buffers [chunks:%zu]\n", chunksCount);
+  }
+  if (initialized) {
+    ClearDumpWriter(&writer);
+  }
+  FreeMemory(positions);
+  FreeMemory(records);
+  FreeMemory(chunks);
+  FreeMemory(text);
+  ClearThreadPool(&pool);
+  if (BINARYSERIALIZER_UNLIKELY(close(outFd) != 0) && status == SUCCESS) {
+    status = ERROR;
+  }
+  LOG("[ImportDumpFromFd end]_____________________\n");
+  return status;
+}
+
+Status ImportDump(const char *inputPath, const char *resultPath,
+                  size_t threadsCount) {
+  LOG("[ImportDump begin]_____________________\n");
+  if (BINARYSERIALIZER_UNLIKELY(!inputPath || !resultPath)) {
+    LOG_ERR("Bad inputPath or resultPath\n");
+    LOG("[ImportDump end]_____________________\n");
+    return INVALID_POINTER_OR_SIZE;
+  }
+  int fd = open(inputPath, O_RDONLY);
+  if (BINARYSERIALIZER_UNLIKELY(fd < 0)) {
+    LOG_ERR("Cannot open file with [path:%s]\n", inputPath);
+    LOG("[ImportDump end]_____________________\n");
+    return BAD_FILE;
+  }
+  Status status = ImportDumpFromFd(fd, resultPath, threadsCount);
+  close(fd);
+  LOG("[ImportDump end]_____________________\n");
+  return status;
+}
@@ -0,0 +1,90 @@
+#include "internal/executionContext.h"
+#include "internal/allocation.h"
+
+#include <string.h>
+
+ExecutionContext *CreateExecutionContext(size_t bucketsCount,
+                                         const Allocator *allocator) {
+  LOG("[CreateExecutionContext begin]_____________________\n");
+  allocator = ResolveAllocator(allocator);
+  if (BINARYSERIALIZER_UNLIKELY(!allocator)) {
+    LOG_ERR("Incomplete allocator\n");
+    LOG("[CreateExecutionContext end]_____________________\n");
+    return NULL;
+  }
+  ExecutionContext *context =
+      AllocatorAllocate(allocator, sizeof(ExecutionContext));
+  if (BINARYSERIALIZER_UNLIKELY(!context)) {
+    LOG_ERR("Cannot allocate [bytes:%zu]\n", sizeof(ExecutionContext));
+    LOG("[CreateExecutionContext end]_____________________\n");
+    return NULL;
+  }
+  memset(context, 0, sizeof(*context));
+  context->allocator = *allocator;
+  if (bucketsCount == 0) {
+    bucketsCount = BINARYSERIALIZER_DEFUALT_BUCKETS_COUNT;
+  }
+  if (BINARYSERIALIZER_UNLIKELY(!InitHashTableWithAllocator(
+          &context->table, bucketsCount, NULL, NULL, NULL,
+          &context->allocator))) {
+    AllocatorFree(allocator, context);
+    LOG_ERR("Cannot init MergeHashTable\n");
+    LOG("[CreateExecutionContext end]_____________________\n");
+    return NULL;
+  }
+  if (BINARYSERIALIZER_UNLIKELY(
+          !InitBulkMergeScratch(&context->scratch, &context->allocator))) {
+    ClearHashTable(&context->table);
+    AllocatorFree(allocator, context);
+    LOG_ERR("Cannot allocate bulk merge scratch\n");
+    LOG("[CreateExecutionContext end]_____________________\n");
+    return NULL;
+  }
+  LOG("[CreateExecutionContext end]_____________________\n");
+  return context;
+}
+
+void DestroyExecutionContext(ExecutionContext *context) {
+  if (BINARYSERIALIZER_UNLIKELY(!context)) {
+    return;
+  }
+  // The allocator lives inside the context, so the context goes last
+  Allocator allocator = context->allocator;
+  ClearBulkMergeScratch(&context->scratch);
+  ClearHashTable(&context->table);
+  AllocatorFree(&allocator, context->joined);
+  AllocatorFree(&allocator, context->sortBuffer);
+  AllocatorFree(&allocator, context->text);
+  AllocatorFree(&allocator, context);
+}
+
+int ReserveContextRecords(const ExecutionContext *context, StatData **buffer,
+                          size_t *capacity, size_t records) {
+  if (*capacity >= records) {
+    return 1;
+  }
+  AllocatorFree(&context->allocator, *buffer);
+  *buffer = AllocatorAllocate(&context->allocator, sizeof(StatData) * records);
+  *capacity = *buffer ? records : 0;
+  return *buffer != NULL;
+}
+
+int AppendContextText(void *context, const char *data, size_t size) {
+  ExecutionContext *self = context;
+  if (self->textCapacity - self->textSize < size) {
+    size_t capacity = self->textCapacity ? self->textCapacity : 4096;
+    while (capacity - self->textSize < size) {
+      capacity *= 2;
+    }
+    char *grown = AllocatorReallocate(&self->allocator, self->text, capacity);
+    if (BINARYSERIALIZER_UNLIKELY(!grown)) {
+      LOG_ERR("Cannot grow context text to [bytes:%zu]\n", capacity);
+      return 0;
+    }
+    self->text = grown;
+    self->textCapacity = capacity;
+  }
+  memcpy(self->text + self->textSize, data, size);
+  self->textSize += size;
+  return 1;
+}
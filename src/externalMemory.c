@@ -0,0 +1,889 @@
+#include "BinarySerializer/externalMemory.h"
+#include "BinarySerializer/mergeHashTable.h"
+#include "internal/allocation.h"
+#include "internal/bulkMerge.h"
+#include "internal/dumpIO.h"
+#include "internal/instrumentation.h"
+#include "internal/sortKey.h"
+
+#if defined(BS_ENABLE_MI_MALLOC)
+#include <mimalloc-override.h>
+#else
+#include <stdlib.h>
+#endif
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * Оценка памяти на одну уникальную запись в MergeHashTable: payload StatData,
+ * заголовок аллокатора, Node с запасом на удвоение массива и Bucket при
+ * заполнении ~1 элемент на бакет
+ */
+static const size_t joinRecordFootprint = 128;
+
+/** Максимальное количество партиций на одном уровне (ограничение по fd) */
+static const size_t maxPartitionsCount = 256;
+
+/** Максимальная глубина повторного партиционирования */
+static const unsigned maxPartitionLevel = 4;
+
+/** Максимальное количество серий, сливаемых за один проход (ограничение по
+ * fd) */
+static const size_t maxMergeFanIn = 256;
+
+/** Минимальный буфер чтения серии при слиянии: меньшие чтения превращают
+ * последовательный ввод в случайный */
+static const size_t minMergeReadBytes = 64u << 10;
+
+/** Доля бюджета сортировки (1/N), оставляемая под мелкие метаданные и
+ * округление размеров блоков аллокатором */
+static const size_t sortHeadroomShare = 64;
+
+/**
+ * @struct ExternalJoin
+ * @brief Общие параметры одного вызова JoinDumpExternal
+ */
+typedef struct ExternalJoin {
+  const char *tempDir;     /**< Каталог временных файлов */
+  const char *resultPath;  /**< Путь результирующего файла */
+  int outFd;               /**< Дескриптор результата, -1 до первой записи */
+  DumpWriter output;       /**< Writer результата, пока outFd >= 0 */
+  size_t outputCapacity;   /**< Емкость буфера результата в элементах */
+  size_t partitionRecords; /**< Записей, объединяемых в памяти за раз */
+  size_t readerCapacity;   /**< Емкость буфера чтения в элементах */
+  size_t partitionsBytes; /**< Бюджет буферов партиций в байтах */
+} ExternalJoin;
+
+/**
+ * @struct WriteNodeHelper
+ * @brief Контекст для потоковой выгрузки хеш-таблицы в DumpWriter
+ */
+typedef struct WriteNodeHelper {
+  DumpWriter *writer; /**< Целевой writer */
+  int failed;         /**< Признак ошибки записи */
+} WriteNodeHelper;
+
+static void WriteNodeToDump(StatData *__restrict data, void *__restrict args) {
+  WriteNodeHelper *helper = args;
+  if (BINARYSERIALIZER_LIKELY(!helper->failed)) {
+    helper->failed = !WriteToDumpWriter(helper->writer, data, 1);
+  }
+}
+
+/**
+ * @brief Номер партиции для id на уровне level
+ *
+ * Финализатор SplitMix64 с солью уровня: на каждом уровне распределение
+ * независимо от предыдущего и от BucketIndex хеш-таблицы.
+ */
+static size_t PartitionIndex(long id, unsigned level, size_t count) {
+  uint64_t x = (uint64_t)id + 0x9e3779b97f4a7c15ULL * (level + 1);
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return (size_t)(x % count);
+}
+
+static void CloseFds(const int *fds, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    if (fds[i] >= 0) {
+      close(fds[i]);
+    }
+  }
+}
+
+/**
+ * @brief Открывает результат перед первой записью в него
+ *
+ * Первая запись происходит, когда входные дампы уже прочитаны целиком: они
+ * либо разбиты на партиции, либо загружены в хеш-таблицу. Поэтому resultPath
+ * может совпадать с firstPath или secondPath.
+ */
+static Status OpenJoinOutput(ExternalJoin *join) {
+  if (join->outFd >= 0) {
+    return SUCCESS;
+  }
+  join->outFd = open(join->resultPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (BINARYSERIALIZER_UNLIKELY(join->outFd < 0)) {
+    LOG_ERR("Cannot open file with [path:%s]\n", join->resultPath);
+    return BAD_FILE;
+  }
+  if (BINARYSERIALIZER_UNLIKELY(
+          !InitDumpWriter(&join->output, join->outFd, join->outputCapacity))) {
+    close(join->outFd);
+    join->outFd = -1;
+    return ERROR;
+  }
+  return SUCCESS;
+}
+
+/**
+ * @brief Объединяет партицию в памяти и дописывает ее в результат
+ *
+ * Партиция может превышать partitionRecords, если повторное деление не
+ * помогло (все записи с одним id или достигнута maxPartitionLevel). Повторы
+ * id сворачиваются в существующие узлы, поэтому бакеты ограничены
+ * partitionRecords, а ERROR возвращается, только когда различных id больше
+ * partitionRecords.
+ */
+static Status JoinInMemory(ExternalJoin *join, const int *fds,
+                           size_t fdsCount, size_t records) {
+  size_t bucketsCount =
+      records < join->partitionRecords ? records : join->partitionRecords;
+  MergeHashTable table;
+  if (BINARYSERIALIZER_UNLIKELY(!InitHashTableWithBuckets(
+          &table, bucketsCount ? bucketsCount : 1, NULL, NULL, NULL))) {
+    LOG_ERR("Cannot init MergeHashTable for [records:%zu]\n", records);
+    return ERROR;
+  }
+  // Одни рабочие массивы на всю партицию, их размер учтен в бюджете
+  BulkMergeScratch scratch;
+  if (BINARYSERIALIZER_UNLIKELY(
+          !InitBulkMergeScratch(&scratch, DefaultAllocator()))) {
+    LOG_ERR("Cannot allocate bulk merge scratch\n");
+    ClearHashTable(&table);
+    return ERROR;
+  }
+
+  // Верхняя оценка количества различных id в таблице
+  size_t distinctBound = 0;
+  for (size_t i = 0; i < fdsCount; ++i) {
+    DumpReader reader;
+    if (BINARYSERIALIZER_UNLIKELY(
+            !InitDumpReader(&reader, fds[i], join->readerCapacity))) {
+      ClearBulkMergeScratch(&scratch);
+      ClearHashTable(&table);
+      return ERROR;
+    }
+    const StatData *batch = NULL;
+    size_t count = 0;
+    while ((count = ReadFromDumpReader(&reader, &batch)) != 0) {
+      if (BINARYSERIALIZER_UNLIKELY(count == (size_t)-1)) {
+        ClearDumpReader(&reader);
+        ClearBulkMergeScratch(&scratch);
+        ClearHashTable(&table);
+        return BAD_FILE;
+      }
+      if (BINARYSERIALIZER_UNLIKELY(
+              !InsertBatchWithScratch(&table, batch, count, &scratch))) {
+        LOG_ERR("Cannot insert value into hash table\n");
+        ClearDumpReader(&reader);
+        ClearBulkMergeScratch(&scratch);
+        ClearHashTable(&table);
+        return ERROR;
+      }
+      // Точный размер таблицы пересчитывается, только когда верхняя оценка
+      // выходит за бюджет: для повторяющихся id это редкие O(buckets)
+      distinctBound += count;
+      if (distinctBound > join->partitionRecords) {
+        distinctBound = HashTableSize(&table);
+      }
+      if (BINARYSERIALIZER_UNLIKELY(distinctBound >
+                                    join->partitionRecords)) {
+        LOG_ERR("Too many distinct ids [ids:%zu] for [partitionRecords:%zu]\n",
+                distinctBound, join->partitionRecords);
+        ClearDumpReader(&reader);
+        ClearBulkMergeScratch(&scratch);
+        ClearHashTable(&table);
+        return ERROR;
+      }
+    }
+    ClearDumpReader(&reader);
+  }
+  ClearBulkMergeScratch(&scratch);
+
+  Status status = OpenJoinOutput(join);
+  if (BINARYSERIALIZER_UNLIKELY(status != SUCCESS)) {
+    ClearHashTable(&table);
+    return status;
+  }
+  WriteNodeHelper helper;
+  helper.writer = &join->output;
+  helper.failed = 0;
+  ForeachElementInHashTable(&table, &WriteNodeToDump, &helper);
+  ClearHashTable(&table);
+  return helper.failed ? BAD_FILE : SUCCESS;
+}
+
+static Status PartitionAndJoin(ExternalJoin *join, const int *fds,
+                               size_t fdsCount, size_t records,
+                               unsigned level) {
+  if (records <= join->partitionRecords || level >= maxPartitionLevel) {
+    return JoinInMemory(join, fds, fdsCount, records);
+  }
+
+  // Запас 25% на неравномерность хеш-партиционирования
+  size_t partitionsCount =
+      (records + records / 4) / join->partitionRecords + 1;
+  if (partitionsCount > maxPartitionsCount) {
+    partitionsCount = maxPartitionsCount;
+  }
+  size_t writerCapacity =
+      join->partitionsBytes / partitionsCount / sizeof(StatData);
+  if (writerCapacity == 0) {
+    writerCapacity = 1;
+  }
+  LOG("Partitioning [records:%zu] into [partitions:%zu] on [level:%u]\n",
+      records, partitionsCount, level);
+
+  int *partitionFds = AllocateMemory(sizeof(int) * partitionsCount);
+  size_t *partitionSizes =
+      AllocateZeroedMemory(partitionsCount, sizeof(size_t));
+  DumpWriter *writers =
+      AllocateZeroedMemory(partitionsCount, sizeof(DumpWriter));
+  if (BINARYSERIALIZER_UNLIKELY(!partitionFds || !partitionSizes ||
+                                !writers)) {
+    FreeMemory(partitionFds);
+    FreeMemory(partitionSizes);
+    FreeMemory(writers);
+    return ERROR;
+  }
+  for (size_t i = 0; i < partitionsCount; ++i) {
+    partitionFds[i] = -1;
+  }
+
+  Status status = SUCCESS;
+  for (size_t i = 0; i < partitionsCount && status == SUCCESS; ++i) {
+    partitionFds[i] = CreateTempDumpFile(join->tempDir);
+    if (BINARYSERIALIZER_UNLIKELY(partitionFds[i] < 0)) {
+      status = BAD_FILE;
+    } else if (BINARYSERIALIZER_UNLIKELY(!InitDumpWriter(
+                   writers + i, partitionFds[i], writerCapacity))) {
+      status = ERROR;
+    }
+  }
+
+  for (size_t i = 0; i < fdsCount && status == SUCCESS; ++i) {
+    DumpReader reader;
+    if (BINARYSERIALIZER_UNLIKELY(
+            !InitDumpReader(&reader, fds[i], join->readerCapacity))) {
+      status = ERROR;
+      break;
+    }
+    const StatData *batch = NULL;
+    size_t count = 0;
+    while (status == SUCCESS &&
+           (count = ReadFromDumpReader(&reader, &batch)) != 0) {
+      if (BINARYSERIALIZER_UNLIKELY(count == (size_t)-1)) {
+        status = BAD_FILE;
+        break;
+      }
+      for (size_t j = 0; j < count; ++j) {
+        size_t index = PartitionIndex(batch[j].id, level, partitionsCount);
+        if (BINARYSERIALIZER_UNLIKELY(
+                !WriteToDumpWriter(writers + index, batch + j, 1))) {
+          status = BAD_FILE;
+          break;
+        }
+        partitionSizes[index]++;
+      }
+    }
+    ClearDumpReader(&reader);
+  }
+
+  for (size_t i = 0; i < partitionsCount; ++i) {
+    if (status == SUCCESS &&
+        BINARYSERIALIZER_UNLIKELY(!FlushDumpWriter(writers + i))) {
+      status = BAD_FILE;
+    }
+    ClearDumpWriter(writers + i);
+  }
+  FreeMemory(writers);
+
+  for (size_t i = 0; i < partitionsCount && status == SUCCESS; ++i) {
+    if (partitionSizes[i] == 0) {
+      continue;
+    }
+    // Все записи попали в одну партицию: повторное деление не поможет
+    unsigned nextLevel =
+        partitionSizes[i] == records ? maxPartitionLevel : level + 1;
+    status = PartitionAndJoin(join, partitionFds + i, 1, partitionSizes[i],
+                              nextLevel);
+    close(partitionFds[i]);
+    partitionFds[i] = -1;
+  }
+
+  CloseFds(partitionFds, partitionsCount);
+  FreeMemory(partitionFds);
+  FreeMemory(partitionSizes);
+  return status;
+}
+
+static int OpenInputDump(const char *path, size_t *records) {
+  if (!path) {
+    return -1;
+  }
+  int fd = open(path, O_RDONLY);
+  if (BINARYSERIALIZER_UNLIKELY(fd < 0)) {
+    LOG_ERR("Cannot open file with [path:%s]\n", path);
+    return -1;
+  }
+  off_t size = lseek(fd, 0, SEEK_END);
+  if (BINARYSERIALIZER_UNLIKELY(size < 0)) {
+    close(fd);
+    return -1;
+  }
+  *records = (size_t)size / sizeof(StatData);
+  return fd;
+}
+
+/**
+ * @brief Каталог временных файлов: tempDir или каталог resultPath
+ */
+static const char *ResolveTempDir(const char *tempDir, const char *resultPath,
+                                  char dirBuffer[PATH_MAX]) {
+  if (tempDir) {
+    return tempDir;
+  }
+  const char *slash = strrchr(resultPath, '/');
+  size_t length = slash ? (size_t)(slash - resultPath) : 0;
+  if (length >= PATH_MAX) {
+    length = PATH_MAX - 1;
+  }
+  memcpy(dirBuffer, resultPath, length);
+  dirBuffer[length] = 0;
+  return slash ? (length ? dirBuffer : "/") : ".";
+}
+
+Status JoinDumpExternal(const char *firstPath, const char *secondPath,
+                        const char *resultPath, const char *tempDir,
+                        size_t memoryBudget) {
+  LOG("[JoinDumpExternal begin]_____________________\n");
+  if (BINARYSERIALIZER_UNLIKELY((!firstPath && !secondPath) || !resultPath ||
+                                memoryBudget <
+                                    BINARYSERIALIZER_MIN_MEMORY_BUDGET)) {
+    LOG_ERR("Bad paths or too small [memoryBudget:%zu]\n", memoryBudget);
+    LOG("[JoinDumpExternal end]_____________________\n");
+    return INVALID_POINTER_OR_SIZE;
+  }
+
+  int fds[2] = {-1, -1};
+  size_t sizes[2] = {0, 0};
+  fds[0] = OpenInputDump(firstPath, sizes);
+  fds[1] = OpenInputDump(secondPath, sizes + 1);
+  if (BINARYSERIALIZER_UNLIKELY((firstPath && fds[0] < 0) ||
+                                (secondPath && fds[1] < 0))) {
+    CloseFds(fds, 2);
+    LOG("[JoinDumpExternal end]_____________________\n");
+    return BAD_FILE;
+  }
+  size_t records = sizes[0] + sizes[1];
+  if (records == 0) {
+    CloseFds(fds, 2);
+    LOG_ERR("Both dumps are empty\n");
+    LOG("[JoinDumpExternal end]_____________________\n");
+    return EMPTY_FILE;
+  }
+
+  char dirBuffer[PATH_MAX];
+  tempDir = ResolveTempDir(tempDir, resultPath, dirBuffer);
+
+  // Четверть бюджета уходит на буферы ввода-вывода: по 1/16 на чтение и
+  // результат, 1/8 на буферы партиций. Из остального вычитаются рабочие
+  // массивы пакетной вставки, остаток занимает хеш-таблица.
+  size_t ioBytes = memoryBudget / 4;
+  ExternalJoin join;
+  join.tempDir = tempDir;
+  join.resultPath = resultPath;
+  join.outFd = -1;
+  join.outputCapacity = ioBytes / 4 / sizeof(StatData);
+  join.partitionRecords =
+      (memoryBudget - ioBytes - BulkMergeScratchBytes()) / joinRecordFootprint;
+  join.readerCapacity = ioBytes / 4 / sizeof(StatData);
+  join.partitionsBytes = ioBytes / 2;
+
+  // PartitionAndJoin работает только с открытыми дескрипторами
+  int inputFds[2];
+  size_t inputsCount = 0;
+  for (size_t i = 0; i < 2; ++i) {
+    if (fds[i] >= 0 && sizes[i] != 0) {
+      inputFds[inputsCount++] = fds[i];
+    }
+  }
+  Status status = PartitionAndJoin(&join, inputFds, inputsCount, records, 0);
+  if (join.outFd >= 0) {
+    if (status == SUCCESS &&
+        BINARYSERIALIZER_UNLIKELY(!FlushDumpWriter(&join.output))) {
+      status = BAD_FILE;
+    }
+    LOG("Joined [records:%zu] into [records:%zu]\n", records,
+        join.output.written);
+    ClearDumpWriter(&join.output);
+    if (BINARYSERIALIZER_UNLIKELY(close(join.outFd) != 0) &&
+        status == SUCCESS) {
+      status = BAD_FILE;
+    }
+  }
+
+  CloseFds(fds, 2);
+  LOG("[JoinDumpExternal end]_____________________\n");
+  return status;
+}
+
+/**
+ * @struct ExternalSort
+ * @brief Общие параметры и счетчики одного вызова SortDumpExternal
+ */
+typedef struct ExternalSort {
+  const char *tempDir;                   /**< Каталог временных файлов */
+  size_t memoryBudget;                   /**< Бюджет памяти в байтах */
+  size_t reservedBytes;                  /**< Запас бюджета вне буферов */
+  size_t mergeFanIn;                     /**< Серий в одном слиянии */
+  SortField field;                       /**< Поле сортировки */
+  uint64_t mask;                         /**< Маска направления ключа */
+  ExternalSortProgress progress;         /**< Текущие счетчики */
+  ExternalSortProgressFunc progressFunc; /**< Получатель счетчиков */
+  void *progressArgs;                    /**< Аргументы progressFunc */
+  struct timespec start;                 /**< Момент начала сортировки */
+} ExternalSort;
+
+/**
+ * @struct MergeRun
+ * @brief Сливаемая серия: reader и текущая позиция в прочитанном блоке
+ */
+typedef struct MergeRun {
+  DumpReader reader;     /**< Последовательное чтение серии */
+  const StatData *batch; /**< Текущий блок */
+  size_t position;       /**< Следующая запись блока */
+  size_t count;          /**< Записей в блоке */
+} MergeRun;
+
+/**
+ * @struct MergeHead
+ * @brief Элемент кучи слияния: ключ очередной записи серии
+ *
+ * Сравнение по паре (key, run) сохраняет устойчивость: серии идут в порядке
+ * входного файла, поэтому при равных ключах побеждает более ранняя серия.
+ */
+typedef struct MergeHead {
+  uint64_t key;
+  size_t run;
+} MergeHead;
+
+static void ReportSortProgress(ExternalSort *sort) {
+  if (!sort->progressFunc) {
+    return;
+  }
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  sort->progress.elapsedSeconds =
+      (double)(now.tv_sec - sort->start.tv_sec) +
+      (double)(now.tv_nsec - sort->start.tv_nsec) / 1e9;
+  sort->progressFunc(&sort->progress, sort->progressArgs);
+}
+
+static inline uint64_t ExternalSortKey(const ExternalSort *sort,
+                                       const StatData *data) {
+  return SortKey(data, sort->field) ^ sort->mask;
+}
+
+static inline int MergeHeadLess(const MergeHead *lhs, const MergeHead *rhs) {
+  return lhs->key < rhs->key || (lhs->key == rhs->key && lhs->run < rhs->run);
+}
+
+static void SiftDownMergeHead(MergeHead *heap, size_t size, size_t root) {
+  MergeHead value = heap[root];
+  for (;;) {
+    size_t child = 2 * root + 1;
+    if (child >= size) {
+      break;
+    }
+    if (child + 1 < size && MergeHeadLess(heap + child + 1, heap + child)) {
+      ++child;
+    }
+    if (!MergeHeadLess(heap + child, &value)) {
+      break;
+    }
+    heap[root] = heap[child];
+    root = child;
+  }
+  heap[root] = value;
+}
+
+/**
+ * @brief Читает следующий блок серии
+ *
+ * @return 1 если в серии есть записи, 0 при конце серии, -1 при ошибке
+ */
+static int AdvanceMergeRun(ExternalSort *sort, MergeRun *run) {
+  size_t count = ReadFromDumpReader(&run->reader, &run->batch);
+  if (BINARYSERIALIZER_UNLIKELY(count == (size_t)-1)) {
+    return -1;
+  }
+  run->position = 0;
+  run->count = count;
+  sort->progress.bytesRead += sizeof(StatData) * count;
+  return count != 0;
+}
+
+/**
+ * @brief K-путевое слияние серий fds в outFd
+ *
+ * Пока ключи серии на вершине кучи меньше лучшего ключа остальных серий,
+ * записи этой серии выводятся одним отрезком без операций с кучей, поэтому
+ * частично упорядоченные данные сливаются почти копированием.
+ */
+static Status MergeRuns(ExternalSort *sort, const int *fds, size_t count,
+                        int outFd) {
+  size_t metaBytes = (sizeof(MergeRun) + sizeof(MergeHead)) * count;
+  size_t outputBytes = sort->memoryBudget / 8;
+  size_t readerCapacity =
+      (sort->memoryBudget - sort->reservedBytes - outputBytes - metaBytes) /
+      count / sizeof(StatData);
+  MergeRun *runs = AllocateZeroedMemory(count, sizeof(MergeRun));
+  MergeHead *heap = AllocateMemory(sizeof(MergeHead) * count);
+  DumpWriter writer;
+  if (BINARYSERIALIZER_UNLIKELY(!runs || !heap ||
+                                !InitDumpWriter(&writer, outFd,
+                                                outputBytes /
+                                                    sizeof(StatData)))) {
+    FreeMemory(runs);
+    FreeMemory(heap);
+    return ERROR;
+  }
+
+  uint64_t phaseStart = BeginPhase();
+  Status status = SUCCESS;
+  size_t heapSize = 0;
+  size_t initialized = 0;
+  for (; initialized < count && status == SUCCESS; ++initialized) {
+    MergeRun *run = runs + initialized;
+    if (BINARYSERIALIZER_UNLIKELY(!InitDumpReader(&run->reader,
+                                                  fds[initialized],
+                                                  readerCapacity))) {
+      status = ERROR;
+      break;
+    }
+    int advanced = AdvanceMergeRun(sort, run);
+    if (BINARYSERIALIZER_UNLIKELY(advanced < 0)) {
+      status = BAD_FILE;
+    } else if (advanced) {
+      heap[heapSize].key = ExternalSortKey(sort, run->batch);
+      heap[heapSize].run = initialized;
+      heapSize++;
+    }
+  }
+  for (size_t i = heapSize / 2; i-- > 0;) {
+    SiftDownMergeHead(heap, heapSize, i);
+  }
+
+  sort->progress.mergedRecords = 0;
+  size_t reportStep = writer.capacity;
+  size_t nextReport = reportStep;
+  while (heapSize != 0 && status == SUCCESS) {
+    MergeRun *run = runs + heap[0].run;
+    const MergeHead *bound = NULL;
+    if (heapSize > 1) {
+      bound = heap + 1;
+      if (heapSize > 2 && MergeHeadLess(heap + 2, heap + 1)) {
+        bound = heap + 2;
+      }
+    }
+    size_t end = run->position + 1;
+    if (!bound) {
+      end = run->count;
+    } else {
+      for (; end < run->count; ++end) {
+        MergeHead head = {ExternalSortKey(sort, run->batch + end),
+                          heap[0].run};
+        if (!MergeHeadLess(&head, bound)) {
+          break;
+        }
+      }
+    }
+    size_t stretch = end - run->position;
+    if (BINARYSERIALIZER_UNLIKELY(!WriteToDumpWriter(
+            &writer, run->batch + run->position, stretch))) {
+      status = BAD_FILE;
+      break;
+    }
+    sort->progress.mergedRecords += stretch;
+    sort->progress.bytesWritten += sizeof(StatData) * stretch;
+    run->position = end;
+
+    int hasRecords = 1;
+    if (run->position == run->count) {
+      hasRecords = AdvanceMergeRun(sort, run);
+      if (BINARYSERIALIZER_UNLIKELY(hasRecords < 0)) {
+        status = BAD_FILE;
+        break;
+      }
+    }
+    if (hasRecords) {
+      heap[0].key = ExternalSortKey(sort, run->batch + run->position);
+    } else {
+      heap[0] = heap[--heapSize];
+    }
+    SiftDownMergeHead(heap, heapSize, 0);
+
+    if (sort->progress.mergedRecords >= nextReport) {
+      nextReport = sort->progress.mergedRecords + reportStep;
+      ReportSortProgress(sort);
+    }
+  }
+
+  if (status == SUCCESS &&
+      BINARYSERIALIZER_UNLIKELY(!FlushDumpWriter(&writer))) {
+    status = BAD_FILE;
+  }
+  ClearDumpWriter(&writer);
+  for (size_t i = 0; i < initialized; ++i) {
+    ClearDumpReader(&runs[i].reader);
+  }
+  FreeMemory(heap);
+  FreeMemory(runs);
+  EndPhase(INSTRUMENTATION_PHASE_MERGE, phaseStart);
+  return status;
+}
+
+/**
+ * @brief Сортирует записи буфера и пишет их в fd
+ */
+static Status WriteSortedRun(ExternalSort *sort, StatData *data, size_t size,
+                             SortDirection direction, int fd,
+                             size_t writerCapacity) {
+  Status status = SortDumpByKey(data, size, sort->field, direction);
+  if (BINARYSERIALIZER_UNLIKELY(status != SUCCESS)) {
+    return status;
+  }
+  DumpWriter writer;
+  if (BINARYSERIALIZER_UNLIKELY(!InitDumpWriter(&writer, fd, writerCapacity))) {
+    return ERROR;
+  }
+  if (BINARYSERIALIZER_UNLIKELY(!WriteToDumpWriter(&writer, data, size) ||
+                                !FlushDumpWriter(&writer))) {
+    status = BAD_FILE;
+  }
+  ClearDumpWriter(&writer);
+  sort->progress.bytesWritten += sizeof(StatData) * size;
+  return status;
+}
+
+/**
+ * @brief Сливает группы по mergeFanIn серий, пока все серии не поместятся в
+ * одно слияние
+ */
+static Status ReduceRunsCount(ExternalSort *sort, int *fds,
+                              size_t *runsCount) {
+  while (*runsCount > sort->mergeFanIn) {
+    size_t groups = (*runsCount + sort->mergeFanIn - 1) / sort->mergeFanIn;
+    for (size_t group = 0; group < groups; ++group) {
+      size_t begin = group * sort->mergeFanIn;
+      size_t count = *runsCount - begin;
+      if (count > sort->mergeFanIn) {
+        count = sort->mergeFanIn;
+      }
+      int fd = CreateTempDumpFile(sort->tempDir);
+      if (BINARYSERIALIZER_UNLIKELY(fd < 0)) {
+        return BAD_FILE;
+      }
+      Status status = MergeRuns(sort, fds + begin, count, fd);
+      CloseFds(fds + begin, count);
+      for (size_t i = 0; i < count; ++i) {
+        fds[begin + i] = -1;
+      }
+      // Group outputs are packed to the front in input order, which keeps
+      // the (key, run) tie-break stable on the next pass
+      fds[group] = fd;
+      if (BINARYSERIALIZER_UNLIKELY(status != SUCCESS)) {
+        return status;
+      }
+    }
+    *runsCount = groups;
+    sort->progress.mergePasses++;
+  }
+  return SUCCESS;
+}
+
+static Status SortRunsAndMerge(ExternalSort *sort, int inputFd, size_t records,
+                               SortDirection direction,
+                               const char *resultPath) {
+  // По 1/16 бюджета занимают буферы чтения входа и записи серии, еще 1/64
+  // и массив дескрипторов серий остаются в запасе. Остальное делят поровну
+  // серия и вспомогательный буфер radix сортировки.
+  size_t ioRecords = sort->memoryBudget / 16 / sizeof(StatData);
+  size_t available = sort->memoryBudget - 2 * ioRecords * sizeof(StatData) -
+                     sort->memoryBudget / sortHeadroomShare;
+  size_t runRecords = available / (2 * sizeof(StatData));
+  size_t maxRuns = (records + runRecords - 1) / runRecords;
+  // Массив дескрипторов живет до конца слияния; запас вдвое покрывает рост
+  // числа серий после уменьшения runRecords
+  size_t fdsBytes = 2 * sizeof(int) * maxRuns;
+  if (BINARYSERIALIZER_UNLIKELY(fdsBytes >= available / 2)) {
+    LOG_ERR("Too many runs [runs:%zu] for the memory budget\n", maxRuns);
+    return INVALID_POINTER_OR_SIZE;
+  }
+  runRecords = (available - fdsBytes) / (2 * sizeof(StatData));
+  if (runRecords > records) {
+    runRecords = records;
+  }
+  maxRuns = (records + runRecords - 1) / runRecords;
+  sort->reservedBytes =
+      sort->memoryBudget / sortHeadroomShare + sizeof(int) * maxRuns;
+  StatData *run = AllocateMemory(sizeof(StatData) * runRecords);
+  int *fds = AllocateMemory(sizeof(int) * maxRuns);
+  DumpReader reader;
+  if (BINARYSERIALIZER_UNLIKELY(!run || !fds ||
+                                !InitDumpReader(&reader, inputFd, ioRecords))) {
+    FreeMemory(run);
+    FreeMemory(fds);
+    return ERROR;
+  }
+  for (size_t i = 0; i < maxRuns; ++i) {
+    fds[i] = -1;
+  }
+
+  Status status = SUCCESS;
+  size_t runsCount = 0;
+  size_t filled = 0;
+  const StatData *batch = NULL;
+  size_t count = 0;
+  while (status == SUCCESS &&
+         (count = ReadFromDumpReader(&reader, &batch)) != 0) {
+    if (BINARYSERIALIZER_UNLIKELY(count == (size_t)-1)) {
+      status = BAD_FILE;
+      break;
+    }
+    sort->progress.bytesRead += sizeof(StatData) * count;
+    while (count != 0 && status == SUCCESS) {
+      size_t chunk =
+          count < runRecords - filled ? count : runRecords - filled;
+      memcpy(run + filled, batch, sizeof(StatData) * chunk);
+      filled += chunk;
+      batch += chunk;
+      count -= chunk;
+      if (filled == runRecords && maxRuns > 1) {
+        fds[runsCount] = CreateTempDumpFile(sort->tempDir);
+        if (BINARYSERIALIZER_UNLIKELY(fds[runsCount] < 0)) {
+          status = BAD_FILE;
+          break;
+        }
+        status = WriteSortedRun(sort, run, filled, direction, fds[runsCount],
+                                ioRecords);
+        runsCount++;
+        sort->progress.sortedRecords += filled;
+        sort->progress.runsCount = runsCount;
+        filled = 0;
+        ReportSortProgress(sort);
+      }
+    }
+  }
+  ClearDumpReader(&reader);
+
+  if (status == SUCCESS && filled != 0 && maxRuns > 1) {
+    fds[runsCount] = CreateTempDumpFile(sort->tempDir);
+    if (BINARYSERIALIZER_UNLIKELY(fds[runsCount] < 0)) {
+      status = BAD_FILE;
+    } else {
+      status = WriteSortedRun(sort, run, filled, direction, fds[runsCount],
+                              ioRecords);
+      runsCount++;
+      sort->progress.sortedRecords += filled;
+      sort->progress.runsCount = runsCount;
+      filled = 0;
+      ReportSortProgress(sort);
+    }
+  }
+  if (maxRuns > 1) {
+    FreeMemory(run);
+    run = NULL;
+  }
+
+  // Вход прочитан целиком, поэтому resultPath может совпадать с ним
+  int outFd = -1;
+  if (status == SUCCESS) {
+    outFd = open(resultPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (BINARYSERIALIZER_UNLIKELY(outFd < 0)) {
+      LOG_ERR("Cannot open file with [path:%s]\n", resultPath);
+      status = BAD_FILE;
+    }
+  }
+
+  if (status == SUCCESS && maxRuns == 1) {
+    // Единственная серия пишется сразу в результат без временных файлов
+    status = WriteSortedRun(sort, run, filled, direction, outFd, ioRecords);
+    sort->progress.sortedRecords = filled;
+    sort->progress.runsCount = 1;
+  } else if (status == SUCCESS) {
+    sort->progress.phase = EXTERNAL_SORT_MERGE;
+    status = ReduceRunsCount(sort, fds, &runsCount);
+    if (status == SUCCESS) {
+      status = MergeRuns(sort, fds, runsCount, outFd);
+      sort->progress.mergePasses++;
+    }
+  }
+
+  if (outFd >= 0 && BINARYSERIALIZER_UNLIKELY(close(outFd) != 0) &&
+      status == SUCCESS) {
+    status = BAD_FILE;
+  }
+  CloseFds(fds, maxRuns);
+  FreeMemory(fds);
+  FreeMemory(run);
+  return status;
+}
+
+Status SortDumpExternal(const char *inputPath, const char *resultPath,
+                        const char *tempDir, size_t memoryBudget,
+                        SortField field, SortDirection direction,
+                        ExternalSortProgressFunc progress,
+                        void *progressArgs) {
+  LOG("[SortDumpExternal begin]_____________________\n");
+  if (BINARYSERIALIZER_UNLIKELY(
+          !inputPath || !resultPath ||
+          memoryBudget < BINARYSERIALIZER_MIN_MEMORY_BUDGET ||
+          !IsValidSortKey(field, direction))) {
+    LOG_ERR("Bad paths, sort key or too small [memoryBudget:%zu]\n",
+            memoryBudget);
+    LOG("[SortDumpExternal end]_____________________\n");
+    return INVALID_POINTER_OR_SIZE;
+  }
+
+  size_t records = 0;
+  int inputFd = OpenInputDump(inputPath, &records);
+  if (BINARYSERIALIZER_UNLIKELY(inputFd < 0)) {
+    LOG("[SortDumpExternal end]_____________________\n");
+    return BAD_FILE;
+  }
+  if (records == 0) {
+    close(inputFd);
+    LOG_ERR("Dump is empty [path:%s]\n", inputPath);
+    LOG("[SortDumpExternal end]_____________________\n");
+    return EMPTY_FILE;
+  }
+
+  char dirBuffer[PATH_MAX];
+  ExternalSort sort;
+  memset(&sort, 0, sizeof(sort));
+  sort.tempDir = ResolveTempDir(tempDir, resultPath, dirBuffer);
+  sort.memoryBudget = memoryBudget;
+  sort.mergeFanIn = (memoryBudget - memoryBudget / 8) / minMergeReadBytes;
+  if (sort.mergeFanIn > maxMergeFanIn) {
+    sort.mergeFanIn = maxMergeFanIn;
+  }
+  sort.field = field;
+  sort.mask = SortMask(field, direction);
+  sort.progress.phase = EXTERNAL_SORT_RUNS;
+  sort.progress.totalRecords = records;
+  sort.progressFunc = progress;
+  sort.progressArgs = progressArgs;
+  clock_gettime(CLOCK_MONOTONIC, &sort.start);
+
+  Status status =
+      SortRunsAndMerge(&sort, inputFd, records, direction, resultPath);
+  close(inputFd);
+  LOG("Sorted [records:%zu] in [runs:%zu] with [passes:%zu]\n", records,
+      sort.progress.runsCount, sort.progress.mergePasses);
+  if (status == SUCCESS) {
+    sort.progress.phase = EXTERNAL_SORT_DONE;
+    ReportSortProgress(&sort);
+  }
+  LOG("[SortDumpExternal end]_____________________\n");
+  return status;
+}
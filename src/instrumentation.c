@@ -0,0 +1,145 @@
+#include "internal/instrumentation.h"
+
+#include <string.h>
+#include <time.h>
+
+static const char *const phaseNames[INSTRUMENTATION_PHASES_COUNT] = {
+    "open", "map", "copy", "hash", "merge", "to_array", "sort", "print",
+    "store"};
+
+static const char *const counterNames[INSTRUMENTATION_COUNTERS_COUNT] = {
+    "bytes_read", "bytes_written", "records", "merges", "probes", "reallocs"};
+
+#if !defined(BS_DISABLE_INSTRUMENTATION)
+int instrumentationEnabled = 0;
+
+// Every value is updated by a single relaxed atomic add, so concurrent
+// callers never lose increments and the disabled path touches nothing here
+static InstrumentationStats accumulated;
+static AllocationStats allocation;
+
+uint64_t InstrumentationNow(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec + 1;
+}
+
+void AddPhaseTime(InstrumentationPhase phase, uint64_t nanoseconds) {
+  __atomic_fetch_add(accumulated.phaseNanoseconds + phase, nanoseconds,
+                     __ATOMIC_RELAXED);
+  __atomic_fetch_add(accumulated.phaseCalls + phase, 1, __ATOMIC_RELAXED);
+}
+
+void AddCounter(InstrumentationCounter counter, uint64_t value) {
+  __atomic_fetch_add(accumulated.counters + counter, value, __ATOMIC_RELAXED);
+}
+
+static void AddLiveBytes(int64_t bytes) {
+  int64_t live =
+      __atomic_add_fetch(&allocation.liveBytes, bytes, __ATOMIC_RELAXED);
+  int64_t peak = __atomic_load_n(&allocation.peakLiveBytes, __ATOMIC_RELAXED);
+  while (live > peak &&
+         !__atomic_compare_exchange_n(&allocation.peakLiveBytes, &peak, live,
+                                      1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+  }
+}
+
+void TrackAllocation(size_t bytes) {
+  __atomic_fetch_add(&allocation.allocations, 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&allocation.allocatedBytes, bytes, __ATOMIC_RELAXED);
+  AddLiveBytes((int64_t)bytes);
+}
+
+void TrackReallocation(size_t oldBytes, size_t newBytes) {
+  __atomic_fetch_add(&allocation.reallocations, 1, __ATOMIC_RELAXED);
+  if (newBytes > oldBytes) {
+    __atomic_fetch_add(&allocation.allocatedBytes, newBytes - oldBytes,
+                       __ATOMIC_RELAXED);
+  }
+  AddLiveBytes((int64_t)newBytes - (int64_t)oldBytes);
+}
+
+void TrackFree(size_t bytes) {
+  __atomic_fetch_add(&allocation.frees, 1, __ATOMIC_RELAXED);
+  __atomic_fetch_sub(&allocation.liveBytes, (int64_t)bytes, __ATOMIC_RELAXED);
+}
+#endif
+
+void SetInstrumentationEnabled(int enabled) {
+#if defined(BS_DISABLE_INSTRUMENTATION)
+  BINARYSERIALIZER_UNUSED(enabled);
+#else
+  __atomic_store_n(&instrumentationEnabled, enabled != 0, __ATOMIC_RELAXED);
+#endif
+}
+
+int IsInstrumentationEnabled(void) { return InstrumentationEnabled(); }
+
+Status GetInstrumentationStats(InstrumentationStats *stats) {
+  if (BINARYSERIALIZER_UNLIKELY(!stats)) {
+    return INVALID_POINTER_OR_SIZE;
+  }
+  memset(stats, 0, sizeof(*stats));
+#if !defined(BS_DISABLE_INSTRUMENTATION)
+  for (size_t i = 0; i < INSTRUMENTATION_PHASES_COUNT; ++i) {
+    stats->phaseNanoseconds[i] =
+        __atomic_load_n(accumulated.phaseNanoseconds + i, __ATOMIC_RELAXED);
+    stats->phaseCalls[i] =
+        __atomic_load_n(accumulated.phaseCalls + i, __ATOMIC_RELAXED);
+  }
+  for (size_t i = 0; i < INSTRUMENTATION_COUNTERS_COUNT; ++i) {
+    stats->counters[i] =
+        __atomic_load_n(accumulated.counters + i, __ATOMIC_RELAXED);
+  }
+#endif
+  return SUCCESS;
+}
+
+Status GetAllocationStats(AllocationStats *stats) {
+  if (BINARYSERIALIZER_UNLIKELY(!stats)) {
+    return INVALID_POINTER_OR_SIZE;
+  }
+  memset(stats, 0, sizeof(*stats));
+#if !defined(BS_DISABLE_INSTRUMENTATION)
+  stats->allocations =
+      __atomic_load_n(&allocation.allocations, __ATOMIC_RELAXED);
+  stats->reallocations =
+      __atomic_load_n(&allocation.reallocations, __ATOMIC_RELAXED);
+  stats->frees = __atomic_load_n(&allocation.frees, __ATOMIC_RELAXED);
+  stats->allocatedBytes =
+      __atomic_load_n(&allocation.allocatedBytes, __ATOMIC_RELAXED);
+  stats->liveBytes = __atomic_load_n(&allocation.liveBytes, __ATOMIC_RELAXED);
+  stats->peakLiveBytes =
+      __atomic_load_n(&allocation.peakLiveBytes, __ATOMIC_RELAXED);
+#endif
+  return SUCCESS;
+}
+
+void ResetInstrumentationStats(void) {
+#if !defined(BS_DISABLE_INSTRUMENTATION)
+  __atomic_store_n(&allocation.allocations, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&allocation.reallocations, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&allocation.frees, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&allocation.allocatedBytes, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&allocation.liveBytes, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&allocation.peakLiveBytes, 0, __ATOMIC_RELAXED);
+  for (size_t i = 0; i < INSTRUMENTATION_PHASES_COUNT; ++i) {
+    __atomic_store_n(accumulated.phaseNanoseconds + i, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(accumulated.phaseCalls + i, 0, __ATOMIC_RELAXED);
+  }
+  for (size_t i = 0; i < INSTRUMENTATION_COUNTERS_COUNT; ++i) {
+    __atomic_store_n(accumulated.counters + i, 0, __ATOMIC_RELAXED);
+  }
+#endif
+}
+
+const char *InstrumentationPhaseName(InstrumentationPhase phase) {
+  return (unsigned)phase < INSTRUMENTATION_PHASES_COUNT ? phaseNames[phase]
+                                                        : "unknown";
+}
+
+const char *InstrumentationCounterName(InstrumentationCounter counter) {
+  return (unsigned)counter < INSTRUMENTATION_COUNTERS_COUNT
+             ? counterNames[counter]
+             : "unknown";
+}
@@ -0,0 +1,457 @@
+#include "BinarySerializer/joinPipeline.h"
+#include "BinarySerializer/mergeHashTable.h"
+#include "internal/allocation.h"
+#include "internal/bulkMerge.h"
+#include "internal/instrumentation.h"
+#include "internal/partitionedSort.h"
+#include "internal/sortKey.h"
+#include "internal/threadPool.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Records read between two progress notifications, a whole number of bulk
+// merge chunks
+#define PIPELINE_READ_RECORDS (16 * (size_t)BINARYSERIALIZER_BULK_MERGE_CHUNK)
+
+// Two readers and the inserter
+#define PIPELINE_THREADS_COUNT 3
+
+enum { INPUT_FIRST, INPUT_SECOND, INPUTS_COUNT };
+
+enum { TASK_INSERT = INPUTS_COUNT, LOAD_TASKS_COUNT };
+
+enum { TASK_SORT, TASK_WRITE, STORE_TASKS_COUNT };
+
+typedef struct PipelineInput {
+  const char *path; /**< Путь к дампу */
+  StatData *data;   /**< Записи входа, выделяются читателем */
+  size_t loaded;    /**< Прочитано записей (под mutex) */
+  int finished;     /**< Чтение завершено (под mutex) */
+  Status status;    /**< Код загрузки, действителен после finished */
+} PipelineInput;
+
+struct JoinPipeline {
+  PipelineInput inputs[INPUTS_COUNT]; /**< Входы конвейера */
+  char *resultPath;                   /**< Копия пути результата */
+  JoinPipelineOptions options;        /**< Параметры запуска */
+  ThreadPool pool;                    /**< Потоки стадий */
+  pthread_t thread;                   /**< Поток, ведущий стадии */
+  pthread_mutex_t mutex;              /**< Защищает счетчики прогресса */
+  pthread_cond_t progress;            /**< Сигнал о новом прогрессе */
+  MergeHashTable table;               /**< Таблица объединения */
+  int insertFailed;                   /**< Ошибка вставки в таблицу */
+  StatData *sorted;                   /**< Отсортированный результат */
+  size_t sortedCount; /**< Готовый префикс sorted (под mutex) */
+  size_t size;        /**< Количество записей результата */
+  int fd;             /**< Дескриптор файла результата */
+  Status writeStatus; /**< Итог записи результата */
+  JoinPipelineResult result; /**< Итог конвейера */
+};
+
+static int ReadRange(int fd, void *buffer, size_t bytes, size_t offset) {
+  size_t done = 0;
+  while (done != bytes) {
+    ssize_t result =
+        pread(fd, (char *)buffer + done, bytes - done, (off_t)(offset + done));
+    if (BINARYSERIALIZER_UNLIKELY(result <= 0)) {
+      if (result < 0 && errno == EINTR) {
+        continue;
+      }
+      return 0;
+    }
+    done += (size_t)result;
+  }
+  return 1;
+}
+
+static int WriteRange(int fd, const void *buffer, size_t bytes,
+                      size_t offset) {
+  size_t done = 0;
+  while (done != bytes) {
+    ssize_t result = pwrite(fd, (const char *)buffer + done, bytes - done,
+                            (off_t)(offset + done));
+    if (BINARYSERIALIZER_UNLIKELY(result < 0)) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return 0;
+    }
+    done += (size_t)result;
+  }
+  return 1;
+}
+
+static void PublishLoaded(JoinPipeline *pipeline, PipelineInput *input,
+                          size_t loaded) {
+  pthread_mutex_lock(&pipeline->mutex);
+  input->loaded = loaded;
+  pthread_cond_broadcast(&pipeline->progress);
+  pthread_mutex_unlock(&pipeline->mutex);
+}
+
+/**
+ * @brief Читает вход целиком, публикуя прогресс после каждого блока
+ *
+ * @return Коды LoadDump(): BAD_FILE, EMPTY_FILE, ERROR или SUCCESS
+ */
+static Status ReadInput(JoinPipeline *pipeline, PipelineInput *input) {
+  int fd = open(input->path, O_RDONLY);
+  if (BINARYSERIALIZER_UNLIKELY(fd < 0)) {
+    LOG_ERR("Cannot open file [path:%s]\n", input->path);
+    return BAD_FILE;
+  }
+  struct stat statBuf;
+  if (BINARYSERIALIZER_UNLIKELY(fstat(fd, &statBuf) < 0)) {
+    close(fd);
+    LOG_ERR("Cannot fstat file [path:%s]\n", input->path);
+    return ERROR;
+  }
+  size_t size = (size_t)statBuf.st_size / sizeof(StatData);
+  if (size == 0) {
+    close(fd);
+    return EMPTY_FILE;
+  }
+  input->data = AllocateMemory(sizeof(StatData) * size);
+  if (BINARYSERIALIZER_UNLIKELY(!input->data)) {
+    close(fd);
+    LOG_ERR("Cannot allocate [bytes:%zu]\n", sizeof(StatData) * size);
+    return ERROR;
+  }
+  BINARYSERIALIZER_UNUSED(posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL));
+  for (size_t loaded = 0; loaded < size;) {
+    size_t records = size - loaded;
+    if (records > PIPELINE_READ_RECORDS) {
+      records = PIPELINE_READ_RECORDS;
+    }
+    uint64_t phaseStart = BeginPhase();
+    int read = ReadRange(fd, input->data + loaded, sizeof(StatData) * records,
+                         sizeof(StatData) * loaded);
+    EndPhase(INSTRUMENTATION_PHASE_COPY, phaseStart);
+    if (BINARYSERIALIZER_UNLIKELY(!read)) {
+      close(fd);
+      LOG_ERR("Cannot read file [path:%s]\n", input->path);
+      return ERROR;
+    }
+    loaded += records;
+    PublishLoaded(pipeline, input, loaded);
+  }
+  close(fd);
+  CountEvent(INSTRUMENTATION_BYTES_READ, sizeof(StatData) * size);
+  return SUCCESS;
+}
+
+/**
+ * @brief Граница записей, которые уже можно вставить
+ *
+ * InsertBatchWithScratch() сворачивает повторы кусками по
+ * BINARYSERIALIZER_BULK_MERGE_CHUNK от начала пакета, а пакеты короче 64
+ * записей вставляет по одной. Пока вход дочитывается, вставляются только
+ * целые куски и последний кусок придерживается, поэтому итоговый вызов не
+ * бывает короче куска, и суммы float складываются в том же порядке, что и
+ * при вставке всего входа одним пакетом в JoinDump().
+ */
+static size_t InsertableRecords(const PipelineInput *input) {
+  const size_t chunk = BINARYSERIALIZER_BULK_MERGE_CHUNK;
+  if (input->finished) {
+    return input->loaded;
+  }
+  return input->loaded > chunk ? (input->loaded - chunk) / chunk * chunk : 0;
+}
+
+/**
+ * @brief Вставляет вход в таблицу по мере чтения
+ *
+ * @return 1 при успехе или пустом входе, 0 при ошибке вставки или чтения
+ * после начала вставки
+ */
+static int InsertInput(JoinPipeline *pipeline, PipelineInput *input,
+                       BulkMergeScratch *scratch) {
+  size_t inserted = 0;
+  for (;;) {
+    pthread_mutex_lock(&pipeline->mutex);
+    while (!input->finished && InsertableRecords(input) <= inserted) {
+      pthread_cond_wait(&pipeline->progress, &pipeline->mutex);
+    }
+    size_t insertable = InsertableRecords(input);
+    int finished = input->finished;
+    Status status = input->status;
+    pthread_mutex_unlock(&pipeline->mutex);
+
+    if (finished && status != SUCCESS) {
+      // Недоступный или пустой вход считается пустым, оборванное чтение -
+      // ошибка: часть записей уже в таблице
+      return input->loaded == 0;
+    }
+    if (insertable > inserted) {
+      if (BINARYSERIALIZER_UNLIKELY(!InsertBatchWithScratch(
+              &pipeline->table, input->data + inserted, insertable - inserted,
+              scratch))) {
+        LOG_ERR("Cannot insert value into hash table\n");
+        return 0;
+      }
+      inserted = insertable;
+    }
+    if (finished && inserted == insertable) {
+      return 1;
+    }
+  }
+}
+
+static void InsertInputs(JoinPipeline *pipeline) {
+  BulkMergeScratch scratch;
+  if (BINARYSERIALIZER_UNLIKELY(
+          !InitBulkMergeScratch(&scratch, &pipeline->table.allocator))) {
+    pipeline->insertFailed = 1;
+    return;
+  }
+  // Порядок входов как в JoinDump(): сначала первый, затем второй
+  for (size_t i = 0; i < INPUTS_COUNT && !pipeline->insertFailed; ++i) {
+    PipelineInput *input = pipeline->inputs + i;
+    pipeline->insertFailed = !InsertInput(pipeline, input, &scratch);
+    if (!pipeline->insertFailed) {
+      // Чтение завершено, записи уже в таблице
+      FreeMemory(input->data);
+      input->data = NULL;
+    }
+  }
+  ClearBulkMergeScratch(&scratch);
+}
+
+static void LoadTask(void *args, size_t index) {
+  JoinPipeline *pipeline = args;
+  if (index == TASK_INSERT) {
+    InsertInputs(pipeline);
+    return;
+  }
+  PipelineInput *input = pipeline->inputs + index;
+  Status status = ReadInput(pipeline, input);
+  pthread_mutex_lock(&pipeline->mutex);
+  input->status = status;
+  input->finished = 1;
+  pthread_cond_broadcast(&pipeline->progress);
+  pthread_mutex_unlock(&pipeline->mutex);
+}
+
+static void PublishSorted(void *context, size_t sortedCount) {
+  JoinPipeline *pipeline = context;
+  pthread_mutex_lock(&pipeline->mutex);
+  pipeline->sortedCount = sortedCount;
+  pthread_cond_broadcast(&pipeline->progress);
+  pthread_mutex_unlock(&pipeline->mutex);
+}
+
+/**
+ * @brief Пишет готовый префикс результата, пока сортируется остальное
+ */
+static void WriteSorted(JoinPipeline *pipeline) {
+  size_t written = 0;
+  while (written < pipeline->size) {
+    pthread_mutex_lock(&pipeline->mutex);
+    while (pipeline->sortedCount == written) {
+      pthread_cond_wait(&pipeline->progress, &pipeline->mutex);
+    }
+    size_t sortedCount = pipeline->sortedCount;
+    pthread_mutex_unlock(&pipeline->mutex);
+
+    uint64_t phaseStart = BeginPhase();
+    int result = WriteRange(pipeline->fd, pipeline->sorted + written,
+                            sizeof(StatData) * (sortedCount - written),
+                            sizeof(StatData) * written);
+    EndPhase(INSTRUMENTATION_PHASE_STORE, phaseStart);
+    if (BINARYSERIALIZER_UNLIKELY(!result)) {
+      LOG_ERR("Cannot write file [path:%s]\n", pipeline->resultPath);
+      pipeline->writeStatus = ERROR;
+      return;
+    }
+    written = sortedCount;
+  }
+  CountEvent(INSTRUMENTATION_BYTES_WRITTEN, sizeof(StatData) * written);
+}
+
+typedef struct StoreArgs {
+  JoinPipeline *pipeline; /**< Конвейер */
+  StatData *joined;       /**< Несортированный результат объединения */
+} StoreArgs;
+
+static void StoreTask(void *args, size_t index) {
+  StoreArgs *store = args;
+  JoinPipeline *pipeline = store->pipeline;
+  if (index == TASK_SORT) {
+    SortByKeyPartitioned(store->joined, pipeline->sorted, pipeline->size,
+                         pipeline->options.sortField,
+                         pipeline->options.sortDirection, &PublishSorted,
+                         pipeline);
+  } else {
+    WriteSorted(pipeline);
+  }
+}
+
+/**
+ * @brief Сортирует результат объединения и пишет его в resultPath
+ */
+static Status StoreJoined(JoinPipeline *pipeline) {
+  StatData *joined = NULL;
+  if (BINARYSERIALIZER_UNLIKELY(
+          !HashTableToArray(&pipeline->table, &joined, &pipeline->size))) {
+    LOG_ERR("HashTableToArray failed\n");
+    return ERROR;
+  }
+  ClearHashTable(&pipeline->table);
+
+  pipeline->fd = open(pipeline->resultPath, O_RDWR);
+  if (BINARYSERIALIZER_UNLIKELY(pipeline->fd < 0)) {
+    FreeMemory(joined);
+    LOG_ERR("Cannot open file [path:%s]\n", pipeline->resultPath);
+    return BAD_FILE;
+  }
+  size_t bytes = sizeof(StatData) * pipeline->size;
+  pipeline->sorted = AllocateMemory(bytes);
+  if (BINARYSERIALIZER_UNLIKELY(!pipeline->sorted ||
+                                ftruncate(pipeline->fd, (off_t)bytes) < 0)) {
+    FreeMemory(joined);
+    close(pipeline->fd);
+    LOG_ERR("Cannot prepare result [bytes:%zu]\n", bytes);
+    return ERROR;
+  }
+  pipeline->writeStatus = SUCCESS;
+  StoreArgs store = {pipeline, joined};
+  RunThreadPool(&pipeline->pool, &StoreTask, &store, STORE_TASKS_COUNT);
+  FreeMemory(joined);
+  if (BINARYSERIALIZER_UNLIKELY(close(pipeline->fd) < 0)) {
+    pipeline->writeStatus = ERROR;
+  }
+  return pipeline->writeStatus;
+}
+
+static void *RunPipeline(void *args) {
+  JoinPipeline *pipeline = args;
+  JoinPipelineResult *result = &pipeline->result;
+  RunThreadPool(&pipeline->pool, &LoadTask, pipeline, LOAD_TASKS_COUNT);
+  for (size_t i = 0; i < INPUTS_COUNT; ++i) {
+    FreeMemory(pipeline->inputs[i].data);
+    pipeline->inputs[i].data = NULL;
+  }
+  result->firstStatus = pipeline->inputs[INPUT_FIRST].status;
+  result->secondStatus = pipeline->inputs[INPUT_SECOND].status;
+
+  if (pipeline->insertFailed) {
+    result->status = ERROR;
+  } else if (HashTableSize(&pipeline->table) == 0) {
+    // Оба входа пусты или недоступны, как JoinDump() без данных
+    result->status = INVALID_POINTER_OR_SIZE;
+  } else {
+    result->status = StoreJoined(pipeline);
+  }
+  ClearHashTable(&pipeline->table);
+  if (result->status == SUCCESS) {
+    result->data = pipeline->sorted;
+    result->size = pipeline->size;
+  } else {
+    FreeMemory(pipeline->sorted);
+  }
+  pipeline->sorted = NULL;
+
+  if (pipeline->options.onComplete) {
+    pipeline->options.onComplete(pipeline->options.context, result);
+  }
+  return NULL;
+}
+
+static void DestroyPipeline(JoinPipeline *pipeline) {
+  pthread_cond_destroy(&pipeline->progress);
+  pthread_mutex_destroy(&pipeline->mutex);
+  FreeMemory(pipeline);
+}
+
+Status StartJoinPipeline(const char *firstPath, const char *secondPath,
+                         const char *resultPath,
+                         const JoinPipelineOptions *options,
+                         JoinPipeline **pipeline) {
+  LOG("[StartJoinPipeline begin]_____________________\n");
+  const JoinPipelineOptions defaults = {SORT_FIELD_COST, SORT_ASC, NULL, NULL};
+  options = options ? options : &defaults;
+  if (BINARYSERIALIZER_UNLIKELY(
+          !firstPath || !secondPath || !resultPath || !pipeline ||
+          !IsValidSortKey(options->sortField, options->sortDirection))) {
+    LOG_ERR("Null path or pipeline or invalid sort key\n");
+    LOG("[StartJoinPipeline end]_____________________\n");
+    return INVALID_POINTER_OR_SIZE;
+  }
+
+  // Пути хранятся в одном блоке сразу за структурой
+  size_t firstBytes = strlen(firstPath) + 1;
+  size_t secondBytes = strlen(secondPath) + 1;
+  size_t resultBytes = strlen(resultPath) + 1;
+  JoinPipeline *self = AllocateMemory(sizeof(JoinPipeline) + firstBytes +
+                                      secondBytes + resultBytes);
+  if (BINARYSERIALIZER_UNLIKELY(!self)) {
+    LOG_ERR("Cannot allocate pipeline\n");
+    LOG("[StartJoinPipeline end]_____________________\n");
+    return ERROR;
+  }
+  memset(self, 0, sizeof(*self));
+  char *paths = (char *)(self + 1);
+  memcpy(paths, firstPath, firstBytes);
+  memcpy(paths + firstBytes, secondPath, secondBytes);
+  memcpy(paths + firstBytes + secondBytes, resultPath, resultBytes);
+  self->inputs[INPUT_FIRST].path = paths;
+  self->inputs[INPUT_SECOND].path = paths + firstBytes;
+  self->resultPath = paths + firstBytes + secondBytes;
+  self->options = *options;
+  self->fd = -1;
+  pthread_mutex_init(&self->mutex, NULL);
+  pthread_cond_init(&self->progress, NULL);
+
+  if (BINARYSERIALIZER_UNLIKELY(!InitHashTable(&self->table, NULL, NULL,
+                                               NULL))) {
+    DestroyPipeline(self);
+    LOG_ERR("Cannot init MergeHashTable\n");
+    LOG("[StartJoinPipeline end]_____________________\n");
+    return ERROR;
+  }
+  if (BINARYSERIALIZER_UNLIKELY(
+          !InitThreadPool(&self->pool, PIPELINE_THREADS_COUNT))) {
+    ClearHashTable(&self->table);
+    DestroyPipeline(self);
+    LOG_ERR("Cannot start pipeline threads\n");
+    LOG("[StartJoinPipeline end]_____________________\n");
+    return ERROR;
+  }
+  if (BINARYSERIALIZER_UNLIKELY(
+          pthread_create(&self->thread, NULL, &RunPipeline, self) != 0)) {
+    ClearThreadPool(&self->pool);
+    ClearHashTable(&self->table);
+    DestroyPipeline(self);
+    LOG_ERR("Cannot start pipeline thread\n");
+    LOG("[StartJoinPipeline end]_____________________\n");
+    return ERROR;
+  }
+  *pipeline = self;
+  LOG("[StartJoinPipeline end]_____________________\n");
+  return SUCCESS;
+}
+
+Status WaitJoinPipeline(JoinPipeline *pipeline, JoinPipelineResult *result) {
+  LOG("[WaitJoinPipeline begin]_____________________\n");
+  if (BINARYSERIALIZER_UNLIKELY(!pipeline)) {
+    LOG_ERR("Null pipeline\n");
+    LOG("[WaitJoinPipeline end]_____________________\n");
+    return INVALID_POINTER_OR_SIZE;
+  }
+  pthread_join(pipeline->thread, NULL);
+  ClearThreadPool(&pipeline->pool);
+  Status status = pipeline->result.status;
+  if (result) {
+    *result = pipeline->result;
+  } else {
+    FreeMemory(pipeline->result.data);
+  }
+  DestroyPipeline(pipeline);
+  LOG("[WaitJoinPipeline end]_____________________\n");
+  return status;
+}
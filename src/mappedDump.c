@@ -0,0 +1,146 @@
+#include "BinarySerializer/mappedDump.h"
+#include "internal/instrumentation.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static Status MapDumpRegion(MappedDump *dump) {
+  dump->mappedBytes = dump->size * sizeof(StatData);
+  if (dump->mappedBytes == 0) {
+    dump->data = NULL;
+    return SUCCESS;
+  }
+  int protection = dump->writable ? PROT_READ | PROT_WRITE : PROT_READ;
+  uint64_t phaseStart = BeginPhase();
+  void *addr =
+      mmap(NULL, dump->mappedBytes, protection, MAP_SHARED, dump->fd, 0);
+  EndPhase(INSTRUMENTATION_PHASE_MAP, phaseStart);
+  if (BINARYSERIALIZER_UNLIKELY(addr == MAP_FAILED)) {
+    LOG_ERR("Cannot mmap [fd:%d] with size [size:%zu]\n", dump->fd,
+            dump->mappedBytes);
+    dump->data = NULL;
+    dump->size = 0;
+    dump->mappedBytes = 0;
+    return ERROR;
+  }
+  dump->data = addr;
+  return SUCCESS;
+}
+
+Status MapDump(const char *filePath, int writable, MappedDump *dump) {
+  LOG("[MapDump begin]_____________________\n");
+  if (BINARYSERIALIZER_UNLIKELY(!filePath || !dump)) {
+    LOG_ERR("Bad filePath or dump\n");
+    LOG("[MapDump end]_____________________\n");
+    return INVALID_POINTER_OR_SIZE;
+  }
+  uint64_t phaseStart = BeginPhase();
+  int fd = open(filePath, writable ? O_RDWR : O_RDONLY);
+  if (BINARYSERIALIZER_UNLIKELY(fd < 0)) {
+    LOG_ERR("Cannot open file with [path:%s]\n", filePath);
+    LOG("[MapDump end]_____________________\n");
+    return BAD_FILE;
+  }
+  struct stat statBuf;
+  if (BINARYSERIALIZER_UNLIKELY(fstat(fd, &statBuf) < 0)) {
+    close(fd);
+    LOG_ERR("Cannot fstat file with [path:%s]\n", filePath);
+    LOG("[MapDump end]_____________________\n");
+    return ERROR;
+  }
+  EndPhase(INSTRUMENTATION_PHASE_OPEN, phaseStart);
+  dump->fd = fd;
+  dump->writable = writable != 0;
+  dump->size = (size_t)statBuf.st_size / sizeof(StatData);
+  Status status = MapDumpRegion(dump);
+  if (BINARYSERIALIZER_UNLIKELY(status != SUCCESS)) {
+    close(fd);
+    dump->fd = -1;
+  }
+  LOG("[path:%s] [size:%zu]\n", filePath, dump->size);
+  LOG("[MapDump end]_____________________\n");
+  return status;
+}
+
+Status ResizeMappedDump(MappedDump *dump, size_t size) {
+  if (BINARYSERIALIZER_UNLIKELY(!dump || !dump->writable)) {
+    return INVALID_POINTER_OR_SIZE;
+  }
+  if (dump->data) {
+    munmap(dump->data, dump->mappedBytes);
+    dump->data = NULL;
+    dump->mappedBytes = 0;
+  }
+  if (BINARYSERIALIZER_UNLIKELY(
+          ftruncate(dump->fd, (off_t)(sizeof(StatData) * size)) == -1)) {
+    LOG_ERR("Cannot truncate [fd:%d] to [size:%zu]\n", dump->fd, size);
+    dump->size = 0;
+    return BAD_FILE;
+  }
+  size_t oldSize = dump->size;
+  dump->size = size;
+  Status status = MapDumpRegion(dump);
+  if (BINARYSERIALIZER_UNLIKELY(status != SUCCESS && size > oldSize)) {
+    // Не оставляем в файле хвост из нулевых записей
+    if (ftruncate(dump->fd, (off_t)(sizeof(StatData) * oldSize)) == -1) {
+      LOG_ERR("Cannot restore [fd:%d] size [size:%zu]\n", dump->fd, oldSize);
+    }
+  }
+  return status;
+}
+
+Status UnmapDump(MappedDump *dump) {
+  if (BINARYSERIALIZER_UNLIKELY(!dump)) {
+    return INVALID_POINTER_OR_SIZE;
+  }
+  int failed = 0;
+  if (dump->data) {
+    if (dump->writable) {
+      failed |= msync(dump->data, dump->mappedBytes, MS_ASYNC) != 0;
+    }
+    failed |= munmap(dump->data, dump->mappedBytes) != 0;
+  }
+  if (dump->fd >= 0) {
+    failed |= close(dump->fd) != 0;
+  }
+  dump->data = NULL;
+  dump->size = 0;
+  dump->mappedBytes = 0;
+  dump->fd = -1;
+  if (BINARYSERIALIZER_UNLIKELY(failed)) {
+    LOG_ERR("Failure to unmap dump\n");
+  }
+  return failed ? ERROR : SUCCESS;
+}
+
+Status PrintMappedDumpPage(const MappedDump *dump, size_t offset, size_t limit,
+                           TableView *view) {
+  LOG("[PrintMappedDumpPage begin]_____________________\n");
+  if (BINARYSERIALIZER_UNLIKELY(!dump || !view || limit == 0 ||
+                                offset >= dump->size)) {
+    LOG_ERR("Bad dump, view or page [offset:%zu][limit:%zu]\n", offset,
+            limit);
+    LOG("[PrintMappedDumpPage end]_____________________\n");
+    return INVALID_POINTER_OR_SIZE;
+  }
+  size_t end = dump->size - offset < limit ? dump->size : offset + limit;
+
+  // One batched read of the displayed pages instead of a fault per page
+  const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+  size_t first = offset * sizeof(StatData) / pageSize * pageSize;
+  size_t last = end * sizeof(StatData);
+  posix_madvise((char *)dump->data + first, last - first,
+                POSIX_MADV_WILLNEED);
+
+  view->data = dump->data;
+  view->dataSize = dump->size;
+  view->memSize = sizeof(StatData);
+  view->permutation = NULL;
+  Status status =
+      PrintTablePage(view, offset, limit) == TVS_SUCCESS ? SUCCESS : ERROR;
+  LOG("[PrintMappedDumpPage end]_____________________\n");
+  return status;
+}
@@ -1,6 +1,10 @@
 #include "BinarySerializer/mergeHashTable.h"
 
 #include "BinarySerializer/config.h"
+#include "BinarySerializer/mergePolicy.h"
+#include "internal/allocation.h"
+#include "internal/bulkMerge.h"
+#include "internal/instrumentation.h"
 
 #if defined(BS_ENABLE_MI_MALLOC)
 #include <mimalloc-override.h>
@@ -62,46 +66,24 @@ typedef struct Bucket {
   Node *nodes;       /**< Динамический массив узлов */
   size_t nodesCount; /**< Количество занятых элементов */
   size_t capacity; /**< Текущая емкость массива */
+  /** Узлов [0, retainedCount) с выделенным data, не меньше nodesCount:
+   * после EraseFromHashTable() и ResetHashTable() записи переиспользуются */
+  size_t retainedCount;
 } Bucket;
 
 /**
- * @struct HashNodeToArrayHelper
- * @brief Вспомогательная структура для копирования данных из хеш-таблицы в
- * массив
+ * @struct InsertCounters
+ * @brief Локальные счетчики вставок для instrumentation.h
  *
- * @details
- * Используется в качестве контекста при обходе хеш-таблицы.
- *
- * @see HashTableToArrayHelperFunc()
- */
-typedef struct HashNodeToArrayHelper {
-  StatData *data; /**< Указатель на целевой массив */
-  size_t shift; /**< Текущее смещение (счетчик записанных элементов) */
-} HashNodeToArrayHelper;
-
-/**
- * @brief Callback-функция для копирования данных узла в массив
- *
- * @details
- * Копирует данные StatData в массив и увеличивает счетчик смещения.
- * Используется с функциями обхода хеш-таблицы.
- *
- * @param[in] data Указатель на данные узла (источник)
- * @param[in,out] args Указатель на HashNodeToArrayHelper (приводится к типу)
- *
- * @pre data != NULL
- * @pre args != NULL
- * @pre args указывает на корректную структуру HashNodeToArrayHelper
- * @pre helper->data имеет достаточный размер для копирования
- *
- * @see HashNodeToArrayHelper
+ * Копятся в обычных переменных и публикуются один раз на вызов
+ * InsertToHashTable() / InsertBatchToHashTable(), чтобы не выполнять
+ * атомарные операции на каждый просмотренный узел.
  */
-static void HashTableToArrayHelperFunc(StatData *__restrict data,
-                                       void *__restrict args) {
-  HashNodeToArrayHelper *helper = (HashNodeToArrayHelper *)args;
-  memcpy(helper->data + helper->shift, data, sizeof(StatData));
-  helper->shift++;
-}
+typedef struct InsertCounters {
+  size_t probes;   /**< Просмотрено узлов цепочек */
+  size_t merges;   /**< Слияний с существующими узлами */
+  size_t reallocs; /**< Расширений массивов узлов */
+} InsertCounters;
 
 /**
  * @brief Вычисляет индекс bucket для заданного хеш-значения
@@ -129,7 +111,7 @@ static void HashTableToArrayHelperFunc(StatData *__restrict data,
  * @see MergeHashTable
  */
 static size_t BucketIndex(const MergeHashTable *table, HashT hash) {
-  return (hash ^ (hash >> 16)) & (table->bucketsCount - 1);
+  return HashToBucketIndex(hash, table->bucketsCount);
 }
 
 /**
@@ -163,23 +145,7 @@ static size_t BucketIndex(const MergeHashTable *table, HashT hash) {
  * @endcode
  */
 static HashT DefaultMurmurHash2(const StatData *stData) {
-  HashT m = 0xc6a4a7935bd1e995ULL;
-  const int r = 47;
-  HashT h = 0x8445d61a4e774912ULL ^ (8 * m);
-
-  HashT k = stData->id;
-  k *= m;
-  k ^= k >> r;
-  k *= m;
-
-  h ^= k;
-  h *= m;
-
-  h ^= h >> r;
-  h *= m;
-  h ^= h >> r;
-
-  return h;
+  return DefaultStatDataHash(stData);
 }
 
 /**
@@ -219,21 +185,7 @@ static HashT DefaultMurmurHash2(const StatData *stData) {
  */
 static void DefaultMerge(StatData *__restrict first,
                          const StatData *__restrict second) {
-  // total sum of count
-  first->count += second->count;
-
-  // total sum of cost
-  first->cost += second->cost;
-
-  // if any primary have zero, than primary always zero
-  first->primary &= second->primary;
-
-  // max(mode) without if, for performance branch predictor
-  unsigned tmpFirstMode = first->mode;
-  unsigned tmpSecondMode = second->mode;
-  int ftrue = (tmpFirstMode > tmpSecondMode);
-  int ffalse = ftrue ^ 1;
-  first->mode = ftrue * tmpFirstMode + ffalse * tmpSecondMode;
+  DefaultStatDataMerge(first, second);
 }
 
 /**
@@ -260,7 +212,7 @@ static void DefaultMerge(StatData *__restrict first,
  */
 static int DefaultStatDataComparator(const StatData *__restrict lhs,
                                      const StatData *__restrict rhs) {
-  return lhs->id == rhs->id;
+  return DefaultStatDataEqual(lhs, rhs);
 }
 
 /**
@@ -272,6 +224,7 @@ static int DefaultStatDataComparator(const StatData *__restrict lhs,
  * 2. Освобождает массив bucket->nodes
  * 3. Сбрасывает счетчики и указатели
  *
+ * @param[in] allocator Аллокатор таблицы
  * @param[in,out] bucket Указатель на bucket для очистки
  *
  * @pre bucket != NULL
@@ -289,12 +242,13 @@ static int DefaultStatDataComparator(const StatData *__restrict lhs,
  *
  * @see Bucket, Node
  */
-static void ClearBucket(Bucket *bucket) {
-  for (size_t i = 0; i < bucket->nodesCount; ++i) {
-    free(bucket->nodes[i].data);
+static void ClearBucket(const Allocator *allocator, Bucket *bucket) {
+  for (size_t i = 0; i < bucket->retainedCount; ++i) {
+    AllocatorFree(allocator, bucket->nodes[i].data);
   }
-  free(bucket->nodes);
+  AllocatorFree(allocator, bucket->nodes);
   bucket->nodesCount = 0;
+  bucket->retainedCount = 0;
   bucket->capacity = 1;
   bucket->nodes = NULL;
 }
@@ -315,6 +269,7 @@ static void ClearBucket(Bucket *bucket) {
  * @param[in,out] bucket Целевой bucket
  * @param[in] data Вставляемые данные
  * @param[in] hash Предвычисленное хеш-значение
+ * @param[in,out] counters Локальные счетчики вставок
  *
  * @retval 1 Успешная вставка или объединение
  * @retval 0 Ошибка выделения памяти
@@ -337,35 +292,63 @@ static void ClearBucket(Bucket *bucket) {
  * @par Оптимизации:
  * - Использование BINARYSERIALIZER_UNLIKELY для редких случаев
  * - Предвычисление хеша для ускорения сравнения
+ * - Для функций по умолчанию поиск идет через встраиваемые политики из
+ *   mergePolicy.h без косвенных вызовов
  *
  * @warning Функция НЕ проверяет корректность индекса bucket в таблице
  *
  * @see Bucket, Node, MergeHashTable
  *
  */
-BINARYSERIALIZER_NODISCARD static int InsertIntoBucket(MergeHashTable *table,
-                                                       Bucket *bucket,
-                                                       const StatData *data,
-                                                       HashT hash) {
-  for (size_t i = 0; i < bucket->nodesCount; ++i) {
-    if (bucket->nodes[i].hash == hash &&
-        table->comparator(bucket->nodes[i].data, data) == 1) {
-      table->merge(bucket->nodes[i].data, data);
-      return 1;
+BINARYSERIALIZER_NODISCARD static int
+InsertIntoBucket(MergeHashTable *table, Bucket *bucket, const StatData *data,
+                 HashT hash, InsertCounters *counters) {
+  if (BINARYSERIALIZER_LIKELY(table->comparator == &DefaultStatDataComparator &&
+                              table->merge == &DefaultMerge)) {
+    for (size_t i = 0; i < bucket->nodesCount; ++i) {
+      if (bucket->nodes[i].hash == hash &&
+          DefaultStatDataEqual(bucket->nodes[i].data, data)) {
+        DefaultStatDataMerge(bucket->nodes[i].data, data);
+        counters->probes += i + 1;
+        counters->merges++;
+        return 1;
+      }
+    }
+  } else {
+    for (size_t i = 0; i < bucket->nodesCount; ++i) {
+      if (bucket->nodes[i].hash == hash &&
+          table->comparator(bucket->nodes[i].data, data) == 1) {
+        table->merge(bucket->nodes[i].data, data);
+        counters->probes += i + 1;
+        counters->merges++;
+        return 1;
+      }
     }
   }
+  counters->probes += bucket->nodesCount;
 
   Node *p = bucket->nodes;
-  StatData *newData = malloc(sizeof(StatData));
+  // A retained slot is always below capacity, so reuse never reallocates
+  if (bucket->nodesCount < bucket->retainedCount) {
+    Node *node = p + bucket->nodesCount;
+    node->hash = hash;
+    memcpy(node->data, data, sizeof(StatData));
+    node->index = bucket->nodesCount;
+    bucket->nodesCount++;
+    return 1;
+  }
+  StatData *newData = AllocatorAllocate(&table->allocator, sizeof(StatData));
   if (BINARYSERIALIZER_UNLIKELY(!newData)) {
     return 0;
   }
   if (BINARYSERIALIZER_UNLIKELY(bucket->nodesCount == bucket->capacity ||
                                 !bucket->nodes)) {
     bucket->capacity *= 2;
-    p = realloc(bucket->nodes, sizeof(Node) * bucket->capacity);
+    counters->reallocs++;
+    p = AllocatorReallocate(&table->allocator, bucket->nodes,
+                            sizeof(Node) * bucket->capacity);
     if (BINARYSERIALIZER_UNLIKELY(!p)) {
-      free(newData);
+      AllocatorFree(&table->allocator, newData);
       return 0;
     }
   }
@@ -378,39 +361,138 @@ BINARYSERIALIZER_NODISCARD static int InsertIntoBucket(MergeHashTable *table,
   p[nodesCount].bucket = bucket;
   p[nodesCount].index = nodesCount;
   bucket->nodesCount++;
+  bucket->retainedCount = bucket->nodesCount;
   return 1;
 }
 
+void MergeStatData(StatData *lhs, const StatData *rhs) {
+  DefaultMerge(lhs, rhs);
+}
+
 int InitHashTable(MergeHashTable *table, HashFunction hash, MergeFunction merge,
                   StatDataCompareFunction comparator) {
-  if (BINARYSERIALIZER_UNLIKELY(!table)) {
+  return InitHashTableWithBuckets(table, BINARYSERIALIZER_DEFUALT_BUCKETS_COUNT,
+                                  hash, merge, comparator);
+}
+
+int InitHashTableWithBuckets(MergeHashTable *table, size_t bucketsCount,
+                             HashFunction hash, MergeFunction merge,
+                             StatDataCompareFunction comparator) {
+  return InitHashTableWithAllocator(table, bucketsCount, hash, merge,
+                                    comparator, NULL);
+}
+
+int InitHashTableWithAllocator(MergeHashTable *table, size_t bucketsCount,
+                               HashFunction hash, MergeFunction merge,
+                               StatDataCompareFunction comparator,
+                               const Allocator *allocator) {
+  allocator = ResolveAllocator(allocator);
+  if (BINARYSERIALIZER_UNLIKELY(!table || bucketsCount == 0 || !allocator)) {
     return 0;
   }
+  // BucketIndex requires power of two buckets count
+  size_t roundedCount = 1;
+  while (roundedCount < bucketsCount) {
+    roundedCount <<= 1;
+  }
   table->hash = hash ? hash : &DefaultMurmurHash2;
   table->merge = merge ? merge : &DefaultMerge;
   table->comparator = comparator ? comparator : &DefaultStatDataComparator;
-  table->buckets =
-      malloc(sizeof(Bucket) * BINARYSERIALIZER_DEFUALT_BUCKETS_COUNT);
+  table->allocator = *allocator;
+  table->buckets = AllocatorAllocate(allocator, sizeof(Bucket) * roundedCount);
   if (BINARYSERIALIZER_LIKELY(table->buckets)) {
-    table->bucketsCount = BINARYSERIALIZER_DEFUALT_BUCKETS_COUNT;
-    for (size_t i = 0; i < BINARYSERIALIZER_DEFUALT_BUCKETS_COUNT; ++i) {
+    table->bucketsCount = roundedCount;
+    for (size_t i = 0; i < roundedCount; ++i) {
       table->buckets[i].nodes = NULL;
       table->buckets[i].nodesCount = 0;
       table->buckets[i].capacity = 1;
+      table->buckets[i].retainedCount = 0;
     }
   }
   return table->buckets != NULL;
 }
 
+static int InsertWithCounters(MergeHashTable *table, const StatData *data,
+                              InsertCounters *counters) {
+  HashT hash = table->hash == &DefaultMurmurHash2 ? DefaultStatDataHash(data)
+                                                  : table->hash(data);
+  size_t index = BucketIndex(table, hash);
+  assert(index < table->bucketsCount);
+  return InsertIntoBucket(table, table->buckets + index, data, hash, counters);
+}
+
+static void PublishInsertCounters(const InsertCounters *counters,
+                                  size_t records) {
+  if (InstrumentationEnabled()) {
+    CountEvent(INSTRUMENTATION_RECORDS, records);
+    CountEvent(INSTRUMENTATION_PROBES, counters->probes);
+    CountEvent(INSTRUMENTATION_MERGES, counters->merges);
+    CountEvent(INSTRUMENTATION_REALLOCS, counters->reallocs);
+  }
+}
+
 int InsertToHashTable(MergeHashTable *table, const StatData *data) {
   if (BINARYSERIALIZER_UNLIKELY(!table || !data || !table->hash ||
                                 !table->merge)) {
     return 0;
   }
-  HashT hash = table->hash(data);
-  size_t index = BucketIndex(table, hash);
-  assert(index < table->bucketsCount);
-  return InsertIntoBucket(table, table->buckets + index, data, hash);
+  InsertCounters counters = {0, 0, 0};
+  int result = InsertWithCounters(table, data, &counters);
+  PublishInsertCounters(&counters, 1);
+  return result;
+}
+
+int InsertBatchToHashTable(MergeHashTable *table, const StatData *data,
+                           size_t size) {
+  return InsertBatchWithScratch(table, data, size, NULL);
+}
+
+int InsertBatchWithScratch(MergeHashTable *table, const StatData *data,
+                           size_t size, BulkMergeScratch *scratch) {
+  if (BINARYSERIALIZER_UNLIKELY(!table || (!data && size != 0) ||
+                                !table->hash || !table->merge)) {
+    return 0;
+  }
+  uint64_t phaseStart = BeginPhase();
+  InsertCounters counters = {0, 0, 0};
+  int result = 1;
+  // Grouping by id is only valid for the default equality and merge rules,
+  // small batches are not worth the scratch setup
+  if (table->comparator != &DefaultStatDataComparator ||
+      table->merge != &DefaultMerge || size < 64) {
+    for (size_t i = 0; i < size && result; ++i) {
+      result = InsertWithCounters(table, data + i, &counters);
+    }
+  } else {
+    BulkMergeScratch localScratch;
+    int ownScratch = scratch == NULL;
+    if (ownScratch) {
+      scratch = &localScratch;
+      if (BINARYSERIALIZER_UNLIKELY(
+              !InitBulkMergeScratch(scratch, &table->allocator))) {
+        return 0;
+      }
+    }
+    for (size_t offset = 0; offset < size && result;
+         offset += BINARYSERIALIZER_BULK_MERGE_CHUNK) {
+      size_t chunk = size - offset;
+      if (chunk > BINARYSERIALIZER_BULK_MERGE_CHUNK) {
+        chunk = BINARYSERIALIZER_BULK_MERGE_CHUNK;
+      }
+      size_t groups = ReduceBatchById(scratch, data + offset, chunk);
+      // Records folded into their group count as merges too
+      counters.merges += chunk - groups;
+      for (size_t i = 0; i < groups && result; ++i) {
+        result = InsertWithCounters(table, scratch->reduced + i, &counters);
+      }
+    }
+    if (ownScratch) {
+      ClearBulkMergeScratch(scratch);
+    }
+  }
+  PublishInsertCounters(&counters, size);
+  EndPhase(INSTRUMENTATION_PHASE_HASH, phaseStart);
+  return result;
 }
 
 void EraseFromHashTable(MergeHashTable *table, const StatData *data) {
@@ -420,16 +502,16 @@ void EraseFromHashTable(MergeHashTable *table, const StatData *data) {
   }
 
   if (node->bucket->nodesCount - 1 == 0) {
-    ClearBucket(node->bucket);
+    ClearBucket(&table->allocator, node->bucket);
     return;
   }
 
   size_t index = node->bucket->nodesCount - 1;
   Node *lastNode = node->bucket->nodes + index;
 
+  // The last record stays allocated in its slot for the next insert
   if (node->hash != lastNode->hash) {
     memcpy(node->data, lastNode->data, sizeof(StatData));
-    free(lastNode->data);
     node->hash = lastNode->hash;
   } else {
     lastNode->index--;
@@ -462,10 +544,10 @@ void ClearHashTable(MergeHashTable *table) {
   }
 
   for (unsigned long i = 0; i < table->bucketsCount; ++i) {
-    ClearBucket(table->buckets + i);
+    ClearBucket(&table->allocator, table->buckets + i);
   }
 
-  free(table->buckets);
+  AllocatorFree(&table->allocator, table->buckets);
   table->buckets = NULL;
   table->bucketsCount = 0;
   table->hash = NULL;
@@ -473,6 +555,94 @@ void ClearHashTable(MergeHashTable *table) {
   table->comparator = NULL;
 }
 
+void ResetHashTable(MergeHashTable *table) {
+  if (BINARYSERIALIZER_UNLIKELY(!table)) {
+    return;
+  }
+  for (size_t i = 0; i < table->bucketsCount; ++i) {
+    table->buckets[i].nodesCount = 0;
+  }
+}
+
+size_t HashTableSize(const MergeHashTable *table) {
+  if (BINARYSERIALIZER_UNLIKELY(!table)) {
+    return 0;
+  }
+  size_t totalDataSize = 0;
+  for (size_t i = 0; i < table->bucketsCount; ++i) {
+    totalDataSize += table->buckets[i].nodesCount;
+  }
+  return totalDataSize;
+}
+
+int GetHashTableStats(const MergeHashTable *table, HashTableStats *stats) {
+  if (BINARYSERIALIZER_UNLIKELY(!table || !stats)) {
+    return 0;
+  }
+  memset(stats, 0, sizeof(*stats));
+  stats->bucketsCount = table->bucketsCount;
+  stats->bucketsBytes = sizeof(Bucket) * table->bucketsCount;
+  size_t probes = 0;
+  size_t retainedCount = 0;
+  for (size_t i = 0; i < table->bucketsCount; ++i) {
+    const Bucket *bucket = table->buckets + i;
+    size_t length = bucket->nodesCount;
+    retainedCount += bucket->retainedCount;
+    size_t bin = 0;
+    while (bin + 1 < BINARYSERIALIZER_CHAIN_HISTOGRAM_SIZE &&
+           (length >> bin) != 0) {
+      ++bin;
+    }
+    stats->chainHistogram[bin]++;
+    if (bucket->nodes) {
+      stats->nodesBytes += sizeof(Node) * bucket->capacity;
+    }
+    if (length > stats->maxChainLength) {
+      stats->maxChainLength = length;
+    }
+    stats->elementsCount += length;
+    probes += length * (length + 1) / 2;
+  }
+  stats->emptyBuckets = stats->chainHistogram[0];
+  // Records kept past nodesCount after a reset or erase stay allocated
+  stats->payloadBytes = sizeof(StatData) * retainedCount;
+  stats->totalBytes =
+      stats->bucketsBytes + stats->nodesBytes + stats->payloadBytes;
+  if (stats->bucketsCount != 0) {
+    stats->loadFactor =
+        (double)stats->elementsCount / (double)stats->bucketsCount;
+  }
+  if (stats->elementsCount != 0) {
+    stats->meanChainLength =
+        (double)stats->elementsCount /
+        (double)(stats->bucketsCount - stats->emptyBuckets);
+    stats->meanProbeLength = (double)probes / (double)stats->elementsCount;
+  }
+  return 1;
+}
+
+size_t HashTableToBuffer(const MergeHashTable *table, StatData *data,
+                         size_t size) {
+  if (BINARYSERIALIZER_UNLIKELY(!table || !data)) {
+    return 0;
+  }
+  uint64_t phaseStart = BeginPhase();
+  size_t shift = 0;
+  for (size_t i = 0; i < table->bucketsCount && shift < size; ++i) {
+    const Bucket *bucket = table->buckets + i;
+    size_t count = bucket->nodesCount;
+    if (count > size - shift) {
+      count = size - shift;
+    }
+    for (size_t j = 0; j < count; ++j) {
+      data[shift + j] = *bucket->nodes[j].data;
+    }
+    shift += count;
+  }
+  EndPhase(INSTRUMENTATION_PHASE_TO_ARRAY, phaseStart);
+  return shift;
+}
+
 int HashTableToArray(const MergeHashTable *table, StatData **data,
                      size_t *size) {
   LOG("[HashTableToArray begin]_____________________\n");
@@ -481,17 +651,15 @@ int HashTableToArray(const MergeHashTable *table, StatData **data,
     LOG("[HashTableToArray end]_____________________\n");
     return 0;
   }
-  size_t totalDataSize = 0;
-  for (size_t i = 0; i < table->bucketsCount; ++i) {
-    totalDataSize += table->buckets[i].nodesCount;
-  }
+  size_t totalDataSize = HashTableSize(table);
 
   if (totalDataSize == 0) {
     LOG_ERR("Empty totalSize for hashTable\n");
     LOG("[HashTableToArray end]_____________________\n");
     return 0;
   }
-  StatData *memBlock = malloc(sizeof(StatData) * totalDataSize);
+  StatData *memBlock =
+      AllocatorAllocate(&table->allocator, sizeof(StatData) * totalDataSize);
 
   if (BINARYSERIALIZER_UNLIKELY(!memBlock)) {
     LOG_ERR("Cannot allocate [bytes:%zu]\n", sizeof(StatData) * totalDataSize);
@@ -500,10 +668,7 @@ int HashTableToArray(const MergeHashTable *table, StatData **data,
   }
   *size = totalDataSize;
   *data = memBlock;
-  HashNodeToArrayHelper helper;
-  helper.data = memBlock;
-  helper.shift = 0;
-  ForeachElementInHashTable(table, &HashTableToArrayHelperFunc, &helper);
+  HashTableToBuffer(table, memBlock, totalDataSize);
   LOG("[HashTableToArray end]_____________________\n");
   return 1;
 }
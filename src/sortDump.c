@@ -0,0 +1,747 @@
+#include "BinarySerializer/sortDump.h"
+
+#include "internal/allocation.h"
+#include "internal/executionContext.h"
+#include "internal/instrumentation.h"
+#include "internal/partitionedSort.h"
+#include "internal/sortKey.h"
+#include "internal/threadPool.h"
+
+#if defined(BS_ENABLE_MI_MALLOC)
+#include <mimalloc-override.h>
+#else
+#include <stdlib.h>
+#endif
+
+#include <stdint.h>
+#include <string.h>
+
+#define RADIX_BUCKETS 256
+
+// Below this size insertion sort is cheaper than histogram passes
+#define RADIX_MIN_SIZE 64
+
+// Below this size thread start-up costs more than the sort itself
+#define PARALLEL_RADIX_MIN_SIZE ((size_t)1 << 16)
+
+#define MAX_KEY_BYTES 8
+
+#define SORT_FIELDS_COUNT (SORT_FIELD_COST + 1)
+
+/**
+ * @brief Генерирует устойчивую LSD radix сортировку по ключу KEY
+ *
+ * Ключ xor-ится с mask: 0 для возрастания, все единицы для убывания, так что
+ * направление не добавляет ветвлений во внутренние циклы. Гистограммы всех
+ * байтов строятся за один проход, байты с единственным значением
+ * пропускаются.
+ */
+#define DEFINE_RADIX_SORT(Name, KEY, KEY_BYTES)                                \
+  static void Name(StatData *data, size_t size, StatData *aux,                 \
+                   uint64_t mask) {                                            \
+    size_t histograms[KEY_BYTES][RADIX_BUCKETS];                               \
+    memset(histograms, 0, sizeof(histograms));                                 \
+    for (size_t i = 0; i < size; ++i) {                                        \
+      uint64_t key = KEY(data + i) ^ mask;                                     \
+      for (unsigned byte = 0; byte < (KEY_BYTES); ++byte) {                    \
+        histograms[byte][(key >> (8 * byte)) & 0xff]++;                        \
+      }                                                                        \
+    }                                                                          \
+                                                                               \
+    StatData *src = data;                                                      \
+    StatData *dst = aux;                                                       \
+    for (unsigned byte = 0; byte < (KEY_BYTES); ++byte) {                      \
+      size_t *histogram = histograms[byte];                                    \
+      unsigned shift = 8 * byte;                                               \
+      if (histogram[(KEY(src) ^ mask) >> shift & 0xff] == size) {              \
+        continue;                                                              \
+      }                                                                        \
+      size_t offset = 0;                                                       \
+      for (size_t digit = 0; digit < RADIX_BUCKETS; ++digit) {                 \
+        size_t count = histogram[digit];                                       \
+        histogram[digit] = offset;                                             \
+        offset += count;                                                       \
+      }                                                                        \
+      for (size_t i = 0; i < size; ++i) {                                      \
+        uint64_t key = KEY(src + i) ^ mask;                                    \
+        dst[histogram[(key >> shift) & 0xff]++] = src[i];                      \
+      }                                                                        \
+      StatData *tmp = src;                                                     \
+      src = dst;                                                               \
+      dst = tmp;                                                               \
+    }                                                                          \
+    if (src != data) {                                                         \
+      memcpy(data, src, sizeof(StatData) * size);                             \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  static void Name##Small(StatData *data, size_t size, uint64_t mask) {        \
+    for (size_t i = 1; i < size; ++i) {                                        \
+      StatData value = data[i];                                                \
+      uint64_t key = KEY(&value) ^ mask;                                       \
+      size_t j = i;                                                            \
+      for (; j > 0 && (KEY(data + j - 1) ^ mask) > key; --j) {                 \
+        data[j] = data[j - 1];                                                 \
+      }                                                                        \
+      data[j] = value;                                                         \
+    }                                                                          \
+  }
+
+DEFINE_RADIX_SORT(RadixSortById, IdSortKey, 8)
+DEFINE_RADIX_SORT(RadixSortByCost, CostSortKey, 4)
+
+/**
+ * @brief Устойчивая сортировка по одному полю, aux нужен при
+ * size >= RADIX_MIN_SIZE
+ */
+static void SortByField(StatData *data, size_t size, StatData *aux,
+                        SortField field, uint64_t mask) {
+  if (size < RADIX_MIN_SIZE) {
+    if (field == SORT_FIELD_ID) {
+      RadixSortByIdSmall(data, size, mask);
+    } else {
+      RadixSortByCostSmall(data, size, mask);
+    }
+  } else if (field == SORT_FIELD_ID) {
+    RadixSortById(data, size, aux, mask);
+  } else {
+    RadixSortByCost(data, size, aux, mask);
+  }
+}
+
+Status SortDumpByKey(StatData *data, size_t size, SortField field,
+                     SortDirection direction) {
+  LOG("[SortDumpByKey begin]_____________________\n");
+  if (BINARYSERIALIZER_UNLIKELY(!data || size == 0 ||
+                                !IsValidSortKey(field, direction))) {
+    LOG_ERR("Invalid data, size or sort key\n");
+    LOG("[SortDumpByKey end]_____________________\n");
+    return INVALID_POINTER_OR_SIZE;
+  }
+
+  StatData *aux = NULL;
+  if (size >= RADIX_MIN_SIZE) {
+    aux = AllocateMemory(sizeof(StatData) * size);
+    if (BINARYSERIALIZER_UNLIKELY(!aux)) {
+      LOG_ERR("Cannot allocate [bytes:%zu]\n", sizeof(StatData) * size);
+      LOG("[SortDumpByKey end]_____________________\n");
+      return ERROR;
+    }
+  }
+  uint64_t phaseStart = BeginPhase();
+  SortByField(data, size, aux, field, SortMask(field, direction));
+  EndPhase(INSTRUMENTATION_PHASE_SORT, phaseStart);
+  FreeMemory(aux);
+  LOG("[SortDumpByKey end]_____________________\n");
+  return SUCCESS;
+}
+
+Status SortDumpByKeyWithContext(ExecutionContext *context, StatData *data,
+                                size_t size, SortField field,
+                                SortDirection direction) {
+  LOG("[SortDumpByKeyWithContext begin]_____________________\n");
+  if (BINARYSERIALIZER_UNLIKELY(!context || !data || size == 0 ||
+                                !IsValidSortKey(field, direction))) {
+    LOG_ERR("Invalid context, data, size or sort key\n");
+    LOG("[SortDumpByKeyWithContext end]_____________________\n");
+    return INVALID_POINTER_OR_SIZE;
+  }
+
+  StatData *aux = NULL;
+  if (size >= RADIX_MIN_SIZE) {
+    if (BINARYSERIALIZER_UNLIKELY(!ReserveContextRecords(
+            context, &context->sortBuffer, &context->sortCapacity, size))) {
+      LOG_ERR("Cannot allocate [bytes:%zu]\n", sizeof(StatData) * size);
+      LOG("[SortDumpByKeyWithContext end]_____________________\n");
+      return ERROR;
+    }
+    aux = context->sortBuffer;
+  }
+  uint64_t phaseStart = BeginPhase();
+  SortByField(data, size, aux, field, SortMask(field, direction));
+  EndPhase(INSTRUMENTATION_PHASE_SORT, phaseStart);
+  LOG("[SortDumpByKeyWithContext end]_____________________\n");
+  return SUCCESS;
+}
+
+void SortByKeyPartitioned(StatData *data, StatData *sorted, size_t size,
+                          SortField field, SortDirection direction,
+                          SortedPrefixFunc ready, void *context) {
+  uint64_t mask = SortMask(field, direction);
+  unsigned keyBytes = field == SORT_FIELD_ID ? 8 : 4;
+  size_t histograms[MAX_KEY_BYTES][RADIX_BUCKETS];
+  memset(histograms, 0, sizeof(histograms));
+  for (size_t i = 0; i < size; ++i) {
+    uint64_t key = SortKey(data + i, field) ^ mask;
+    for (unsigned byte = 0; byte < keyBytes; ++byte) {
+      histograms[byte][(key >> (8 * byte)) & 0xff]++;
+    }
+  }
+
+  // Bytes above the partition byte are equal across all records, so the
+  // partition digit alone orders the parts
+  unsigned byte = keyBytes;
+  uint64_t firstKey = size ? SortKey(data, field) ^ mask : 0;
+  while (byte > 0 &&
+         histograms[byte - 1][(firstKey >> (8 * (byte - 1))) & 0xff] == size) {
+    --byte;
+  }
+  uint64_t phaseStart = BeginPhase();
+  if (byte == 0 || size < RADIX_MIN_SIZE) {
+    memcpy(sorted, data, sizeof(StatData) * size);
+    SortByField(sorted, size, data, field, mask);
+    EndPhase(INSTRUMENTATION_PHASE_SORT, phaseStart);
+    ready(context, size);
+    return;
+  }
+  unsigned shift = 8 * (byte - 1);
+  size_t *histogram = histograms[byte - 1];
+  size_t offsets[RADIX_BUCKETS];
+  size_t offset = 0;
+  for (size_t digit = 0; digit < RADIX_BUCKETS; ++digit) {
+    offsets[digit] = offset;
+    offset += histogram[digit];
+  }
+  for (size_t i = 0; i < size; ++i) {
+    uint64_t key = SortKey(data + i, field) ^ mask;
+    sorted[offsets[(key >> shift) & 0xff]++] = data[i];
+  }
+  EndPhase(INSTRUMENTATION_PHASE_SORT, phaseStart);
+
+  size_t begin = 0;
+  for (size_t digit = 0; digit < RADIX_BUCKETS; ++digit) {
+    size_t count = histogram[digit];
+    if (count == 0) {
+      continue;
+    }
+    phaseStart = BeginPhase();
+    SortByField(sorted + begin, count, data + begin, field, mask);
+    EndPhase(INSTRUMENTATION_PHASE_SORT, phaseStart);
+    begin += count;
+    ready(context, begin);
+  }
+}
+
+Status SortDumpByKeys(StatData *data, size_t size, const SortKeySpec *keys,
+                      size_t keysCount) {
+  LOG("[SortDumpByKeys begin]_____________________\n");
+  if (BINARYSERIALIZER_UNLIKELY(!data || size == 0 || !keys ||
+                                keysCount == 0)) {
+    LOG_ERR("Invalid data, size or keys\n");
+    LOG("[SortDumpByKeys end]_____________________\n");
+    return INVALID_POINTER_OR_SIZE;
+  }
+  // Only the first occurrence of a field matters: records are already
+  // ordered by it when a repeated spec would be applied
+  size_t effectiveCount = 0;
+  unsigned seenFields = 0;
+  SortKeySpec effective[SORT_FIELDS_COUNT];
+  for (size_t i = 0; i < keysCount; ++i) {
+    if (BINARYSERIALIZER_UNLIKELY(
+            !IsValidSortKey(keys[i].field, keys[i].direction))) {
+      LOG_ERR("Invalid sort key [index:%zu]\n", i);
+      LOG("[SortDumpByKeys end]_____________________\n");
+      return INVALID_POINTER_OR_SIZE;
+    }
+    unsigned fieldBit = 1u << keys[i].field;
+    if (!(seenFields & fieldBit)) {
+      seenFields |= fieldBit;
+      effective[effectiveCount++] = keys[i];
+    }
+  }
+
+  StatData *aux = NULL;
+  if (size >= RADIX_MIN_SIZE) {
+    aux = AllocateMemory(sizeof(StatData) * size);
+    if (BINARYSERIALIZER_UNLIKELY(!aux)) {
+      LOG_ERR("Cannot allocate [bytes:%zu]\n", sizeof(StatData) * size);
+      LOG("[SortDumpByKeys end]_____________________\n");
+      return ERROR;
+    }
+  }
+  // Stable passes from the least significant key to the most significant
+  uint64_t phaseStart = BeginPhase();
+  for (size_t i = effectiveCount; i > 0; --i) {
+    const SortKeySpec *key = effective + i - 1;
+    SortByField(data, size, aux, key->field,
+                SortMask(key->field, key->direction));
+  }
+  EndPhase(INSTRUMENTATION_PHASE_SORT, phaseStart);
+  FreeMemory(aux);
+  LOG("[SortDumpByKeys end]_____________________\n");
+  return SUCCESS;
+}
+
+/**
+ * @struct ParallelRadixSort
+ * @brief Состояние параллельной LSD сортировки, общее для задач пула
+ *
+ * Массив делится на blocksCount непрерывных блоков. На каждом проходе блоки
+ * независимо строят гистограммы текущего байта, затем смещения вычисляются
+ * в порядке "значение байта, затем номер блока", что сохраняет устойчивость,
+ * и блоки параллельно раскладывают записи в dst.
+ */
+typedef struct ParallelRadixSort {
+  const StatData *src;
+  StatData *dst;
+  size_t size;
+  size_t blocksCount;
+  SortField field;
+  uint64_t mask;
+  unsigned shift;
+  size_t (*byteHistograms)[MAX_KEY_BYTES][RADIX_BUCKETS];
+  size_t (*histograms)[RADIX_BUCKETS];
+} ParallelRadixSort;
+
+static size_t BlockBegin(const ParallelRadixSort *sort, size_t block) {
+  return sort->size / sort->blocksCount * block +
+         sort->size % sort->blocksCount * block / sort->blocksCount;
+}
+
+static void CountAllBytesTask(void *args, size_t block) {
+  ParallelRadixSort *sort = args;
+  size_t(*histograms)[RADIX_BUCKETS] = sort->byteHistograms[block];
+  memset(histograms, 0, sizeof(sort->byteHistograms[block]));
+  size_t end = BlockBegin(sort, block + 1);
+  // Separate loops let the compiler inline a single key transform in each
+  if (sort->field == SORT_FIELD_ID) {
+    for (size_t i = BlockBegin(sort, block); i < end; ++i) {
+      uint64_t key = IdSortKey(sort->src + i) ^ sort->mask;
+      for (unsigned byte = 0; byte < 8; ++byte) {
+        histograms[byte][(key >> (8 * byte)) & 0xff]++;
+      }
+    }
+  } else {
+    for (size_t i = BlockBegin(sort, block); i < end; ++i) {
+      uint64_t key = CostSortKey(sort->src + i) ^ sort->mask;
+      for (unsigned byte = 0; byte < 4; ++byte) {
+        histograms[byte][(key >> (8 * byte)) & 0xff]++;
+      }
+    }
+  }
+}
+
+static void CountByteTask(void *args, size_t block) {
+  ParallelRadixSort *sort = args;
+  size_t *histogram = sort->histograms[block];
+  memset(histogram, 0, sizeof(sort->histograms[block]));
+  size_t end = BlockBegin(sort, block + 1);
+  if (sort->field == SORT_FIELD_ID) {
+    for (size_t i = BlockBegin(sort, block); i < end; ++i) {
+      uint64_t key = IdSortKey(sort->src + i) ^ sort->mask;
+      histogram[(key >> sort->shift) & 0xff]++;
+    }
+  } else {
+    for (size_t i = BlockBegin(sort, block); i < end; ++i) {
+      uint64_t key = CostSortKey(sort->src + i) ^ sort->mask;
+      histogram[(key >> sort->shift) & 0xff]++;
+    }
+  }
+}
+
+static void ScatterTask(void *args, size_t block) {
+  ParallelRadixSort *sort = args;
+  size_t *offsets = sort->histograms[block];
+  size_t end = BlockBegin(sort, block + 1);
+  const StatData *src = sort->src;
+  StatData *dst = sort->dst;
+  if (sort->field == SORT_FIELD_ID) {
+    for (size_t i = BlockBegin(sort, block); i < end; ++i) {
+      uint64_t key = IdSortKey(src + i) ^ sort->mask;
+      dst[offsets[(key >> sort->shift) & 0xff]++] = src[i];
+    }
+  } else {
+    for (size_t i = BlockBegin(sort, block); i < end; ++i) {
+      uint64_t key = CostSortKey(src + i) ^ sort->mask;
+      dst[offsets[(key >> sort->shift) & 0xff]++] = src[i];
+    }
+  }
+}
+
+static void CopyTask(void *args, size_t block) {
+  ParallelRadixSort *sort = args;
+  size_t begin = BlockBegin(sort, block);
+  size_t end = BlockBegin(sort, block + 1);
+  memcpy(sort->dst + begin, sort->src + begin,
+         sizeof(StatData) * (end - begin));
+}
+
+static void RunParallelRadixSort(ThreadPool *pool, ParallelRadixSort *sort,
+                                 StatData *data, StatData *aux) {
+  unsigned keyBytes = sort->field == SORT_FIELD_ID ? 8 : 4;
+  sort->src = data;
+  RunThreadPool(pool, &CountAllBytesTask, sort, sort->blocksCount);
+
+  StatData *src = data;
+  StatData *dst = aux;
+  int firstPass = 1;
+  for (unsigned byte = 0; byte < keyBytes; ++byte) {
+    size_t total[RADIX_BUCKETS] = {0};
+    for (size_t block = 0; block < sort->blocksCount; ++block) {
+      for (size_t digit = 0; digit < RADIX_BUCKETS; ++digit) {
+        total[digit] += sort->byteHistograms[block][byte][digit];
+      }
+    }
+    if (total[(SortKey(data, sort->field) ^ sort->mask) >> (8 * byte) &
+              0xff] == sort->size) {
+      continue;
+    }
+
+    sort->src = src;
+    sort->dst = dst;
+    sort->shift = 8 * byte;
+    if (firstPass) {
+      // Per-block histograms of the unpermuted input are already known
+      for (size_t block = 0; block < sort->blocksCount; ++block) {
+        memcpy(sort->histograms[block], sort->byteHistograms[block][byte],
+               sizeof(sort->histograms[block]));
+      }
+      firstPass = 0;
+    } else {
+      RunThreadPool(pool, &CountByteTask, sort, sort->blocksCount);
+    }
+
+    // Digit-major, block-minor offsets keep equal keys in input order
+    size_t offset = 0;
+    for (size_t digit = 0; digit < RADIX_BUCKETS; ++digit) {
+      for (size_t block = 0; block < sort->blocksCount; ++block) {
+        size_t count = sort->histograms[block][digit];
+        sort->histograms[block][digit] = offset;
+        offset += count;
+      }
+    }
+    RunThreadPool(pool, &ScatterTask, sort, sort->blocksCount);
+
+    StatData *tmp = src;
+    src = dst;
+    dst = tmp;
+  }
+
+  if (src != data) {
+    sort->src = src;
+    sort->dst = data;
+    RunThreadPool(pool, &CopyTask, sort, sort->blocksCount);
+  }
+}
+
+Status SortDumpByKeyParallel(StatData *data, size_t size, SortField field,
+                             SortDirection direction, size_t threadsCount) {
+  LOG("[SortDumpByKeyParallel begin]_____________________\n");
+  if (threadsCount == 0) {
+    threadsCount = HardwareThreadsCount();
+  }
+  if (threadsCount == 1 || size < PARALLEL_RADIX_MIN_SIZE) {
+    Status status = SortDumpByKey(data, size, field, direction);
+    LOG("[SortDumpByKeyParallel end]_____________________\n");
+    return status;
+  }
+  if (BINARYSERIALIZER_UNLIKELY(!data || !IsValidSortKey(field, direction))) {
+    LOG_ERR("Invalid data or sort key\n");
+    LOG("[SortDumpByKeyParallel end]_____________________\n");
+    return INVALID_POINTER_OR_SIZE;
+  }
+
+  ThreadPool pool;
+  if (BINARYSERIALIZER_UNLIKELY(!InitThreadPool(&pool, threadsCount))) {
+    LOG_ERR("Cannot start [threads:%zu]\n", threadsCount);
+    LOG("[SortDumpByKeyParallel end]_____________________\n");
+    return ERROR;
+  }
+
+  ParallelRadixSort sort;
+  sort.size = size;
+  sort.blocksCount = pool.threadsCount;
+  sort.field = field;
+  sort.mask = SortMask(field, direction);
+  sort.shift = 0;
+  sort.byteHistograms =
+      AllocateMemory(sizeof(*sort.byteHistograms) * sort.blocksCount);
+  sort.histograms = AllocateMemory(sizeof(*sort.histograms) * sort.blocksCount);
+  StatData *aux = AllocateMemory(sizeof(StatData) * size);
+
+  Status status = SUCCESS;
+  if (BINARYSERIALIZER_UNLIKELY(!sort.byteHistograms || !sort.histograms ||
+                                !aux)) {
+    LOG_ERR("Cannot allocate sort buffers for [size:%zu]\n", size);
+    status = ERROR;
+  } else {
+    uint64_t phaseStart = BeginPhase();
+    RunParallelRadixSort(&pool, &sort, data, aux);
+    EndPhase(INSTRUMENTATION_PHASE_SORT, phaseStart);
+  }
+
+  FreeMemory(aux);
+  FreeMemory(sort.histograms);
+  FreeMemory(sort.byteHistograms);
+  ClearThreadPool(&pool);
+  LOG("[SortDumpByKeyParallel end]_____________________\n");
+  return status;
+}
+
+/**
+ * @struct TopKEntry
+ * @brief Кандидат в top-K: преобразованный ключ и исходная позиция
+ *
+ * Сравнение по паре (key, index) дает тот же порядок, что и устойчивая
+ * сортировка, поэтому равные ключи упорядочиваются детерминированно.
+ */
+typedef struct TopKEntry {
+  uint64_t key;
+  size_t index;
+} TopKEntry;
+
+static inline int TopKEntryLess(const TopKEntry *lhs, const TopKEntry *rhs) {
+  return lhs->key < rhs->key ||
+         (lhs->key == rhs->key && lhs->index < rhs->index);
+}
+
+// Max-heap by (key, index): the root is the worst of the kept candidates
+static void SiftDown(TopKEntry *heap, size_t size, size_t root) {
+  TopKEntry value = heap[root];
+  for (;;) {
+    size_t child = 2 * root + 1;
+    if (child >= size) {
+      break;
+    }
+    if (child + 1 < size && TopKEntryLess(heap + child, heap + child + 1)) {
+      ++child;
+    }
+    if (!TopKEntryLess(&value, heap + child)) {
+      break;
+    }
+    heap[root] = heap[child];
+    root = child;
+  }
+  heap[root] = value;
+}
+
+static void SiftUp(TopKEntry *heap, size_t index) {
+  TopKEntry value = heap[index];
+  while (index > 0) {
+    size_t parent = (index - 1) / 2;
+    if (!TopKEntryLess(heap + parent, &value)) {
+      break;
+    }
+    heap[index] = heap[parent];
+    index = parent;
+  }
+  heap[index] = value;
+}
+
+Status TopKByKey(const StatData *data, size_t size, SortField field,
+                 SortDirection direction, StatData *result, size_t k) {
+  LOG("[TopKByKey begin]_____________________\n");
+  if (BINARYSERIALIZER_UNLIKELY(!data || size == 0 || !result || k == 0 ||
+                                !IsValidSortKey(field, direction))) {
+    LOG_ERR("Invalid data, size, result or sort key\n");
+    LOG("[TopKByKey end]_____________________\n");
+    return INVALID_POINTER_OR_SIZE;
+  }
+  if (k > size) {
+    k = size;
+  }
+  uint64_t mask = SortMask(field, direction);
+
+  TopKEntry *heap = AllocateMemory(sizeof(TopKEntry) * k);
+  if (BINARYSERIALIZER_UNLIKELY(!heap)) {
+    LOG_ERR("Cannot allocate [bytes:%zu]\n", sizeof(TopKEntry) * k);
+    LOG("[TopKByKey end]_____________________\n");
+    return ERROR;
+  }
+
+  uint64_t phaseStart = BeginPhase();
+  size_t heapSize = 0;
+  for (size_t i = 0; i < size; ++i) {
+    TopKEntry entry = {SortKey(data + i, field) ^ mask, i};
+    if (heapSize < k) {
+      heap[heapSize] = entry;
+      SiftUp(heap, heapSize++);
+    } else if (entry.key < heap[0].key) {
+      // Later records never win a tie against kept ones, so only a strictly
+      // smaller key can replace the root
+      heap[0] = entry;
+      SiftDown(heap, k, 0);
+    }
+  }
+
+  // Heap sort in place: the largest entry goes to the end on every step
+  for (size_t end = k; end > 1; --end) {
+    TopKEntry tmp = heap[0];
+    heap[0] = heap[end - 1];
+    heap[end - 1] = tmp;
+    SiftDown(heap, end - 1, 0);
+  }
+  for (size_t i = 0; i < k; ++i) {
+    result[i] = data[heap[i].index];
+  }
+  EndPhase(INSTRUMENTATION_PHASE_SORT, phaseStart);
+  FreeMemory(heap);
+  LOG("[TopKByKey end]_____________________\n");
+  return SUCCESS;
+}
+
+/**
+ * @struct ArgSortEntry
+ * @brief Преобразованный ключ id и индекс записи во входном массиве
+ *
+ * 16 байт вместо 24 байт StatData: проходы radix сортировки перемещают
+ * только пары, сами записи не копируются. 32-битный ключ cost упаковывается
+ * вместе с индексом в одно 64-битное слово (ключ в старших байтах).
+ */
+typedef struct ArgSortEntry {
+  uint64_t key;
+  uint32_t index;
+} ArgSortEntry;
+
+/**
+ * @brief Генерирует LSD radix сортировку массива TYPE по байтам ключа
+ * [FIRST_BYTE, FIRST_BYTE + KEY_BYTES)
+ */
+#define DEFINE_ARG_RADIX_SORT(Name, TYPE, KEY, FIRST_BYTE, KEY_BYTES)          \
+  static void Name(TYPE *entries, TYPE *aux, size_t size) {                    \
+    size_t histograms[KEY_BYTES][RADIX_BUCKETS];                               \
+    memset(histograms, 0, sizeof(histograms));                                 \
+    for (size_t i = 0; i < size; ++i) {                                        \
+      uint64_t key = KEY(entries[i]);                                          \
+      for (unsigned byte = 0; byte < (KEY_BYTES); ++byte) {                    \
+        histograms[byte][(key >> (8 * (byte + (FIRST_BYTE)))) & 0xff]++;       \
+      }                                                                        \
+    }                                                                          \
+                                                                               \
+    TYPE *src = entries;                                                       \
+    TYPE *dst = aux;                                                           \
+    for (unsigned byte = 0; byte < (KEY_BYTES); ++byte) {                      \
+      size_t *histogram = histograms[byte];                                    \
+      unsigned shift = 8 * (byte + (FIRST_BYTE));                              \
+      if (histogram[(KEY(src[0]) >> shift) & 0xff] == size) {                 \
+        continue;                                                              \
+      }                                                                        \
+      size_t offset = 0;                                                       \
+      for (size_t digit = 0; digit < RADIX_BUCKETS; ++digit) {                 \
+        size_t count = histogram[digit];                                       \
+        histogram[digit] = offset;                                             \
+        offset += count;                                                       \
+      }                                                                        \
+      for (size_t i = 0; i < size; ++i) {                                      \
+        dst[histogram[(KEY(src[i]) >> shift) & 0xff]++] = src[i];              \
+      }                                                                        \
+      TYPE *tmp = src;                                                         \
+      src = dst;                                                               \
+      dst = tmp;                                                               \
+    }                                                                          \
+    if (src != entries) {                                                      \
+      memcpy(entries, src, sizeof(TYPE) * size);                               \
+    }                                                                          \
+  }
+
+#define ENTRY_KEY(entry) ((entry).key)
+#define PACKED_KEY(entry) (entry)
+
+DEFINE_ARG_RADIX_SORT(RadixArgSortById, ArgSortEntry, ENTRY_KEY, 0, 8)
+DEFINE_ARG_RADIX_SORT(RadixArgSortByCost, uint64_t, PACKED_KEY, 4, 4)
+
+static void InsertionArgSortById(ArgSortEntry *entries, size_t size) {
+  for (size_t i = 1; i < size; ++i) {
+    ArgSortEntry value = entries[i];
+    size_t j = i;
+    for (; j > 0 && entries[j - 1].key > value.key; --j) {
+      entries[j] = entries[j - 1];
+    }
+    entries[j] = value;
+  }
+}
+
+static Status ArgSortById(const StatData *data, size_t size, uint64_t mask,
+                          uint32_t *permutation) {
+  size_t buffersCount = size < RADIX_MIN_SIZE ? 1 : 2;
+  ArgSortEntry *entries =
+      AllocateMemory(sizeof(ArgSortEntry) * size * buffersCount);
+  if (BINARYSERIALIZER_UNLIKELY(!entries)) {
+    LOG_ERR("Cannot allocate [bytes:%zu]\n",
+            sizeof(ArgSortEntry) * size * buffersCount);
+    return ERROR;
+  }
+  for (size_t i = 0; i < size; ++i) {
+    entries[i].key = IdSortKey(data + i) ^ mask;
+    entries[i].index = (uint32_t)i;
+  }
+  if (size < RADIX_MIN_SIZE) {
+    InsertionArgSortById(entries, size);
+  } else {
+    RadixArgSortById(entries, entries + size, size);
+  }
+  for (size_t i = 0; i < size; ++i) {
+    permutation[i] = entries[i].index;
+  }
+  FreeMemory(entries);
+  return SUCCESS;
+}
+
+static Status ArgSortByCost(const StatData *data, size_t size, uint64_t mask,
+                            uint32_t *permutation) {
+  // Packed words compare as (key, index), so the small path may compare them
+  // directly and stays stable
+  size_t buffersCount = size < RADIX_MIN_SIZE ? 1 : 2;
+  uint64_t *entries = AllocateMemory(sizeof(uint64_t) * size * buffersCount);
+  if (BINARYSERIALIZER_UNLIKELY(!entries)) {
+    LOG_ERR("Cannot allocate [bytes:%zu]\n",
+            sizeof(uint64_t) * size * buffersCount);
+    return ERROR;
+  }
+  for (size_t i = 0; i < size; ++i) {
+    entries[i] = (CostSortKey(data + i) ^ mask) << 32 | i;
+  }
+  if (size < RADIX_MIN_SIZE) {
+    for (size_t i = 1; i < size; ++i) {
+      uint64_t value = entries[i];
+      size_t j = i;
+      for (; j > 0 && entries[j - 1] > value; --j) {
+        entries[j] = entries[j - 1];
+      }
+      entries[j] = value;
+    }
+  } else {
+    RadixArgSortByCost(entries, entries + size, size);
+  }
+  for (size_t i = 0; i < size; ++i) {
+    permutation[i] = (uint32_t)entries[i];
+  }
+  FreeMemory(entries);
+  return SUCCESS;
+}
+
+Status ArgSortByKey(const StatData *data, size_t size, SortField field,
+                    SortDirection direction, uint32_t *permutation) {
+  LOG("[ArgSortByKey begin]_____________________\n");
+  if (BINARYSERIALIZER_UNLIKELY(!data || size == 0 || size > UINT32_MAX ||
+                                !permutation ||
+                                !IsValidSortKey(field, direction))) {
+    LOG_ERR("Invalid data, size, permutation or sort key\n");
+    LOG("[ArgSortByKey end]_____________________\n");
+    return INVALID_POINTER_OR_SIZE;
+  }
+  uint64_t mask = SortMask(field, direction);
+  uint64_t phaseStart = BeginPhase();
+  Status status = field == SORT_FIELD_ID
+                      ? ArgSortById(data, size, mask, permutation)
+                      : ArgSortByCost(data, size, mask, permutation);
+  EndPhase(INSTRUMENTATION_PHASE_SORT, phaseStart);
+  LOG("[ArgSortByKey end]_____________________\n");
+  return status;
+}
+
+Status GatherByPermutation(const StatData *data, const uint32_t *permutation,
+                           size_t size, StatData *result) {
+  LOG("[GatherByPermutation begin]_____________________\n");
+  if (BINARYSERIALIZER_UNLIKELY(!data || !permutation || size == 0 ||
+                                !result || data == result)) {
+    LOG_ERR("Invalid data, permutation, size or result\n");
+    LOG("[GatherByPermutation end]_____________________\n");
+    return INVALID_POINTER_OR_SIZE;
+  }
+  for (size_t i = 0; i < size; ++i) {
+    result[i] = data[permutation[i]];
+  }
+  LOG("[GatherByPermutation end]_____________________\n");
+  return SUCCESS;
+}
@@ -1,6 +1,8 @@
 #include "BinarySerializer/tableView.h"
 
 #include "BinarySerializer/config.h"
+#include "internal/allocation.h"
+#include "internal/instrumentation.h"
 #include <stdio.h>
 
 #if defined(BS_ENABLE_MI_MALLOC)
@@ -10,37 +12,145 @@
 #endif
 
 #include <assert.h>
+#include <errno.h>
+#include <stdint.h>
 #include <string.h>
+#include <unistd.h>
 
-static void PrintHeader(TableView *view) {
+static size_t RowSize(const TableView *view) {
   size_t count = 3;
-  LOG("Fields count:%zu\n", view->fieldsCount);
   for (size_t i = 0; i < view->fieldsCount; ++i) {
     count += view->fields[i].fieldSize;
   }
-  char *buff = malloc(count * sizeof(char));
-  if (BINARYSERIALIZER_UNLIKELY(!buff)) {
-    return;
+  return count;
+}
+
+/**
+ * @brief Гарантирует буфер на блок вывода и пять строк таблицы
+ *
+ * Между проверками заполнения добавляется не больше пяти строк: заголовок из
+ * трех строк, строка данных и разделитель.
+ */
+static int ReserveOutput(TableView *view, size_t rowSize) {
+  size_t capacity = BINARYSERIALIZER_TABLE_VIEW_BLOCK_SIZE + 5 * rowSize;
+  if (view->outputCapacity >= capacity) {
+    return 1;
+  }
+  char *output = ReallocateMemory(view->output, capacity);
+  if (BINARYSERIALIZER_UNLIKELY(!output)) {
+    return 0;
   }
-  memset(buff, '-', count);
-  buff[count - 1] = 0;
-  fprintf(stdout, "%s\n", buff);
-  memset(buff, ' ', count);
+  view->output = output;
+  view->outputCapacity = capacity;
+  return 1;
+}
+
+static int WriteToFd(void *context, const char *data, size_t size) {
+  int fd = (int)(intptr_t)context;
+  while (size != 0) {
+    ssize_t result = write(fd, data, size);
+    if (BINARYSERIALIZER_UNLIKELY(result < 0)) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG_ERR("Cannot write table [bytes:%zu] into [fd:%d]\n", size, fd);
+      return 0;
+    }
+    data += result;
+    size -= (size_t)result;
+  }
+  return 1;
+}
+
+static int WriteToFile(void *context, const char *data, size_t size) {
+  return fwrite(data, 1, size, (FILE *)context) == size;
+}
+
+static int WriteToMemory(void *context, const char *data, size_t size) {
+  TableMemoryBuffer *buffer = context;
+  if (buffer->capacity - buffer->size < size) {
+    size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+    while (capacity - buffer->size < size) {
+      capacity *= 2;
+    }
+    char *grown = ReallocateMemory(buffer->data, capacity);
+    if (BINARYSERIALIZER_UNLIKELY(!grown)) {
+      LOG_ERR("Cannot grow table buffer to [bytes:%zu]\n", capacity);
+      return 0;
+    }
+    buffer->data = grown;
+    buffer->capacity = capacity;
+  }
+  memcpy(buffer->data + buffer->size, data, size);
+  buffer->size += size;
+  return 1;
+}
+
+static int FlushOutput(const TableView *view, size_t size) {
+  return size == 0 || view->sink.write(view->sink.context, view->output, size);
+}
+
+/**
+ * @brief Строка из символа fill длиной rowSize с переводом строки
+ */
+static char *RenderLine(char *out, char fill, size_t rowSize) {
+  memset(out, fill, rowSize - 1);
+  out[rowSize - 1] = '\n';
+  return out + rowSize;
+}
+
+static char *RenderHeader(const TableView *view, char *out, size_t rowSize) {
+  LOG("Fields count:%zu\n", view->fieldsCount);
+  out = RenderLine(out, '-', rowSize);
+  memset(out, ' ', rowSize - 1);
   for (size_t i = 0, j = 0; i < view->fieldsCount; i++) {
-    buff[j] = '|';
+    out[j] = '|';
     if (view->fields[i].header && view->fields[i].header[0] != 0) {
-      memcpy(buff + j + 1, view->fields[i].header,
+      memcpy(out + j + 1, view->fields[i].header,
              view->fields[i].headerSize - 1);
     }
     j += view->fields[i].fieldSize;
   }
-  buff[count - 2] = '|';
-  buff[count - 1] = 0;
-  fprintf(stdout, "%s\n", buff);
-  memset(buff, '-', count);
-  buff[count - 1] = 0;
-  fprintf(stdout, "%s\n", buff);
-  free(buff);
+  out[rowSize - 2] = '|';
+  out[rowSize - 1] = '\n';
+  out += rowSize;
+  return RenderLine(out, '-', rowSize);
+}
+
+/**
+ * @brief Десятичная запись номера строки без snprintf
+ */
+static void RenderNumber(char *out, size_t number) {
+  char digits[24];
+  size_t count = 0;
+  do {
+    digits[count++] = (char)('0' + number % 10);
+    number /= 10;
+  } while (number != 0);
+  for (size_t i = 0; i < count; ++i) {
+    out[i] = digits[count - 1 - i];
+  }
+}
+
+static char *RenderRow(const TableView *view, char *out, size_t rowSize,
+                       size_t lineIndex) {
+  size_t elementIndex =
+      view->permutation ? view->permutation[lineIndex] : lineIndex;
+  const char *element = (const char *)view->data + elementIndex * view->memSize;
+  memset(out, ' ', rowSize - 1);
+  for (size_t i = 0, j = 0; i < view->fieldsCount; ++i) {
+    out[j] = '|';
+    if (view->fields[i].id == -1) {
+      RenderNumber(out + j + 1, lineIndex + 1);
+    } else {
+      view->formatter(view->fields[i].id, element, out + j + 1,
+                      rowSize - j - 1);
+    }
+    j += view->fields[i].fieldSize;
+  }
+  out[rowSize - 2] = '|';
+  out[rowSize - 1] = '\n';
+  return out + rowSize;
 }
 
 TablewViewStatus InitTableView(TableView *view, FormatterFunc formatter,
@@ -54,7 +164,11 @@ TablewViewStatus InitTableView(TableView *view, FormatterFunc formatter,
   view->formatter = NULL;
   view->data = NULL;
   view->memSize = 0;
-  view->fields = malloc(sizeof(Field) * fieldsCount);
+  view->permutation = NULL;
+  view->output = NULL;
+  view->outputCapacity = 0;
+  view->sink = FdTableSink(STDOUT_FILENO);
+  view->fields = AllocateMemory(sizeof(Field) * fieldsCount);
   if (view->fields) {
     view->fieldsCount = fieldsCount;
     view->formatter = formatter;
@@ -72,69 +186,163 @@ void ClearTableView(TableView *view) {
   view->fieldsCount = 0;
   view->data = NULL;
   view->dataSize = 0;
-  free(view->fields);
+  FreeMemory(view->fields);
   view->fields = NULL;
   view->formatter = NULL;
   view->memSize = 0;
+  view->permutation = NULL;
+  FreeMemory(view->output);
+  view->output = NULL;
+  view->outputCapacity = 0;
+}
+
+/**
+ * @brief Готовит буфер отрисовки перед выводом
+ */
+static int BeginOutput(TableView *view, size_t rowSize) {
+  if (BINARYSERIALIZER_UNLIKELY(!ReserveOutput(view, rowSize))) {
+    return 0;
+  }
+  // Earlier stdio output must reach the descriptor before the table
+  if (view->sink.write == &WriteToFd &&
+      (int)(intptr_t)view->sink.context == STDOUT_FILENO) {
+    fflush(stdout);
+  }
+  return 1;
+}
+
+/**
+ * @brief Отрисовывает строки [begin, end) с разделителями, сбрасывая
+ * заполненные блоки
+ *
+ * После строки lastLine разделитель не добавляется.
+ *
+ * @return Конец отрисованных байт в буфере или NULL при ошибке записи
+ */
+static char *RenderRows(TableView *view, char *out, size_t rowSize,
+                        size_t begin, size_t end, size_t lastLine) {
+  for (size_t lineIndex = begin; lineIndex < end; ++lineIndex) {
+    out = RenderRow(view, out, rowSize, lineIndex);
+    if (lineIndex != lastLine) {
+      out = RenderLine(out, '-', rowSize);
+    }
+    if ((size_t)(out - view->output) >=
+        BINARYSERIALIZER_TABLE_VIEW_BLOCK_SIZE) {
+      if (BINARYSERIALIZER_UNLIKELY(
+              !FlushOutput(view, (size_t)(out - view->output)))) {
+        return NULL;
+      }
+      out = view->output;
+    }
+  }
+  return out;
 }
 
 TablewViewStatus PrintTable(TableView *view, size_t linesCount) {
-  if (BINARYSERIALIZER_UNLIKELY(!view || linesCount == 0)) {
+  return PrintTablePage(view, 0, linesCount);
+}
+
+static TablewViewStatus PrintPage(TableView *view, size_t offset,
+                                  size_t limit) {
+  if (BINARYSERIALIZER_UNLIKELY(!view || limit == 0 ||
+                                (offset != 0 && offset >= view->dataSize))) {
     return TVS_ERROR;
   }
 
-  if (linesCount > view->dataSize) {
-    linesCount = view->dataSize;
+  size_t end = view->dataSize - offset < limit ? view->dataSize
+                                               : offset + limit;
+  size_t rowSize = RowSize(view);
+  if (BINARYSERIALIZER_UNLIKELY(!BeginOutput(view, rowSize))) {
+    return TVS_ERROR;
   }
 
-  size_t count = 3;
-  for (size_t i = 0; i < view->fieldsCount; ++i) {
-    count += view->fields[i].fieldSize;
+  char *out = RenderHeader(view, view->output, rowSize);
+  out = RenderRows(view, out, rowSize, offset, end, end - 1);
+  if (BINARYSERIALIZER_UNLIKELY(!out)) {
+    return TVS_ERROR;
   }
+  out = RenderLine(out, end < view->dataSize ? '.' : '-', rowSize);
+  if (BINARYSERIALIZER_UNLIKELY(
+          !FlushOutput(view, (size_t)(out - view->output)))) {
+    return TVS_ERROR;
+  }
+  return TVS_SUCCESS;
+}
+
+TablewViewStatus PrintTablePage(TableView *view, size_t offset,
+                                size_t limit) {
+  uint64_t phaseStart = BeginPhase();
+  TablewViewStatus status = PrintPage(view, offset, limit);
+  EndPhase(INSTRUMENTATION_PHASE_PRINT, phaseStart);
+  return status;
+}
 
-  char *separator = malloc(count);
-  if (BINARYSERIALIZER_UNLIKELY(!separator)) {
+TablewViewStatus PrintTableHeader(TableView *view) {
+  if (BINARYSERIALIZER_UNLIKELY(!view)) {
     return TVS_ERROR;
   }
-  char *buffer = malloc(count);
-  if (BINARYSERIALIZER_UNLIKELY(!buffer)) {
-    free(separator);
+  size_t rowSize = RowSize(view);
+  if (BINARYSERIALIZER_UNLIKELY(!BeginOutput(view, rowSize))) {
     return TVS_ERROR;
   }
-  memset(separator, '-', count);
-  separator[count - 1] = 0;
-
-  PrintHeader(view);
-  for (size_t dataIndex = 0; dataIndex < linesCount; ++dataIndex) {
-    memset(buffer, ' ', count);
-    buffer[count - 1] = 0;
-    for (size_t i = 0, j = 0; i < view->fieldsCount; ++i) {
-      buffer[j] = '|';
-      if (view->fields[i].id == -1) {
-        int bytes = snprintf(buffer + j + 1, count, "%zu", dataIndex + 1);
-        (buffer + j + 1)[bytes] = ' ';
-      } else {
-        view->formatter(view->fields[i].id,
-                        (const char *)view->data + dataIndex * view->memSize,
-                        buffer + j + 1, count);
-      }
-      j += view->fields[i].fieldSize;
-    }
-    buffer[count - 2] = '|';
-    fprintf(stdout, "%s\n", buffer);
-    if (dataIndex + 1 != linesCount) {
-      fprintf(stdout, "%s\n", separator);
-    }
+  char *out = RenderHeader(view, view->output, rowSize);
+  return FlushOutput(view, (size_t)(out - view->output)) ? TVS_SUCCESS
+                                                         : TVS_ERROR;
+}
+
+static TablewViewStatus PrintRange(TableView *view, size_t begin,
+                                   size_t end) {
+  if (BINARYSERIALIZER_UNLIKELY(!view || begin > end ||
+                                end > view->dataSize)) {
+    return TVS_ERROR;
+  }
+  size_t rowSize = RowSize(view);
+  if (BINARYSERIALIZER_UNLIKELY(!BeginOutput(view, rowSize))) {
+    return TVS_ERROR;
+  }
+  char *out = RenderRows(view, view->output, rowSize, begin, end, SIZE_MAX);
+  if (BINARYSERIALIZER_UNLIKELY(!out)) {
+    return TVS_ERROR;
   }
+  return FlushOutput(view, (size_t)(out - view->output)) ? TVS_SUCCESS
+                                                         : TVS_ERROR;
+}
+
+TablewViewStatus PrintTableRange(TableView *view, size_t begin, size_t end) {
+  uint64_t phaseStart = BeginPhase();
+  TablewViewStatus status = PrintRange(view, begin, end);
+  EndPhase(INSTRUMENTATION_PHASE_PRINT, phaseStart);
+  return status;
+}
 
-  if (linesCount < view->dataSize) {
-    memset(separator, '.', count);
+void SetTableViewSink(TableView *view, TableSink sink) {
+  if (BINARYSERIALIZER_UNLIKELY(!view || !sink.write)) {
+    return;
   }
+  view->sink = sink;
+}
 
-  separator[count - 1] = 0;
-  fprintf(stdout, "%s\n", separator);
+TableSink FdTableSink(int fd) {
+  TableSink sink = {&WriteToFd, (void *)(intptr_t)fd};
+  return sink;
+}
 
-  free(buffer);
-  free(separator);
-  return TVS_SUCCESS;
-}
\ No newline at end of file
+TableSink FileTableSink(FILE *file) {
+  TableSink sink = {&WriteToFile, file};
+  return sink;
+}
+
+TableSink MemoryTableSink(TableMemoryBuffer *buffer) {
+  TableSink sink = {&WriteToMemory, buffer};
+  return sink;
+}
+
+void ClearTableMemoryBuffer(TableMemoryBuffer *buffer) {
+  if (BINARYSERIALIZER_UNLIKELY(!buffer)) {
+    return;
+  }
+  FreeMemory(buffer->data);
+  buffer->data = NULL;
+  buffer->size = 0;
+  buffer->capacity = 0;
+}
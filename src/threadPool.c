@@ -0,0 +1,142 @@
+#include "internal/threadPool.h"
+#include "internal/allocation.h"
+
+#if defined(BS_ENABLE_MI_MALLOC)
+#include <mimalloc-override.h>
+#else
+#include <stdlib.h>
+#endif
+
+#include <unistd.h>
+
+size_t HardwareThreadsCount(void) {
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return count > 0 ? (size_t)count : 1;
+}
+
+static void DrainTasks(ThreadPool *pool, ThreadPoolTask task, void *args,
+                       size_t tasksCount) {
+  for (;;) {
+    size_t index = __atomic_fetch_add(&pool->nextTask, 1, __ATOMIC_RELAXED);
+    if (index >= tasksCount) {
+      return;
+    }
+    task(args, index);
+  }
+}
+
+static void *WorkerLoop(void *args) {
+  ThreadPool *pool = args;
+  unsigned long seenEpoch = 0;
+  pthread_mutex_lock(&pool->mutex);
+  for (;;) {
+    while (!pool->stop && pool->epoch == seenEpoch) {
+      pthread_cond_wait(&pool->wake, &pool->mutex);
+    }
+    if (pool->stop) {
+      break;
+    }
+    seenEpoch = pool->epoch;
+    ThreadPoolTask task = pool->task;
+    void *taskArgs = pool->args;
+    size_t tasksCount = pool->tasksCount;
+    pthread_mutex_unlock(&pool->mutex);
+
+    DrainTasks(pool, task, taskArgs, tasksCount);
+
+    pthread_mutex_lock(&pool->mutex);
+    if (++pool->finishedWorkers + 1 == pool->threadsCount) {
+      pthread_cond_signal(&pool->done);
+    }
+  }
+  pthread_mutex_unlock(&pool->mutex);
+  return NULL;
+}
+
+int InitThreadPool(ThreadPool *pool, size_t threadsCount) {
+  if (BINARYSERIALIZER_UNLIKELY(!pool)) {
+    return 0;
+  }
+  if (threadsCount == 0) {
+    threadsCount = HardwareThreadsCount();
+  }
+  pool->threads = NULL;
+  pool->threadsCount = 1;
+  pool->task = NULL;
+  pool->args = NULL;
+  pool->tasksCount = 0;
+  pool->nextTask = 0;
+  pool->finishedWorkers = 0;
+  pool->epoch = 0;
+  pool->stop = 0;
+  pthread_mutex_init(&pool->mutex, NULL);
+  pthread_cond_init(&pool->wake, NULL);
+  pthread_cond_init(&pool->done, NULL);
+  if (threadsCount == 1) {
+    return 1;
+  }
+
+  pool->threads = AllocateMemory(sizeof(pthread_t) * (threadsCount - 1));
+  if (BINARYSERIALIZER_UNLIKELY(!pool->threads)) {
+    ClearThreadPool(pool);
+    return 0;
+  }
+  for (size_t i = 0; i + 1 < threadsCount; ++i) {
+    if (BINARYSERIALIZER_UNLIKELY(
+            pthread_create(pool->threads + i, NULL, &WorkerLoop, pool) != 0)) {
+      LOG_ERR("Cannot create worker [index:%zu]\n", i);
+      ClearThreadPool(pool);
+      return 0;
+    }
+    pool->threadsCount++;
+  }
+  return 1;
+}
+
+void RunThreadPool(ThreadPool *pool, ThreadPoolTask task, void *args,
+                   size_t tasksCount) {
+  if (pool->threadsCount == 1 || tasksCount == 1) {
+    for (size_t i = 0; i < tasksCount; ++i) {
+      task(args, i);
+    }
+    return;
+  }
+  pthread_mutex_lock(&pool->mutex);
+  pool->task = task;
+  pool->args = args;
+  pool->tasksCount = tasksCount;
+  pool->nextTask = 0;
+  pool->finishedWorkers = 0;
+  pool->epoch++;
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->mutex);
+
+  DrainTasks(pool, task, args, tasksCount);
+
+  // Every worker checks in for every run, so none of them can pick up a task
+  // index of the next run with the arguments of this one
+  pthread_mutex_lock(&pool->mutex);
+  while (pool->finishedWorkers + 1 != pool->threadsCount) {
+    pthread_cond_wait(&pool->done, &pool->mutex);
+  }
+  pthread_mutex_unlock(&pool->mutex);
+}
+
+void ClearThreadPool(ThreadPool *pool) {
+  if (BINARYSERIALIZER_UNLIKELY(!pool)) {
+    return;
+  }
+  pthread_mutex_lock(&pool->mutex);
+  pool->stop = 1;
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->mutex);
+  for (size_t i = 0; i + 1 < pool->threadsCount; ++i) {
+    pthread_join(pool->threads[i], NULL);
+  }
+  FreeMemory(pool->threads);
+  pool->threads = NULL;
+  pool->threadsCount = 0;
+  pthread_cond_destroy(&pool->done);
+  pthread_cond_destroy(&pool->wake);
+  pthread_mutex_destroy(&pool->mutex);
+}
@@ -1,5 +1,15 @@
 #include "BinarySerializer/binarySerializer.h"
+#include "BinarySerializer/cellFormat.h"
+#include "BinarySerializer/dumpText.h"
+#include "BinarySerializer/executionContext.h"
+#include "BinarySerializer/externalMemory.h"
+#include "BinarySerializer/joinPipeline.h"
+#include "BinarySerializer/instrumentation.h"
+#include "BinarySerializer/mappedDump.h"
 #include "BinarySerializer/mergeHashTable.h"
+#include "BinarySerializer/mergeHashTable.hpp"
+#include "BinarySerializer/sortDump.h"
+#include "BinarySerializer/specializedHashTable.h"
 #include <gtest/gtest.h>
 
 #if defined(BS_ENABLE_MI_MALLOC)
@@ -8,8 +18,12 @@
 #include <stdlib.h>
 #endif
 
+#include <algorithm>
 #include <math.h>
 #include <stdio.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
 
 namespace {
 
@@ -111,13 +125,14 @@ static int SortStatDataFunc(const void *__restrict lhs,
                             const void *__restrict rhs) {
   const StatData *sdlhs = reinterpret_cast<const StatData *>(lhs);
   const StatData *sdrhs = reinterpret_cast<const StatData *>(rhs);
-  return sdlhs->cost > sdrhs->cost;
+  return (sdlhs->cost > sdrhs->cost) - (sdlhs->cost < sdrhs->cost);
 }
 
 int SortStatDataByID(const void *__restrict lhs, const void *__restrict rhs) {
   const StatData *dlhs = reinterpret_cast<const StatData *>(lhs);
   const StatData *drhs = reinterpret_cast<const StatData *>(rhs);
-  return dlhs->id < drhs->id;
+  // По убыванию id
+  return (dlhs->id < drhs->id) - (dlhs->id > drhs->id);
 }
 
 HashT HashFunctionBase(const StatData *data) { return data->id % 5; }
@@ -132,6 +147,53 @@ int StatDataCompareFunctionDefault(const StatData *__restrict lhs,
   return lhs->id == rhs->id;
 }
 
+int SortStatDataByIDAsc(const void *__restrict lhs,
+                        const void *__restrict rhs) {
+  const StatData *dlhs = reinterpret_cast<const StatData *>(lhs);
+  const StatData *drhs = reinterpret_cast<const StatData *>(rhs);
+  return (dlhs->id > drhs->id) - (dlhs->id < drhs->id);
+}
+
+void FillGeneratedData(StatData *data, size_t size, unsigned seed,
+                       long idsRange) {
+  for (size_t i = 0; i < size; ++i) {
+    seed = seed * 1103515245u + 12345u;
+    data[i].id = (long)(seed % (unsigned)idsRange);
+    data[i].count = (int)(i % 13);
+    data[i].cost = (float)(i % 7);
+    data[i].primary = (seed >> 7) & 1;
+    data[i].mode = (seed >> 9) & 7;
+  }
+}
+
+void CreateEmptyFile(const char *path) {
+  FILE *fd = fopen(path, "wb+");
+  ASSERT_NE(fd, nullptr);
+  fclose(fd);
+}
+
+std::string ReadWholeFile(const char *path) {
+  std::string text;
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    return text;
+  }
+  char block[1 << 16];
+  size_t read = 0;
+  while ((read = fread(block, 1, sizeof(block), file)) != 0) {
+    text.append(block, read);
+  }
+  fclose(file);
+  return text;
+}
+
+void WriteTextFile(const char *path, const std::string &text) {
+  FILE *file = fopen(path, "wb");
+  ASSERT_NE(file, nullptr);
+  ASSERT_EQ(fwrite(text.data(), 1, text.size(), file), text.size());
+  fclose(file);
+}
+
 void CheckEqualData(const StatData *d1, size_t size1, const StatData *d2,
                     size_t size2) {
   ASSERT_EQ(size1, size2);
@@ -694,4 +756,1837 @@ TEST(BaseAPI, TestCaseBase4Success) {
   remove(cases[i].firstStorePath);
   remove(cases[i].secondStorePath);
   remove(cases[i].resultPath);
-}
\ No newline at end of file
+}
+
+TEST(ExternalMemory, JoinDumpExternalInvalidArguments) {
+  EXPECT_EQ(JoinDumpExternal(nullptr, nullptr, "out.dat", nullptr,
+                             BINARYSERIALIZER_MIN_MEMORY_BUDGET),
+            INVALID_POINTER_OR_SIZE);
+  EXPECT_EQ(JoinDumpExternal("a.dat", "b.dat", nullptr, nullptr,
+                             BINARYSERIALIZER_MIN_MEMORY_BUDGET),
+            INVALID_POINTER_OR_SIZE);
+  EXPECT_EQ(JoinDumpExternal("a.dat", "b.dat", "out.dat", nullptr, 1024),
+            INVALID_POINTER_OR_SIZE);
+  EXPECT_EQ(JoinDumpExternal("not_existed_a.dat", nullptr, "out.dat", nullptr,
+                             BINARYSERIALIZER_MIN_MEMORY_BUDGET),
+            BAD_FILE);
+}
+
+TEST(ExternalMemory, JoinDumpExternalMatchesJoinDump) {
+  const size_t size = 60000;
+  std::vector<StatData> first(size), second(size);
+  FillGeneratedData(first.data(), size, 7, 40000);
+  FillGeneratedData(second.data(), size, 11, 40000);
+
+  const char *firstPath = "external_join_a.dat";
+  const char *secondPath = "external_join_b.dat";
+  const char *resultPath = "external_join_out.dat";
+  CreateEmptyFile(firstPath);
+  CreateEmptyFile(secondPath);
+  ASSERT_EQ(StoreDump(firstPath, first.data(), size), SUCCESS);
+  ASSERT_EQ(StoreDump(secondPath, second.data(), size), SUCCESS);
+
+  // Минимальный бюджет заставляет разбить вход на партиции
+  Status result = JoinDumpExternal(firstPath, secondPath, resultPath, nullptr,
+                                   BINARYSERIALIZER_MIN_MEMORY_BUDGET);
+  ASSERT_EQ(result, SUCCESS);
+
+  StatData *external = nullptr;
+  size_t externalSize = 0;
+  ASSERT_EQ(LoadDump(resultPath, &external, &externalSize), SUCCESS);
+
+  StatData *joined = nullptr;
+  size_t joinedSize = 0;
+  ASSERT_EQ(JoinDump(first.data(), size, second.data(), size, &joined,
+                     &joinedSize),
+            SUCCESS);
+
+  ASSERT_EQ(externalSize, joinedSize);
+  qsort(external, externalSize, sizeof(StatData), &SortStatDataByIDAsc);
+  qsort(joined, joinedSize, sizeof(StatData), &SortStatDataByIDAsc);
+  for (size_t i = 0; i < joinedSize; ++i) {
+    ASSERT_EQ(external[i].id, joined[i].id);
+    ASSERT_EQ(external[i].count, joined[i].count);
+    ASSERT_EQ(external[i].cost, joined[i].cost);
+    ASSERT_EQ(external[i].primary, joined[i].primary);
+    ASSERT_EQ(external[i].mode, joined[i].mode);
+  }
+
+  free(external);
+  free(joined);
+  remove(firstPath);
+  remove(secondPath);
+  remove(resultPath);
+}
+
+TEST(ExternalMemory, JoinDumpExternalResultMayBeInput) {
+  // Маленький вход объединяется в памяти, большой делится на партиции
+  for (size_t size : {(size_t)1000, (size_t)60000}) {
+    std::vector<StatData> first(size), second(size);
+    FillGeneratedData(first.data(), size, 23, size);
+    FillGeneratedData(second.data(), size, 29, size);
+    StatData *joined = nullptr;
+    size_t joinedSize = 0;
+    ASSERT_EQ(JoinDump(first.data(), size, second.data(), size, &joined,
+                       &joinedSize),
+              SUCCESS);
+    qsort(joined, joinedSize, sizeof(StatData), &SortStatDataByIDAsc);
+
+    const char *firstPath = "external_inplace_a.dat";
+    const char *secondPath = "external_inplace_b.dat";
+    for (int resultIsFirst : {1, 0}) {
+      CreateEmptyFile(firstPath);
+      CreateEmptyFile(secondPath);
+      ASSERT_EQ(StoreDump(firstPath, first.data(), size), SUCCESS);
+      ASSERT_EQ(StoreDump(secondPath, second.data(), size), SUCCESS);
+      const char *resultPath = resultIsFirst ? firstPath : secondPath;
+      ASSERT_EQ(JoinDumpExternal(firstPath, secondPath, resultPath, nullptr,
+                                 BINARYSERIALIZER_MIN_MEMORY_BUDGET),
+                SUCCESS)
+          << "size " << size << " resultIsFirst " << resultIsFirst;
+
+      StatData *external = nullptr;
+      size_t externalSize = 0;
+      ASSERT_EQ(LoadDump(resultPath, &external, &externalSize), SUCCESS);
+      ASSERT_EQ(externalSize, joinedSize);
+      qsort(external, externalSize, sizeof(StatData), &SortStatDataByIDAsc);
+      for (size_t i = 0; i < joinedSize; ++i) {
+        ASSERT_EQ(external[i].id, joined[i].id);
+        ASSERT_EQ(external[i].count, joined[i].count);
+        ASSERT_EQ(external[i].cost, joined[i].cost);
+        ASSERT_EQ(external[i].primary, joined[i].primary);
+        ASSERT_EQ(external[i].mode, joined[i].mode);
+      }
+      free(external);
+    }
+    free(joined);
+    remove(firstPath);
+    remove(secondPath);
+  }
+}
+
+TEST(ExternalMemory, JoinDumpExternalStaysWithinBudget) {
+  SetInstrumentationEnabled(1);
+  if (!IsInstrumentationEnabled()) {
+    GTEST_SKIP() << "built with BS_DISABLE_INSTRUMENTATION";
+  }
+  // Почти все id различны: каждая партиция заполняет таблицу до предела
+  const size_t size = 100000;
+  std::vector<StatData> first(size), second(size);
+  FillGeneratedData(first.data(), size, 17, 4 * size);
+  FillGeneratedData(second.data(), size, 19, 4 * size);
+  const char *firstPath = "external_budget_a.dat";
+  const char *secondPath = "external_budget_b.dat";
+  const char *resultPath = "external_budget_out.dat";
+  CreateEmptyFile(firstPath);
+  CreateEmptyFile(secondPath);
+  ASSERT_EQ(StoreDump(firstPath, first.data(), size), SUCCESS);
+  ASSERT_EQ(StoreDump(secondPath, second.data(), size), SUCCESS);
+
+  for (size_t budget : {(size_t)BINARYSERIALIZER_MIN_MEMORY_BUDGET,
+                        (size_t)BINARYSERIALIZER_MIN_MEMORY_BUDGET * 2}) {
+    ResetInstrumentationStats();
+    ASSERT_EQ(JoinDumpExternal(firstPath, secondPath, resultPath, nullptr,
+                               budget),
+              SUCCESS);
+    AllocationStats memory;
+    ASSERT_EQ(GetAllocationStats(&memory), SUCCESS);
+    EXPECT_EQ(memory.liveBytes, 0);
+    EXPECT_LE(memory.peakLiveBytes, (int64_t)budget) << "budget " << budget;
+  }
+
+  SetInstrumentationEnabled(0);
+  ResetInstrumentationStats();
+  remove(firstPath);
+  remove(secondPath);
+  remove(resultPath);
+}
+
+TEST(ExternalMemory, JoinDumpExternalFoldsHotIdWithinBudget) {
+  SetInstrumentationEnabled(1);
+  if (!IsInstrumentationEnabled()) {
+    GTEST_SKIP() << "built with BS_DISABLE_INSTRUMENTATION";
+  }
+  // Один горячий id во много раз больше partitionRecords: партицию с ним
+  // не разделить, но повторы сворачиваются в один узел
+  const long hotId = 42;
+  const size_t hotSize = 300000;
+  const size_t coldSize = 2000;
+  std::vector<StatData> first(hotSize), second(coldSize + 1);
+  for (size_t i = 0; i < hotSize; ++i) {
+    first[i] = {hotId, 1, 0.5f, 1, 1};
+  }
+  for (size_t i = 0; i < coldSize; ++i) {
+    second[i] = {(long)(1000 + i), 1, 1.0f, 1, 2};
+  }
+  second[coldSize] = {hotId, 1, 0.5f, 0, 3};
+  const char *firstPath = "external_hot_a.dat";
+  const char *secondPath = "external_hot_b.dat";
+  const char *resultPath = "external_hot_out.dat";
+  CreateEmptyFile(firstPath);
+  CreateEmptyFile(secondPath);
+  ASSERT_EQ(StoreDump(firstPath, first.data(), hotSize), SUCCESS);
+  ASSERT_EQ(StoreDump(secondPath, second.data(), coldSize + 1), SUCCESS);
+
+  const size_t budget = BINARYSERIALIZER_MIN_MEMORY_BUDGET;
+  ResetInstrumentationStats();
+  ASSERT_EQ(
+      JoinDumpExternal(firstPath, secondPath, resultPath, nullptr, budget),
+      SUCCESS);
+  AllocationStats memory;
+  ASSERT_EQ(GetAllocationStats(&memory), SUCCESS);
+  EXPECT_EQ(memory.liveBytes, 0);
+  EXPECT_LE(memory.peakLiveBytes, (int64_t)budget);
+  SetInstrumentationEnabled(0);
+  ResetInstrumentationStats();
+
+  StatData *joined = nullptr;
+  size_t joinedSize = 0;
+  ASSERT_EQ(LoadDump(resultPath, &joined, &joinedSize), SUCCESS);
+  ASSERT_EQ(joinedSize, coldSize + 1);
+  qsort(joined, joinedSize, sizeof(StatData), &SortStatDataByIDAsc);
+  EXPECT_EQ(joined[0].id, hotId);
+  EXPECT_EQ(joined[0].count, (int)hotSize + 1);
+  EXPECT_FLOAT_EQ(joined[0].cost, 0.5f * (hotSize + 1));
+  EXPECT_EQ(joined[0].primary, 0u);
+  EXPECT_EQ(joined[0].mode, 3u);
+  for (size_t i = 0; i < coldSize; ++i) {
+    ASSERT_EQ(joined[i + 1].id, (long)(1000 + i));
+    ASSERT_EQ(joined[i + 1].count, 1);
+  }
+
+  free(joined);
+  remove(firstPath);
+  remove(secondPath);
+  remove(resultPath);
+}
+
+static void CollectSortProgress(const ExternalSortProgress *progress,
+                                void *args) {
+  static_cast<std::vector<ExternalSortProgress> *>(args)->push_back(*progress);
+}
+
+TEST(ExternalMemory, SortDumpExternalInvalidArguments) {
+  EXPECT_EQ(SortDumpExternal(nullptr, "out.dat", nullptr,
+                             BINARYSERIALIZER_MIN_MEMORY_BUDGET, SORT_FIELD_ID,
+                             SORT_ASC, nullptr, nullptr),
+            INVALID_POINTER_OR_SIZE);
+  EXPECT_EQ(SortDumpExternal("a.dat", "out.dat", nullptr, 1024, SORT_FIELD_ID,
+                             SORT_ASC, nullptr, nullptr),
+            INVALID_POINTER_OR_SIZE);
+  EXPECT_EQ(SortDumpExternal("a.dat", "out.dat", nullptr,
+                             BINARYSERIALIZER_MIN_MEMORY_BUDGET,
+                             (SortField)5, SORT_ASC, nullptr, nullptr),
+            INVALID_POINTER_OR_SIZE);
+  EXPECT_EQ(SortDumpExternal("not_existed_a.dat", "out.dat", nullptr,
+                             BINARYSERIALIZER_MIN_MEMORY_BUDGET, SORT_FIELD_ID,
+                             SORT_ASC, nullptr, nullptr),
+            BAD_FILE);
+}
+
+TEST(ExternalMemory, SortDumpExternalMatchesSortDumpByKey) {
+  // При минимальном бюджете это ~20 серий и два прохода слияния
+  const size_t size = 400000;
+  std::vector<StatData> data(size);
+  FillGeneratedData(data.data(), size, 13, 100000);
+  for (size_t i = 0; i < size; ++i) {
+    data[i].cost = (float)(i % 1000);
+    data[i].count = (int)i;
+  }
+  const char *inputPath = "external_sort_in.dat";
+  const char *resultPath = "external_sort_out.dat";
+  CreateEmptyFile(inputPath);
+  ASSERT_EQ(StoreDump(inputPath, data.data(), size), SUCCESS);
+
+  for (SortField field : {SORT_FIELD_ID, SORT_FIELD_COST}) {
+    SortDirection direction = field == SORT_FIELD_ID ? SORT_DESC : SORT_ASC;
+    std::vector<ExternalSortProgress> progress;
+    ASSERT_EQ(SortDumpExternal(inputPath, resultPath, nullptr,
+                               BINARYSERIALIZER_MIN_MEMORY_BUDGET, field,
+                               direction, &CollectSortProgress, &progress),
+              SUCCESS);
+
+    ASSERT_FALSE(progress.empty());
+    const ExternalSortProgress &done = progress.back();
+    ASSERT_EQ(done.phase, EXTERNAL_SORT_DONE);
+    ASSERT_EQ(done.totalRecords, size);
+    ASSERT_EQ(done.sortedRecords, size);
+    ASSERT_GT(done.runsCount, 1u);
+    ASSERT_GE(done.mergePasses, 2u);
+    ASSERT_GE(done.bytesRead, sizeof(StatData) * size);
+    ASSERT_GE(done.bytesWritten, sizeof(StatData) * size);
+
+    std::vector<StatData> expected = data;
+    ASSERT_EQ(SortDumpByKey(expected.data(), size, field, direction),
+              SUCCESS);
+    StatData *sorted = nullptr;
+    size_t sortedSize = 0;
+    ASSERT_EQ(LoadDump(resultPath, &sorted, &sortedSize), SUCCESS);
+    ASSERT_EQ(sortedSize, size);
+    for (size_t i = 0; i < size; ++i) {
+      ASSERT_EQ(sorted[i].count, expected[i].count);
+    }
+    free(sorted);
+  }
+
+  // Небольшой дамп сортируется одной серией на месте
+  ASSERT_EQ(StoreDump(inputPath, data.data(), 1000), SUCCESS);
+  ASSERT_EQ(SortDumpExternal(inputPath, inputPath, nullptr,
+                             BINARYSERIALIZER_MIN_MEMORY_BUDGET, SORT_FIELD_ID,
+                             SORT_ASC, nullptr, nullptr),
+            SUCCESS);
+  StatData *sorted = nullptr;
+  size_t sortedSize = 0;
+  ASSERT_EQ(LoadDump(inputPath, &sorted, &sortedSize), SUCCESS);
+  ASSERT_EQ(sortedSize, 1000u);
+  for (size_t i = 1; i < sortedSize; ++i) {
+    ASSERT_LE(sorted[i - 1].id, sorted[i].id);
+  }
+  free(sorted);
+
+  remove(inputPath);
+  remove(resultPath);
+}
+
+TEST(ExternalMemory, SortDumpExternalStaysWithinBudget) {
+  SetInstrumentationEnabled(1);
+  if (!IsInstrumentationEnabled()) {
+    GTEST_SKIP() << "built with BS_DISABLE_INSTRUMENTATION";
+  }
+  const size_t size = 300000;
+  std::vector<StatData> data(size);
+  FillGeneratedData(data.data(), size, 23, size);
+  const char *inputPath = "external_sort_budget_in.dat";
+  const char *resultPath = "external_sort_budget_out.dat";
+  CreateEmptyFile(inputPath);
+  ASSERT_EQ(StoreDump(inputPath, data.data(), size), SUCCESS);
+
+  // Серии с вспомогательным буфером radix и слияние почти заполняют бюджет
+  for (size_t budget : {(size_t)BINARYSERIALIZER_MIN_MEMORY_BUDGET,
+                        (size_t)BINARYSERIALIZER_MIN_MEMORY_BUDGET * 2,
+                        (size_t)BINARYSERIALIZER_MIN_MEMORY_BUDGET * 8}) {
+    ResetInstrumentationStats();
+    ASSERT_EQ(SortDumpExternal(inputPath, resultPath, nullptr, budget,
+                               SORT_FIELD_COST, SORT_ASC, nullptr, nullptr),
+              SUCCESS);
+    AllocationStats memory;
+    ASSERT_EQ(GetAllocationStats(&memory), SUCCESS);
+    EXPECT_EQ(memory.liveBytes, 0);
+    EXPECT_LE(memory.peakLiveBytes, (int64_t)budget) << "budget " << budget;
+  }
+
+  SetInstrumentationEnabled(0);
+  ResetInstrumentationStats();
+  remove(inputPath);
+  remove(resultPath);
+}
+
+static size_t CountProcessMappings() {
+  std::string maps = ReadWholeFile("/proc/self/maps");
+  return (size_t)std::count(maps.begin(), maps.end(), '\n');
+}
+
+TEST(BaseAPI, LoadDumpReleasesIntermediateMappings) {
+  const size_t size = 10000;
+  std::vector<StatData> data(size);
+  FillGeneratedData(data.data(), size, 19, 1 << 20);
+  const char *path = "load_mappings.dat";
+  CreateEmptyFile(path);
+  ASSERT_EQ(StoreDump(path, data.data(), size), SUCCESS);
+
+  StatData *loaded = nullptr;
+  size_t loadedSize = 0;
+  const size_t before = CountProcessMappings();
+  ASSERT_EQ(LoadDump(path, &loaded, &loadedSize), SUCCESS);
+  // Сам результат может занять отдельное отображение аллокатора, но не
+  // по одному на каждую из size / BINARYSERIALIZER_BUTCHE_SIZE порций
+  EXPECT_LE(CountProcessMappings(), before + 2);
+  CheckEqualData(loaded, loadedSize, data.data(), size);
+  free(loaded);
+  remove(path);
+}
+
+TEST(MappedDump, MapAndResize) {
+  const char *path = "mapped_dump.dat";
+  CreateEmptyFile(path);
+  MappedDump dump;
+  ASSERT_EQ(MapDump(path, 1, &dump), SUCCESS);
+  ASSERT_EQ(dump.size, 0);
+  ASSERT_EQ(dump.data, nullptr);
+  ASSERT_EQ(ResizeMappedDump(&dump, 3), SUCCESS);
+  ASSERT_EQ(dump.size, 3);
+  for (size_t i = 0; i < dump.size; ++i) {
+    dump.data[i] = testCase1[i % std::size(testCase1)];
+  }
+  ASSERT_EQ(UnmapDump(&dump), SUCCESS);
+
+  ASSERT_EQ(MapDump(path, 0, &dump), SUCCESS);
+  ASSERT_EQ(dump.size, 3);
+  ASSERT_EQ(dump.data[2].id, testCase1[0].id);
+  ASSERT_EQ(ResizeMappedDump(&dump, 1), INVALID_POINTER_OR_SIZE);
+  ASSERT_EQ(UnmapDump(&dump), SUCCESS);
+
+  ASSERT_EQ(MapDump(nullptr, 0, &dump), INVALID_POINTER_OR_SIZE);
+  ASSERT_EQ(MapDump("not_existed_mapped.dat", 0, &dump), BAD_FILE);
+  remove(path);
+}
+
+TEST(UpdateDump, MergesDeltaIntoSortedDump) {
+  std::vector<StatData> aggregate(100);
+  for (size_t i = 0; i < aggregate.size(); ++i) {
+    aggregate[i] = {.id = (long)(i * 2),
+                    .count = 1,
+                    .cost = 2,
+                    .primary = 1,
+                    .mode = (unsigned)(i % 8)};
+  }
+  StatData delta[] = {
+      {.id = 4, .count = 2, .cost = 1, .primary = 0, .mode = 7},
+      {.id = 201, .count = 1, .cost = 1, .primary = 1, .mode = 1},
+      {.id = 4, .count = 3, .cost = 1, .primary = 1, .mode = 0},
+      {.id = -5, .count = 1, .cost = 1, .primary = 1, .mode = 1},
+      {.id = 51, .count = 1, .cost = 1, .primary = 0, .mode = 2},
+      {.id = 198, .count = 1, .cost = 1, .primary = 1, .mode = 0}};
+
+  const char *path = "update_dump.dat";
+  CreateEmptyFile(path);
+  ASSERT_EQ(StoreDump(path, aggregate.data(), aggregate.size()), SUCCESS);
+  ASSERT_EQ(UpdateDump(path, delta, std::size(delta)), SUCCESS);
+
+  // Новые id дописаны серией в конец, исходные записи остались на местах
+  StatData *updated = nullptr;
+  size_t updatedSize = 0;
+  ASSERT_EQ(LoadDump(path, &updated, &updatedSize), SUCCESS);
+  ASSERT_EQ(updatedSize, aggregate.size() + 3);
+  for (size_t i = 0; i < aggregate.size(); ++i) {
+    ASSERT_EQ(updated[i].id, aggregate[i].id);
+  }
+  EXPECT_EQ(updated[aggregate.size()].id, -5);
+  EXPECT_EQ(updated[aggregate.size() + 1].id, 51);
+  EXPECT_EQ(updated[aggregate.size() + 2].id, 201);
+  free(updated);
+  ASSERT_EQ(CompactDump(path), SUCCESS);
+  EXPECT_EQ(access((std::string(path) + ".runs").c_str(), F_OK), -1);
+  ASSERT_EQ(LoadDump(path, &updated, &updatedSize), SUCCESS);
+
+  StatData *expected = nullptr;
+  size_t expectedSize = 0;
+  ASSERT_EQ(JoinDump(aggregate.data(), aggregate.size(), delta,
+                     std::size(delta), &expected, &expectedSize),
+            SUCCESS);
+  qsort(expected, expectedSize, sizeof(StatData), &SortStatDataByIDAsc);
+
+  ASSERT_EQ(updatedSize, expectedSize);
+  for (size_t i = 0; i < expectedSize; ++i) {
+    ASSERT_EQ(updated[i].id, expected[i].id);
+    ASSERT_EQ(updated[i].count, expected[i].count);
+    ASSERT_EQ(updated[i].cost, expected[i].cost);
+    ASSERT_EQ(updated[i].primary, expected[i].primary);
+    ASSERT_EQ(updated[i].mode, expected[i].mode);
+  }
+
+  free(updated);
+  free(expected);
+  remove(path);
+
+  ASSERT_EQ(UpdateDump(path, delta, 0), INVALID_POINTER_OR_SIZE);
+  ASSERT_EQ(UpdateDump("not_existed_update.dat", delta, std::size(delta)),
+            BAD_FILE);
+  ASSERT_EQ(CompactDump(nullptr), INVALID_POINTER_OR_SIZE);
+}
+
+TEST(UpdateDump, AppendsRunsAndKeepsThemLogarithmic) {
+  std::vector<StatData> aggregate(1000);
+  FillGeneratedData(aggregate.data(), aggregate.size(), 37, 1000000);
+  qsort(aggregate.data(), aggregate.size(), sizeof(StatData),
+        &SortStatDataByIDAsc);
+  aggregate.erase(std::unique(aggregate.begin(), aggregate.end(),
+                              [](const StatData &lhs, const StatData &rhs) {
+                                return lhs.id == rhs.id;
+                              }),
+                  aggregate.end());
+  const char *path = "update_dump_runs.dat";
+  const std::string runsPath = std::string(path) + ".runs";
+  CreateEmptyFile(path);
+  ASSERT_EQ(StoreDump(path, aggregate.data(), aggregate.size()), SUCCESS);
+
+  // Дельты смешивают существующие и новые id
+  std::vector<StatData> all = aggregate;
+  for (unsigned round = 0; round < 40; ++round) {
+    std::vector<StatData> delta(60);
+    FillGeneratedData(delta.data(), delta.size(), 100 + round, 1000000);
+    for (size_t i = 0; i < delta.size(); i += 3) {
+      delta[i].id = aggregate[(round * 7 + i) % aggregate.size()].id;
+    }
+    ASSERT_EQ(UpdateDump(path, delta.data(), delta.size()), SUCCESS);
+    all.insert(all.end(), delta.begin(), delta.end());
+
+    StatData *updated = nullptr;
+    size_t updatedSize = 0;
+    ASSERT_EQ(LoadDump(path, &updated, &updatedSize), SUCCESS);
+    std::string runs = access(runsPath.c_str(), F_OK) == 0
+                           ? ReadWholeFile(runsPath.c_str())
+                           : std::string();
+    EXPECT_LE(runs.size() / sizeof(uint64_t),
+              (size_t)log2((double)updatedSize) + 1);
+    free(updated);
+  }
+
+  ASSERT_EQ(CompactDump(path), SUCCESS);
+  EXPECT_EQ(access(runsPath.c_str(), F_OK), -1);
+  StatData *updated = nullptr;
+  size_t updatedSize = 0;
+  ASSERT_EQ(LoadDump(path, &updated, &updatedSize), SUCCESS);
+  StatData *expected = nullptr;
+  size_t expectedSize = 0;
+  ASSERT_EQ(JoinDump(all.data(), all.size(), nullptr, 0, &expected,
+                     &expectedSize),
+            SUCCESS);
+  qsort(expected, expectedSize, sizeof(StatData), &SortStatDataByIDAsc);
+  ASSERT_EQ(updatedSize, expectedSize);
+  for (size_t i = 0; i < expectedSize; ++i) {
+    ASSERT_EQ(updated[i].id, expected[i].id);
+    ASSERT_EQ(updated[i].count, expected[i].count);
+    ASSERT_EQ(updated[i].primary, expected[i].primary);
+    ASSERT_EQ(updated[i].mode, expected[i].mode);
+  }
+  free(updated);
+  free(expected);
+  remove(path);
+}
+
+TEST(UpdateDump, RejectsDumpNotSortedById) {
+  // Так выглядит результат CLI, отсортированный по cost
+  const StatData unordered[] = {{10, 1, 1.0f, 1, 0}, {2, 1, 2.0f, 1, 0},
+                                {30, 1, 3.0f, 1, 0}, {4, 1, 4.0f, 1, 0},
+                                {50, 1, 5.0f, 1, 0}, {6, 1, 6.0f, 1, 0}};
+  const char *path = "update_dump_unordered.dat";
+  CreateEmptyFile(path);
+  ASSERT_EQ(StoreDump(path, unordered, std::size(unordered)), SUCCESS);
+  const std::string before = ReadWholeFile(path);
+
+  const StatData delta[] = {{4, 1, 1.0f, 1, 0}, {7, 1, 1.0f, 1, 0}};
+  EXPECT_EQ(UpdateDump(path, delta, std::size(delta)), BAD_FILE);
+  EXPECT_EQ(ReadWholeFile(path), before);
+  EXPECT_EQ(access((std::string(path) + ".runs").c_str(), F_OK), -1);
+  remove(path);
+}
+
+TEST(MergeHashTable, HashTableToBufferCopiesAllElements) {
+  MergeHashTable table;
+  ASSERT_EQ(InitHashTable(&table, nullptr, nullptr, nullptr), 1);
+  for (size_t i = 0; i < std::size(testCase41); ++i) {
+    ASSERT_EQ(InsertToHashTable(&table, testCase41 + i), 1);
+  }
+  ASSERT_EQ(HashTableSize(&table), 2);
+
+  StatData buffer[2];
+  ASSERT_EQ(HashTableToBuffer(&table, buffer, std::size(buffer)), 2);
+  qsort(buffer, std::size(buffer), sizeof(StatData), &SortStatDataByIDAsc);
+  ASSERT_EQ(buffer[0].id, 90089);
+  ASSERT_EQ(buffer[0].count, 26);
+  ASSERT_EQ(buffer[0].mode, 7);
+  ASSERT_EQ(buffer[1].id, 90189);
+
+  ASSERT_EQ(HashTableToBuffer(&table, buffer, 1), 1);
+  ASSERT_EQ(HashTableSize(nullptr), 0);
+  ClearHashTable(&table);
+}
+
+TEST(BaseAPI, JoinDumpToFileMatchesJoinDump) {
+  const size_t i = 2;
+  CreateEmptyFile(cases[i].resultPath);
+  MappedDump joined;
+  Status result =
+      JoinDumpToFile(cases[i].firstIn, cases[i].firstInSize, cases[i].secondIn,
+                     cases[i].secondInSize, cases[i].resultPath, &joined);
+  ASSERT_EQ(result, SUCCESS);
+  ASSERT_EQ(joined.size, cases[i].resultSize);
+  ASSERT_EQ(SortDump(joined.data, joined.size, &SortStatDataFunc), SUCCESS);
+  CheckEqualData(joined.data, joined.size, cases[i].resultData,
+                 cases[i].resultSize);
+  ASSERT_EQ(UnmapDump(&joined), SUCCESS);
+
+  StatData *loaded = nullptr;
+  size_t loadedSize = 0;
+  ASSERT_EQ(LoadDump(cases[i].resultPath, &loaded, &loadedSize), SUCCESS);
+  CheckEqualData(loaded, loadedSize, cases[i].resultData, cases[i].resultSize);
+  free(loaded);
+
+  result = JoinDumpToFile(cases[i].firstIn, cases[i].firstInSize, nullptr, 0,
+                          cases[i].resultPath, nullptr);
+  ASSERT_EQ(result, SUCCESS);
+  ASSERT_EQ(JoinDumpToFile(nullptr, 0, nullptr, 0, cases[i].resultPath,
+                           nullptr),
+            INVALID_POINTER_OR_SIZE);
+  remove(cases[i].resultPath);
+}
+
+TEST(BaseAPI, JoinDumpInsertsFirstThenSecond) {
+  // Попеременная вставка дала бы 1e8 - 1e8 + 1 + 1 = 2, а порядок "весь
+  // first, затем весь second" теряет первую единицу при округлении
+  const StatData first[] = {{1, 1, 1e8f, 1, 0}, {1, 1, 1.0f, 1, 0}};
+  const StatData second[] = {{1, 1, -1e8f, 1, 0}, {1, 1, 1.0f, 1, 0}};
+  StatData *joined = nullptr;
+  size_t joinedSize = 0;
+  ASSERT_EQ(JoinDump(first, 2, second, 2, &joined, &joinedSize), SUCCESS);
+  ASSERT_EQ(joinedSize, 1u);
+  EXPECT_EQ(joined[0].count, 4);
+  EXPECT_EQ(joined[0].cost, 1.0f);
+  free(joined);
+
+  // На больших входах результат побитово и по порядку совпадает с пакетной
+  // вставкой first, затем second
+  const size_t size = 50000;
+  std::vector<StatData> large(size), other(size);
+  FillGeneratedData(large.data(), size, 29, 3000);
+  FillGeneratedData(other.data(), size, 31, 3000);
+  MergeHashTable table;
+  ASSERT_EQ(InitHashTable(&table, nullptr, nullptr, nullptr), 1);
+  ASSERT_EQ(InsertBatchToHashTable(&table, large.data(), size), 1);
+  ASSERT_EQ(InsertBatchToHashTable(&table, other.data(), size), 1);
+  StatData *expected = nullptr;
+  size_t expectedSize = 0;
+  ASSERT_EQ(HashTableToArray(&table, &expected, &expectedSize), 1);
+  ClearHashTable(&table);
+
+  ASSERT_EQ(JoinDump(large.data(), size, other.data(), size, &joined,
+                     &joinedSize),
+            SUCCESS);
+  ASSERT_EQ(joinedSize, expectedSize);
+  for (size_t i = 0; i < joinedSize; ++i) {
+    ASSERT_EQ(joined[i].id, expected[i].id);
+    ASSERT_EQ(joined[i].count, expected[i].count);
+    ASSERT_EQ(memcmp(&joined[i].cost, &expected[i].cost, sizeof(float)), 0);
+    ASSERT_EQ(joined[i].primary, expected[i].primary);
+    ASSERT_EQ(joined[i].mode, expected[i].mode);
+  }
+  free(expected);
+  free(joined);
+}
+
+TEST(SpecializedHashTable, MatchesRuntimeTable) {
+  const size_t size = 20000;
+  std::vector<StatData> data(size);
+  FillGeneratedData(data.data(), size, 5, 3000);
+
+  MergeHashTable runtime;
+  ASSERT_EQ(InitHashTable(&runtime, nullptr, nullptr, nullptr), 1);
+  DefaultMergeTable specialized;
+  ASSERT_EQ(DefaultMergeTableInit(&specialized, 100), 1);
+  ASSERT_EQ(specialized.bucketsCount, 128);
+  bs::DefaultMergeHashTable templated(100);
+  ASSERT_EQ(templated.BucketsCount(), 128);
+
+  for (const StatData &record : data) {
+    ASSERT_EQ(InsertToHashTable(&runtime, &record), 1);
+    ASSERT_EQ(DefaultMergeTableInsert(&specialized, &record), 1);
+  }
+  templated.Insert(data);
+
+  std::vector<StatData> expected(HashTableSize(&runtime));
+  HashTableToBuffer(&runtime, expected.data(), expected.size());
+  ASSERT_EQ(DefaultMergeTableSize(&specialized), expected.size());
+  ASSERT_EQ(templated.Size(), expected.size());
+
+  std::vector<StatData> fromMacro(expected.size());
+  ASSERT_EQ(DefaultMergeTableToBuffer(&specialized, fromMacro.data(),
+                                      fromMacro.size()),
+            expected.size());
+  std::vector<StatData> fromTemplate = templated.ToVector();
+
+  qsort(expected.data(), expected.size(), sizeof(StatData),
+        &SortStatDataByIDAsc);
+  qsort(fromMacro.data(), fromMacro.size(), sizeof(StatData),
+        &SortStatDataByIDAsc);
+  qsort(fromTemplate.data(), fromTemplate.size(), sizeof(StatData),
+        &SortStatDataByIDAsc);
+  for (size_t i = 0; i < expected.size(); ++i) {
+    for (const std::vector<StatData> *actual : {&fromMacro, &fromTemplate}) {
+      ASSERT_EQ((*actual)[i].id, expected[i].id);
+      ASSERT_EQ((*actual)[i].count, expected[i].count);
+      ASSERT_EQ((*actual)[i].cost, expected[i].cost);
+      ASSERT_EQ((*actual)[i].primary, expected[i].primary);
+      ASSERT_EQ((*actual)[i].mode, expected[i].mode);
+    }
+  }
+
+  const StatData *found = DefaultMergeTableFind(&specialized, &expected[0]);
+  ASSERT_NE(found, nullptr);
+  ASSERT_EQ(found->count, expected[0].count);
+  ASSERT_NE(templated.Find(expected[0]), nullptr);
+
+  ClearHashTable(&runtime);
+  DefaultMergeTableClear(&specialized);
+  templated.Clear();
+  ASSERT_EQ(templated.Size(), 0);
+}
+
+TEST(MergeHashTable, InsertBatchMatchesSingleInserts) {
+  // Несколько горячих id и длинный хвост уникальных, больше одного пакета
+  const size_t size = 3 * 4096 + 123;
+  std::vector<StatData> data(size);
+  FillGeneratedData(data.data(), size, 3, 40);
+  for (size_t i = 0; i < size; i += 5) {
+    data[i].id = 1000 + (long)i;
+  }
+
+  MergeHashTable single;
+  MergeHashTable batch;
+  ASSERT_EQ(InitHashTable(&single, nullptr, nullptr, nullptr), 1);
+  ASSERT_EQ(InitHashTable(&batch, nullptr, nullptr, nullptr), 1);
+  for (const StatData &record : data) {
+    ASSERT_EQ(InsertToHashTable(&single, &record), 1);
+  }
+  ASSERT_EQ(InsertBatchToHashTable(&batch, data.data(), size), 1);
+  ASSERT_EQ(InsertBatchToHashTable(&batch, nullptr, 0), 1);
+  ASSERT_EQ(InsertBatchToHashTable(nullptr, data.data(), size), 0);
+
+  std::vector<StatData> expected(HashTableSize(&single));
+  std::vector<StatData> actual(HashTableSize(&batch));
+  ASSERT_EQ(actual.size(), expected.size());
+  HashTableToBuffer(&single, expected.data(), expected.size());
+  HashTableToBuffer(&batch, actual.data(), actual.size());
+  qsort(expected.data(), expected.size(), sizeof(StatData),
+        &SortStatDataByIDAsc);
+  qsort(actual.data(), actual.size(), sizeof(StatData), &SortStatDataByIDAsc);
+  for (size_t i = 0; i < expected.size(); ++i) {
+    ASSERT_EQ(actual[i].id, expected[i].id);
+    ASSERT_EQ(actual[i].count, expected[i].count);
+    ASSERT_EQ(actual[i].cost, expected[i].cost);
+    ASSERT_EQ(actual[i].primary, expected[i].primary);
+    ASSERT_EQ(actual[i].mode, expected[i].mode);
+  }
+
+  ClearHashTable(&single);
+  ClearHashTable(&batch);
+}
+
+TEST(MergeHashTable, StatsDescribeChainsAndMemory) {
+  MergeHashTable table;
+  ASSERT_EQ(InitHashTable(&table, &HashFunctionBase, nullptr, nullptr), 1);
+  HashTableStats stats;
+  ASSERT_EQ(GetHashTableStats(&table, &stats), 1);
+  EXPECT_EQ(stats.elementsCount, 0u);
+  EXPECT_EQ(stats.emptyBuckets, stats.bucketsCount);
+  EXPECT_EQ(stats.meanChainLength, 0.0);
+
+  // id % 5: все 100 элементов в 5 цепочках по 20
+  for (long id = 0; id < 100; ++id) {
+    StatData record = {id, 1, 1.0f, 1, 0};
+    ASSERT_EQ(InsertToHashTable(&table, &record), 1);
+    ASSERT_EQ(InsertToHashTable(&table, &record), 1);
+  }
+  ASSERT_EQ(GetHashTableStats(&table, &stats), 1);
+  EXPECT_EQ(stats.elementsCount, 100u);
+  EXPECT_EQ(stats.bucketsCount, size_t{BINARYSERIALIZER_DEFUALT_BUCKETS_COUNT});
+  EXPECT_EQ(stats.emptyBuckets, stats.bucketsCount - 5);
+  EXPECT_EQ(stats.maxChainLength, 20u);
+  EXPECT_DOUBLE_EQ(stats.loadFactor, 100.0 / stats.bucketsCount);
+  EXPECT_DOUBLE_EQ(stats.meanChainLength, 20.0);
+  EXPECT_DOUBLE_EQ(stats.meanProbeLength, 10.5);
+  EXPECT_EQ(stats.chainHistogram[0], stats.emptyBuckets);
+  EXPECT_EQ(stats.chainHistogram[5], 5u);
+  EXPECT_EQ(stats.payloadBytes, 100 * sizeof(StatData));
+  EXPECT_GT(stats.nodesBytes, 0u);
+  EXPECT_EQ(stats.totalBytes,
+            stats.bucketsBytes + stats.nodesBytes + stats.payloadBytes);
+  // Записи, сохраненные после сброса и удаления, остаются выделенными
+  const StatData erased = {7, 1, 1.0f, 1, 0};
+  EraseFromHashTable(&table, &erased);
+  ASSERT_EQ(GetHashTableStats(&table, &stats), 1);
+  EXPECT_EQ(stats.elementsCount, 99u);
+  EXPECT_EQ(stats.payloadBytes, 100 * sizeof(StatData));
+  ResetHashTable(&table);
+  ASSERT_EQ(GetHashTableStats(&table, &stats), 1);
+  EXPECT_EQ(stats.elementsCount, 0u);
+  EXPECT_EQ(stats.payloadBytes, 100 * sizeof(StatData));
+  ClearHashTable(&table);
+
+  const size_t size = 20000;
+  std::vector<StatData> data(size);
+  FillGeneratedData(data.data(), size, 5, 1 << 30);
+  ASSERT_EQ(InitHashTableWithBuckets(&table, 4096, nullptr, nullptr, nullptr),
+            1);
+  ASSERT_EQ(InsertBatchToHashTable(&table, data.data(), size), 1);
+  ASSERT_EQ(GetHashTableStats(&table, &stats), 1);
+  EXPECT_EQ(stats.elementsCount, HashTableSize(&table));
+  size_t buckets = 0;
+  for (size_t count : stats.chainHistogram) {
+    buckets += count;
+  }
+  EXPECT_EQ(buckets, stats.bucketsCount);
+  // Хороший хеш держит цепочки близко к коэффициенту заполнения
+  EXPECT_LT(stats.maxChainLength, 4 * (size_t)stats.loadFactor + 8);
+  EXPECT_EQ(GetHashTableStats(nullptr, &stats), 0);
+  EXPECT_EQ(GetHashTableStats(&table, nullptr), 0);
+  ClearHashTable(&table);
+}
+
+// Аллокатор поверх malloc, считающий вызовы и живые блоки
+struct CountingAllocator {
+  size_t allocations = 0;
+  size_t reallocations = 0;
+  size_t deallocations = 0;
+  long liveBlocks = 0;
+
+  static void *Allocate(void *context, size_t size) {
+    auto *self = static_cast<CountingAllocator *>(context);
+    self->allocations++;
+    self->liveBlocks++;
+    return malloc(size);
+  }
+
+  static void *Reallocate(void *context, void *memory, size_t size) {
+    auto *self = static_cast<CountingAllocator *>(context);
+    self->reallocations++;
+    self->liveBlocks += memory == nullptr;
+    return realloc(memory, size);
+  }
+
+  static void Deallocate(void *context, void *memory) {
+    auto *self = static_cast<CountingAllocator *>(context);
+    self->deallocations++;
+    self->liveBlocks--;
+    free(memory);
+  }
+
+  Allocator Get() { return {&Allocate, &Reallocate, &Deallocate, this}; }
+};
+
+TEST(Allocator, ServesHashTableLoadAndJoin) {
+  const size_t size = 5000;
+  std::vector<StatData> data(size);
+  FillGeneratedData(data.data(), size, 29, 2000);
+
+  CountingAllocator counting;
+  Allocator allocator = counting.Get();
+  MergeHashTable table;
+  ASSERT_EQ(InitHashTableWithAllocator(&table, 256, nullptr, nullptr, nullptr,
+                                       &allocator),
+            1);
+  ASSERT_EQ(InsertBatchToHashTable(&table, data.data(), size), 1);
+  const StatData *first = &data[0];
+  EraseFromHashTable(&table, first);
+  EXPECT_GT(counting.allocations, HashTableSize(&table));
+  EXPECT_GT(counting.reallocations, 0u);
+  StatData *array = nullptr;
+  size_t arraySize = 0;
+  ASSERT_EQ(HashTableToArray(&table, &array, &arraySize), 1);
+  allocator.deallocate(allocator.context, array);
+  ClearHashTable(&table);
+  EXPECT_EQ(counting.liveBlocks, 0);
+
+  StatData *expected = nullptr;
+  size_t expectedSize = 0;
+  ASSERT_EQ(JoinDump(data.data(), size / 2, data.data() + size / 2,
+                     size - size / 2, &expected, &expectedSize),
+            SUCCESS);
+  StatData *joined = nullptr;
+  size_t joinedSize = 0;
+  const size_t before = counting.allocations;
+  ASSERT_EQ(JoinDumpWithAllocator(data.data(), size / 2,
+                                  data.data() + size / 2, size - size / 2,
+                                  &joined, &joinedSize, &allocator),
+            SUCCESS);
+  EXPECT_GT(counting.allocations, before);
+  // Таблица освобождена, жив только результат
+  EXPECT_EQ(counting.liveBlocks, 1);
+  ASSERT_EQ(joinedSize, expectedSize);
+  CheckEqualData(joined, joinedSize, expected, expectedSize);
+
+  const char *path = "allocator_dump.dat";
+  CreateEmptyFile(path);
+  ASSERT_EQ(StoreDump(path, joined, joinedSize), SUCCESS);
+  allocator.deallocate(allocator.context, joined);
+  StatData *loaded = nullptr;
+  size_t loadedSize = 0;
+  const size_t reallocations = counting.reallocations;
+  ASSERT_EQ(LoadDumpWithAllocator(path, &loaded, &loadedSize, &allocator),
+            SUCCESS);
+  EXPECT_GT(counting.reallocations, reallocations);
+  EXPECT_EQ(counting.liveBlocks, 1);
+  ASSERT_EQ(loadedSize, expectedSize);
+  CheckEqualData(loaded, loadedSize, expected, expectedSize);
+  allocator.deallocate(allocator.context, loaded);
+  EXPECT_EQ(counting.liveBlocks, 0);
+
+  // NULL выбирает аллокатор по умолчанию, неполная таблица функций - ошибка
+  ASSERT_EQ(LoadDumpWithAllocator(path, &loaded, &loadedSize, nullptr),
+            SUCCESS);
+  free(loaded);
+  Allocator incomplete = allocator;
+  incomplete.deallocate = nullptr;
+  EXPECT_EQ(LoadDumpWithAllocator(path, &loaded, &loadedSize, &incomplete),
+            INVALID_POINTER_OR_SIZE);
+  EXPECT_EQ(JoinDumpWithAllocator(data.data(), size, nullptr, 0, &joined,
+                                  &joinedSize, &incomplete),
+            INVALID_POINTER_OR_SIZE);
+  EXPECT_EQ(InitHashTableWithAllocator(&table, 256, nullptr, nullptr, nullptr,
+                                       &incomplete),
+            0);
+  EXPECT_NE(DefaultAllocator(), nullptr);
+  EXPECT_EQ(counting.liveBlocks, 0);
+  free(expected);
+  remove(path);
+}
+
+TEST(ExecutionContext, RepeatedCallsDoNotAllocate) {
+  const size_t size = 3000;
+  std::vector<StatData> data(size);
+  FillGeneratedData(data.data(), size, 31, 1000);
+  StatData *expected = nullptr;
+  size_t expectedSize = 0;
+  ASSERT_EQ(JoinDump(data.data(), size / 2, data.data() + size / 2,
+                     size - size / 2, &expected, &expectedSize),
+            SUCCESS);
+  ASSERT_EQ(SortDumpByKey(expected, expectedSize, SORT_FIELD_COST, SORT_ASC),
+            SUCCESS);
+
+  const char idField[] = "id";
+  const Field fields[] = {{NULL, 0, STAT_DATA_COLUMN_NUMBER, 8},
+                          {idField, sizeof(idField), STAT_DATA_COLUMN_ID, 16}};
+  TableView view;
+  ASSERT_EQ(InitTableView(&view, &StatDataFormatter, fields, 2), TVS_SUCCESS);
+  TableMemoryBuffer memory = {};
+  SetTableViewSink(&view, MemoryTableSink(&memory));
+  ASSERT_EQ(PrintDump(expected, expectedSize, 100, &view), SUCCESS);
+  const std::string table(memory.data, memory.size);
+
+  CountingAllocator counting;
+  Allocator allocator = counting.Get();
+  // Те же бакеты, что у JoinDump(): порядок равных cost после сортировки
+  // совпадает
+  ExecutionContext *context = CreateExecutionContext(0, &allocator);
+  ASSERT_NE(context, nullptr);
+  size_t allocations = 0;
+  size_t reallocations = 0;
+  for (int round = 0; round < 3; ++round) {
+    StatData *joined = nullptr;
+    size_t joinedSize = 0;
+    ASSERT_EQ(JoinDumpWithContext(context, data.data(), size / 2,
+                                  data.data() + size / 2, size - size / 2,
+                                  &joined, &joinedSize),
+              SUCCESS);
+    ASSERT_EQ(SortDumpByKeyWithContext(context, joined, joinedSize,
+                                       SORT_FIELD_COST, SORT_ASC),
+              SUCCESS);
+    ASSERT_EQ(joinedSize, expectedSize);
+    CheckEqualData(joined, joinedSize, expected, expectedSize);
+    const char *text = nullptr;
+    size_t textSize = 0;
+    ASSERT_EQ(PrintDumpWithContext(context, joined, joinedSize, 100, &view,
+                                   &text, &textSize),
+              SUCCESS);
+    ASSERT_EQ(std::string(text, textSize), table);
+    // Первый проход прогревает буферы, дальше выделений нет
+    if (round > 0) {
+      EXPECT_EQ(counting.allocations, allocations);
+      EXPECT_EQ(counting.reallocations, reallocations);
+    }
+    allocations = counting.allocations;
+    reallocations = counting.reallocations;
+  }
+  // Приемник view восстановлен
+  memory.size = 0;
+  ASSERT_EQ(PrintDump(expected, expectedSize, 100, &view), SUCCESS);
+  EXPECT_EQ(std::string(memory.data, memory.size), table);
+
+  StatData *joined = nullptr;
+  size_t joinedSize = 0;
+  EXPECT_EQ(JoinDumpWithContext(nullptr, data.data(), size, nullptr, 0,
+                                &joined, &joinedSize),
+            INVALID_POINTER_OR_SIZE);
+  EXPECT_EQ(SortDumpByKeyWithContext(nullptr, data.data(), size,
+                                     SORT_FIELD_ID, SORT_ASC),
+            INVALID_POINTER_OR_SIZE);
+  DestroyExecutionContext(context);
+  EXPECT_EQ(counting.liveBlocks, 0);
+  DestroyExecutionContext(nullptr);
+  ClearTableMemoryBuffer(&memory);
+  ClearTableView(&view);
+  free(expected);
+}
+
+static void RecordPipelineResult(void *context,
+                                 const JoinPipelineResult *result) {
+  *static_cast<JoinPipelineResult *>(context) = *result;
+}
+
+TEST(JoinPipeline, MatchesSequentialJoinSortAndStore) {
+  // Несколько блоков чтения и кусков вставки в каждом входе
+  const size_t size = 150000;
+  std::vector<StatData> first(size);
+  std::vector<StatData> second(size - 777);
+  FillGeneratedData(first.data(), first.size(), 41, 90000);
+  FillGeneratedData(second.data(), second.size(), 43, 90000);
+  for (size_t i = 0; i < size; ++i) {
+    // Дробные cost проверяют порядок сложения float
+    first[i].cost = (float)(i % 97) * 0.37f;
+    if (i < second.size()) {
+      second[i].cost = (float)(i % 89) * 0.13f;
+    }
+  }
+  const char *firstPath = "pipeline_first.dat";
+  const char *secondPath = "pipeline_second.dat";
+  const char *resultPath = "pipeline_result.dat";
+  CreateEmptyFile(firstPath);
+  CreateEmptyFile(secondPath);
+  CreateEmptyFile(resultPath);
+  ASSERT_EQ(StoreDump(firstPath, first.data(), first.size()), SUCCESS);
+  ASSERT_EQ(StoreDump(secondPath, second.data(), second.size()), SUCCESS);
+
+  for (SortField field : {SORT_FIELD_COST, SORT_FIELD_ID}) {
+    for (SortDirection direction : {SORT_ASC, SORT_DESC}) {
+      StatData *expected = nullptr;
+      size_t expectedSize = 0;
+      ASSERT_EQ(JoinDump(first.data(), first.size(), second.data(),
+                         second.size(), &expected, &expectedSize),
+                SUCCESS);
+      ASSERT_EQ(SortDumpByKey(expected, expectedSize, field, direction),
+                SUCCESS);
+
+      JoinPipelineResult notified = {};
+      JoinPipelineOptions options = {field, direction, &RecordPipelineResult,
+                                     &notified};
+      JoinPipeline *pipeline = nullptr;
+      ASSERT_EQ(StartJoinPipeline(firstPath, secondPath, resultPath, &options,
+                                  &pipeline),
+                SUCCESS);
+      JoinPipelineResult result;
+      ASSERT_EQ(WaitJoinPipeline(pipeline, &result), SUCCESS);
+      EXPECT_EQ(notified.status, SUCCESS);
+      EXPECT_EQ(notified.data, result.data);
+      EXPECT_EQ(result.firstStatus, SUCCESS);
+      EXPECT_EQ(result.secondStatus, SUCCESS);
+      ASSERT_EQ(result.size, expectedSize);
+
+      StatData *stored = nullptr;
+      size_t storedSize = 0;
+      ASSERT_EQ(LoadDump(resultPath, &stored, &storedSize), SUCCESS);
+      ASSERT_EQ(storedSize, expectedSize);
+      for (size_t i = 0; i < expectedSize; ++i) {
+        ASSERT_EQ(result.data[i].id, expected[i].id);
+        ASSERT_EQ(result.data[i].cost, expected[i].cost);
+        ASSERT_EQ(result.data[i].count, expected[i].count);
+        ASSERT_EQ(result.data[i].primary, expected[i].primary);
+        ASSERT_EQ(result.data[i].mode, expected[i].mode);
+        ASSERT_EQ(stored[i].id, expected[i].id);
+        ASSERT_EQ(stored[i].cost, expected[i].cost);
+      }
+      free(stored);
+      free(result.data);
+      free(expected);
+    }
+  }
+
+  // Недоступный вход считается пустым, как в serializeData
+  JoinPipeline *pipeline = nullptr;
+  ASSERT_EQ(StartJoinPipeline("pipeline_missing.dat", secondPath, resultPath,
+                              nullptr, &pipeline),
+            SUCCESS);
+  JoinPipelineResult result;
+  ASSERT_EQ(WaitJoinPipeline(pipeline, &result), SUCCESS);
+  EXPECT_EQ(result.firstStatus, BAD_FILE);
+  EXPECT_EQ(result.secondStatus, SUCCESS);
+  EXPECT_GT(result.size, 0u);
+  EXPECT_LE(result.size, second.size());
+  free(result.data);
+
+  ASSERT_EQ(StartJoinPipeline("pipeline_missing.dat", "pipeline_missing.dat",
+                              resultPath, nullptr, &pipeline),
+            SUCCESS);
+  EXPECT_EQ(WaitJoinPipeline(pipeline, nullptr), INVALID_POINTER_OR_SIZE);
+  EXPECT_EQ(StartJoinPipeline(firstPath, nullptr, resultPath, nullptr,
+                              &pipeline),
+            INVALID_POINTER_OR_SIZE);
+  EXPECT_EQ(WaitJoinPipeline(nullptr, nullptr), INVALID_POINTER_OR_SIZE);
+  remove(firstPath);
+  remove(secondPath);
+  remove(resultPath);
+}
+
+TEST(SortDump, SortDumpByKeyMatchesStableSort) {
+  for (size_t size : {size_t{1}, size_t{37}, size_t{5000}}) {
+    std::vector<StatData> data(size);
+    FillGeneratedData(data.data(), size, 17, 300);
+    for (size_t i = 0; i < size; ++i) {
+      // Отрицательные id и cost проверяют преобразование ключей
+      data[i].id -= 150;
+      data[i].cost = (float)((long)(i % 11) - 5) * 0.25f;
+      data[i].count = (int)i;
+    }
+
+    for (SortField field : {SORT_FIELD_ID, SORT_FIELD_COST}) {
+      for (SortDirection direction : {SORT_ASC, SORT_DESC}) {
+        std::vector<StatData> expected = data;
+        std::stable_sort(expected.begin(), expected.end(),
+                         [&](const StatData &lhs, const StatData &rhs) {
+                           if (field == SORT_FIELD_ID) {
+                             return direction == SORT_ASC ? lhs.id < rhs.id
+                                                          : lhs.id > rhs.id;
+                           }
+                           return direction == SORT_ASC ? lhs.cost < rhs.cost
+                                                        : lhs.cost > rhs.cost;
+                         });
+        std::vector<StatData> actual = data;
+        ASSERT_EQ(SortDumpByKey(actual.data(), size, field, direction),
+                  SUCCESS);
+        for (size_t i = 0; i < size; ++i) {
+          // count хранит исходную позицию, поэтому проверяется и устойчивость
+          ASSERT_EQ(actual[i].count, expected[i].count);
+        }
+      }
+    }
+  }
+
+  StatData record{};
+  ASSERT_EQ(SortDumpByKey(nullptr, 1, SORT_FIELD_ID, SORT_ASC),
+            INVALID_POINTER_OR_SIZE);
+  ASSERT_EQ(SortDumpByKey(&record, 0, SORT_FIELD_ID, SORT_ASC),
+            INVALID_POINTER_OR_SIZE);
+  ASSERT_EQ(SortDumpByKey(&record, 1, (SortField)7, SORT_ASC),
+            INVALID_POINTER_OR_SIZE);
+}
+
+TEST(SortDump, SortDumpByKeyParallelMatchesSequential) {
+  const size_t size = 200000;
+  std::vector<StatData> data(size);
+  FillGeneratedData(data.data(), size, 23, 1 << 20);
+  for (size_t i = 0; i < size; ++i) {
+    data[i].cost = (float)((long)(i % 1001) - 500) * 0.5f;
+    data[i].count = (int)i;
+  }
+
+  for (SortField field : {SORT_FIELD_ID, SORT_FIELD_COST}) {
+    for (SortDirection direction : {SORT_ASC, SORT_DESC}) {
+      std::vector<StatData> expected = data;
+      ASSERT_EQ(SortDumpByKey(expected.data(), size, field, direction),
+                SUCCESS);
+      for (size_t threads : {size_t{2}, size_t{3}, size_t{8}}) {
+        std::vector<StatData> actual = data;
+        ASSERT_EQ(SortDumpByKeyParallel(actual.data(), size, field, direction,
+                                        threads),
+                  SUCCESS);
+        for (size_t i = 0; i < size; ++i) {
+          ASSERT_EQ(actual[i].count, expected[i].count);
+        }
+      }
+    }
+  }
+  ASSERT_EQ(SortDumpByKeyParallel(nullptr, size, SORT_FIELD_ID, SORT_ASC, 4),
+            INVALID_POINTER_OR_SIZE);
+}
+
+TEST(SortDump, TopKByKeyMatchesSortPrefix) {
+  const size_t size = 10000;
+  std::vector<StatData> data(size);
+  FillGeneratedData(data.data(), size, 29, 500);
+  for (size_t i = 0; i < size; ++i) {
+    // Много одинаковых cost проверяют порядок при равенстве ключей
+    data[i].cost = (float)(i % 97);
+    data[i].count = (int)i;
+  }
+
+  for (SortField field : {SORT_FIELD_ID, SORT_FIELD_COST}) {
+    for (SortDirection direction : {SORT_ASC, SORT_DESC}) {
+      std::vector<StatData> sorted = data;
+      ASSERT_EQ(SortDumpByKey(sorted.data(), size, field, direction), SUCCESS);
+      for (size_t k : {size_t{1}, size_t{10}, size_t{250}, size + 5}) {
+        std::vector<StatData> top(std::min(k, size));
+        ASSERT_EQ(
+            TopKByKey(data.data(), size, field, direction, top.data(), k),
+            SUCCESS);
+        for (size_t i = 0; i < top.size(); ++i) {
+          ASSERT_EQ(top[i].count, sorted[i].count);
+        }
+      }
+    }
+  }
+
+  StatData record{};
+  ASSERT_EQ(TopKByKey(data.data(), size, SORT_FIELD_ID, SORT_ASC, &record, 0),
+            INVALID_POINTER_OR_SIZE);
+  ASSERT_EQ(TopKByKey(data.data(), size, SORT_FIELD_ID, SORT_ASC, nullptr, 1),
+            INVALID_POINTER_OR_SIZE);
+}
+
+static void PrintIdFormatter(int id, const void *data, char *buffer,
+                             size_t bufferSize) {
+  (void)id;
+  int count = snprintf(buffer, bufferSize, "%ld",
+                       static_cast<const StatData *>(data)->id);
+  buffer[count] = ' ';
+}
+
+TEST(SortDump, ArgSortByKeyMatchesSortDumpByKey) {
+  for (size_t size : {size_t{1}, size_t{37}, size_t{5000}}) {
+    std::vector<StatData> data(size);
+    FillGeneratedData(data.data(), size, 31, 200);
+    for (size_t i = 0; i < size; ++i) {
+      data[i].id -= 100;
+      data[i].cost = (float)((long)(i % 13) - 6) * 0.5f;
+      data[i].count = (int)i;
+    }
+
+    for (SortField field : {SORT_FIELD_ID, SORT_FIELD_COST}) {
+      for (SortDirection direction : {SORT_ASC, SORT_DESC}) {
+        std::vector<StatData> expected = data;
+        ASSERT_EQ(SortDumpByKey(expected.data(), size, field, direction),
+                  SUCCESS);
+        std::vector<uint32_t> permutation(size);
+        ASSERT_EQ(ArgSortByKey(data.data(), size, field, direction,
+                               permutation.data()),
+                  SUCCESS);
+        std::vector<StatData> gathered(size);
+        ASSERT_EQ(GatherByPermutation(data.data(), permutation.data(), size,
+                                      gathered.data()),
+                  SUCCESS);
+        for (size_t i = 0; i < size; ++i) {
+          ASSERT_EQ(gathered[i].count, expected[i].count);
+        }
+      }
+    }
+  }
+
+  StatData record{};
+  uint32_t index = 0;
+  ASSERT_EQ(ArgSortByKey(&record, 1, SORT_FIELD_ID, SORT_ASC, nullptr),
+            INVALID_POINTER_OR_SIZE);
+  ASSERT_EQ(ArgSortByKey(&record, 0, SORT_FIELD_ID, SORT_ASC, &index),
+            INVALID_POINTER_OR_SIZE);
+  ASSERT_EQ(GatherByPermutation(&record, &index, 1, &record),
+            INVALID_POINTER_OR_SIZE);
+}
+
+TEST(BaseAPI, PrintDumpPermutedMatchesPrintOfGathered) {
+  const size_t size = 100;
+  std::vector<StatData> data(size);
+  FillGeneratedData(data.data(), size, 5, 1000);
+  std::vector<uint32_t> permutation(size);
+  ASSERT_EQ(ArgSortByKey(data.data(), size, SORT_FIELD_COST, SORT_DESC,
+                         permutation.data()),
+            SUCCESS);
+  std::vector<StatData> gathered(size);
+  ASSERT_EQ(GatherByPermutation(data.data(), permutation.data(), size,
+                                gathered.data()),
+            SUCCESS);
+
+  const char idField[] = "id";
+  const Field fields[] = {{NULL, 0, -1, 8}, {idField, sizeof(idField), 0, 24}};
+  TableView view;
+  ASSERT_EQ(InitTableView(&view, &PrintIdFormatter, fields, 2), TVS_SUCCESS);
+
+  testing::internal::CaptureStdout();
+  ASSERT_EQ(PrintDump(gathered.data(), size, 10, &view), SUCCESS);
+  std::string expected = testing::internal::GetCapturedStdout();
+  testing::internal::CaptureStdout();
+  ASSERT_EQ(
+      PrintDumpPermuted(data.data(), permutation.data(), size, 10, &view),
+      SUCCESS);
+  std::string actual = testing::internal::GetCapturedStdout();
+  ClearTableView(&view);
+
+  ASSERT_EQ(actual, expected);
+  ASSERT_EQ(PrintDumpPermuted(data.data(), nullptr, size, 10, &view),
+            INVALID_POINTER_OR_SIZE);
+}
+
+TEST(SortDump, SortDumpByKeysMatchesStableMultiKeySort) {
+  for (size_t size : {size_t{1}, size_t{45}, size_t{6000}}) {
+    std::vector<StatData> data(size);
+    FillGeneratedData(data.data(), size, 41, 50);
+    for (size_t i = 0; i < size; ++i) {
+      data[i].id -= 25;
+      data[i].cost = (float)((long)(i % 7) - 3) * 1.5f;
+      data[i].count = (int)i;
+    }
+
+    const SortKeySpec costDescIdAsc[] = {{SORT_FIELD_COST, SORT_DESC},
+                                         {SORT_FIELD_ID, SORT_ASC}};
+    std::vector<StatData> expected = data;
+    std::stable_sort(expected.begin(), expected.end(),
+                     [](const StatData &lhs, const StatData &rhs) {
+                       if (lhs.cost != rhs.cost) {
+                         return lhs.cost > rhs.cost;
+                       }
+                       return lhs.id < rhs.id;
+                     });
+    std::vector<StatData> actual = data;
+    ASSERT_EQ(SortDumpByKeys(actual.data(), size, costDescIdAsc, 2), SUCCESS);
+    for (size_t i = 0; i < size; ++i) {
+      ASSERT_EQ(actual[i].count, expected[i].count);
+    }
+
+    // Повтор поля не влияет на результат
+    const SortKeySpec idDescTwice[] = {{SORT_FIELD_ID, SORT_DESC},
+                                       {SORT_FIELD_COST, SORT_ASC},
+                                       {SORT_FIELD_ID, SORT_ASC}};
+    expected = data;
+    std::stable_sort(expected.begin(), expected.end(),
+                     [](const StatData &lhs, const StatData &rhs) {
+                       if (lhs.id != rhs.id) {
+                         return lhs.id > rhs.id;
+                       }
+                       return lhs.cost < rhs.cost;
+                     });
+    actual = data;
+    ASSERT_EQ(SortDumpByKeys(actual.data(), size, idDescTwice, 3), SUCCESS);
+    for (size_t i = 0; i < size; ++i) {
+      ASSERT_EQ(actual[i].count, expected[i].count);
+    }
+  }
+
+  StatData record{};
+  const SortKeySpec invalid[] = {{SORT_FIELD_ID, SORT_ASC},
+                                 {(SortField)9, SORT_ASC}};
+  ASSERT_EQ(SortDumpByKeys(&record, 1, invalid, 2), INVALID_POINTER_OR_SIZE);
+  ASSERT_EQ(SortDumpByKeys(&record, 1, invalid, 0), INVALID_POINTER_OR_SIZE);
+  ASSERT_EQ(SortDumpByKeys(&record, 1, nullptr, 1), INVALID_POINTER_OR_SIZE);
+}
+
+static void PrintIdCostFormatter(int id, const void *data, char *buffer,
+                                 size_t bufferSize) {
+  const StatData *record = static_cast<const StatData *>(data);
+  int count = id == 0 ? snprintf(buffer, bufferSize, "%ld", record->id)
+                      : snprintf(buffer, bufferSize, "%.2f", record->cost);
+  buffer[count] = ' ';
+}
+
+TEST(TableView, PrintTableMatchesGoldenOutput) {
+  // Эталон получен выводом в stdout до перехода на блочную отрисовку:
+  // заголовок, разделители, столбец номеров, обрезка длинного значения и
+  // строка '.' при неполном выводе
+  const StatData data[] = {{7, 1, 1.5f, 1, 0},
+                           {-42, 2, 0.25f, 0, 3},
+                           {12345678901, 3, 10.0f, 1, 7},
+                           {0, 4, -3.75f, 0, 1}};
+  const char idField[] = "id";
+  const char costField[] = "cost";
+  const Field fields[] = {{NULL, 0, -1, 6},
+                          {idField, sizeof(idField), 0, 10},
+                          {costField, sizeof(costField), 1, 8}};
+  TableView view;
+  ASSERT_EQ(InitTableView(&view, &PrintIdCostFormatter, fields, 3),
+            TVS_SUCCESS);
+  view.data = data;
+  view.dataSize = 4;
+  view.memSize = sizeof(StatData);
+  TableMemoryBuffer memory = {};
+  SetTableViewSink(&view, MemoryTableSink(&memory));
+
+  const std::string header = "--------------------------\n"
+                             "|     |id       |cost    |\n"
+                             "--------------------------\n"
+                             "|1    |7        |1.50    |\n"
+                             "--------------------------\n"
+                             "|2    |-42      |0.25    |\n";
+  ASSERT_EQ(PrintTable(&view, 2), TVS_SUCCESS);
+  EXPECT_EQ(std::string(memory.data, memory.size),
+            header + "..........................\n");
+
+  memory.size = 0;
+  ASSERT_EQ(PrintTable(&view, 4), TVS_SUCCESS);
+  EXPECT_EQ(std::string(memory.data, memory.size),
+            header + "--------------------------\n"
+                     "|3    |123456789|10.00   |\n"
+                     "--------------------------\n"
+                     "|4    |0        |-3.75   |\n"
+                     "--------------------------\n");
+  ClearTableMemoryBuffer(&memory);
+  ClearTableView(&view);
+}
+
+TEST(TableView, SinksAndRangesProduceSameBytes) {
+  const size_t size = 3000;
+  std::vector<StatData> data(size);
+  FillGeneratedData(data.data(), size, 3, 1 << 20);
+
+  const char idField[] = "id";
+  const Field fields[] = {{NULL, 0, -1, 8}, {idField, sizeof(idField), 0, 24}};
+  TableView view;
+  ASSERT_EQ(InitTableView(&view, &PrintIdFormatter, fields, 2), TVS_SUCCESS);
+  view.data = data.data();
+  view.dataSize = size;
+  view.memSize = sizeof(StatData);
+
+  TableMemoryBuffer whole = {};
+  SetTableViewSink(&view, MemoryTableSink(&whole));
+  ASSERT_EQ(PrintTable(&view, size), TVS_SUCCESS);
+  std::string expected(whole.data, whole.size);
+
+  FILE *file = tmpfile();
+  ASSERT_NE(file, nullptr);
+  SetTableViewSink(&view, FileTableSink(file));
+  ASSERT_EQ(PrintTable(&view, size), TVS_SUCCESS);
+  std::string fromFile(expected.size(), 0);
+  rewind(file);
+  ASSERT_EQ(fread(fromFile.data(), 1, fromFile.size(), file), expected.size());
+  fclose(file);
+  ASSERT_EQ(fromFile, expected);
+
+  // Заголовок и две половины, отрисованные независимыми представлениями
+  TableMemoryBuffer parts[3] = {};
+  TableView views[3];
+  for (size_t i = 0; i < 3; ++i) {
+    ASSERT_EQ(InitTableView(views + i, &PrintIdFormatter, fields, 2),
+              TVS_SUCCESS);
+    views[i].data = data.data();
+    views[i].dataSize = size;
+    views[i].memSize = sizeof(StatData);
+    SetTableViewSink(views + i, MemoryTableSink(parts + i));
+  }
+  ASSERT_EQ(PrintTableHeader(views), TVS_SUCCESS);
+  ASSERT_EQ(PrintTableRange(views + 1, 0, size / 2), TVS_SUCCESS);
+  ASSERT_EQ(PrintTableRange(views + 2, size / 2, size), TVS_SUCCESS);
+  std::string assembled;
+  for (size_t i = 0; i < 3; ++i) {
+    assembled.append(parts[i].data, parts[i].size);
+    ClearTableMemoryBuffer(parts + i);
+    ClearTableView(views + i);
+  }
+  ASSERT_EQ(assembled, expected);
+  ASSERT_EQ(PrintTableRange(&view, 10, size + 1), TVS_ERROR);
+
+  ClearTableMemoryBuffer(&whole);
+  ClearTableView(&view);
+}
+
+TEST(CellFormat, FormattersMatchSnprintf) {
+  char buffer[64];
+  char expected[64];
+  unsigned seed = 17;
+  for (size_t i = 0; i < 200000; ++i) {
+    seed = seed * 1103515245u + 12345u;
+    uint64_t bits = ((uint64_t)seed << 32) ^ (seed * 2654435761u);
+    int64_t value = (int64_t)(bits >> (seed % 64));
+    if (seed & 1) {
+      value = -value;
+    }
+
+    size_t length = FormatHex((uint64_t)value, buffer, sizeof(buffer));
+    snprintf(expected, sizeof(expected), "%lx", (unsigned long)value);
+    ASSERT_EQ(std::string(buffer, length), expected);
+
+    length = FormatDecimal(value, buffer, sizeof(buffer));
+    snprintf(expected, sizeof(expected), "%ld", (long)value);
+    ASSERT_EQ(std::string(buffer, length), expected);
+
+    uint32_t floatBits = (uint32_t)(bits >> 16);
+    float cost;
+    memcpy(&cost, &floatBits, sizeof(cost));
+    if ((floatBits & 0x7f800000u) == 0x7f800000u && (floatBits & 0x7fffffu)) {
+      continue; // nan печатается без знака и полезной нагрузки
+    }
+    unsigned precision = seed % 10;
+    length = FormatScientific(cost, precision, buffer, sizeof(buffer));
+    snprintf(expected, sizeof(expected), "%.*e", (int)precision, cost);
+    ASSERT_EQ(std::string(buffer, length), expected) << precision;
+  }
+
+  const double specials[] = {0.0,     -0.0,     1.0,       9.9995,  9.9994999,
+                             0.5,     1e-45,    3.4e38,    INFINITY, -INFINITY,
+                             1e300,   1e-310,   0.0001235, 99999.5, 2.5e-5};
+  for (double special : specials) {
+    size_t length = FormatScientific(special, 3, buffer, sizeof(buffer));
+    snprintf(expected, sizeof(expected), "%.3e", special);
+    ASSERT_EQ(std::string(buffer, length), expected);
+  }
+  ASSERT_EQ(FormatScientific(NAN, 3, buffer, sizeof(buffer)), 3u);
+  ASSERT_EQ(std::string(buffer, 3), "nan");
+
+  for (unsigned width = 1; width <= 8; ++width) {
+    size_t length = FormatBits(0xa5, width, buffer, sizeof(buffer));
+    std::string bitsText;
+    for (unsigned i = width; i-- > 0;) {
+      bitsText += (0xa5 >> i) & 1 ? '1' : '0';
+    }
+    ASSERT_EQ(std::string(buffer, length), bitsText);
+  }
+
+  // Не помещающееся значение не пишется совсем
+  memset(buffer, '#', sizeof(buffer));
+  ASSERT_EQ(FormatHex(0x12345, buffer, 4), 0u);
+  ASSERT_EQ(FormatDecimal(-1000, buffer, 4), 0u);
+  ASSERT_EQ(FormatScientific(1.5, 3, buffer, 8), 0u);
+  ASSERT_EQ(FormatBits(5, 3, buffer, 2), 0u);
+  ASSERT_EQ(FormatScientific(1.5, 10, buffer, sizeof(buffer)), 0u);
+  ASSERT_EQ(buffer[0], '#');
+
+  StatData record = {.id = 0xbeef, .count = -42, .cost = 1234.5f,
+                     .primary = 1, .mode = 5};
+  const std::pair<int, const char *> cells[] = {
+      {STAT_DATA_COLUMN_ID, "beef"},
+      {STAT_DATA_COLUMN_COUNT, "-42"},
+      {STAT_DATA_COLUMN_COST, "1.234e+03"},
+      {STAT_DATA_COLUMN_PRIMARY, "y"},
+      {STAT_DATA_COLUMN_MODE, "101"}};
+  for (const auto &cell : cells) {
+    memset(buffer, ' ', sizeof(buffer));
+    StatDataFormatter(cell.first, &record, buffer, sizeof(buffer));
+    ASSERT_EQ(std::string(buffer, strlen(cell.second)), cell.second);
+    ASSERT_EQ(buffer[strlen(cell.second)], ' ');
+  }
+}
+
+TEST(DumpText, ExportMatchesSnprintf) {
+  // Несколько окон по блоку на поток и неполный последний блок
+  const size_t size = 5 * BINARYSERIALIZER_TEXT_CHUNK_RECORDS + 123;
+  std::vector<StatData> data(size);
+  FillGeneratedData(data.data(), size, 29, 1L << 30);
+  for (size_t i = 0; i < size; ++i) {
+    data[i].id -= 1L << 29;
+    data[i].count = (int)(i * 2654435761u);
+    data[i].cost = (float)((double)data[i].count / 7.0e3);
+  }
+  data[1].cost = INFINITY;
+  data[2].cost = -0.0f;
+  data[3].cost = 1e-40f;
+  const char *inputPath = "export_in.dat";
+  const char *resultPath = "export_out.txt";
+  CreateEmptyFile(inputPath);
+  ASSERT_EQ(StoreDump(inputPath, data.data(), size), SUCCESS);
+
+  std::string csv = "id,count,cost,primary,mode\n";
+  std::string json;
+  char line[160];
+  for (const StatData &record : data) {
+    snprintf(line, sizeof(line), "%ld,%d,%.8e,%u,%u\n", record.id,
+             record.count, record.cost, (unsigned)record.primary,
+             (unsigned)record.mode);
+    csv += line;
+    char cost[32] = "null";
+    if (isfinite(record.cost)) {
+      snprintf(cost, sizeof(cost), "%.8e", record.cost);
+    }
+    snprintf(line, sizeof(line),
+             "{\"id\":%ld,\"count\":%d,\"cost\":%s,\"primary\":%s,"
+             "\"mode\":%u}\n",
+             record.id, record.count, cost, record.primary ? "true" : "false",
+             (unsigned)record.mode);
+    json += line;
+  }
+
+  for (size_t threads : {1, 3}) {
+    ASSERT_EQ(ExportDump(inputPath, resultPath, TEXT_FORMAT_CSV, threads),
+              SUCCESS);
+    ASSERT_EQ(ReadWholeFile(resultPath), csv);
+    ASSERT_EQ(
+        ExportDump(inputPath, resultPath, TEXT_FORMAT_JSON_LINES, threads),
+        SUCCESS);
+    ASSERT_EQ(ReadWholeFile(resultPath), json);
+  }
+
+  CreateEmptyFile(inputPath);
+  ASSERT_EQ(ExportDump(inputPath, resultPath, TEXT_FORMAT_CSV, 0), EMPTY_FILE);
+  ASSERT_EQ(ReadWholeFile(resultPath), "id,count,cost,primary,mode\n");
+  EXPECT_EQ(ExportDump(nullptr, resultPath, TEXT_FORMAT_CSV, 0),
+            INVALID_POINTER_OR_SIZE);
+  EXPECT_EQ(ExportDumpToFd(inputPath, 1, (TextFormat)7, 0),
+            INVALID_POINTER_OR_SIZE);
+  EXPECT_EQ(ExportDump("not_existed.dat", resultPath, TEXT_FORMAT_CSV, 0),
+            BAD_FILE);
+  remove(inputPath);
+  remove(resultPath);
+}
+
+TEST(DumpText, ImportRestoresExportedDump) {
+  const size_t size = 5 * BINARYSERIALIZER_TEXT_CHUNK_RECORDS + 77;
+  std::vector<StatData> data(size);
+  FillGeneratedData(data.data(), size, 31, 1L << 30);
+  unsigned seed = 5;
+  for (size_t i = 0; i < size; ++i) {
+    seed = seed * 1103515245u + 12345u;
+    uint32_t bits = seed;
+    if ((bits & 0x7f800000u) == 0x7f800000u) {
+      bits &= 0xff7fffffu;
+    }
+    memcpy(&data[i].cost, &bits, sizeof(bits));
+    data[i].id = (long)seed * (long)(i + 1) - (1L << 40);
+    data[i].count = (int)(seed ^ (unsigned)i);
+  }
+  data[1].cost = -INFINITY;
+  data[2].cost = -0.0f;
+  data[3].cost = 3.40282347e+38f;
+  data[4].cost = 1e-45f;
+  data[5].id = INT64_MIN;
+  data[6].id = INT64_MAX;
+  const char *dumpPath = "import_in.dat";
+  const char *textPath = "import_text.csv";
+  const char *resultPath = "import_out.dat";
+  CreateEmptyFile(dumpPath);
+  ASSERT_EQ(StoreDump(dumpPath, data.data(), size), SUCCESS);
+  ASSERT_EQ(ExportDump(dumpPath, textPath, TEXT_FORMAT_CSV, 2), SUCCESS);
+
+  for (size_t threads : {1, 4}) {
+    ASSERT_EQ(ImportDump(textPath, resultPath, threads), SUCCESS);
+    StatData *loaded = nullptr;
+    size_t loadedSize = 0;
+    ASSERT_EQ(LoadDump(resultPath, &loaded, &loadedSize), SUCCESS);
+    ASSERT_EQ(loadedSize, size);
+    for (size_t i = 0; i < size; ++i) {
+      ASSERT_EQ(loaded[i].id, data[i].id) << i;
+      ASSERT_EQ(loaded[i].count, data[i].count) << i;
+      ASSERT_EQ(memcmp(&loaded[i].cost, &data[i].cost, sizeof(float)), 0)
+          << i << " " << data[i].cost;
+      ASSERT_EQ(loaded[i].primary, data[i].primary) << i;
+      ASSERT_EQ(loaded[i].mode, data[i].mode) << i;
+    }
+    free(loaded);
+  }
+  remove(dumpPath);
+  remove(textPath);
+  remove(resultPath);
+}
+
+TEST(DumpText, ImportParsesLikeStrtof) {
+  std::string text;
+  std::vector<float> expected;
+  unsigned seed = 11;
+  char cost[64];
+  char line[128];
+  for (size_t i = 0; i < 100000; ++i) {
+    seed = seed * 1103515245u + 12345u;
+    unsigned digits = 1 + seed % 12;
+    int exponent = (int)(seed >> 8) % 90 - 50;
+    int length = 0;
+    for (unsigned d = 0; d < digits; ++d) {
+      seed = seed * 1103515245u + 12345u;
+      cost[length++] = (char)('0' + (seed >> 16) % 10);
+      if (d == 0 && digits > 1 && (seed & 1)) {
+        cost[length++] = '.';
+      }
+    }
+    snprintf(cost + length, sizeof(cost) - length, "%c%d",
+             (seed & 2) ? 'e' : 'E', exponent);
+    expected.push_back(strtof(cost, nullptr));
+    snprintf(line, sizeof(line), "%zu,%d,%s%s,%u,%u%s", i, -(int)i,
+             (seed & 4) ? "-" : "", cost, (seed >> 3) & 1, (seed >> 5) & 7,
+             (seed & 64) ? "\r\n" : "\n");
+    if (seed & 4) {
+      expected.back() = -expected.back();
+    }
+    text += line;
+    if (i % 1000 == 0) {
+      text += "\n";
+    }
+  }
+  text += "7,7,+.5,1,7";
+  expected.push_back(0.5f);
+
+  const char *textPath = "import_parse.csv";
+  const char *resultPath = "import_parse.dat";
+  WriteTextFile(textPath, text);
+  ASSERT_EQ(ImportDump(textPath, resultPath, 3), SUCCESS);
+  StatData *loaded = nullptr;
+  size_t loadedSize = 0;
+  ASSERT_EQ(LoadDump(resultPath, &loaded, &loadedSize), SUCCESS);
+  ASSERT_EQ(loadedSize, expected.size());
+  for (size_t i = 0; i < loadedSize; ++i) {
+    ASSERT_EQ(memcmp(&loaded[i].cost, &expected[i], sizeof(float)), 0)
+        << i << " " << loaded[i].cost << " " << expected[i];
+  }
+  ASSERT_EQ(loaded[loadedSize - 1].mode, 7u);
+  free(loaded);
+
+  const char *malformed[] = {"1,2,3,4,5\n",  "1,2,3,0\n",
+                             "1,2,3,0,1,2\n", "1,2,x,0,1\n",
+                             "1,2,3e,0,1\n", "1,99999999999,3,0,1\n",
+                             "1,2,3,0,8\n",  "1,,3,0,1\n"};
+  for (const char *bad : malformed) {
+    WriteTextFile(textPath, std::string("1,2,3,0,1\n") + bad);
+    EXPECT_EQ(ImportDump(textPath, resultPath, 1), BAD_FILE) << bad;
+  }
+  WriteTextFile(textPath, "id,count,cost,primary,mode\n\n");
+  EXPECT_EQ(ImportDump(textPath, resultPath, 0), EMPTY_FILE);
+  EXPECT_EQ(ImportDump(nullptr, resultPath, 0), INVALID_POINTER_OR_SIZE);
+  EXPECT_EQ(ImportDump("not_existed.csv", resultPath, 0), BAD_FILE);
+  remove(textPath);
+  remove(resultPath);
+}
+
+TEST(TableView, MappedDumpPageMatchesRangeOfWholeTable) {
+  const size_t size = 100000;
+  std::vector<StatData> data(size);
+  FillGeneratedData(data.data(), size, 37, 1 << 20);
+  const char *path = "page_dump.dat";
+  CreateEmptyFile(path);
+  ASSERT_EQ(StoreDump(path, data.data(), size), SUCCESS);
+  MappedDump dump;
+  ASSERT_EQ(MapDump(path, 0, &dump), SUCCESS);
+
+  const char idField[] = "id";
+  const Field fields[] = {{NULL, 0, STAT_DATA_COLUMN_NUMBER, 8},
+                          {idField, sizeof(idField), STAT_DATA_COLUMN_ID, 16}};
+  TableView view;
+  ASSERT_EQ(InitTableView(&view, &StatDataFormatter, fields, 2), TVS_SUCCESS);
+  view.data = data.data();
+  view.dataSize = size;
+  view.memSize = sizeof(StatData);
+  TableMemoryBuffer whole = {};
+  SetTableViewSink(&view, MemoryTableSink(&whole));
+  ASSERT_EQ(PrintTable(&view, size), TVS_SUCCESS);
+  const std::string table(whole.data, whole.size);
+  whole.size = 0;
+  ASSERT_EQ(PrintTablePage(&view, 0, 10), TVS_SUCCESS);
+  std::string firstPage(whole.data, whole.size);
+  whole.size = 0;
+  ASSERT_EQ(PrintTable(&view, 10), TVS_SUCCESS);
+  ASSERT_EQ(firstPage, std::string(whole.data, whole.size));
+
+  // Заголовок занимает три строки, каждая запись - строку и разделитель
+  const size_t rowBytes = table.find('\n') + 1;
+  const size_t headerBytes = 3 * rowBytes;
+  TableMemoryBuffer page = {};
+  SetTableViewSink(&view, MemoryTableSink(&page));
+  const size_t pages[][2] = {{40000, 50}, {size - 7, 50}, {size - 1, 1}};
+  for (const auto &bounds : pages) {
+    size_t offset = bounds[0];
+    size_t end = std::min(size, offset + bounds[1]);
+    page.size = 0;
+    ASSERT_EQ(PrintMappedDumpPage(&dump, offset, bounds[1], &view), SUCCESS);
+    std::string text(page.data, page.size);
+    ASSERT_EQ(text.substr(0, headerBytes), table.substr(0, headerBytes));
+    std::string rows = table.substr(headerBytes + offset * 2 * rowBytes,
+                                    (end - offset) * 2 * rowBytes - rowBytes);
+    ASSERT_EQ(text.substr(headerBytes, rows.size()), rows);
+    ASSERT_EQ(text[text.size() - 2], end < size ? '.' : '-');
+  }
+  EXPECT_EQ(PrintMappedDumpPage(&dump, size, 10, &view),
+            INVALID_POINTER_OR_SIZE);
+  EXPECT_EQ(PrintMappedDumpPage(&dump, 0, 0, &view), INVALID_POINTER_OR_SIZE);
+  EXPECT_EQ(PrintTablePage(&view, size, 1), TVS_ERROR);
+
+  ClearTableMemoryBuffer(&page);
+  ClearTableMemoryBuffer(&whole);
+  ClearTableView(&view);
+  ASSERT_EQ(UnmapDump(&dump), SUCCESS);
+  remove(path);
+}
+
+TEST(Instrumentation, CountsPhasesAndEventsOfPipeline) {
+  ResetInstrumentationStats();
+  SetInstrumentationEnabled(1);
+  if (!IsInstrumentationEnabled()) {
+    GTEST_SKIP() << "built with BS_DISABLE_INSTRUMENTATION";
+  }
+  const size_t size = 50000;
+  std::vector<StatData> data(size);
+  FillGeneratedData(data.data(), size, 41, 20000);
+
+  StatData *joined = nullptr;
+  size_t joinedSize = 0;
+  ASSERT_EQ(JoinDump(data.data(), size, data.data(), size, &joined,
+                     &joinedSize),
+            SUCCESS);
+  const char *path = "instrumentation_dump.dat";
+  CreateEmptyFile(path);
+  ASSERT_EQ(StoreDump(path, joined, joinedSize), SUCCESS);
+  StatData *loaded = nullptr;
+  size_t loadedSize = 0;
+  ASSERT_EQ(LoadDump(path, &loaded, &loadedSize), SUCCESS);
+  ASSERT_EQ(SortDumpByKey(loaded, loadedSize, SORT_FIELD_COST, SORT_DESC),
+            SUCCESS);
+  const Field fields[] = {{NULL, 0, STAT_DATA_COLUMN_NUMBER, 8}};
+  TableView view;
+  ASSERT_EQ(InitTableView(&view, &StatDataFormatter, fields, 1), TVS_SUCCESS);
+  TableMemoryBuffer buffer = {};
+  SetTableViewSink(&view, MemoryTableSink(&buffer));
+  ASSERT_EQ(PrintDump(loaded, loadedSize, 10, &view), SUCCESS);
+
+  InstrumentationStats stats;
+  ASSERT_EQ(GetInstrumentationStats(&stats), SUCCESS);
+  const uint64_t bytes = sizeof(StatData) * joinedSize;
+  EXPECT_EQ(stats.counters[INSTRUMENTATION_RECORDS], 2 * size);
+  // Every record but the first of its id is merged somewhere
+  EXPECT_EQ(stats.counters[INSTRUMENTATION_MERGES], 2 * size - joinedSize);
+  EXPECT_GT(stats.counters[INSTRUMENTATION_PROBES], 0u);
+  EXPECT_GT(stats.counters[INSTRUMENTATION_REALLOCS], 0u);
+  EXPECT_EQ(stats.counters[INSTRUMENTATION_BYTES_WRITTEN], bytes);
+  EXPECT_EQ(stats.counters[INSTRUMENTATION_BYTES_READ], bytes);
+  EXPECT_EQ(stats.phaseCalls[INSTRUMENTATION_PHASE_HASH], 2u);
+  EXPECT_EQ(stats.phaseCalls[INSTRUMENTATION_PHASE_TO_ARRAY], 1u);
+  EXPECT_EQ(stats.phaseCalls[INSTRUMENTATION_PHASE_OPEN], 2u);
+  EXPECT_EQ(stats.phaseCalls[INSTRUMENTATION_PHASE_STORE], 1u);
+  EXPECT_EQ(stats.phaseCalls[INSTRUMENTATION_PHASE_SORT], 1u);
+  EXPECT_EQ(stats.phaseCalls[INSTRUMENTATION_PHASE_PRINT], 1u);
+  EXPECT_EQ(stats.phaseCalls[INSTRUMENTATION_PHASE_MERGE], 0u);
+  EXPECT_GT(stats.phaseCalls[INSTRUMENTATION_PHASE_MAP], 0u);
+  EXPECT_GT(stats.phaseCalls[INSTRUMENTATION_PHASE_COPY], 0u);
+  EXPECT_GT(stats.phaseNanoseconds[INSTRUMENTATION_PHASE_HASH], 0u);
+  EXPECT_STREQ(InstrumentationPhaseName(INSTRUMENTATION_PHASE_TO_ARRAY),
+               "to_array");
+  EXPECT_STREQ(InstrumentationCounterName(INSTRUMENTATION_PROBES), "probes");
+
+  // Выключенный сбор не меняет накопленные значения
+  SetInstrumentationEnabled(0);
+  EXPECT_EQ(IsInstrumentationEnabled(), 0);
+  free(joined);
+  ASSERT_EQ(JoinDump(data.data(), size, nullptr, 0, &joined, &joinedSize),
+            SUCCESS);
+  InstrumentationStats after;
+  ASSERT_EQ(GetInstrumentationStats(&after), SUCCESS);
+  EXPECT_EQ(memcmp(&stats, &after, sizeof(stats)), 0);
+
+  ResetInstrumentationStats();
+  ASSERT_EQ(GetInstrumentationStats(&after), SUCCESS);
+  const InstrumentationStats zero = {};
+  EXPECT_EQ(memcmp(&zero, &after, sizeof(zero)), 0);
+  EXPECT_EQ(GetInstrumentationStats(nullptr), INVALID_POINTER_OR_SIZE);
+
+  ClearTableMemoryBuffer(&buffer);
+  ClearTableView(&view);
+  free(loaded);
+  free(joined);
+  remove(path);
+}
+
+TEST(Instrumentation, TracksLibraryAllocations) {
+  SetInstrumentationEnabled(1);
+  if (!IsInstrumentationEnabled()) {
+    GTEST_SKIP() << "built with BS_DISABLE_INSTRUMENTATION";
+  }
+  const size_t size = 20000;
+  std::vector<StatData> data(size);
+  FillGeneratedData(data.data(), size, 43, size);
+
+  // Таблица освобождает все свои блоки: живых байт не остается
+  ResetInstrumentationStats();
+  MergeHashTable table;
+  ASSERT_TRUE(InitHashTable(&table, NULL, NULL, NULL));
+  for (const StatData &record : data) {
+    ASSERT_TRUE(InsertToHashTable(&table, &record));
+  }
+  AllocationStats memory;
+  ASSERT_EQ(GetAllocationStats(&memory), SUCCESS);
+  EXPECT_GT(memory.allocations, HashTableSize(&table));
+  EXPECT_GT(memory.reallocations, 0u);
+  EXPECT_GE(memory.peakLiveBytes,
+            (int64_t)(HashTableSize(&table) * sizeof(StatData)));
+  const int64_t peak = memory.peakLiveBytes;
+  ClearHashTable(&table);
+  ASSERT_EQ(GetAllocationStats(&memory), SUCCESS);
+  EXPECT_EQ(memory.liveBytes, 0);
+  EXPECT_EQ(memory.frees, memory.allocations);
+  EXPECT_EQ(memory.peakLiveBytes, peak);
+
+  // Результат JoinDump остается живым: его освобождает вызывающая сторона
+  ResetInstrumentationStats();
+  StatData *joined = nullptr;
+  size_t joinedSize = 0;
+  ASSERT_EQ(JoinDump(data.data(), size, data.data(), size, &joined,
+                     &joinedSize),
+            SUCCESS);
+  ASSERT_EQ(GetAllocationStats(&memory), SUCCESS);
+  EXPECT_GE(memory.liveBytes, (int64_t)(joinedSize * sizeof(StatData)));
+  EXPECT_GE(memory.allocatedBytes, (uint64_t)memory.peakLiveBytes);
+  EXPECT_GE(memory.peakLiveBytes, memory.liveBytes);
+  free(joined);
+
+  SetInstrumentationEnabled(0);
+  ResetInstrumentationStats();
+  ASSERT_EQ(GetAllocationStats(&memory), SUCCESS);
+  const AllocationStats zero = {};
+  EXPECT_EQ(memcmp(&zero, &memory, sizeof(zero)), 0);
+  EXPECT_EQ(GetAllocationStats(nullptr), INVALID_POINTER_OR_SIZE);
+}